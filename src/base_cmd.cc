@@ -9,6 +9,9 @@
 
 #include "base_cmd.h"
 
+#include <chrono>
+#include <thread>
+
 #include "fmt/core.h"
 
 #include "praft/praft.h"
@@ -38,9 +41,58 @@ bool BaseCmd::CheckArg(size_t num) const {
 
 std::vector<std::string> BaseCmd::CurrentKey(PClient* client) const { return std::vector<std::string>{client->Key()}; }
 
+// A write to an instance with a compaction backlog waits a little, as set by
+// its write throttle, or is turned away with BUSY before RocksDB would stop it
+// and block the thread. It is turned away as well when too many threads wait.
+// The commands run by EXEC are not, a transaction is never cut in two.
+// It runs before the command takes the DB lock, which neither a FLUSHDB nor a
+// reopen then waits on, and the command parses and runs on the DB as it is
+// after the wait. The keys come from a DoInitial of their own, only run while
+// an instance of the DB throttles.
+bool BaseCmd::AdmitWrite(PClient* client) {
+  if (!g_config.write_throttle.load(std::memory_order_relaxed) || client->IsFlagOn(kClientFlagInExec)) {
+    return true;
+  }
+  auto db = client->GetCurrentDB();
+  auto& backend = PSTORE.GetBackend(db);
+  int64_t delay_us = 0;
+  {
+    backend->LockShared();
+    DEFER { backend->UnLockShared(); };
+    if (!backend->GetStorage()->WriteThrottled()) {
+      return true;
+    }
+    client->ClearKeys();
+    if (!DoInitial(client)) {
+      return false;
+    }
+    if (client->Keys().empty()) {
+      return true;
+    }
+    delay_us = backend->GetStorage()->AdmitWrite(client->Keys());
+  }
+  if (delay_us == 0) {
+    return true;
+  }
+  if (delay_us == storage::WriteThrottle::kReject || !g_pikiwidb->EnterWriteThrottle()) {
+    client->SetLineString(
+        fmt::format("-BUSY writes to db {} are throttled for a compaction backlog, try again later", db));
+    return false;
+  }
+  std::this_thread::sleep_for(std::chrono::microseconds(delay_us));
+  g_pikiwidb->LeaveWriteThrottle();
+  return true;
+}
+
 void BaseCmd::Execute(PClient* client) {
   DEBUG("execute command: {}", client->CmdName());
 
+  // the DBs are still being opened, only commands that do not touch the data may run
+  if (PSTORE.IsLoading() &&
+      (HasFlag(kCmdFlagsReadonly | kCmdFlagsWrite | kCmdFlagsExclusive) || (acl_category_ & kAclCategoryRaft))) {
+    return client->SetRes(CmdRes::kLoading);
+  }
+
   // read consistency (lease read) / write redirection
   if (g_config.use_raft.load(std::memory_order_relaxed) && (HasFlag(kCmdFlagsReadonly) || HasFlag(kCmdFlagsWrite))) {
     if (!PRAFT.IsInitialized()) {
@@ -57,20 +109,34 @@ void BaseCmd::Execute(PClient* client) {
     }
   }
 
+  if (HasFlag(kCmdFlagsWrite) && !AdmitWrite(client)) {
+    return;
+  }
+
   auto dbIndex = client->GetCurrentDB();
-  if (!HasFlag(kCmdFlagsExclusive)) {
+  // EXEC already holds the exclusive lock of the DBs used by the queued commands
+  bool lock = !HasFlag(kCmdFlagsExclusive) && !client->IsFlagOn(kClientFlagInExec);
+  if (lock) {
     PSTORE.GetBackend(dbIndex)->LockShared();
   }
   DEFER {
-    if (!HasFlag(kCmdFlagsExclusive)) {
+    if (lock) {
       PSTORE.GetBackend(dbIndex)->UnLockShared();
     }
   };
 
+  // the keys of the previous command must not stand in for this one's
+  client->ClearKeys();
   if (!DoInitial(client)) {
     return;
   }
   DoCmd(client);
+
+  // Bump the versions while still holding the lock, so EXEC never misses an in-flight write.
+  // Every write command puts the keys it may modify in Keys().
+  if (HasFlag(kCmdFlagsWrite) && !client->Keys().empty()) {
+    PSTORE.GetBackend(dbIndex)->TouchKeys(client->Keys());
+  }
 }
 
 std::string BaseCmd::ToBinlog(uint32_t exec_time, uint32_t term_id, uint64_t logic_id, uint32_t filenum,
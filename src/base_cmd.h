@@ -83,6 +83,8 @@ const std::string kSubCmdNameConfigGet = "get";
 const std::string kSubCmdNameConfigSet = "set";
 const std::string kCmdNameFlushdb = "flushdb";
 const std::string kCmdNameFlushall = "flushall";
+const std::string kCmdNameConvertformat = "convertformat";
+const std::string kCmdNameBgbackup = "bgbackup";
 const std::string kCmdNameAuth = "auth";
 const std::string kCmdNameSelect = "select";
 const std::string kCmdNameShutdown = "shutdown";
@@ -90,6 +92,7 @@ const std::string kCmdNameDebug = "debug";
 const std::string kSubCmdNameDebugHelp = "help";
 const std::string kSubCmdNameDebugOOM = "oom";
 const std::string kSubCmdNameDebugSegfault = "segfault";
+const std::string kSubCmdNameDebugWritePressure = "write-pressure";
 const std::string kCmdNameInfo = "info";
 const std::string kCmdNameSort = "sort";
 
@@ -165,6 +168,28 @@ const std::string kCmdNameZRevrank = "zrevrank";
 const std::string kCmdNameZRem = "zrem";
 const std::string kCmdNameZIncrby = "zincrby";
 
+// geo cmd
+const std::string kCmdNameGeoAdd = "geoadd";
+const std::string kCmdNameGeoPos = "geopos";
+const std::string kCmdNameGeoDist = "geodist";
+const std::string kCmdNameGeoSearch = "geosearch";
+
+// stream cmd
+const std::string kCmdNameXAdd = "xadd";
+const std::string kCmdNameXLen = "xlen";
+const std::string kCmdNameXRange = "xrange";
+const std::string kCmdNameXRevrange = "xrevrange";
+const std::string kCmdNameXDel = "xdel";
+const std::string kCmdNameXTrim = "xtrim";
+const std::string kCmdNameXRead = "xread";
+const std::string kCmdNameXGroup = "xgroup";
+const std::string kSubCmdNameXGroupCreate = "create";
+const std::string kSubCmdNameXGroupSetID = "setid";
+const std::string kSubCmdNameXGroupDestroy = "destroy";
+const std::string kCmdNameXReadGroup = "xreadgroup";
+const std::string kCmdNameXAck = "xack";
+const std::string kCmdNameXPending = "xpending";
+
 enum CmdFlags {
   kCmdFlagsWrite = (1 << 0),             // May modify the dataset
   kCmdFlagsReadonly = (1 << 1),          // Doesn't modify the dataset
@@ -342,6 +367,9 @@ class BaseCmd : public std::enable_shared_from_this<BaseCmd> {
   // If this function returns false, then Do Cmd will not be executed
   virtual bool DoInitial(PClient* client) = 0;
 
+  // Waits out the write throttle of the DB or turns the write away, false when the reply is set
+  bool AdmitWrite(PClient* client);
+
   //  virtual void Clear(){};
   //  BaseCmd& operator=(const BaseCmd&);
 };
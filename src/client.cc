@@ -148,6 +148,9 @@ void CmdRes::SetRes(CmdRes::CmdRet _ret, const std::string& content) {
       AppendStringRaw(content);
       AppendStringRaw(CRLF);
       break;
+    case kLoading:
+      SetLineString("-LOADING PikiwiDB is loading the dataset");
+      break;
     default:
       break;
   }
@@ -361,28 +364,11 @@ int PClient::handlePacket(const char* start, int bytes) {
   //  }
   auto now = std::chrono::steady_clock::now();
   time_stat_->SetEnqueueTs(now);
-  g_pikiwidb->SubmitFast(std::make_shared<CmdThreadPoolTask>(shared_from_this()));
-
-  // check transaction
-  //  if (IsFlagOn(ClientFlag_multi)) {
-  //    if (cmdName_ != kCmdNameMulti && cmdName_ != kCmdNameExec && cmdName_ != kCmdNameWatch &&
-  //        cmdName_ != kCmdNameUnwatch && cmdName_ != kCmdNameDiscard) {
-  //      if (!info->CheckParamsCount(static_cast<int>(params.size()))) {
-  //        ERROR("queue failed: cmd {} has params {}", cmdName_, params.size());
-  //        ReplyError(info ? PError_param : PError_unknowCmd, &reply_);
-  //        FlagExecWrong();
-  //      } else {
-  //        if (!IsFlagOn(ClientFlag_wrongExec)) {
-  //          queue_cmds_.push_back(params);
-  //        }
-  //
-  //        reply_.PushData("+QUEUED\r\n", 9);
-  //        INFO("queue cmd {}", cmdName_);
-  //      }
-  //
-  //      return static_cast<int>(ptr - start);
-  //    }
-  //  }
+  if (!g_pikiwidb->SubmitFast(std::make_shared<CmdThreadPoolTask>(shared_from_this()))) {
+    SetLineString("-BUSY too many commands queued for db " + std::to_string(dbno_) + ", try again later");
+    SendPacket();
+    return static_cast<int>(ptr - start);
+  }
 
   // check readonly slave and execute command
   //  PError err = PError_ok;
@@ -497,6 +483,9 @@ void PClient::Close() { g_pikiwidb->CloseConnection(shared_from_this()); }
 
 void PClient::OnClose() {
   SetState(ClientState::kClosed);
+  PSTORE.GetBackend(GetCurrentDB())->UnblockClient(shared_from_this());
+  ClearMulti();
+  ClearWatch();
   reset();
 }
 
@@ -518,55 +507,41 @@ uint64_t PClient::uniqueID() const { return GetConnId(); }
 
 bool PClient::Watch(int dbno, const std::string& key) {
   DEBUG("Client {} watch {}, db {}", name_, key, dbno);
-  return watch_keys_[dbno].insert(key).second;
-}
-
-bool PClient::NotifyDirty(int dbno, const std::string& key) {
-  if (IsFlagOn(kClientFlagDirty)) {
-    INFO("client is already dirty {}", uniqueID());
-    return true;
-  }
-
-  if (watch_keys_[dbno].contains(key)) {
-    INFO("{} client become dirty because key {} in db {}", uniqueID(), key, dbno);
-    SetFlag(kClientFlagDirty);
-    return true;
-  } else {
-    INFO("Dirty key is not exist: {}, because client unwatch before dirty", key);
+  auto& keys = watch_keys_[dbno];
+  if (keys.contains(key)) {
+    return false;
   }
-
-  return false;
+  keys.emplace(key, PSTORE.GetBackend(dbno)->WatchKey(key));
+  return true;
 }
 
-bool PClient::Exec() {
-  DEFER {
-    this->ClearMulti();
-    this->ClearWatch();
-  };
-
-  if (IsFlagOn(kClientFlagWrongExec)) {
-    return false;
+bool PClient::CheckWatch() const {
+  for (const auto& [dbno, keys] : watch_keys_) {
+    auto& db = PSTORE.GetBackend(dbno);
+    for (const auto& [key, version] : keys) {
+      if (db->KeyVersion(key) != version) {
+        DEBUG("Client {} watched key {} in db {} is modified", uniqueID(), key, dbno);
+        return false;
+      }
+    }
   }
+  return true;
+}
 
-  if (IsFlagOn(kClientFlagDirty)) {
-    //    FormatNullArray(&reply_);
-    AppendString("");
-    return true;
+std::vector<int> PClient::WatchedDBs() const {
+  std::vector<int> dbs;
+  dbs.reserve(watch_keys_.size());
+  for (const auto& [dbno, _] : watch_keys_) {
+    dbs.push_back(dbno);
   }
+  return dbs;
+}
 
-  //  PreFormatMultiBulk(queue_cmds_.size(), &reply_);
-  //  for (const auto& cmd : queue_cmds_) {
-  //    DEBUG("EXEC {}, for client {}", cmd[0], UniqueId());
-  //    const PCommandInfo* info = PCommandTable::GetCommandInfo(cmd[0]);
-  //    PError err = PCommandTable::ExecuteCmd(cmd, info, &reply_);
-
-  // may dirty clients;
-  //    if (err == PError_ok && (info->attr & PAttr_write)) {
-  //      Propagate(cmd);
-  //    }
-  //  }
-
-  return true;
+void PClient::SwapQueuedCmd(std::vector<std::string>& params) {
+  params_.swap(params);
+  argv_ = params_;
+  cmdName_ = params_[0];
+  pstd::StringToLower(cmdName_);
 }
 
 void PClient::ClearMulti() {
@@ -576,8 +551,13 @@ void PClient::ClearMulti() {
 }
 
 void PClient::ClearWatch() {
+  for (const auto& [dbno, keys] : watch_keys_) {
+    auto& db = PSTORE.GetBackend(dbno);
+    for (const auto& [key, _] : keys) {
+      db->UnWatchKey(key);
+    }
+  }
   watch_keys_.clear();
-  ClearFlag(kClientFlagDirty);
 }
 
 bool PClient::WaitFor(const std::string& key, const std::string* target) {
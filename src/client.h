@@ -92,6 +92,7 @@ class CmdRes {
     kInvalidCursor,
     kWrongLeader,
     kMultiKey,
+    kLoading,
   };
 
   CmdRes() = default;
@@ -144,9 +145,10 @@ class CmdRes {
 
 enum ClientFlag {
   kClientFlagMulti = (1 << 0),
-  kClientFlagDirty = (1 << 1),
   kClientFlagWrongExec = (1 << 2),
   kClientFlagMaster = (1 << 3),
+  kClientFlagInExec = (1 << 4),  // EXEC is running the queued commands and holds the DB locks
+  kClientFlagBlocked = (1 << 5),  // a blocking read found nothing, the reply waits for a write or the timeout
 };
 
 enum class ClientState {
@@ -203,8 +205,13 @@ class PClient : public std::enable_shared_from_this<PClient>, public CmdRes {
   }
 
   bool Watch(int dbno, const std::string& key);
-  bool NotifyDirty(int dbno, const std::string& key);
-  bool Exec();
+  // true if none of the watched keys was modified since WATCH
+  bool CheckWatch() const;
+  std::vector<int> WatchedDBs() const;
+  void QueueCmd() { queue_cmds_.push_back(params_); }
+  std::vector<std::vector<std::string>>& QueuedCmds() { return queue_cmds_; }
+  // swap argv_ with a queued command so EXEC can run it, swapping again restores the original command
+  void SwapQueuedCmd(std::vector<std::string>& params);
   void ClearMulti();
   void ClearWatch();
 
@@ -228,6 +235,21 @@ class PClient : public std::enable_shared_from_this<PClient>, public CmdRes {
   void ClearWaitingKeys() { waiting_keys_.clear(), target_.clear(); }
   const std::string& GetTarget() const { return target_; }
 
+  // Blocking reads park the client on Keys() instead of replying, the worker
+  // hands it to DB::BlockClient. The deadline survives the re-runs after a
+  // wake up, so a retried command keeps its original timeout.
+  void Block(std::chrono::steady_clock::time_point deadline, uint64_t ready_version) {
+    SetFlag(kClientFlagBlocked);
+    block_deadline_ = deadline;
+    block_ready_version_ = ready_version;
+  }
+  void ClearBlock() {
+    ClearFlag(kClientFlagBlocked);
+    block_deadline_ = {};
+  }
+  std::chrono::steady_clock::time_point BlockDeadline() const { return block_deadline_; }
+  uint64_t BlockReadyVersion() const { return block_ready_version_; }
+
   void SetName(const std::string& name) { name_ = name; }
   const std::string& GetName() const { return name_; }
   void SetCmdName(const std::string& name) { cmdName_ = name; }
@@ -240,6 +262,7 @@ class PClient : public std::enable_shared_from_this<PClient>, public CmdRes {
     keys_.emplace_back(name);
   }
   void SetKey(std::vector<std::string>& names);
+  void ClearKeys() { keys_.clear(); }
   const std::string& Key() const { return keys_.at(0); }
   const std::vector<std::string>& Keys() const { return keys_; }
   std::vector<storage::FieldValue>& Fvs() { return fvs_; }
@@ -302,12 +325,15 @@ class PClient : public std::enable_shared_from_this<PClient>, public CmdRes {
   std::unordered_set<std::string> pattern_channels_;
 
   uint32_t flag_ = 0;
-  std::unordered_map<int32_t, std::unordered_set<std::string> > watch_keys_;
+  // watched keys of each db and their versions at WATCH time
+  std::unordered_map<int32_t, std::unordered_map<std::string, uint64_t> > watch_keys_;
   std::vector<std::vector<std::string> > queue_cmds_;
 
   // blocked list
   std::unordered_set<std::string> waiting_keys_;
   std::string target_;
+  std::chrono::steady_clock::time_point block_deadline_;
+  uint64_t block_ready_version_ = 0;
 
   // slave info from master view
   std::unique_ptr<PSlaveInfo> slave_info_;
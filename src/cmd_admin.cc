@@ -67,6 +67,12 @@ void CmdConfigSet::DoCmd(PClient* client) {
   auto s = g_config.Set(client->argv_[2], client->argv_[3]);
   if (!s.ok()) {
     client->SetRes(CmdRes::kInvalidParameter);
+    return;
+  }
+  std::string key = client->argv_[2];
+  s = g_pikiwidb->OnConfigSet(pstd::StringToLower(key));
+  if (!s.ok()) {
+    client->SetRes(CmdRes::kErrOther, s.ToString());
   } else {
     client->SetRes(CmdRes::kOK);
   }
@@ -79,21 +85,11 @@ FlushdbCmd::FlushdbCmd(const std::string& name, int16_t arity)
 bool FlushdbCmd::DoInitial(PClient* client) { return true; }
 
 void FlushdbCmd::DoCmd(PClient* client) {
-  int currentDBIndex = client->GetCurrentDB();
-  PSTORE.GetBackend(currentDBIndex).get()->Lock();
-  DEFER { PSTORE.GetBackend(currentDBIndex).get()->UnLock(); };
-
-  std::string db_path = g_config.db_path.ToString() + std::to_string(currentDBIndex);
-  std::string path_temp = db_path;
-  path_temp.append("_deleting/");
-  pstd::RenameFile(db_path, path_temp);
-
-  auto s = PSTORE.GetBackend(currentDBIndex)->Open();
+  auto s = PSTORE.GetBackend(client->GetCurrentDB())->Flush();
   if (!s.ok()) {
-    client->SetRes(CmdRes::kErrOther, "flushdb failed");
+    client->SetRes(CmdRes::kErrOther, "flushdb failed: " + s.ToString());
     return;
   }
-  auto f = std::async(std::launch::async, [&path_temp]() { pstd::DeleteDir(path_temp); });
   client->SetRes(CmdRes::kOK);
 }
 
@@ -104,21 +100,44 @@ FlushallCmd::FlushallCmd(const std::string& name, int16_t arity)
 bool FlushallCmd::DoInitial(PClient* client) { return true; }
 
 void FlushallCmd::DoCmd(PClient* client) {
-  for (size_t i = 0; i < g_config.databases; ++i) {
-    PSTORE.GetBackend(i).get()->Lock();
-    std::string db_path = g_config.db_path.ToString() + std::to_string(i);
-    std::string path_temp = db_path;
-    path_temp.append("_deleting/");
-    pstd::RenameFile(db_path, path_temp);
-
-    auto s = PSTORE.GetBackend(i)->Open();
-    assert(s.ok());
-    auto f = std::async(std::launch::async, [&path_temp]() { pstd::DeleteDir(path_temp); });
-    PSTORE.GetBackend(i).get()->UnLock();
+  for (int i = 0; i < PSTORE.GetDBNumber(); ++i) {
+    auto s = PSTORE.GetBackend(i)->Flush();
+    if (!s.ok()) {
+      client->SetRes(CmdRes::kErrOther, "flushall failed: " + s.ToString());
+      return;
+    }
   }
   client->SetRes(CmdRes::kOK);
 }
 
+ConvertformatCmd::ConvertformatCmd(const std::string& name, int16_t arity)
+    : BaseCmd(name, arity, kCmdFlagsAdmin | kCmdFlagsWrite, kAclCategoryWrite | kAclCategoryAdmin) {}
+
+bool ConvertformatCmd::DoInitial(PClient* client) { return true; }
+
+void ConvertformatCmd::DoCmd(PClient* client) {
+  auto s = PSTORE.StartConvertFormat(client->GetCurrentDB());
+  if (!s.ok()) {
+    client->SetRes(CmdRes::kErrOther, "convertformat failed: " + s.ToString());
+    return;
+  }
+  client->SetLineString("+Background format conversion started");
+}
+
+BgbackupCmd::BgbackupCmd(const std::string& name, int16_t arity)
+    : BaseCmd(name, arity, kCmdFlagsAdmin | kCmdFlagsReadonly, kAclCategoryAdmin) {}
+
+bool BgbackupCmd::DoInitial(PClient* client) { return true; }
+
+void BgbackupCmd::DoCmd(PClient* client) {
+  auto s = PSTORE.StartBackup();
+  if (!s.ok()) {
+    client->SetRes(CmdRes::kErrOther, "bgbackup failed: " + s.ToString());
+    return;
+  }
+  client->SetLineString("+Background backup started");
+}
+
 SelectCmd::SelectCmd(const std::string& name, int16_t arity)
     : BaseCmd(name, arity, kCmdFlagsAdmin | kCmdFlagsReadonly, kAclCategoryAdmin) {}
 
@@ -158,7 +177,13 @@ PingCmd::PingCmd(const std::string& name, int16_t arity) : BaseCmd(name, arity,
 
 bool PingCmd::DoInitial(PClient* client) { return true; }
 
-void PingCmd::DoCmd(PClient* client) { client->SetRes(CmdRes::kPong, "PONG"); }
+void PingCmd::DoCmd(PClient* client) {
+  // like Redis, health checks only pass once the data is available
+  if (PSTORE.IsLoading()) {
+    return client->SetRes(CmdRes::kLoading);
+  }
+  client->SetRes(CmdRes::kPong, "PONG");
+}
 
 const std::string InfoCmd::kInfoSection = "info";
 const std::string InfoCmd::kAllSection = "all";
@@ -168,6 +193,10 @@ const std::string InfoCmd::kCPUSection = "cpu";
 const std::string InfoCmd::kDataSection = "data";
 const std::string InfoCmd::kCommandStatsSection = "commandstats";
 const std::string InfoCmd::kRaftSection = "raft";
+const std::string InfoCmd::kLoadingSection = "loading";
+const std::string InfoCmd::kBackupSection = "backup";
+const std::string InfoCmd::kConvertSection = "convert";
+const std::string InfoCmd::kThrottleSection = "throttle";
 
 InfoCmd::InfoCmd(const std::string& name, int16_t arity) : BaseCmd(name, arity, kCmdFlagsAdmin, kAclCategoryAdmin) {}
 
@@ -204,6 +233,14 @@ void InfoCmd::DoCmd(PClient* client) {
       info.append("\r\n");
       InfoData(info);
       info.append("\r\n");
+      InfoLoading(info);
+      info.append("\r\n");
+      InfoBackup(info);
+      info.append("\r\n");
+      InfoConvert(info);
+      info.append("\r\n");
+      InfoThrottle(info);
+      info.append("\r\n");
       InfoStats(info);
       info.append("\r\n");
       InfoCPU(info);
@@ -214,6 +251,14 @@ void InfoCmd::DoCmd(PClient* client) {
       info.append("\r\n");
       InfoData(info);
       info.append("\r\n");
+      InfoLoading(info);
+      info.append("\r\n");
+      InfoBackup(info);
+      info.append("\r\n");
+      InfoConvert(info);
+      info.append("\r\n");
+      InfoThrottle(info);
+      info.append("\r\n");
       InfoStats(info);
       info.append("\r\n");
       InfoCommandStats(client, info);
@@ -239,6 +284,18 @@ void InfoCmd::DoCmd(PClient* client) {
     case kInfoRaft:
       InfoRaft(info);
       break;
+    case kInfoLoading:
+      InfoLoading(info);
+      break;
+    case kInfoBackup:
+      InfoBackup(info);
+      break;
+    case kInfoConvert:
+      InfoConvert(info);
+      break;
+    case kInfoThrottle:
+      InfoThrottle(info);
+      break;
     default:
       break;
   }
@@ -341,6 +398,19 @@ void InfoCmd::InfoStats(std::string& info) {
 
   tmp_stream << "is_bgsaving:" << (PREPL.IsBgsaving() ? "Yes" : "No") << "\r\n";
   tmp_stream << "slow_logs_count:" << PSlowLog::Instance().GetLogsCount() << "\r\n";
+  auto poll_stats = g_pikiwidb->GetPollStats();
+  tmp_stream << "io_blocking_polls:" << poll_stats.blockingPolls << "\r\n";
+  tmp_stream << "io_busy_poll_hits:" << poll_stats.busyPollHits << "\r\n";
+  auto iterator_stats = PSTORE.GetIteratorPoolStats();
+  tmp_stream << "iterators_created:" << iterator_stats.created << "\r\n";
+  tmp_stream << "iterators_reused:" << iterator_stats.reused << "\r\n";
+  tmp_stream << "iterators_expired:" << iterator_stats.expired << "\r\n";
+  tmp_stream << "iterators_parked:" << iterator_stats.parked << "\r\n";
+  for (const auto& qos : g_pikiwidb->GetQosStats()) {
+    tmp_stream << "qos_db" << qos.db << ":weight=" << qos.weight << ",queued=" << qos.queued
+               << ",dispatched=" << qos.dispatched << ",rejected=" << qos.rejected << ",throttled=" << qos.throttled
+               << ",avg_wait_us=" << (qos.dispatched ? qos.wait_us / qos.dispatched : 0) << "\r\n";
+  }
   info.append(tmp_stream.str());
 }
 
@@ -371,6 +441,170 @@ void InfoCmd::InfoData(std::string& message) {
   message += DATABASES_NUM + std::string(":") + std::to_string(pikiwidb::g_config.databases) + "\r\n";
   message += ROCKSDB_NUM + std::string(":") + std::to_string(pikiwidb::g_config.db_instance_num) + "\r\n";
   message += ROCKSDB_VERSION + std::string(":") + ROCKSDB_NAMESPACE::GetRocksVersionAsString() + "\r\n";
+
+  const auto& cache = PSTORE.GetBlockCache();
+  const auto& write_buffer_manager = PSTORE.GetWriteBufferManager();
+  if (cache) {
+    message += "block_cache_capacity:" + std::to_string(cache->GetCapacity()) + "\r\n";
+    message += "block_cache_usage:" + std::to_string(cache->GetUsage()) + "\r\n";
+    message += "block_cache_pinned_usage:" + std::to_string(cache->GetPinnedUsage()) + "\r\n";
+  }
+  if (const auto& secondary_cache = PSTORE.GetSecondaryCache(); secondary_cache) {
+    size_t capacity = 0;
+    secondary_cache->GetCapacity(capacity);
+    message += "secondary_cache_capacity:" + std::to_string(capacity) + "\r\n";
+  }
+  if (const auto& statistics = PSTORE.GetStatistics(); statistics) {
+    // a block found in the secondary cache counts as a block cache hit as well
+    uint64_t hits = statistics->getTickerCount(rocksdb::BLOCK_CACHE_HIT);
+    uint64_t misses = statistics->getTickerCount(rocksdb::BLOCK_CACHE_MISS);
+    uint64_t secondary_hits = std::min(statistics->getTickerCount(rocksdb::SECONDARY_CACHE_HITS), hits);
+    auto rate = [](uint64_t part, uint64_t total) {
+      return std::to_string(total == 0 ? 0.0 : static_cast<double>(part) / static_cast<double>(total));
+    };
+    message += "block_cache_hits:" + std::to_string(hits - secondary_hits) + "\r\n";
+    message += "block_cache_misses:" + std::to_string(misses + secondary_hits) + "\r\n";
+    message += "block_cache_hit_rate:" + rate(hits - secondary_hits, hits + misses) + "\r\n";
+    if (PSTORE.GetSecondaryCache()) {
+      message += "secondary_cache_hits:" + std::to_string(secondary_hits) + "\r\n";
+      message += "secondary_cache_misses:" + std::to_string(misses) + "\r\n";
+      message += "secondary_cache_hit_rate:" + rate(secondary_hits, secondary_hits + misses) + "\r\n";
+      message += "cache_hit_rate:" + rate(hits, hits + misses) + "\r\n";
+    }
+  }
+  if (!g_config.rocksdb_cold_path.ToString().empty() && !PSTORE.IsLoading()) {
+    uint64_t hot_bytes = 0;
+    uint64_t cold_bytes = 0;
+    for (int i = 0; i < PSTORE.GetDBNumber(); ++i) {
+      bool locked = PSTORE.GetBackend(i)->LockSharedUnlessHeld();
+      PSTORE.GetBackend(i)->GetStorage()->GetTierUsage(&hot_bytes, &cold_bytes);
+      if (locked) {
+        PSTORE.GetBackend(i)->UnLockShared();
+      }
+    }
+    message += "tier_hot_bytes:" + std::to_string(hot_bytes) + "\r\n";
+    message += "tier_cold_bytes:" + std::to_string(cold_bytes) + "\r\n";
+    if (const auto& statistics = PSTORE.GetStatistics(); statistics) {
+      auto ticker = [&statistics](const char* name, rocksdb::Tickers ticker) {
+        return std::string(name) + ":" + std::to_string(statistics->getTickerCount(ticker)) + "\r\n";
+      };
+      // the last level is the cold one, the upper levels mostly sit on the hot path
+      message += ticker("tier_upper_level_reads", rocksdb::NON_LAST_LEVEL_READ_COUNT);
+      message += ticker("tier_upper_level_read_bytes", rocksdb::NON_LAST_LEVEL_READ_BYTES);
+      message += ticker("tier_last_level_reads", rocksdb::LAST_LEVEL_READ_COUNT);
+      message += ticker("tier_last_level_read_bytes", rocksdb::LAST_LEVEL_READ_BYTES);
+    }
+  }
+  if (write_buffer_manager) {
+    message += "memtable_budget:" + std::to_string(write_buffer_manager->buffer_size()) + "\r\n";
+    message += "memtable_usage:" + std::to_string(write_buffer_manager->memory_usage()) + "\r\n";
+  }
+}
+
+/*
+ * INFO loading
+ * The open progress of every RocksDB instance, e.g.
+ *   loading:1
+ *   loading_instances_opened:4/48
+ *   db0_instance0:stage=opened,elapsed_ms=2310
+ *   db0_instance1:stage=loading_log_index,elapsed_ms=2562
+ */
+void InfoCmd::InfoLoading(std::string& info) {
+  static const char* stage_names[] = {"pending", "opening", "loading_log_index", "opened", "failed"};
+  auto progress = PSTORE.GetOpenProgress();
+  size_t opened = std::count_if(progress.begin(), progress.end(),
+                                [](const auto& item) { return item.stage == storage::OpenStage::kOpened; });
+
+  std::stringstream tmp_stream;
+  tmp_stream << "# Loading\r\n";
+  tmp_stream << "loading:" << (PSTORE.IsLoading() ? 1 : 0) << "\r\n";
+  tmp_stream << "loading_instances_opened:" << opened << "/" << progress.size() << "\r\n";
+  for (const auto& item : progress) {
+    tmp_stream << "db" << item.db << "_instance" << item.instance
+               << ":stage=" << stage_names[static_cast<int>(item.stage)] << ",elapsed_ms=" << item.elapsed_ms
+               << "\r\n";
+  }
+  info.append(tmp_stream.str());
+}
+
+/*
+ * INFO backup
+ * The running or last backup of BGBACKUP, copied bytes grow by 4MB steps
+ * Reply:
+ *   backup_in_progress:1
+ *   backup_copied_bytes:125829120
+ *   backup_last_time:1729238400
+ *   backup_last_duration_ms:5210
+ *   backup_last_status:ok
+ */
+void InfoCmd::InfoBackup(std::string& info) {
+  auto progress = PSTORE.GetBackupProgress();
+  std::stringstream tmp_stream;
+  tmp_stream << "# Backup\r\n";
+  tmp_stream << "backup_path:" << g_config.backup_path.ToString() << "\r\n";
+  tmp_stream << "backup_in_progress:" << (progress.in_progress ? 1 : 0) << "\r\n";
+  tmp_stream << "backup_copied_bytes:" << progress.copied_bytes << "\r\n";
+  tmp_stream << "backup_last_time:" << progress.last_time << "\r\n";
+  tmp_stream << "backup_last_duration_ms:" << progress.last_duration_ms << "\r\n";
+  tmp_stream << "backup_last_status:" << progress.last_status << "\r\n";
+  info.append(tmp_stream.str());
+}
+
+/*
+ * INFO convert
+ * The running or last CONVERTFORMAT, the keys grow by steps of 1000 scanned
+ * Reply:
+ *   convert_in_progress:1
+ *   convert_db:0
+ *   convert_scanned_keys:52000
+ *   convert_converted_keys:31877
+ *   convert_last_time:1729238400
+ *   convert_last_duration_ms:5210
+ *   convert_last_status:ok
+ */
+void InfoCmd::InfoConvert(std::string& info) {
+  auto progress = PSTORE.GetConvertProgress();
+  std::stringstream tmp_stream;
+  tmp_stream << "# Convert\r\n";
+  tmp_stream << "convert_in_progress:" << (progress.in_progress ? 1 : 0) << "\r\n";
+  tmp_stream << "convert_db:" << progress.db << "\r\n";
+  tmp_stream << "convert_scanned_keys:" << progress.scanned_keys << "\r\n";
+  tmp_stream << "convert_converted_keys:" << progress.converted_keys << "\r\n";
+  tmp_stream << "convert_last_time:" << progress.last_time << "\r\n";
+  tmp_stream << "convert_last_duration_ms:" << progress.last_duration_ms << "\r\n";
+  tmp_stream << "convert_last_status:" << progress.last_status << "\r\n";
+  info.append(tmp_stream.str());
+}
+
+/*
+ * INFO throttle
+ * The write throttle of every RocksDB instance, pressure is 0 to 100 and
+ * delay_us -1 while the writes are turned away
+ * Reply:
+ *   write_throttle:yes
+ *   write_throttle_waiting:0
+ *   write_throttle_overflows:0
+ *   db0_instance0:pressure=50,delay_us=1111,l0_files=28,pending_compaction_bytes=0,delayed_write_rate=8388608,stopped=0,delayed=5120,rejected=0
+ */
+void InfoCmd::InfoThrottle(std::string& info) {
+  std::stringstream tmp_stream;
+  tmp_stream << "# Throttle\r\n";
+  tmp_stream << "write_throttle:" << (g_config.write_throttle.load() ? "yes" : "no") << "\r\n";
+  tmp_stream << "write_throttle_waiting:" << g_pikiwidb->ThrottledWorkers() << "\r\n";
+  tmp_stream << "write_throttle_overflows:" << g_pikiwidb->ThrottleOverflows() << "\r\n";
+  auto all_stats = PSTORE.GetWriteThrottleStats();
+  for (size_t db = 0; db < all_stats.size(); ++db) {
+    for (size_t i = 0; i < all_stats[db].size(); ++i) {
+      const auto& stats = all_stats[db][i];
+      tmp_stream << "db" << db << "_instance" << i << ":pressure=" << stats.pressure << ",delay_us=" << stats.delay_us
+                 << ",l0_files=" << stats.metrics.l0_files
+                 << ",pending_compaction_bytes=" << stats.metrics.pending_compaction_bytes
+                 << ",delayed_write_rate=" << stats.metrics.delayed_write_rate
+                 << ",stopped=" << (stats.metrics.stopped ? 1 : 0) << ",delayed=" << stats.delayed
+                 << ",rejected=" << stats.rejected << "\r\n";
+    }
+  }
+  info.append(tmp_stream.str());
 }
 
 double InfoCmd::MethodofTotalTimeCalculation(const uint64_t time_consuming) {
@@ -442,6 +676,24 @@ void CmdDebugSegfault::DoCmd(PClient* client) {
   *ptr = 0;
 }
 
+CmdDebugWritePressure::CmdDebugWritePressure(const std::string& name, int16_t arity)
+    : BaseCmd(name, arity, kCmdFlagsAdmin, kAclCategoryAdmin) {}
+
+bool CmdDebugWritePressure::DoInitial(PClient* client) {
+  int64_t pressure = 0;
+  if (pstd::String2int(client->argv_[2], &pressure) == 0 || pressure < -1 || pressure > 100) {
+    client->SetRes(CmdRes::kInvalidParameter);
+    return false;
+  }
+  pressure_ = static_cast<int32_t>(pressure);
+  return true;
+}
+
+void CmdDebugWritePressure::DoCmd(PClient* client) {
+  PSTORE.ForceWritePressure(pressure_);
+  client->SetRes(CmdRes::kOK);
+}
+
 SortCmd::SortCmd(const std::string& name, int16_t arity)
     : BaseCmd(name, arity, kCmdFlagsAdmin | kCmdFlagsWrite, kAclCategoryAdmin) {}
 
@@ -481,6 +733,10 @@ bool SortCmd::DoInitial(PClient* client) {
       return false;
     }
   }
+  if (!store_key_.empty()) {
+    std::vector<std::string> keys{client->argv_[1], store_key_};
+    client->SetKey(keys);
+  }
 
   Status s;
   s = PSTORE.GetBackend(client->GetCurrentDB())->GetStorage()->LRange(client->Key(), 0, -1, &ret_);
@@ -515,75 +771,66 @@ bool SortCmd::DoInitial(PClient* client) {
 }
 
 void SortCmd::DoCmd(PClient* client) {
+  // ret_ owns the elements until the reply is built, the sort objects only keep views of them
   std::vector<RedisSortObject> sort_ret(ret_.size());
   for (size_t i = 0; i < ret_.size(); ++i) {
     sort_ret[i].obj = ret_[i];
   }
 
-  if (!dontsort_) {
-    for (size_t i = 0; i < ret_.size(); ++i) {
-      std::string byval;
-      if (!sortby_.empty()) {
-        auto lookup = lookupKeyByPattern(client, sortby_, ret_[i]);
-        if (!lookup.has_value()) {
-          byval = ret_[i];
-        } else {
-          byval = std::move(lookup.value());
-        }
-      } else {
-        byval = ret_[i];
-      }
+  size_t sort_size = sort_ret.size();
+  size_t start = std::min(offset_, sort_size);
+  size_t end = count_ >= sort_size - start ? sort_size : start + count_;
 
+  std::vector<std::optional<std::string>> byvals;
+  if (!dontsort_) {
+    if (!sortby_.empty()) {
+      byvals = lookupKeysByPattern(client, sortby_, sort_ret);
+    }
+    for (size_t i = 0; i < sort_size; ++i) {
+      std::string_view byval = (i < byvals.size() && byvals[i].has_value()) ? byvals[i].value() : sort_ret[i].obj;
       if (alpha_) {
-        sort_ret[i].u = byval;
-      } else {
-        double double_byval;
-        if (pstd::String2d(byval, &double_byval)) {
-          sort_ret[i].u = double_byval;
-        } else {
-          client->SetRes(CmdRes::kErrOther, "One or more scores can't be converted into double");
-          return;
-        }
+        sort_ret[i].alpha = byval;
+      } else if (!pstd::String2d(byval.data(), byval.size(), &sort_ret[i].score)) {
+        client->SetRes(CmdRes::kErrOther, "One or more scores can't be converted into double");
+        return;
       }
     }
 
-    std::sort(sort_ret.begin(), sort_ret.end(), [this](const RedisSortObject& a, const RedisSortObject& b) {
-      if (this->alpha_) {
-        std::string score_a = std::get<std::string>(a.u);
-        std::string score_b = std::get<std::string>(b.u);
-        return !this->desc_ ? score_a < score_b : score_a > score_b;
-      } else {
-        double score_a = std::get<double>(a.u);
-        double score_b = std::get<double>(b.u);
-        return !this->desc_ ? score_a < score_b : score_a > score_b;
+    auto cmp = [alpha = alpha_, desc = desc_](const RedisSortObject& a, const RedisSortObject& b) {
+      if (alpha) {
+        return !desc ? a.alpha < b.alpha : a.alpha > b.alpha;
       }
-    });
-
-    size_t sort_size = sort_ret.size();
-
-    count_ = count_ >= 0 ? count_ : sort_size;
-    offset_ = (offset_ >= 0 && offset_ < sort_size) ? offset_ : sort_size;
-    count_ = (offset_ + count_ < sort_size) ? count_ : sort_size - offset_;
-
-    size_t m_start = offset_;
-    size_t m_end = offset_ + count_;
-
-    ret_.clear();
-    if (get_patterns_.empty()) {
-      get_patterns_.emplace_back("#");
+      return !desc ? a.score < b.score : a.score > b.score;
+    };
+    // with LIMIT only the requested window has to be ordered
+    if (start > 0 || end < sort_size) {
+      if (start > 0) {
+        std::nth_element(sort_ret.begin(), sort_ret.begin() + start, sort_ret.end(), cmp);
+      }
+      std::partial_sort(sort_ret.begin() + start, sort_ret.begin() + end, sort_ret.end(), cmp);
+    } else {
+      std::sort(sort_ret.begin(), sort_ret.end(), cmp);
     }
+  }
 
-    for (; m_start < m_end; m_start++) {
-      for (const std::string& pattern : get_patterns_) {
-        std::optional<std::string> val = lookupKeyByPattern(client, pattern, sort_ret[m_start].obj);
-        if (val.has_value()) {
-          ret_.push_back(val.value());
-        } else {
-          ret_.emplace_back("");
-        }
-      }
+  std::span<const RedisSortObject> window(sort_ret.data() + start, end - start);
+  if (get_patterns_.empty()) {
+    get_patterns_.emplace_back("#");
+  }
+  std::vector<std::vector<std::optional<std::string>>> getvals;
+  getvals.reserve(get_patterns_.size());
+  for (const std::string& pattern : get_patterns_) {
+    getvals.push_back(lookupKeysByPattern(client, pattern, window));
+  }
+
+  std::vector<std::string> reply;
+  reply.reserve(window.size() * get_patterns_.size());
+  for (size_t i = 0; i < window.size(); ++i) {
+    for (auto& vals : getvals) {
+      reply.push_back(vals[i].has_value() ? std::move(vals[i].value()) : std::string());
     }
   }
+  ret_.swap(reply);
 
   if (store_key_.empty()) {
     client->AppendStringVector(ret_);
@@ -598,39 +845,55 @@ void SortCmd::DoCmd(PClient* client) {
   }
 }
 
-std::optional<std::string> SortCmd::lookupKeyByPattern(PClient* client, const std::string& pattern,
-                                                       const std::string& subst) {
+std::vector<std::optional<std::string>> SortCmd::lookupKeysByPattern(PClient* client, const std::string& pattern,
+                                                                     std::span<const RedisSortObject> objs) {
+  std::vector<std::optional<std::string>> values(objs.size());
   if (pattern == "#") {
-    return subst;
+    for (size_t i = 0; i < objs.size(); ++i) {
+      values[i] = std::string(objs[i].obj);
+    }
+    return values;
   }
 
   auto match_pos = pattern.find('*');
-  if (match_pos == std::string::npos) {
-    return std::nullopt;
+  if (match_pos == std::string::npos || objs.empty()) {
+    return values;
   }
 
   std::string field;
+  std::string key_pattern = pattern;
   auto arrow_pos = pattern.find("->", match_pos + 1);
   if (arrow_pos != std::string::npos && arrow_pos + 2 < pattern.size()) {
     field = pattern.substr(arrow_pos + 2);
+    key_pattern = pattern.substr(0, arrow_pos);
   }
 
-  std::string key = pattern.substr(0, match_pos + 1);
-  key.replace(match_pos, 1, subst);
+  std::vector<std::string> keys;
+  keys.reserve(objs.size());
+  for (const auto& obj : objs) {
+    std::string key = key_pattern;
+    key.replace(match_pos, 1, obj.obj.data(), obj.obj.size());
+    keys.push_back(std::move(key));
+  }
 
-  std::string value;
+  // one batched read per instance instead of a point read per element
+  std::vector<storage::ValueStatus> vss;
   storage::Status s;
   if (!field.empty()) {
-    s = PSTORE.GetBackend(client->GetCurrentDB())->GetStorage()->HGet(key, field, &value);
+    s = PSTORE.GetBackend(client->GetCurrentDB())->GetStorage()->HGetMultiKeys(keys, field, &vss);
   } else {
-    s = PSTORE.GetBackend(client->GetCurrentDB())->GetStorage()->Get(key, &value);
+    s = PSTORE.GetBackend(client->GetCurrentDB())->GetStorage()->MGet(keys, &vss);
   }
-
   if (!s.ok()) {
-    return std::nullopt;
+    return values;
   }
 
-  return value;
+  for (size_t i = 0; i < vss.size(); ++i) {
+    if (vss[i].status.ok()) {
+      values[i] = std::move(vss[i].value);
+    }
+  }
+  return values;
 }
 
 void SortCmd::InitialArgument() {
@@ -10,7 +10,8 @@
 #pragma once
 
 #include <optional>
-#include <variant>
+#include <span>
+#include <string_view>
 #include "base_cmd.h"
 #include "config.h"
 
@@ -20,7 +21,9 @@ const std::vector<std::string> debugHelps = {"DEBUG <subcommand> [<arg> [value]
                                              "SEGFAULT",
                                              "    Crash the server with sigsegv.",
                                              "OOM",
-                                             "    Crash the server simulating an out-of-memory error."};
+                                             "    Crash the server simulating an out-of-memory error.",
+                                             "WRITE-PRESSURE <percent>",
+                                             "    Pin the pressure of the write throttles, -1 to unpin."};
 
 namespace pikiwidb {
 const std::string kCmdNameMonitor = "monitor";
@@ -73,6 +76,32 @@ class FlushdbCmd : public BaseCmd {
   void DoCmd(PClient* client) override;
 };
 
+// Moves the hashes, sets and zsets of the DB to the compact data format in the
+// background, INFO convert reports its progress
+class ConvertformatCmd : public BaseCmd {
+ public:
+  ConvertformatCmd(const std::string& name, int16_t arity);
+
+ protected:
+  bool DoInitial(PClient* client) override;
+
+ private:
+  void DoCmd(PClient* client) override;
+};
+
+// Starts an incremental backup of every DB to backup-path, INFO backup
+// reports its progress
+class BgbackupCmd : public BaseCmd {
+ public:
+  BgbackupCmd(const std::string& name, int16_t arity);
+
+ protected:
+  bool DoInitial(PClient* client) override;
+
+ private:
+  void DoCmd(PClient* client) override;
+};
+
 class FlushallCmd : public BaseCmd {
  public:
   FlushallCmd(const std::string& name, int16_t arity);
@@ -136,7 +165,11 @@ class InfoCmd : public BaseCmd {
     kInfo,
     kInfoAll,
     kInfoCommandStats,
-    kInfoRaft
+    kInfoRaft,
+    kInfoLoading,
+    kInfoBackup,
+    kInfoConvert,
+    kInfoThrottle
   };
 
   InfoSection info_section_;
@@ -148,6 +181,10 @@ class InfoCmd : public BaseCmd {
   const static std::string kDataSection;
   const static std::string kCommandStatsSection;
   const static std::string kRaftSection;
+  const static std::string kLoadingSection;
+  const static std::string kBackupSection;
+  const static std::string kConvertSection;
+  const static std::string kThrottleSection;
 
   const std::unordered_map<std::string, InfoSection> sectionMap = {{kAllSection, kInfoAll},
                                                                    {kServerSection, kInfoServer},
@@ -155,6 +192,10 @@ class InfoCmd : public BaseCmd {
                                                                    {kCPUSection, kInfoCPU},
                                                                    {kDataSection, kInfoData},
                                                                    {kRaftSection, kInfoRaft},
+                                                                   {kLoadingSection, kInfoLoading},
+                                                                   {kBackupSection, kInfoBackup},
+                                                                   {kConvertSection, kInfoConvert},
+                                                                   {kThrottleSection, kInfoThrottle},
                                                                    {kCommandStatsSection, kInfoCommandStats}};
 
   void InfoServer(std::string& info);
@@ -162,6 +203,10 @@ class InfoCmd : public BaseCmd {
   void InfoCPU(std::string& info);
   void InfoRaft(std::string& info);
   void InfoData(std::string& info);
+  void InfoLoading(std::string& info);
+  void InfoBackup(std::string& info);
+  void InfoConvert(std::string& info);
+  void InfoThrottle(std::string& info);
   void InfoCommandStats(PClient* client, std::string& info);
   std::string FormatCommandStatLine(const CommandStatistics& stats);
   double MethodofTotalTimeCalculation(const uint64_t time_consuming);
@@ -214,6 +259,19 @@ class CmdDebugSegfault : public BaseCmd {
   void DoCmd(PClient* client) override;
 };
 
+class CmdDebugWritePressure : public BaseCmd {
+ public:
+  CmdDebugWritePressure(const std::string& name, int16_t arity);
+
+ protected:
+  bool DoInitial(PClient* client) override;
+
+ private:
+  void DoCmd(PClient* client) override;
+
+  int32_t pressure_ = -1;
+};
+
 class MonitorCmd : public BaseCmd {
  public:
   MonitorCmd(const std::string& name, int arity);
@@ -235,14 +293,17 @@ class SortCmd : public BaseCmd {
  private:
   void DoCmd(PClient* client) override;
 
-  void InitialArgument();
-  std::optional<std::string> lookupKeyByPattern(PClient* client, const std::string& pattern, const std::string& subst);
-
   struct RedisSortObject {
-    std::string obj;
-    std::variant<double, std::string> u;
+    std::string_view obj;
+    double score = 0;        // parsed weight, used unless ALPHA
+    std::string_view alpha;  // weight compared as string with ALPHA, views obj or a looked up value
   };
 
+  void InitialArgument();
+  // resolve pattern for every object with batched reads, std::nullopt when the key or field does not exist
+  std::vector<std::optional<std::string>> lookupKeysByPattern(PClient* client, const std::string& pattern,
+                                                              std::span<const RedisSortObject> objs);
+
   int desc_ = 0;
   int alpha_ = 0;
   size_t offset_ = 0;
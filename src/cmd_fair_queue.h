@@ -0,0 +1,281 @@
+// Copyright (c) 2024-present, OpenAtom Foundation, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory
+
+/*
+  Weighted fair queuing of the commands across the DBs.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace pikiwidb {
+
+class CmdThreadPoolTask;
+
+// The share and the limits of one DB, 0 for a limit means unlimited
+struct CmdQosLimits {
+  int64_t weight = 1;      // commands served per round, relative to the other DBs
+  int64_t ops_limit = 0;   // commands per second
+  int64_t bytes_limit = 0;  // request bytes per second
+  int64_t max_queued = 0;  // commands waiting, more are rejected
+};
+
+struct CmdQosStats {
+  int db = 0;
+  int64_t weight = 1;
+  size_t queued = 0;
+  uint64_t dispatched = 0;
+  uint64_t rejected = 0;   // turned away because max_queued was reached
+  uint64_t throttled = 0;  // times the DB was passed over for its rate limits
+  uint64_t wait_us = 0;    // total time the dispatched commands waited in the queue
+};
+
+// Deficit round robin over one queue per DB: each round a DB with commands
+// waiting may dispatch up to its weight, as long as its token buckets allow.
+// A batch job on one DB then only delays the others by its share instead of
+// by its whole backlog. Not thread safe, the pool calls it under its mutex.
+// Task needs Db() and Bytes(), see CmdThreadPoolTask.
+template <typename Task>
+class WeightedFairQueue {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  // Limits of DB i are limits[i], the DBs past the end get the defaults
+  void SetLimits(std::vector<CmdQosLimits> limits);
+
+  // Returns false when the DB has max_queued commands waiting already, admit
+  // false skips that check for the commands which must not be turned away
+  bool Push(const std::shared_ptr<Task> &task, bool admit = true);
+
+  // Moves up to max commands to out, returns how many. It may return 0 with
+  // commands waiting when the DBs holding them are over their rate limits.
+  size_t Pop(size_t max, std::vector<std::shared_ptr<Task>> *out);
+
+  // When the first DB over its rate limits has the tokens for its next command,
+  // for Pop to be tried again. Clock::time_point::max() with nothing waiting.
+  Clock::time_point NextReady() const;
+
+  inline size_t Size() const { return size_; }
+
+  inline bool Empty() const { return size_ == 0; }
+
+  void Clear();
+
+  // The DBs that have seen commands
+  std::vector<CmdQosStats> Stats() const;
+
+ private:
+  struct Class {
+    CmdQosLimits limits;
+    std::deque<std::pair<std::shared_ptr<Task>, Clock::time_point>> tasks;
+    int64_t deficit = 0;
+    bool active = false;  // in active_
+    double op_tokens = 0;
+    double byte_tokens = 0;
+    Clock::time_point refill;
+    uint64_t dispatched = 0;
+    uint64_t rejected = 0;
+    uint64_t throttled = 0;
+    uint64_t wait_us = 0;
+  };
+
+  Class &GetClass(int db);
+
+  static void ResetTokens(Class &cls);
+
+  // refills the buckets and takes the tokens of a command of bytes when there are enough
+  static bool TakeTokens(Class &cls, size_t bytes, Clock::time_point now);
+
+  std::vector<CmdQosLimits> limits_;
+  std::vector<Class> classes_;  // by DB index
+  std::vector<int> active_;     // the DBs with commands waiting, in round robin order
+  size_t cursor_ = 0;           // the DB of active_ served next
+  size_t size_ = 0;
+};
+
+using CmdFairQueue = WeightedFairQueue<CmdThreadPoolTask>;
+
+template <typename Task>
+void WeightedFairQueue<Task>::ResetTokens(Class &cls) {
+  cls.limits.weight = std::max<int64_t>(cls.limits.weight, 1);
+  // the buckets hold one second worth of tokens, that is the burst a DB may have
+  cls.op_tokens = static_cast<double>(cls.limits.ops_limit);
+  cls.byte_tokens = static_cast<double>(cls.limits.bytes_limit);
+}
+
+template <typename Task>
+void WeightedFairQueue<Task>::SetLimits(std::vector<CmdQosLimits> limits) {
+  limits_ = std::move(limits);
+  for (size_t db = 0; db < classes_.size(); ++db) {
+    auto &cls = classes_[db];
+    cls.limits = db < limits_.size() ? limits_[db] : CmdQosLimits{};
+    ResetTokens(cls);
+    cls.deficit = std::min(cls.deficit, cls.limits.weight);
+  }
+}
+
+template <typename Task>
+typename WeightedFairQueue<Task>::Class &WeightedFairQueue<Task>::GetClass(int db) {
+  auto index = static_cast<size_t>(std::max(db, 0));
+  if (index >= classes_.size()) {
+    auto old = classes_.size();
+    classes_.resize(index + 1);
+    auto now = Clock::now();
+    for (auto i = old; i < classes_.size(); ++i) {
+      auto &cls = classes_[i];
+      cls.limits = i < limits_.size() ? limits_[i] : CmdQosLimits{};
+      ResetTokens(cls);
+      cls.refill = now;
+    }
+  }
+  return classes_[index];
+}
+
+template <typename Task>
+bool WeightedFairQueue<Task>::Push(const std::shared_ptr<Task> &task, bool admit) {
+  auto &cls = GetClass(task->Db());
+  if (admit && cls.limits.max_queued > 0 && cls.tasks.size() >= static_cast<size_t>(cls.limits.max_queued)) {
+    ++cls.rejected;
+    return false;
+  }
+  cls.tasks.emplace_back(task, Clock::now());
+  ++size_;
+  if (!cls.active) {
+    cls.active = true;
+    cls.deficit = 0;
+    active_.push_back(std::max(task->Db(), 0));
+  }
+  return true;
+}
+
+template <typename Task>
+bool WeightedFairQueue<Task>::TakeTokens(Class &cls, size_t bytes, Clock::time_point now) {
+  const auto &limits = cls.limits;
+  if (limits.ops_limit <= 0 && limits.bytes_limit <= 0) {
+    return true;
+  }
+  double elapsed = std::chrono::duration<double>(now - cls.refill).count();
+  cls.refill = now;
+  if (limits.ops_limit > 0) {
+    cls.op_tokens = std::min(cls.op_tokens + elapsed * limits.ops_limit, static_cast<double>(limits.ops_limit));
+    if (cls.op_tokens < 1) {
+      return false;
+    }
+  }
+  if (limits.bytes_limit > 0) {
+    cls.byte_tokens =
+        std::min(cls.byte_tokens + elapsed * limits.bytes_limit, static_cast<double>(limits.bytes_limit));
+    // a request larger than the bucket still goes once the bucket is positive,
+    // the debt it leaves holds the DB back until it is paid
+    if (cls.byte_tokens <= 0) {
+      return false;
+    }
+    cls.byte_tokens -= static_cast<double>(bytes);
+  }
+  if (limits.ops_limit > 0) {
+    cls.op_tokens -= 1;
+  }
+  return true;
+}
+
+template <typename Task>
+size_t WeightedFairQueue<Task>::Pop(size_t max, std::vector<std::shared_ptr<Task>> *out) {
+  size_t popped = 0;
+  size_t idle = 0;  // the DBs visited in a row that could not dispatch anything
+  auto now = Clock::now();
+  while (popped < max && !active_.empty() && idle < active_.size()) {
+    if (cursor_ >= active_.size()) {
+      cursor_ = 0;
+    }
+    auto &cls = classes_[active_[cursor_]];
+    if (cls.deficit <= 0) {
+      cls.deficit += cls.limits.weight;
+    }
+
+    bool served = false;
+    while (popped < max && cls.deficit > 0 && !cls.tasks.empty()) {
+      auto &[task, enqueued] = cls.tasks.front();
+      if (!TakeTokens(cls, task->Bytes(), now)) {
+        ++cls.throttled;
+        break;
+      }
+      cls.wait_us += std::chrono::duration_cast<std::chrono::microseconds>(now - enqueued).count();
+      ++cls.dispatched;
+      --cls.deficit;
+      out->emplace_back(std::move(task));
+      cls.tasks.pop_front();
+      --size_;
+      ++popped;
+      served = true;
+    }
+
+    if (cls.tasks.empty()) {
+      // the next DB moves into the cursor
+      cls.active = false;
+      cls.deficit = 0;
+      active_.erase(active_.begin() + static_cast<std::ptrdiff_t>(cursor_));
+    } else if (popped < max || cls.deficit <= 0) {
+      // stay on this DB if only max stopped it, the next Pop goes on with its share
+      ++cursor_;
+    }
+    idle = served ? 0 : idle + 1;
+  }
+  return popped;
+}
+
+template <typename Task>
+typename WeightedFairQueue<Task>::Clock::time_point WeightedFairQueue<Task>::NextReady() const {
+  auto next = Clock::time_point::max();
+  for (auto db : active_) {
+    const auto &cls = classes_[db];
+    // the buckets fill up linearly from their level at the last refill
+    double wait = 0;
+    if (cls.limits.ops_limit > 0 && cls.op_tokens < 1) {
+      wait = (1 - cls.op_tokens) / static_cast<double>(cls.limits.ops_limit);
+    }
+    if (cls.limits.bytes_limit > 0 && cls.byte_tokens <= 0) {
+      wait = std::max(wait, -cls.byte_tokens / static_cast<double>(cls.limits.bytes_limit));
+    }
+    // rounded up, a wake up just short of the tokens would only go back to sleep
+    auto ready = cls.refill + std::chrono::ceil<std::chrono::microseconds>(std::chrono::duration<double>(wait)) +
+                 std::chrono::microseconds(1);
+    next = std::min(next, ready);
+  }
+  return next;
+}
+
+template <typename Task>
+void WeightedFairQueue<Task>::Clear() {
+  for (auto &cls : classes_) {
+    cls.tasks.clear();
+    cls.active = false;
+    cls.deficit = 0;
+  }
+  active_.clear();
+  cursor_ = 0;
+  size_ = 0;
+}
+
+template <typename Task>
+std::vector<CmdQosStats> WeightedFairQueue<Task>::Stats() const {
+  std::vector<CmdQosStats> stats;
+  for (size_t db = 0; db < classes_.size(); ++db) {
+    const auto &cls = classes_[db];
+    if (cls.dispatched == 0 && cls.rejected == 0 && cls.tasks.empty()) {
+      continue;
+    }
+    stats.push_back({static_cast<int>(db), cls.limits.weight, cls.tasks.size(), cls.dispatched, cls.rejected,
+                     cls.throttled, cls.wait_us});
+  }
+  return stats;
+}
+
+}  // namespace pikiwidb
@@ -0,0 +1,484 @@
+// Copyright (c) 2024-present, OpenAtom Foundation, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory
+
+/*
+  Implemented a set of features related to geo sets.
+ */
+
+#include "cmd_geo.h"
+
+#include <algorithm>
+
+#include "fmt/core.h"
+#include "pstd/pstd_string.h"
+#include "store.h"
+
+namespace pikiwidb {
+
+// how many members one ZRangebyscore call of GEOSEARCH reads from a cell
+static constexpr int64_t kGeoScanBatch = 256;
+
+struct GeoPoint {
+  std::string member;
+  double score = 0;
+  double lon = 0;
+  double lat = 0;
+  double dist = 0;
+};
+
+// meters per unit, 0 for an unknown unit
+static double ParseGeoUnit(const std::string& unit) {
+  if (strcasecmp(unit.data(), "m") == 0) {
+    return 1;
+  } else if (strcasecmp(unit.data(), "km") == 0) {
+    return 1000;
+  } else if (strcasecmp(unit.data(), "ft") == 0) {
+    return 0.3048;
+  } else if (strcasecmp(unit.data(), "mi") == 0) {
+    return 1609.34;
+  }
+  return 0;
+}
+
+static void AppendBulk(PClient* client, const std::string& value) {
+  client->AppendStringLen(static_cast<int64_t>(value.size()));
+  client->AppendContent(value);
+}
+
+static void AppendCoord(PClient* client, double lon, double lat) {
+  client->AppendArrayLen(2);
+  AppendBulk(client, fmt::format("{:.17g}", lon));
+  AppendBulk(client, fmt::format("{:.17g}", lat));
+}
+
+static void SetStorageError(PClient* client, const storage::Status& s) {
+  if (s.IsInvalidArgument()) {
+    client->SetRes(CmdRes::kMultiKey);
+  } else {
+    client->SetRes(CmdRes::kErrOther, s.ToString());
+  }
+}
+
+// Scans the cells covering the shape in batches and keeps the members inside
+// it. With a limit the scan stops as soon as that many members were found.
+static storage::Status GeoScan(storage::Storage* db_storage, const std::string& key, const GeoShape& shape,
+                               size_t limit, std::vector<GeoPoint>* points) {
+  std::vector<storage::ScoreMember> score_members;
+  std::vector<double> lons;
+  std::vector<double> lats;
+  std::vector<double> dists;
+  std::vector<uint8_t> keep;
+  for (const auto& [min, max] : GeoCoverShape(shape)) {
+    double from = min;
+    int64_t offset = 0;
+    while (true) {
+      storage::Status s = db_storage->ZRangebyscore(key, from, max, true, false, kGeoScanBatch, offset, &score_members);
+      if (!s.ok()) {
+        return s;
+      }
+
+      size_t n = score_members.size();
+      lons.resize(n);
+      lats.resize(n);
+      dists.resize(n);
+      keep.resize(n);
+      for (size_t i = 0; i < n; i++) {
+        GeoHashDecodeCenter(static_cast<uint64_t>(score_members[i].score), &lons[i], &lats[i]);
+      }
+      GeoFilterBatch(shape, lons.data(), lats.data(), n, dists.data(), keep.data());
+      for (size_t i = 0; i < n; i++) {
+        if (!keep[i]) {
+          continue;
+        }
+        points->push_back({std::move(score_members[i].member), score_members[i].score, lons[i], lats[i], dists[i]});
+        if (limit > 0 && points->size() >= limit) {
+          return storage::Status::OK();
+        }
+      }
+      if (n < static_cast<size_t>(kGeoScanBatch)) {
+        break;
+      }
+
+      // resume after the last member, several members may share its score
+      double last = score_members.back().score;
+      int64_t same = 0;
+      for (auto it = score_members.rbegin(); it != score_members.rend() && it->score == last; ++it) {
+        same++;
+      }
+      if (last == from) {
+        offset += same;
+      } else {
+        from = last;
+        offset = same;
+      }
+    }
+  }
+  return storage::Status::OK();
+}
+
+GeoAddCmd::GeoAddCmd(const std::string& name, int16_t arity)
+    : BaseCmd(name, arity, kCmdFlagsWrite, kAclCategoryWrite | kAclCategoryGeo) {}
+
+bool GeoAddCmd::DoInitial(PClient* client) {
+  client->SetKey(client->argv_[1]);
+  return true;
+}
+
+// GEOADD key [NX | XX] [CH] longitude latitude member [longitude latitude member ...]
+void GeoAddCmd::DoCmd(PClient* client) {
+  bool nx = false;
+  bool xx = false;
+  bool ch = false;
+  size_t index = 2;
+  for (; index < client->argv_.size(); index++) {
+    const auto& opt = client->argv_[index];
+    if (strcasecmp(opt.data(), "nx") == 0) {
+      nx = true;
+    } else if (strcasecmp(opt.data(), "xx") == 0) {
+      xx = true;
+    } else if (strcasecmp(opt.data(), "ch") == 0) {
+      ch = true;
+    } else {
+      break;
+    }
+  }
+  size_t remain = client->argv_.size() - index;
+  if (remain == 0 || remain % 3 != 0 || (nx && xx)) {
+    client->SetRes(CmdRes::kSyntaxErr);
+    return;
+  }
+
+  std::vector<storage::ScoreMember> score_members;
+  for (; index < client->argv_.size(); index += 3) {
+    double lon = 0;
+    double lat = 0;
+    if (pstd::String2d(client->argv_[index].data(), client->argv_[index].size(), &lon) == 0 ||
+        pstd::String2d(client->argv_[index + 1].data(), client->argv_[index + 1].size(), &lat) == 0) {
+      client->SetRes(CmdRes::kInvalidFloat);
+      return;
+    }
+    if (!GeoCoordValid(lon, lat)) {
+      client->SetRes(CmdRes::kErrOther, fmt::format("invalid longitude,latitude pair {:.6f},{:.6f}", lon, lat));
+      return;
+    }
+    score_members.push_back({static_cast<double>(GeoHashEncode(lon, lat)), client->argv_[index + 2]});
+  }
+
+  auto& db_storage = PSTORE.GetBackend(client->GetCurrentDB())->GetStorage();
+  int64_t changed = 0;
+  if (nx || xx || ch) {
+    // the options need the current scores, members that must not be touched are dropped
+    std::vector<storage::ScoreMember> filtered;
+    for (auto& score_member : score_members) {
+      double old_score = 0;
+      storage::Status s = db_storage->ZScore(client->Key(), score_member.member, &old_score);
+      if (!s.ok() && !s.IsNotFound()) {
+        SetStorageError(client, s);
+        return;
+      }
+      bool exists = s.ok();
+      if ((nx && exists) || (xx && !exists)) {
+        continue;
+      }
+      if (exists && old_score != score_member.score) {
+        changed++;
+      }
+      filtered.push_back(std::move(score_member));
+    }
+    score_members.swap(filtered);
+  }
+
+  int32_t added = 0;
+  if (!score_members.empty()) {
+    storage::Status s = db_storage->ZAdd(client->Key(), score_members, &added);
+    if (!s.ok()) {
+      SetStorageError(client, s);
+      return;
+    }
+  }
+  client->AppendInteger(ch ? added + changed : added);
+}
+
+GeoPosCmd::GeoPosCmd(const std::string& name, int16_t arity)
+    : BaseCmd(name, arity, kCmdFlagsReadonly, kAclCategoryRead | kAclCategoryGeo) {}
+
+bool GeoPosCmd::DoInitial(PClient* client) {
+  client->SetKey(client->argv_[1]);
+  return true;
+}
+
+// GEOPOS key [member [member ...]]
+void GeoPosCmd::DoCmd(PClient* client) {
+  auto& db_storage = PSTORE.GetBackend(client->GetCurrentDB())->GetStorage();
+  std::vector<double> scores;
+  std::vector<bool> found;
+  for (size_t i = 2; i < client->argv_.size(); i++) {
+    double score = 0;
+    storage::Status s = db_storage->ZScore(client->Key(), client->argv_[i], &score);
+    if (!s.ok() && !s.IsNotFound()) {
+      SetStorageError(client, s);
+      return;
+    }
+    scores.push_back(score);
+    found.push_back(s.ok());
+  }
+
+  client->AppendArrayLen(static_cast<int64_t>(scores.size()));
+  for (size_t i = 0; i < scores.size(); i++) {
+    if (!found[i]) {
+      client->AppendArrayLen(-1);
+      continue;
+    }
+    double lon = 0;
+    double lat = 0;
+    GeoHashDecodeCenter(static_cast<uint64_t>(scores[i]), &lon, &lat);
+    AppendCoord(client, lon, lat);
+  }
+}
+
+GeoDistCmd::GeoDistCmd(const std::string& name, int16_t arity)
+    : BaseCmd(name, arity, kCmdFlagsReadonly, kAclCategoryRead | kAclCategoryGeo) {}
+
+bool GeoDistCmd::DoInitial(PClient* client) {
+  client->SetKey(client->argv_[1]);
+  return true;
+}
+
+// GEODIST key member1 member2 [M | KM | FT | MI]
+void GeoDistCmd::DoCmd(PClient* client) {
+  if (client->argv_.size() > 5) {
+    client->SetRes(CmdRes::kSyntaxErr);
+    return;
+  }
+  double unit = 1;
+  if (client->argv_.size() == 5) {
+    unit = ParseGeoUnit(client->argv_[4]);
+    if (unit == 0) {
+      client->SetRes(CmdRes::kErrOther, "unsupported unit provided. please use M, KM, FT, MI");
+      return;
+    }
+  }
+
+  auto& db_storage = PSTORE.GetBackend(client->GetCurrentDB())->GetStorage();
+  double scores[2] = {0, 0};
+  for (int i = 0; i < 2; i++) {
+    storage::Status s = db_storage->ZScore(client->Key(), client->argv_[2 + i], &scores[i]);
+    if (s.IsNotFound()) {
+      client->AppendStringLen(-1);
+      return;
+    } else if (!s.ok()) {
+      SetStorageError(client, s);
+      return;
+    }
+  }
+
+  double lon1 = 0;
+  double lat1 = 0;
+  double lon2 = 0;
+  double lat2 = 0;
+  GeoHashDecodeCenter(static_cast<uint64_t>(scores[0]), &lon1, &lat1);
+  GeoHashDecodeCenter(static_cast<uint64_t>(scores[1]), &lon2, &lat2);
+  AppendBulk(client, fmt::format("{:.4f}", GeoDistance(lon1, lat1, lon2, lat2) / unit));
+}
+
+GeoSearchCmd::GeoSearchCmd(const std::string& name, int16_t arity)
+    : BaseCmd(name, arity, kCmdFlagsReadonly, kAclCategoryRead | kAclCategoryGeo) {}
+
+bool GeoSearchCmd::DoInitial(PClient* client) {
+  client->SetKey(client->argv_[1]);
+  return true;
+}
+
+// GEOSEARCH key <FROMMEMBER member | FROMLONLAT longitude latitude>
+//   <BYRADIUS radius <M | KM | FT | MI> | BYBOX width height <M | KM | FT | MI>>
+//   [ASC | DESC] [COUNT count [ANY]] [WITHCOORD] [WITHDIST] [WITHHASH]
+void GeoSearchCmd::DoCmd(PClient* client) {
+  const auto& argv = client->argv_;
+  GeoShape shape;
+  std::string from_member;
+  bool from_set = false;
+  bool from_lonlat = false;
+  bool by_set = false;
+  double unit = 1;
+  int sort = 0;  // 1 for ASC, -1 for DESC
+  int64_t count = 0;
+  bool any = false;
+  bool with_coord = false;
+  bool with_dist = false;
+  bool with_hash = false;
+
+  auto parse_double = [&](size_t i, double* value) {
+    return pstd::String2d(argv[i].data(), argv[i].size(), value) != 0;
+  };
+  for (size_t i = 2; i < argv.size(); i++) {
+    const char* opt = argv[i].data();
+    size_t left = argv.size() - i - 1;
+    if (strcasecmp(opt, "frommember") == 0 && left >= 1) {
+      if (from_set) {
+        client->SetRes(CmdRes::kErrOther, "exactly one of FROMMEMBER or FROMLONLAT can be specified for GEOSEARCH");
+        return;
+      }
+      from_set = true;
+      from_member = argv[++i];
+    } else if (strcasecmp(opt, "fromlonlat") == 0 && left >= 2) {
+      if (from_set) {
+        client->SetRes(CmdRes::kErrOther, "exactly one of FROMMEMBER or FROMLONLAT can be specified for GEOSEARCH");
+        return;
+      }
+      if (!parse_double(i + 1, &shape.lon) || !parse_double(i + 2, &shape.lat)) {
+        client->SetRes(CmdRes::kInvalidFloat);
+        return;
+      }
+      if (!GeoCoordValid(shape.lon, shape.lat)) {
+        client->SetRes(CmdRes::kErrOther,
+                       fmt::format("invalid longitude,latitude pair {:.6f},{:.6f}", shape.lon, shape.lat));
+        return;
+      }
+      from_set = true;
+      from_lonlat = true;
+      i += 2;
+    } else if (strcasecmp(opt, "byradius") == 0 && left >= 2) {
+      if (by_set) {
+        client->SetRes(CmdRes::kErrOther, "exactly one of BYRADIUS and BYBOX can be specified for GEOSEARCH");
+        return;
+      }
+      if (!parse_double(i + 1, &shape.radius)) {
+        client->SetRes(CmdRes::kErrOther, "need numeric radius");
+        return;
+      }
+      if (shape.radius < 0) {
+        client->SetRes(CmdRes::kErrOther, "radius cannot be negative");
+        return;
+      }
+      unit = ParseGeoUnit(argv[i + 2]);
+      shape.type = GeoShape::kRadius;
+      by_set = true;
+      i += 2;
+    } else if (strcasecmp(opt, "bybox") == 0 && left >= 3) {
+      if (by_set) {
+        client->SetRes(CmdRes::kErrOther, "exactly one of BYRADIUS and BYBOX can be specified for GEOSEARCH");
+        return;
+      }
+      if (!parse_double(i + 1, &shape.width) || !parse_double(i + 2, &shape.height)) {
+        client->SetRes(CmdRes::kInvalidFloat);
+        return;
+      }
+      if (shape.width < 0 || shape.height < 0) {
+        client->SetRes(CmdRes::kErrOther, "height or width cannot be negative");
+        return;
+      }
+      unit = ParseGeoUnit(argv[i + 3]);
+      shape.type = GeoShape::kBox;
+      by_set = true;
+      i += 3;
+    } else if (strcasecmp(opt, "asc") == 0) {
+      sort = 1;
+    } else if (strcasecmp(opt, "desc") == 0) {
+      sort = -1;
+    } else if (strcasecmp(opt, "count") == 0 && left >= 1) {
+      if (pstd::String2int(argv[i + 1], &count) == 0 || count <= 0) {
+        client->SetRes(CmdRes::kErrOther, "COUNT must be > 0");
+        return;
+      }
+      i++;
+      if (i + 1 < argv.size() && strcasecmp(argv[i + 1].data(), "any") == 0) {
+        any = true;
+        i++;
+      }
+    } else if (strcasecmp(opt, "withcoord") == 0) {
+      with_coord = true;
+    } else if (strcasecmp(opt, "withdist") == 0) {
+      with_dist = true;
+    } else if (strcasecmp(opt, "withhash") == 0) {
+      with_hash = true;
+    } else {
+      client->SetRes(CmdRes::kSyntaxErr);
+      return;
+    }
+  }
+  if (!from_set) {
+    client->SetRes(CmdRes::kErrOther, "exactly one of FROMMEMBER or FROMLONLAT can be specified for GEOSEARCH");
+    return;
+  }
+  if (!by_set) {
+    client->SetRes(CmdRes::kErrOther, "exactly one of BYRADIUS and BYBOX can be specified for GEOSEARCH");
+    return;
+  }
+  if (unit == 0) {
+    client->SetRes(CmdRes::kErrOther, "unsupported unit provided. please use M, KM, FT, MI");
+    return;
+  }
+  shape.radius *= unit;
+  shape.width *= unit;
+  shape.height *= unit;
+
+  auto& db_storage = PSTORE.GetBackend(client->GetCurrentDB())->GetStorage();
+  if (!from_lonlat) {
+    double score = 0;
+    storage::Status s = db_storage->ZScore(client->Key(), from_member, &score);
+    if (s.IsNotFound()) {
+      int32_t card = 0;
+      s = db_storage->ZCard(client->Key(), &card);
+      if (s.ok() && card > 0) {
+        client->SetRes(CmdRes::kErrOther, "could not decode requested zset member");
+      } else if (s.ok() || s.IsNotFound()) {
+        client->AppendArrayLen(0);
+      } else {
+        SetStorageError(client, s);
+      }
+      return;
+    } else if (!s.ok()) {
+      SetStorageError(client, s);
+      return;
+    }
+    GeoHashDecodeCenter(static_cast<uint64_t>(score), &shape.lon, &shape.lat);
+  }
+
+  // COUNT ANY may stop at the first matches, otherwise all of them are needed to pick the nearest
+  std::vector<GeoPoint> points;
+  storage::Status s = GeoScan(db_storage.get(), client->Key(), shape, any ? static_cast<size_t>(count) : 0, &points);
+  if (!s.ok() && !s.IsNotFound()) {
+    SetStorageError(client, s);
+    return;
+  }
+
+  if (count > 0 && !any && sort == 0) {
+    sort = 1;
+  }
+  auto nearer = [](const GeoPoint& a, const GeoPoint& b) { return a.dist < b.dist; };
+  auto farther = [](const GeoPoint& a, const GeoPoint& b) { return a.dist > b.dist; };
+  size_t limit = count > 0 ? std::min(points.size(), static_cast<size_t>(count)) : points.size();
+  if (sort != 0) {
+    if (limit < points.size()) {
+      std::partial_sort(points.begin(), points.begin() + static_cast<int64_t>(limit), points.end(),
+                        sort > 0 ? +nearer : +farther);
+    } else {
+      std::sort(points.begin(), points.end(), sort > 0 ? +nearer : +farther);
+    }
+  }
+  points.resize(limit);
+
+  client->AppendArrayLen(static_cast<int64_t>(points.size()));
+  int64_t fields = with_coord + with_dist + with_hash;
+  for (const auto& point : points) {
+    if (fields == 0) {
+      AppendBulk(client, point.member);
+      continue;
+    }
+    client->AppendArrayLen(fields + 1);
+    AppendBulk(client, point.member);
+    if (with_dist) {
+      AppendBulk(client, fmt::format("{:.4f}", point.dist / unit));
+    }
+    if (with_hash) {
+      client->AppendInteger(static_cast<int64_t>(point.score));
+    }
+    if (with_coord) {
+      AppendCoord(client, point.lon, point.lat);
+    }
+  }
+}
+
+}  // namespace pikiwidb
@@ -0,0 +1,61 @@
+// Copyright (c) 2024-present, OpenAtom Foundation, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory
+
+/*
+  Defined a set of features related to geo sets, which are zsets scored by
+  the geohash of their members.
+ */
+
+#pragma once
+#include "base_cmd.h"
+#include "geohash.h"
+
+namespace pikiwidb {
+
+class GeoAddCmd : public BaseCmd {
+ public:
+  GeoAddCmd(const std::string &name, int16_t arity);
+
+ protected:
+  bool DoInitial(PClient *client) override;
+
+ private:
+  void DoCmd(PClient *client) override;
+};
+
+class GeoPosCmd : public BaseCmd {
+ public:
+  GeoPosCmd(const std::string &name, int16_t arity);
+
+ protected:
+  bool DoInitial(PClient *client) override;
+
+ private:
+  void DoCmd(PClient *client) override;
+};
+
+class GeoDistCmd : public BaseCmd {
+ public:
+  GeoDistCmd(const std::string &name, int16_t arity);
+
+ protected:
+  bool DoInitial(PClient *client) override;
+
+ private:
+  void DoCmd(PClient *client) override;
+};
+
+class GeoSearchCmd : public BaseCmd {
+ public:
+  GeoSearchCmd(const std::string &name, int16_t arity);
+
+ protected:
+  bool DoInitial(PClient *client) override;
+
+ private:
+  void DoCmd(PClient *client) override;
+};
+
+}  // namespace pikiwidb
@@ -242,7 +242,8 @@ RenameCmd::RenameCmd(const std::string& name, int16_t arity)
     : BaseCmd(name, arity, kCmdFlagsWrite, kAclCategoryWrite | kAclCategoryKeyspace) {}
 
 bool RenameCmd::DoInitial(PClient* client) {
-  client->SetKey(client->argv_[1]);
+  std::vector<std::string> keys{client->argv_[1], client->argv_[2]};
+  client->SetKey(keys);
   return true;
 }
 
@@ -261,7 +262,8 @@ RenameNXCmd::RenameNXCmd(const std::string& name, int16_t arity)
     : BaseCmd(name, arity, kCmdFlagsWrite, kAclCategoryWrite | kAclCategoryKeyspace) {}
 
 bool RenameNXCmd::DoInitial(PClient* client) {
-  client->SetKey(client->argv_[1]);
+  std::vector<std::string> keys{client->argv_[1], client->argv_[2]};
+  client->SetKey(keys);
   return true;
 }
 
@@ -313,6 +313,7 @@ bool BitOpCmd::DoInitial(PClient* client) {
     client->SetRes(CmdRes::kSyntaxErr, "operation error");
     return false;
   }
+  client->SetKey(client->argv_[2]);
   return true;
 }
 
@@ -66,6 +66,8 @@ bool RPoplpushCmd::DoInitial(PClient* client) {
   }
   source_ = client->argv_[1];
   receiver_ = client->argv_[2];
+  std::vector<std::string> keys{source_, receiver_};
+  client->SetKey(keys);
   return true;
 }
 
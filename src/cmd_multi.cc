@@ -0,0 +1,157 @@
+// Copyright (c) 2024-present, OpenAtom Foundation, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory
+
+/*
+  Implemented optimistic transactions: MULTI/EXEC/DISCARD/WATCH/UNWATCH.
+
+  WATCH records the version of a key in the DB's watch table. Writes bump the
+  versions of watched keys, and EXEC aborts with a null reply if any of them
+  changed. EXEC holds the exclusive lock of every DB it may touch, so the
+  queued commands run without interleaving with other clients.
+ */
+
+#include "cmd_multi.h"
+
+#include <algorithm>
+
+#include "cmd_table_manager.h"
+#include "config.h"
+#include "pstd/pstd_defer.h"
+#include "pstd_string.h"
+#include "store.h"
+
+namespace pikiwidb {
+
+MultiCmd::MultiCmd(const std::string& name, int16_t arity)
+    : BaseCmd(name, arity, kCmdFlagsNoMulti | kCmdFlagsFast, kAclCategoryTransaction | kAclCategoryFast) {}
+
+bool MultiCmd::DoInitial(PClient* client) { return true; }
+
+void MultiCmd::DoCmd(PClient* client) {
+  if (client->IsFlagOn(kClientFlagMulti)) {
+    client->SetRes(CmdRes::kErrOther, "MULTI calls can not be nested");
+    return;
+  }
+  client->SetFlag(kClientFlagMulti);
+  client->SetRes(CmdRes::kOK);
+}
+
+ExecCmd::ExecCmd(const std::string& name, int16_t arity)
+    : BaseCmd(name, arity, kCmdFlagsExclusive | kCmdFlagsNoMulti, kAclCategoryTransaction | kAclCategorySlow) {}
+
+bool ExecCmd::DoInitial(PClient* client) {
+  if (!client->IsFlagOn(kClientFlagMulti)) {
+    client->SetRes(CmdRes::kErrOther, "EXEC without MULTI");
+    return false;
+  }
+  return true;
+}
+
+void ExecCmd::DoCmd(PClient* client) {
+  DEFER {
+    client->ClearMulti();
+    client->ClearWatch();
+  };
+
+  if (client->IsFlagOn(kClientFlagWrongExec)) {
+    client->SetLineString("-EXECABORT Transaction discarded because of previous errors.");
+    return;
+  }
+
+  auto& cmds = client->QueuedCmds();
+
+  // Lock every DB the transaction may touch in index order, so concurrent EXECs can not deadlock
+  std::vector<int> dbs = client->WatchedDBs();
+  dbs.push_back(client->GetCurrentDB());
+  for (const auto& params : cmds) {
+    int index = 0;
+    if (params.size() == 2 && pstd::StringEqualCaseInsensitive(params[0], kCmdNameSelect) &&
+        pstd::String2int(params[1], &index) && index >= 0 && static_cast<size_t>(index) < g_config.databases) {
+      dbs.push_back(index);
+    }
+  }
+  std::sort(dbs.begin(), dbs.end());
+  dbs.erase(std::unique(dbs.begin(), dbs.end()), dbs.end());
+  for (auto db : dbs) {
+    PSTORE.GetBackend(db)->Lock();
+  }
+  DEFER {
+    for (auto it = dbs.rbegin(); it != dbs.rend(); ++it) {
+      PSTORE.GetBackend(*it)->UnLock();
+    }
+  };
+
+  if (!client->CheckWatch()) {
+    client->AppendStringRaw("*-1\r\n");
+    return;
+  }
+
+  std::string replies;
+  client->SetFlag(kClientFlagInExec);
+  for (auto& params : cmds) {
+    client->SwapQueuedCmd(params);
+    auto [cmdPtr, ret] = cmd_table_manager_->GetCommand(client->CmdName(), client);
+    if (cmdPtr) {
+      cmdPtr->Execute(client);
+    } else {
+      client->SetRes(CmdRes::kErrOther, "unknown command '" + client->CmdName() + "'");
+    }
+    std::string reply;
+    client->Message(&reply);
+    replies.append(reply);
+    client->SwapQueuedCmd(params);
+  }
+  client->ClearFlag(kClientFlagInExec);
+
+  client->AppendArrayLen(static_cast<int64_t>(cmds.size()));
+  client->AppendStringRaw(replies);
+}
+
+DiscardCmd::DiscardCmd(const std::string& name, int16_t arity)
+    : BaseCmd(name, arity, kCmdFlagsNoMulti | kCmdFlagsFast, kAclCategoryTransaction | kAclCategoryFast) {}
+
+bool DiscardCmd::DoInitial(PClient* client) {
+  if (!client->IsFlagOn(kClientFlagMulti)) {
+    client->SetRes(CmdRes::kErrOther, "DISCARD without MULTI");
+    return false;
+  }
+  return true;
+}
+
+void DiscardCmd::DoCmd(PClient* client) {
+  client->ClearMulti();
+  client->ClearWatch();
+  client->SetRes(CmdRes::kOK);
+}
+
+WatchCmd::WatchCmd(const std::string& name, int16_t arity)
+    : BaseCmd(name, arity, kCmdFlagsNoMulti | kCmdFlagsFast, kAclCategoryTransaction | kAclCategoryFast) {}
+
+bool WatchCmd::DoInitial(PClient* client) {
+  if (client->IsFlagOn(kClientFlagMulti)) {
+    client->SetRes(CmdRes::kErrOther, "WATCH inside MULTI is not allowed");
+    return false;
+  }
+  return true;
+}
+
+void WatchCmd::DoCmd(PClient* client) {
+  for (size_t i = 1; i < client->argv_.size(); ++i) {
+    client->Watch(client->GetCurrentDB(), client->argv_[i]);
+  }
+  client->SetRes(CmdRes::kOK);
+}
+
+UnwatchCmd::UnwatchCmd(const std::string& name, int16_t arity)
+    : BaseCmd(name, arity, kCmdFlagsNoMulti | kCmdFlagsFast, kAclCategoryTransaction | kAclCategoryFast) {}
+
+bool UnwatchCmd::DoInitial(PClient* client) { return true; }
+
+void UnwatchCmd::DoCmd(PClient* client) {
+  client->ClearWatch();
+  client->SetRes(CmdRes::kOK);
+}
+
+}  // namespace pikiwidb
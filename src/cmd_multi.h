@@ -0,0 +1,78 @@
+// Copyright (c) 2024-present, OpenAtom Foundation, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory
+
+/*
+  Stores the declarations of transaction commands.
+ */
+
+#pragma once
+
+#include "base_cmd.h"
+
+namespace pikiwidb {
+
+class CmdTableManager;
+
+class MultiCmd : public BaseCmd {
+ public:
+  MultiCmd(const std::string& name, int16_t arity);
+
+ protected:
+  bool DoInitial(PClient* client) override;
+
+ private:
+  void DoCmd(PClient* client) override;
+};
+
+class ExecCmd : public BaseCmd {
+ public:
+  ExecCmd(const std::string& name, int16_t arity);
+
+  // the queued commands are resolved through the command table of the worker running EXEC
+  void SetCmdTableManager(CmdTableManager* manager) { cmd_table_manager_ = manager; }
+
+ protected:
+  bool DoInitial(PClient* client) override;
+
+ private:
+  void DoCmd(PClient* client) override;
+
+  CmdTableManager* cmd_table_manager_ = nullptr;
+};
+
+class DiscardCmd : public BaseCmd {
+ public:
+  DiscardCmd(const std::string& name, int16_t arity);
+
+ protected:
+  bool DoInitial(PClient* client) override;
+
+ private:
+  void DoCmd(PClient* client) override;
+};
+
+class WatchCmd : public BaseCmd {
+ public:
+  WatchCmd(const std::string& name, int16_t arity);
+
+ protected:
+  bool DoInitial(PClient* client) override;
+
+ private:
+  void DoCmd(PClient* client) override;
+};
+
+class UnwatchCmd : public BaseCmd {
+ public:
+  UnwatchCmd(const std::string& name, int16_t arity);
+
+ protected:
+  bool DoInitial(PClient* client) override;
+
+ private:
+  void DoCmd(PClient* client) override;
+};
+
+}  // namespace pikiwidb
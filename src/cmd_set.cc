@@ -206,7 +206,11 @@ void SCardCmd::DoCmd(PClient* client) {
 SMoveCmd::SMoveCmd(const std::string& name, int16_t arity)
     : BaseCmd(name, arity, kCmdFlagsWrite, kAclCategoryWrite | kAclCategorySet) {}
 
-bool SMoveCmd::DoInitial(PClient* client) { return true; }
+bool SMoveCmd::DoInitial(PClient* client) {
+  std::vector<std::string> keys{client->argv_[1], client->argv_[2]};
+  client->SetKey(keys);
+  return true;
+}
 
 void SMoveCmd::DoCmd(PClient* client) {
   int32_t reply_num = 0;
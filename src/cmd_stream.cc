@@ -0,0 +1,778 @@
+// Copyright (c) 2024-present, OpenAtom Foundation, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory
+
+/*
+  Implemented a set of features related to streams.
+ */
+
+#include "cmd_stream.h"
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+
+#include "pstd/pstd_string.h"
+#include "store.h"
+
+namespace pikiwidb {
+
+static const std::string kInvalidStreamID = "Invalid stream ID specified as stream command argument";
+
+// Parses 'ms-seq', '-' and '+'. A bare 'ms' takes missing_seq as its seq and
+// leaves seq_given false, 'ms-*' too when allow_star is set.
+static bool ParseStreamID(const std::string& str, uint64_t missing_seq, storage::StreamID* id,
+                          bool* seq_given = nullptr, bool allow_star = false) {
+  if (seq_given) {
+    *seq_given = false;
+  }
+  if (str == "-") {
+    *id = storage::StreamID::Min();
+    return true;
+  }
+  if (str == "+") {
+    *id = storage::StreamID::Max();
+    return true;
+  }
+
+  auto is_digits = [](const std::string& s) {
+    return !s.empty() && std::all_of(s.begin(), s.end(), [](char c) { return c >= '0' && c <= '9'; });
+  };
+  auto pos = str.find('-');
+  std::string ms = str.substr(0, pos);
+  if (!is_digits(ms) || pstd::String2int(ms, &id->ms) == 0) {
+    return false;
+  }
+  if (pos == std::string::npos) {
+    id->seq = missing_seq;
+    return true;
+  }
+  std::string seq = str.substr(pos + 1);
+  if (allow_star && seq == "*") {
+    id->seq = missing_seq;
+    return true;
+  }
+  if (!is_digits(seq) || pstd::String2int(seq, &id->seq) == 0) {
+    return false;
+  }
+  if (seq_given) {
+    *seq_given = true;
+  }
+  return true;
+}
+
+// Parses '(id' as well, the exclusive bound of XRANGE
+static bool ParseRangeID(const std::string& str, uint64_t missing_seq, bool is_start, storage::StreamID* id) {
+  if (str.size() > 1 && str[0] == '(') {
+    if (!ParseStreamID(str.substr(1), missing_seq, id)) {
+      return false;
+    }
+    return is_start ? id->Incr() : id->Decr();
+  }
+  return ParseStreamID(str, missing_seq, id);
+}
+
+// Parses MAXLEN|MINID [=|~] threshold [LIMIT count] at argv[*index] and moves past it.
+// The trim is always exact, '~' and LIMIT are accepted for compatibility.
+static bool ParseTrimArgs(PClient* client, size_t* index, storage::StreamTrimArgs* trim) {
+  size_t argc = client->argv_.size();
+  size_t i = *index;
+  bool maxlen = strcasecmp(client->argv_[i].data(), "maxlen") == 0;
+  if (++i < argc && (client->argv_[i] == "=" || client->argv_[i] == "~")) {
+    i++;
+  }
+  if (i >= argc) {
+    client->SetRes(CmdRes::kSyntaxErr);
+    return false;
+  }
+  if (maxlen) {
+    int64_t len = 0;
+    if (pstd::String2int(client->argv_[i], &len) == 0 || len < 0) {
+      client->SetRes(CmdRes::kErrOther, "The MAXLEN argument must be >= 0.");
+      return false;
+    }
+    trim->strategy = storage::StreamTrimArgs::kMaxLen;
+    trim->maxlen = static_cast<uint64_t>(len);
+  } else {
+    if (!ParseStreamID(client->argv_[i], 0, &trim->minid)) {
+      client->SetRes(CmdRes::kErrOther, kInvalidStreamID);
+      return false;
+    }
+    trim->strategy = storage::StreamTrimArgs::kMinID;
+  }
+  i++;
+  if (i + 1 < argc && strcasecmp(client->argv_[i].data(), "limit") == 0) {
+    int64_t limit = 0;
+    if (pstd::String2int(client->argv_[i + 1], &limit) == 0 || limit < 0) {
+      client->SetRes(CmdRes::kInvalidInt);
+      return false;
+    }
+    i += 2;
+  }
+  *index = i;
+  return true;
+}
+
+// Storage reports the errors a client should see as Corruption with the whole error line
+static void SetStreamError(PClient* client, const storage::Status& s) {
+  if (s.IsInvalidArgument()) {
+    client->SetRes(CmdRes::kMultiKey);
+  } else if (s.IsCorruption()) {
+    client->SetLineString("-" + std::string(s.getState()));
+  } else {
+    client->SetRes(CmdRes::kErrOther, s.ToString());
+  }
+}
+
+// Empty values are legal stream fields, so unlike AppendString they are never sent as nil
+static void AppendBulk(PClient* client, const std::string& value) {
+  client->AppendStringLen(static_cast<int64_t>(value.size()));
+  client->AppendContent(value);
+}
+
+static void AppendEntries(PClient* client, const std::vector<storage::StreamEntry>& entries) {
+  client->AppendArrayLen(static_cast<int64_t>(entries.size()));
+  for (const auto& entry : entries) {
+    client->AppendArrayLen(2);
+    AppendBulk(client, entry.id.ToString());
+    if (entry.field_values.empty()) {
+      // a pending entry that was deleted from the stream
+      client->AppendArrayLen(-1);
+      continue;
+    }
+    client->AppendArrayLen(static_cast<int64_t>(entry.field_values.size()));
+    for (const auto& item : entry.field_values) {
+      AppendBulk(client, item);
+    }
+  }
+}
+
+// Parses [COUNT n] [BLOCK ms] [NOACK] up to STREAMS and splits what follows into keys and IDs
+static bool ParseReadArgs(PClient* client, size_t index, bool group, int64_t* count, int64_t* block, bool* noack,
+                          std::vector<std::string>* keys, std::vector<std::string>* ids) {
+  size_t argc = client->argv_.size();
+  for (; index < argc; index++) {
+    const auto& arg = client->argv_[index];
+    if (strcasecmp(arg.data(), "streams") == 0) {
+      break;
+    }
+    if (strcasecmp(arg.data(), "count") == 0 && index + 1 < argc) {
+      if (pstd::String2int(client->argv_[++index], count) == 0) {
+        client->SetRes(CmdRes::kInvalidInt);
+        return false;
+      }
+      if (*count <= 0) {
+        *count = -1;
+      }
+    } else if (strcasecmp(arg.data(), "block") == 0 && index + 1 < argc) {
+      if (pstd::String2int(client->argv_[++index], block) == 0 || *block < 0) {
+        client->SetRes(CmdRes::kErrOther, "timeout is not an integer or out of range");
+        return false;
+      }
+    } else if (group && strcasecmp(arg.data(), "noack") == 0) {
+      *noack = true;
+    } else {
+      client->SetRes(CmdRes::kSyntaxErr);
+      return false;
+    }
+  }
+
+  size_t streams = argc - index - 1;
+  if (index >= argc || streams == 0 || streams % 2 != 0) {
+    client->SetRes(CmdRes::kErrOther, "Unbalanced '" + client->CmdName() +
+                                          "' list of streams: for each stream key an ID or '$' must be specified.");
+    return false;
+  }
+  keys->assign(client->argv_.begin() + index + 1, client->argv_.begin() + index + 1 + streams / 2);
+  ids->assign(client->argv_.begin() + index + 1 + streams / 2, client->argv_.end());
+  client->SetKey(*keys);
+  return true;
+}
+
+// Parks the client on Keys() when a blocking read found nothing, the command runs
+// again when one of the keys is written or replies nil at the deadline.
+static bool BlockReader(PClient* client, int64_t block, uint64_t ready_version) {
+  if (block < 0 || client->IsFlagOn(kClientFlagInExec)) {
+    return false;
+  }
+  auto now = std::chrono::steady_clock::now();
+  auto deadline = client->BlockDeadline();
+  if (deadline == std::chrono::steady_clock::time_point{}) {
+    deadline = block == 0 ? std::chrono::steady_clock::time_point::max() : now + std::chrono::milliseconds(block);
+  } else if (deadline <= now) {
+    return false;
+  }
+  client->Block(deadline, ready_version);
+  return true;
+}
+
+XAddCmd::XAddCmd(const std::string& name, int16_t arity)
+    : BaseCmd(name, arity, kCmdFlagsWrite, kAclCategoryWrite | kAclCategoryStream) {}
+
+bool XAddCmd::DoInitial(PClient* client) {
+  client->SetKey(client->argv_[1]);
+  return true;
+}
+
+void XAddCmd::DoCmd(PClient* client) {
+  storage::StreamAddArgs args;
+  size_t argc = client->argv_.size();
+  size_t index = 2;
+  while (index < argc) {
+    const auto& arg = client->argv_[index];
+    if (strcasecmp(arg.data(), "nomkstream") == 0) {
+      args.no_mkstream = true;
+      index++;
+    } else if (strcasecmp(arg.data(), "maxlen") == 0 || strcasecmp(arg.data(), "minid") == 0) {
+      if (!ParseTrimArgs(client, &index, &args.trim)) {
+        return;
+      }
+    } else {
+      break;
+    }
+  }
+  if (index >= argc) {
+    client->SetRes(CmdRes::kSyntaxErr);
+    return;
+  }
+
+  if (client->argv_[index] != "*") {
+    if (!ParseStreamID(client->argv_[index], 0, &args.id, &args.seq_given, true) ||
+        client->argv_[index] == "-" || client->argv_[index] == "+") {
+      client->SetRes(CmdRes::kErrOther, kInvalidStreamID);
+      return;
+    }
+    args.id_given = true;
+  }
+  index++;
+  if (index >= argc || (argc - index) % 2 != 0) {
+    client->SetRes(CmdRes::kWrongNum, client->CmdName());
+    return;
+  }
+
+  std::vector<std::string> field_values(client->argv_.begin() + index, client->argv_.end());
+  storage::StreamID id;
+  auto& db = PSTORE.GetBackend(client->GetCurrentDB());
+  storage::Status s = db->GetStorage()->XAdd(client->Key(), field_values, args, &id);
+  if (s.ok()) {
+    AppendBulk(client, id.ToString());
+    db->SignalKeyReady(client->Key());
+  } else if (s.IsNotFound()) {
+    client->AppendStringLen(-1);
+  } else {
+    SetStreamError(client, s);
+  }
+}
+
+XLenCmd::XLenCmd(const std::string& name, int16_t arity)
+    : BaseCmd(name, arity, kCmdFlagsReadonly, kAclCategoryRead | kAclCategoryStream) {}
+
+bool XLenCmd::DoInitial(PClient* client) {
+  client->SetKey(client->argv_[1]);
+  return true;
+}
+
+void XLenCmd::DoCmd(PClient* client) {
+  uint64_t len = 0;
+  storage::Status s = PSTORE.GetBackend(client->GetCurrentDB())->GetStorage()->XLen(client->Key(), &len);
+  if (s.ok() || s.IsNotFound()) {
+    client->AppendInteger(static_cast<int64_t>(len));
+  } else {
+    SetStreamError(client, s);
+  }
+}
+
+// XRANGE key start end [COUNT count] and XREVRANGE key end start [COUNT count]
+static void DoStreamRange(PClient* client, bool reverse) {
+  storage::StreamID start;
+  storage::StreamID end;
+  const auto& raw_start = client->argv_[reverse ? 3 : 2];
+  const auto& raw_end = client->argv_[reverse ? 2 : 3];
+  if (!ParseRangeID(raw_start, 0, true, &start) || !ParseRangeID(raw_end, UINT64_MAX, false, &end)) {
+    client->SetRes(CmdRes::kErrOther, kInvalidStreamID);
+    return;
+  }
+
+  int64_t count = -1;
+  size_t argc = client->argv_.size();
+  if (argc == 6 && strcasecmp(client->argv_[4].data(), "count") == 0) {
+    if (pstd::String2int(client->argv_[5], &count) == 0) {
+      client->SetRes(CmdRes::kInvalidInt);
+      return;
+    }
+    if (count < 0) {
+      count = 0;
+    }
+  } else if (argc != 4) {
+    client->SetRes(CmdRes::kSyntaxErr);
+    return;
+  }
+
+  std::vector<storage::StreamEntry> entries;
+  auto& storage = PSTORE.GetBackend(client->GetCurrentDB())->GetStorage();
+  storage::Status s = reverse ? storage->XRevRange(client->Key(), end, start, count, &entries)
+                              : storage->XRange(client->Key(), start, end, count, &entries);
+  if (s.ok() || s.IsNotFound()) {
+    AppendEntries(client, entries);
+  } else {
+    SetStreamError(client, s);
+  }
+}
+
+XRangeCmd::XRangeCmd(const std::string& name, int16_t arity)
+    : BaseCmd(name, arity, kCmdFlagsReadonly, kAclCategoryRead | kAclCategoryStream) {}
+
+bool XRangeCmd::DoInitial(PClient* client) {
+  client->SetKey(client->argv_[1]);
+  return true;
+}
+
+void XRangeCmd::DoCmd(PClient* client) { DoStreamRange(client, false); }
+
+XRevrangeCmd::XRevrangeCmd(const std::string& name, int16_t arity)
+    : BaseCmd(name, arity, kCmdFlagsReadonly, kAclCategoryRead | kAclCategoryStream) {}
+
+bool XRevrangeCmd::DoInitial(PClient* client) {
+  client->SetKey(client->argv_[1]);
+  return true;
+}
+
+void XRevrangeCmd::DoCmd(PClient* client) { DoStreamRange(client, true); }
+
+XDelCmd::XDelCmd(const std::string& name, int16_t arity)
+    : BaseCmd(name, arity, kCmdFlagsWrite, kAclCategoryWrite | kAclCategoryStream) {}
+
+bool XDelCmd::DoInitial(PClient* client) {
+  client->SetKey(client->argv_[1]);
+  return true;
+}
+
+void XDelCmd::DoCmd(PClient* client) {
+  std::vector<storage::StreamID> ids(client->argv_.size() - 2);
+  for (size_t i = 2; i < client->argv_.size(); i++) {
+    if (!ParseStreamID(client->argv_[i], 0, &ids[i - 2])) {
+      client->SetRes(CmdRes::kErrOther, kInvalidStreamID);
+      return;
+    }
+  }
+
+  int64_t count = 0;
+  storage::Status s = PSTORE.GetBackend(client->GetCurrentDB())->GetStorage()->XDel(client->Key(), ids, &count);
+  if (s.ok() || s.IsNotFound()) {
+    client->AppendInteger(count);
+  } else {
+    SetStreamError(client, s);
+  }
+}
+
+XTrimCmd::XTrimCmd(const std::string& name, int16_t arity)
+    : BaseCmd(name, arity, kCmdFlagsWrite, kAclCategoryWrite | kAclCategoryStream) {}
+
+bool XTrimCmd::DoInitial(PClient* client) {
+  client->SetKey(client->argv_[1]);
+  return true;
+}
+
+void XTrimCmd::DoCmd(PClient* client) {
+  const auto& strategy = client->argv_[2];
+  if (strcasecmp(strategy.data(), "maxlen") != 0 && strcasecmp(strategy.data(), "minid") != 0) {
+    client->SetRes(CmdRes::kSyntaxErr);
+    return;
+  }
+  storage::StreamTrimArgs args;
+  size_t index = 2;
+  if (!ParseTrimArgs(client, &index, &args)) {
+    return;
+  }
+  if (index != client->argv_.size()) {
+    client->SetRes(CmdRes::kSyntaxErr);
+    return;
+  }
+
+  int64_t count = 0;
+  storage::Status s = PSTORE.GetBackend(client->GetCurrentDB())->GetStorage()->XTrim(client->Key(), args, &count);
+  if (s.ok() || s.IsNotFound()) {
+    client->AppendInteger(count);
+  } else {
+    SetStreamError(client, s);
+  }
+}
+
+XReadCmd::XReadCmd(const std::string& name, int16_t arity)
+    : BaseCmd(name, arity, kCmdFlagsReadonly | kCmdFlagsBlocking,
+              kAclCategoryRead | kAclCategoryStream | kAclCategoryBlocking) {}
+
+bool XReadCmd::DoInitial(PClient* client) { return true; }
+
+void XReadCmd::DoCmd(PClient* client) {
+  int64_t count = -1;
+  int64_t block = -1;
+  bool noack = false;
+  std::vector<std::string> keys;
+  std::vector<std::string> ids;
+  if (!ParseReadArgs(client, 1, false, &count, &block, &noack, &keys, &ids)) {
+    return;
+  }
+
+  auto& db = PSTORE.GetBackend(client->GetCurrentDB());
+  auto& storage = db->GetStorage();
+  uint64_t ready_version = db->ReadyVersion();
+  std::vector<storage::StreamID> starts(keys.size());
+  std::vector<std::vector<storage::StreamEntry>> results(keys.size());
+  size_t ready = 0;
+  for (size_t i = 0; i < keys.size(); i++) {
+    storage::Status s;
+    if (ids[i] == "$") {
+      s = storage->XLastID(keys[i], &starts[i]);
+    } else if (!ParseStreamID(ids[i], 0, &starts[i])) {
+      client->ClearBlock();
+      client->SetRes(CmdRes::kErrOther, kInvalidStreamID);
+      return;
+    }
+    // entries strictly after the given ID
+    storage::StreamID from = starts[i];
+    if ((s.ok() || s.IsNotFound()) && from.Incr()) {
+      s = storage->XRange(keys[i], from, storage::StreamID::Max(), count, &results[i]);
+    }
+    if (!s.ok() && !s.IsNotFound()) {
+      client->ClearBlock();
+      SetStreamError(client, s);
+      return;
+    }
+    ready += results[i].empty() ? 0 : 1;
+  }
+
+  if (ready == 0) {
+    if (BlockReader(client, block, ready_version)) {
+      // pin '$' to the last ID seen now, the retry after a wake up must not skip the new entries
+      size_t id_index = client->argv_.size() - keys.size();
+      for (size_t i = 0; i < keys.size(); i++) {
+        client->argv_[id_index + i] = starts[i].ToString();
+      }
+      return;
+    }
+    client->ClearBlock();
+    client->AppendArrayLen(-1);
+    return;
+  }
+
+  client->ClearBlock();
+  client->AppendArrayLen(static_cast<int64_t>(ready));
+  for (size_t i = 0; i < keys.size(); i++) {
+    if (results[i].empty()) {
+      continue;
+    }
+    client->AppendArrayLen(2);
+    AppendBulk(client, keys[i]);
+    AppendEntries(client, results[i]);
+  }
+}
+
+CmdXGroup::CmdXGroup(const std::string& name, int arity) : BaseCmdGroup(name, kCmdFlagsWrite) {}
+
+bool CmdXGroup::HasSubCommand() const { return true; }
+
+CmdXGroupCreate::CmdXGroupCreate(const std::string& name, int16_t arity)
+    : BaseCmd(name, arity, kCmdFlagsWrite, kAclCategoryWrite | kAclCategoryStream) {}
+
+bool CmdXGroupCreate::DoInitial(PClient* client) {
+  client->SetKey(client->argv_[2]);
+  return true;
+}
+
+// XGROUP CREATE key group id|$ [MKSTREAM] [ENTRIESREAD n]
+void CmdXGroupCreate::DoCmd(PClient* client) {
+  bool mkstream = false;
+  for (size_t i = 5; i < client->argv_.size(); i++) {
+    if (strcasecmp(client->argv_[i].data(), "mkstream") == 0) {
+      mkstream = true;
+    } else if (strcasecmp(client->argv_[i].data(), "entriesread") == 0 && i + 1 < client->argv_.size()) {
+      i++;
+    } else {
+      client->SetRes(CmdRes::kSyntaxErr);
+      return;
+    }
+  }
+
+  storage::StreamID id;
+  bool last_id = client->argv_[4] == "$";
+  if (!last_id && !ParseStreamID(client->argv_[4], 0, &id)) {
+    client->SetRes(CmdRes::kErrOther, kInvalidStreamID);
+    return;
+  }
+  storage::Status s =
+      PSTORE.GetBackend(client->GetCurrentDB())->GetStorage()->XGroupCreate(client->Key(), client->argv_[3], id,
+                                                                          last_id, mkstream);
+  if (s.ok()) {
+    client->SetRes(CmdRes::kOK);
+  } else {
+    SetStreamError(client, s);
+  }
+}
+
+CmdXGroupSetID::CmdXGroupSetID(const std::string& name, int16_t arity)
+    : BaseCmd(name, arity, kCmdFlagsWrite, kAclCategoryWrite | kAclCategoryStream) {}
+
+bool CmdXGroupSetID::DoInitial(PClient* client) {
+  client->SetKey(client->argv_[2]);
+  return true;
+}
+
+// XGROUP SETID key group id|$ [ENTRIESREAD n]
+void CmdXGroupSetID::DoCmd(PClient* client) {
+  size_t argc = client->argv_.size();
+  if (argc != 5 && !(argc == 7 && strcasecmp(client->argv_[5].data(), "entriesread") == 0)) {
+    client->SetRes(CmdRes::kSyntaxErr);
+    return;
+  }
+
+  storage::StreamID id;
+  bool last_id = client->argv_[4] == "$";
+  if (!last_id && !ParseStreamID(client->argv_[4], 0, &id)) {
+    client->SetRes(CmdRes::kErrOther, kInvalidStreamID);
+    return;
+  }
+  storage::Status s = PSTORE.GetBackend(client->GetCurrentDB())
+                          ->GetStorage()
+                          ->XGroupSetID(client->Key(), client->argv_[3], id, last_id);
+  if (s.ok()) {
+    client->SetRes(CmdRes::kOK);
+  } else {
+    SetStreamError(client, s);
+  }
+}
+
+CmdXGroupDestroy::CmdXGroupDestroy(const std::string& name, int16_t arity)
+    : BaseCmd(name, arity, kCmdFlagsWrite, kAclCategoryWrite | kAclCategoryStream) {}
+
+bool CmdXGroupDestroy::DoInitial(PClient* client) {
+  client->SetKey(client->argv_[2]);
+  return true;
+}
+
+void CmdXGroupDestroy::DoCmd(PClient* client) {
+  int32_t ret = 0;
+  storage::Status s =
+      PSTORE.GetBackend(client->GetCurrentDB())->GetStorage()->XGroupDestroy(client->Key(), client->argv_[3], &ret);
+  if (s.ok()) {
+    client->AppendInteger(ret);
+  } else {
+    SetStreamError(client, s);
+  }
+}
+
+XReadGroupCmd::XReadGroupCmd(const std::string& name, int16_t arity)
+    : BaseCmd(name, arity, kCmdFlagsWrite | kCmdFlagsBlocking,
+              kAclCategoryWrite | kAclCategoryStream | kAclCategoryBlocking) {}
+
+bool XReadGroupCmd::DoInitial(PClient* client) {
+  if (strcasecmp(client->argv_[1].data(), "group") != 0) {
+    client->SetRes(CmdRes::kSyntaxErr);
+    return false;
+  }
+  // the streams whose pending entries are written, DoCmd checks the rest of the syntax
+  std::vector<std::string> keys;
+  for (size_t i = 4; i < client->argv_.size(); ++i) {
+    if (strcasecmp(client->argv_[i].data(), "streams") == 0) {
+      auto num = (client->argv_.size() - i - 1) / 2;
+      keys.assign(client->argv_.begin() + i + 1, client->argv_.begin() + i + 1 + num);
+      break;
+    }
+  }
+  client->SetKey(keys);
+  return true;
+}
+
+// XREADGROUP GROUP group consumer [COUNT n] [BLOCK ms] [NOACK] STREAMS key... id...
+void XReadGroupCmd::DoCmd(PClient* client) {
+  int64_t count = -1;
+  int64_t block = -1;
+  bool noack = false;
+  std::vector<std::string> keys;
+  std::vector<std::string> ids;
+  if (!ParseReadArgs(client, 4, true, &count, &block, &noack, &keys, &ids)) {
+    return;
+  }
+
+  const auto& group = client->argv_[2];
+  const auto& consumer = client->argv_[3];
+  auto& db = PSTORE.GetBackend(client->GetCurrentDB());
+  uint64_t ready_version = db->ReadyVersion();
+  std::vector<std::vector<storage::StreamEntry>> results(keys.size());
+  size_t replies = 0;
+  bool only_new = true;
+  for (size_t i = 0; i < keys.size(); i++) {
+    bool new_entries = ids[i] == ">";
+    storage::StreamID start;
+    if (!new_entries && !ParseStreamID(ids[i], 0, &start)) {
+      client->ClearBlock();
+      client->SetRes(CmdRes::kErrOther, kInvalidStreamID);
+      return;
+    }
+    // the history is the pending entries of the consumer after start, it never waits
+    only_new = only_new && new_entries;
+    storage::Status s =
+        db->GetStorage()->XReadGroup(keys[i], group, consumer, start, new_entries, count, noack, &results[i]);
+    if (!s.ok()) {
+      client->ClearBlock();
+      SetStreamError(client, s);
+      return;
+    }
+    replies += (!new_entries || !results[i].empty()) ? 1 : 0;
+  }
+
+  if (replies == 0) {
+    if (only_new && BlockReader(client, block, ready_version)) {
+      return;
+    }
+    client->ClearBlock();
+    client->AppendArrayLen(-1);
+    return;
+  }
+
+  client->ClearBlock();
+  client->AppendArrayLen(static_cast<int64_t>(replies));
+  for (size_t i = 0; i < keys.size(); i++) {
+    if (ids[i] == ">" && results[i].empty()) {
+      continue;
+    }
+    client->AppendArrayLen(2);
+    AppendBulk(client, keys[i]);
+    AppendEntries(client, results[i]);
+  }
+}
+
+XAckCmd::XAckCmd(const std::string& name, int16_t arity)
+    : BaseCmd(name, arity, kCmdFlagsWrite, kAclCategoryWrite | kAclCategoryStream) {}
+
+bool XAckCmd::DoInitial(PClient* client) {
+  client->SetKey(client->argv_[1]);
+  return true;
+}
+
+void XAckCmd::DoCmd(PClient* client) {
+  std::vector<storage::StreamID> ids(client->argv_.size() - 3);
+  for (size_t i = 3; i < client->argv_.size(); i++) {
+    if (!ParseStreamID(client->argv_[i], 0, &ids[i - 3])) {
+      client->SetRes(CmdRes::kErrOther, kInvalidStreamID);
+      return;
+    }
+  }
+
+  int64_t count = 0;
+  storage::Status s =
+      PSTORE.GetBackend(client->GetCurrentDB())->GetStorage()->XAck(client->Key(), client->argv_[2], ids, &count);
+  if (s.ok() || s.IsNotFound()) {
+    client->AppendInteger(count);
+  } else {
+    SetStreamError(client, s);
+  }
+}
+
+XPendingCmd::XPendingCmd(const std::string& name, int16_t arity)
+    : BaseCmd(name, arity, kCmdFlagsReadonly, kAclCategoryRead | kAclCategoryStream) {}
+
+bool XPendingCmd::DoInitial(PClient* client) {
+  client->SetKey(client->argv_[1]);
+  return true;
+}
+
+// XPENDING key group [[IDLE min-idle] start end count [consumer]]
+void XPendingCmd::DoCmd(PClient* client) {
+  size_t argc = client->argv_.size();
+  const auto& group = client->argv_[2];
+  auto& storage = PSTORE.GetBackend(client->GetCurrentDB())->GetStorage();
+  std::vector<storage::StreamPendingEntry> pendings;
+
+  if (argc == 3) {
+    // the summary: count, smallest and greatest ID, count of each consumer
+    storage::Status s = storage->XPending(client->Key(), group, storage::StreamID::Min(), storage::StreamID::Max(), -1,
+                                          "", &pendings);
+    if (!s.ok()) {
+      SetStreamError(client, s);
+      return;
+    }
+    client->AppendArrayLen(4);
+    client->AppendInteger(static_cast<int64_t>(pendings.size()));
+    if (pendings.empty()) {
+      client->AppendStringLen(-1);
+      client->AppendStringLen(-1);
+      client->AppendArrayLen(-1);
+      return;
+    }
+    AppendBulk(client, pendings.front().id.ToString());
+    AppendBulk(client, pendings.back().id.ToString());
+    std::map<std::string, int64_t> consumers;
+    for (const auto& pending : pendings) {
+      consumers[pending.consumer]++;
+    }
+    client->AppendArrayLen(static_cast<int64_t>(consumers.size()));
+    for (const auto& [consumer, count] : consumers) {
+      client->AppendArrayLen(2);
+      AppendBulk(client, consumer);
+      AppendBulk(client, std::to_string(count));
+    }
+    return;
+  }
+
+  size_t index = 3;
+  int64_t min_idle = 0;
+  if (strcasecmp(client->argv_[index].data(), "idle") == 0) {
+    if (index + 1 >= argc || pstd::String2int(client->argv_[index + 1], &min_idle) == 0) {
+      client->SetRes(CmdRes::kInvalidInt);
+      return;
+    }
+    index += 2;
+  }
+  if (argc - index != 3 && argc - index != 4) {
+    client->SetRes(CmdRes::kSyntaxErr);
+    return;
+  }
+  storage::StreamID start;
+  storage::StreamID end;
+  int64_t count = 0;
+  if (!ParseRangeID(client->argv_[index], 0, true, &start) ||
+      !ParseRangeID(client->argv_[index + 1], UINT64_MAX, false, &end)) {
+    client->SetRes(CmdRes::kErrOther, kInvalidStreamID);
+    return;
+  }
+  if (pstd::String2int(client->argv_[index + 2], &count) == 0) {
+    client->SetRes(CmdRes::kInvalidInt);
+    return;
+  }
+  std::string consumer = argc - index == 4 ? client->argv_[index + 3] : "";
+
+  // with IDLE the count applies after the filter
+  int64_t limit = min_idle > 0 ? -1 : std::max<int64_t>(count, 0);
+  storage::Status s = storage->XPending(client->Key(), group, start, end, limit, consumer, &pendings);
+  if (!s.ok()) {
+    SetStreamError(client, s);
+    return;
+  }
+
+  auto now = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch())
+          .count());
+  std::vector<const storage::StreamPendingEntry*> selected;
+  for (const auto& pending : pendings) {
+    if (static_cast<int64_t>(selected.size()) >= count) {
+      break;
+    }
+    uint64_t idle = now > pending.delivery_time ? now - pending.delivery_time : 0;
+    if (idle >= static_cast<uint64_t>(min_idle)) {
+      selected.push_back(&pending);
+    }
+  }
+  client->AppendArrayLen(static_cast<int64_t>(selected.size()));
+  for (const auto* pending : selected) {
+    uint64_t idle = now > pending->delivery_time ? now - pending->delivery_time : 0;
+    client->AppendArrayLen(4);
+    AppendBulk(client, pending->id.ToString());
+    AppendBulk(client, pending->consumer);
+    client->AppendInteger(static_cast<int64_t>(idle));
+    client->AppendInteger(static_cast<int64_t>(pending->delivery_count));
+  }
+}
+
+}  // namespace pikiwidb
@@ -0,0 +1,172 @@
+// Copyright (c) 2024-present, OpenAtom Foundation, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory
+
+/*
+  Defined a set of features related to streams.
+ */
+
+#pragma once
+#include "base_cmd.h"
+
+namespace pikiwidb {
+
+class XAddCmd : public BaseCmd {
+ public:
+  XAddCmd(const std::string &name, int16_t arity);
+
+ protected:
+  bool DoInitial(PClient *client) override;
+
+ private:
+  void DoCmd(PClient *client) override;
+};
+
+class XLenCmd : public BaseCmd {
+ public:
+  XLenCmd(const std::string &name, int16_t arity);
+
+ protected:
+  bool DoInitial(PClient *client) override;
+
+ private:
+  void DoCmd(PClient *client) override;
+};
+
+class XRangeCmd : public BaseCmd {
+ public:
+  XRangeCmd(const std::string &name, int16_t arity);
+
+ protected:
+  bool DoInitial(PClient *client) override;
+
+ private:
+  void DoCmd(PClient *client) override;
+};
+
+class XRevrangeCmd : public BaseCmd {
+ public:
+  XRevrangeCmd(const std::string &name, int16_t arity);
+
+ protected:
+  bool DoInitial(PClient *client) override;
+
+ private:
+  void DoCmd(PClient *client) override;
+};
+
+class XDelCmd : public BaseCmd {
+ public:
+  XDelCmd(const std::string &name, int16_t arity);
+
+ protected:
+  bool DoInitial(PClient *client) override;
+
+ private:
+  void DoCmd(PClient *client) override;
+};
+
+class XTrimCmd : public BaseCmd {
+ public:
+  XTrimCmd(const std::string &name, int16_t arity);
+
+ protected:
+  bool DoInitial(PClient *client) override;
+
+ private:
+  void DoCmd(PClient *client) override;
+};
+
+// With BLOCK the client waits on the keys when nothing is available, see DB::BlockClient
+class XReadCmd : public BaseCmd {
+ public:
+  XReadCmd(const std::string &name, int16_t arity);
+
+ protected:
+  bool DoInitial(PClient *client) override;
+
+ private:
+  void DoCmd(PClient *client) override;
+};
+
+class CmdXGroup : public BaseCmdGroup {
+ public:
+  CmdXGroup(const std::string &name, int arity);
+
+  bool HasSubCommand() const override;
+
+ protected:
+  bool DoInitial(PClient *client) override { return true; };
+
+ private:
+  void DoCmd(PClient *client) override{};
+};
+
+class CmdXGroupCreate : public BaseCmd {
+ public:
+  CmdXGroupCreate(const std::string &name, int16_t arity);
+
+ protected:
+  bool DoInitial(PClient *client) override;
+
+ private:
+  void DoCmd(PClient *client) override;
+};
+
+class CmdXGroupSetID : public BaseCmd {
+ public:
+  CmdXGroupSetID(const std::string &name, int16_t arity);
+
+ protected:
+  bool DoInitial(PClient *client) override;
+
+ private:
+  void DoCmd(PClient *client) override;
+};
+
+class CmdXGroupDestroy : public BaseCmd {
+ public:
+  CmdXGroupDestroy(const std::string &name, int16_t arity);
+
+ protected:
+  bool DoInitial(PClient *client) override;
+
+ private:
+  void DoCmd(PClient *client) override;
+};
+
+class XReadGroupCmd : public BaseCmd {
+ public:
+  XReadGroupCmd(const std::string &name, int16_t arity);
+
+ protected:
+  bool DoInitial(PClient *client) override;
+
+ private:
+  void DoCmd(PClient *client) override;
+};
+
+class XAckCmd : public BaseCmd {
+ public:
+  XAckCmd(const std::string &name, int16_t arity);
+
+ protected:
+  bool DoInitial(PClient *client) override;
+
+ private:
+  void DoCmd(PClient *client) override;
+};
+
+class XPendingCmd : public BaseCmd {
+ public:
+  XPendingCmd(const std::string &name, int16_t arity);
+
+ protected:
+  bool DoInitial(PClient *client) override;
+
+ private:
+  void DoCmd(PClient *client) override;
+};
+
+}  // namespace pikiwidb
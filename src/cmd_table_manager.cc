@@ -12,12 +12,15 @@
 #include <memory>
 
 #include "cmd_admin.h"
+#include "cmd_geo.h"
 #include "cmd_hash.h"
 #include "cmd_keys.h"
 #include "cmd_kv.h"
 #include "cmd_list.h"
+#include "cmd_multi.h"
 #include "cmd_raft.h"
 #include "cmd_set.h"
+#include "cmd_stream.h"
 #include "cmd_zset.h"
 #include "pstd_string.h"
 
@@ -60,18 +63,29 @@ void CmdTableManager::InitCmdTable() {
   ADD_SUBCOMMAND(Debug, Help, 2);
   ADD_SUBCOMMAND(Debug, OOM, 2);
   ADD_SUBCOMMAND(Debug, Segfault, 2);
+  ADD_SUBCOMMAND(Debug, WritePressure, 3);
   ADD_COMMAND(Sort, -2);
   ADD_COMMAND(Monitor, 1);
 
   // server
   ADD_COMMAND(Flushdb, 1);
   ADD_COMMAND(Flushall, 1);
+  ADD_COMMAND(Convertformat, 1);
+  ADD_COMMAND(Bgbackup, 1);
   ADD_COMMAND(Select, 2);
   ADD_COMMAND(Shutdown, 1);
 
   // info
   ADD_COMMAND(Info, -1);
 
+  // multi
+  ADD_COMMAND(Multi, 1);
+  ADD_COMMAND(Exec, 1);
+  ADD_COMMAND(Discard, 1);
+  ADD_COMMAND(Watch, -2);
+  ADD_COMMAND(Unwatch, 1);
+  static_cast<ExecCmd*>(cmds_->at(kCmdNameExec).get())->SetCmdTableManager(this);
+
   // raft
   ADD_COMMAND(RaftCluster, -1);
   ADD_COMMAND(RaftNode, -2);
@@ -186,6 +200,28 @@ void CmdTableManager::InitCmdTable() {
   ADD_COMMAND(ZRevrank, 3);
   ADD_COMMAND(ZRem, -3);
   ADD_COMMAND(ZIncrby, 4);
+
+  // geo
+  ADD_COMMAND(GeoAdd, -5);
+  ADD_COMMAND(GeoPos, -2);
+  ADD_COMMAND(GeoDist, -4);
+  ADD_COMMAND(GeoSearch, -7);
+
+  // stream
+  ADD_COMMAND(XAdd, -5);
+  ADD_COMMAND(XLen, 2);
+  ADD_COMMAND(XRange, -4);
+  ADD_COMMAND(XRevrange, -4);
+  ADD_COMMAND(XDel, -3);
+  ADD_COMMAND(XTrim, -4);
+  ADD_COMMAND(XRead, -4);
+  ADD_COMMAND_GROUP(XGroup, -2);
+  ADD_SUBCOMMAND(XGroup, Create, -5);
+  ADD_SUBCOMMAND(XGroup, SetID, -5);
+  ADD_SUBCOMMAND(XGroup, Destroy, 4);
+  ADD_COMMAND(XReadGroup, -7);
+  ADD_COMMAND(XAck, -4);
+  ADD_COMMAND(XPending, -3);
 }
 
 std::pair<BaseCmd*, CmdRes::CmdRet> CmdTableManager::GetCommand(const std::string& cmdName, PClient* client) {
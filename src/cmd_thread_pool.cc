@@ -8,11 +8,22 @@
  */
 
 #include "cmd_thread_pool.h"
+
+#include <algorithm>
+
 #include "cmd_thread_pool_worker.h"
 #include "log.h"
+#include "pstd/pstd_cpu.h"
 
 namespace pikiwidb {
 
+CmdThreadPoolTask::CmdThreadPoolTask(std::shared_ptr<PClient> client) : client_(std::move(client)) {
+  db_ = client_->GetCurrentDB();
+  for (const auto &arg : client_->argv_) {
+    bytes_ += arg.size();
+  }
+}
+
 void CmdThreadPoolTask::Run(BaseCmd *cmd) { cmd->Execute(client_.get()); }
 const std::string &CmdThreadPoolTask::CmdName() { return client_->CmdName(); }
 std::shared_ptr<PClient> CmdThreadPoolTask::Client() { return client_; }
@@ -26,32 +37,120 @@ pstd::Status CmdThreadPool::Init(int fast_thread, int slow_thread, std::string n
   name_ = std::move(name);
   fast_thread_num_ = fast_thread;
   slow_thread_num_ = slow_thread;
-  threads_.reserve(fast_thread_num_ + slow_thread_num_);
-  workers_.reserve(fast_thread_num_ + slow_thread_num_);
   return pstd::Status::OK();
 }
 
+std::vector<int> CmdThreadPool::WorkerCpus(int index) const {
+  if (cpus_.empty()) {
+    return {};
+  }
+  return {cpus_[index % cpus_.size()]};
+}
+
+CmdThreadPool::WorkerThread CmdThreadPool::StartWorker(const std::shared_ptr<CmdWorkThreadPoolWorker> &worker,
+                                                      int index) {
+  std::thread thread([worker, cpus = WorkerCpus(index)] {
+    pstd::BindThreadToCpus(cpus);
+    worker->Work();
+  });
+  return {worker, std::move(thread)};
+}
+
 void CmdThreadPool::Start() {
+  std::lock_guard lock(resize_mutex_);
   for (int i = 0; i < fast_thread_num_; ++i) {
     auto fastWorker = std::make_shared<CmdFastWorker>(this, 2, "fast worker" + std::to_string(i));
-    std::thread thread(&CmdWorkThreadPoolWorker::Work, fastWorker);
-    threads_.emplace_back(std::move(thread));
-    workers_.emplace_back(fastWorker);
+    fast_workers_.emplace_back(StartWorker(fastWorker, i));
     INFO("fast worker [{}] starting ...", i);
   }
   for (int i = 0; i < slow_thread_num_; ++i) {
     auto slowWorker = std::make_shared<CmdSlowWorker>(this, 2, "slow worker" + std::to_string(i));
-    std::thread thread(&CmdWorkThreadPoolWorker::Work, slowWorker);
-    threads_.emplace_back(std::move(thread));
-    workers_.emplace_back(slowWorker);
+    slow_workers_.emplace_back(StartWorker(slowWorker, fast_thread_num_ + i));
     INFO("slow worker [{}] starting ...", i);
   }
 }
 
-void CmdThreadPool::SubmitFast(const std::shared_ptr<CmdThreadPoolTask> &runner) {
+pstd::Status CmdThreadPool::Resize(int fast_thread) {
+  if (fast_thread <= 0) {
+    return pstd::Status::InvalidArgument("thread num must be positive");
+  }
+  std::lock_guard lock(resize_mutex_);
+  if (stopped_.load()) {
+    return pstd::Status::Incomplete("thread pool is stopped");
+  }
+  JoinRetired(false);
+
+  int old = static_cast<int>(fast_workers_.size());
+  for (int i = old; i < fast_thread; ++i) {
+    auto fastWorker = std::make_shared<CmdFastWorker>(this, 2, "fast worker" + std::to_string(i));
+    fast_workers_.emplace_back(StartWorker(fastWorker, i));
+    INFO("fast worker [{}] starting ...", i);
+  }
+  if (fast_thread < old) {
+    for (int i = fast_thread; i < old; ++i) {
+      fast_workers_[i].first->Stop();
+      retired_.emplace_back(std::move(fast_workers_[i]));
+      INFO("fast worker [{}] retiring ...", i);
+    }
+    fast_workers_.resize(fast_thread);
+    // wake the idle ones up so the retired workers see they are stopped
+    std::unique_lock fl(fast_mutex_);
+    fast_condition_.notify_all();
+  }
+  fast_thread_num_.store(fast_thread, std::memory_order_relaxed);
+  return pstd::Status::OK();
+}
+
+void CmdThreadPool::JoinRetired(bool all) {
+  // CONFIG SET may run on a worker that is being retired, it must not join itself
+  auto self = std::this_thread::get_id();
+  for (auto iter = retired_.begin(); iter != retired_.end();) {
+    auto &thread = iter->second;
+    if (thread.get_id() != self && (all || iter->first->Exited())) {
+      if (thread.joinable()) {
+        thread.join();
+      }
+      iter = retired_.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+}
+
+bool CmdThreadPool::EnterWriteThrottle() {
+  auto max_waiting = std::max(1, FastThreadNum() / 2);
+  if (throttled_workers_.fetch_add(1, std::memory_order_relaxed) >= max_waiting) {
+    throttled_workers_.fetch_sub(1, std::memory_order_relaxed);
+    throttle_overflows_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+size_t CmdThreadPool::FastQueueSize() {
+  std::unique_lock lock(fast_mutex_);
+  return fast_tasks_.Size();
+}
+
+void CmdThreadPool::SetQosLimits(std::vector<CmdQosLimits> limits) {
+  std::unique_lock lock(fast_mutex_);
+  fast_tasks_.SetLimits(std::move(limits));
+  // a raised limit may let the throttled tasks go now
+  fast_condition_.notify_all();
+}
+
+std::vector<CmdQosStats> CmdThreadPool::QosStats() {
+  std::unique_lock lock(fast_mutex_);
+  return fast_tasks_.Stats();
+}
+
+bool CmdThreadPool::SubmitFast(const std::shared_ptr<CmdThreadPoolTask> &runner, bool admit) {
   std::unique_lock rl(fast_mutex_);
-  fast_tasks_.emplace_back(runner);
+  if (!fast_tasks_.Push(runner, admit)) {
+    return false;
+  }
   fast_condition_.notify_one();
+  return true;
 }
 
 void CmdThreadPool::SubmitSlow(const std::shared_ptr<CmdThreadPoolTask> &runner) {
@@ -68,8 +167,11 @@ void CmdThreadPool::DoStop() {
   }
   stopped_.store(true);
 
-  for (auto &worker : workers_) {
-    worker->Stop();
+  std::lock_guard lock(resize_mutex_);
+  for (auto &workers : {&fast_workers_, &slow_workers_}) {
+    for (auto &[worker, thread] : *workers) {
+      worker->Stop();
+    }
   }
 
   {
@@ -81,14 +183,15 @@ void CmdThreadPool::DoStop() {
     slow_condition_.notify_all();
   }
 
-  for (auto &thread : threads_) {
-    if (thread.joinable()) {
-      thread.join();
+  for (auto &workers : {&fast_workers_, &slow_workers_, &retired_}) {
+    for (auto &[worker, thread] : *workers) {
+      if (thread.joinable()) {
+        thread.join();
+      }
     }
+    workers->clear();
   }
-  threads_.clear();
-  workers_.clear();
-  fast_tasks_.clear();
+  fast_tasks_.Clear();
   slow_tasks_.clear();
 }
 
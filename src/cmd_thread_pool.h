@@ -16,6 +16,7 @@
 #include <utility>
 #include <vector>
 #include "base_cmd.h"
+#include "cmd_fair_queue.h"
 #include "pstd/pstd_status.h"
 
 namespace pikiwidb {
@@ -28,13 +29,19 @@ namespace pikiwidb {
 */
 class CmdThreadPoolTask {
  public:
-  explicit CmdThreadPoolTask(std::shared_ptr<PClient> client) : client_(std::move(client)) {}
+  explicit CmdThreadPoolTask(std::shared_ptr<PClient> client);
   void Run(BaseCmd *cmd);
   const std::string &CmdName();
   std::shared_ptr<PClient> Client();
+  // the DB the command was sent to, its QoS class
+  inline int Db() const { return db_; }
+  // the size of the request, charged to the bytes limit of the DB
+  inline size_t Bytes() const { return bytes_; }
 
  private:
   std::shared_ptr<PClient> client_;
+  int db_ = 0;
+  size_t bytes_ = 0;
 };
 
 class CmdWorkThreadPoolWorker;
@@ -55,41 +62,86 @@ class CmdThreadPool {
 
   pstd::Status Init(int fast_thread, int slow_thread, std::string name);
 
+  // pin worker i to cpus[i % cpus.size()], must be called before Start
+  void SetCpuList(std::vector<int> cpus) { cpus_ = std::move(cpus); }
+
   // start the thread pool
   void Start();
 
+  // Grow or shrink the fast workers while running. A retiring worker finishes
+  // the tasks it already took, the queue is shared so the others take the rest.
+  pstd::Status Resize(int fast_thread);
+
   // stop the thread pool
   void Stop();
 
-  // submit a fast task to the thread pool
-  void SubmitFast(const std::shared_ptr<CmdThreadPoolTask> &runner);
+  // submit a fast task to the thread pool, false when the queue of its DB is
+  // full. admit false queues it anyway, for the commands already accepted once.
+  bool SubmitFast(const std::shared_ptr<CmdThreadPoolTask> &runner, bool admit = true);
 
   // submit a slow task to the thread pool
   void SubmitSlow(const std::shared_ptr<CmdThreadPoolTask> &runner);
 
   // get the fast thread num
-  inline int FastThreadNum() const { return fast_thread_num_; };
+  inline int FastThreadNum() const { return fast_thread_num_.load(std::memory_order_relaxed); };
 
   // get the slow thread num
   inline int SlowThreadNum() const { return slow_thread_num_; };
 
   // get the thread pool size
-  inline int ThreadPollSize() const { return fast_thread_num_ + slow_thread_num_; };
+  inline int ThreadPollSize() const { return FastThreadNum() + slow_thread_num_; };
+
+  // the tasks waiting in the fast queue
+  size_t FastQueueSize();
+
+  // the weights and limits of the fast queue by DB
+  void SetQosLimits(std::vector<CmdQosLimits> limits);
+
+  std::vector<CmdQosStats> QosStats();
+
+  // the time the workers spent running tasks, the utilization is its growth over time * threads
+  inline int64_t BusyMicros() const { return busy_us_.load(std::memory_order_relaxed); }
+
+  // A worker about to wait for a throttled write, false when half of the fast
+  // workers wait already, so the reads keep the others. LeaveWriteThrottle after it.
+  bool EnterWriteThrottle();
+  inline void LeaveWriteThrottle() { throttled_workers_.fetch_sub(1, std::memory_order_relaxed); }
+
+  inline int ThrottledWorkers() const { return throttled_workers_.load(std::memory_order_relaxed); }
+
+  // the writes turned away since no more workers could wait
+  inline uint64_t ThrottleOverflows() const { return throttle_overflows_.load(std::memory_order_relaxed); }
 
   ~CmdThreadPool();
 
  private:
+  using WorkerThread = std::pair<std::shared_ptr<CmdWorkThreadPoolWorker>, std::thread>;
+
   void DoStop();
 
+  WorkerThread StartWorker(const std::shared_ptr<CmdWorkThreadPoolWorker> &worker, int index);
+
+  // joins the retired workers that have exited, never the calling thread
+  void JoinRetired(bool all);
+
+  // the CPU of the worker, empty when the workers are not pinned
+  std::vector<int> WorkerCpus(int index) const;
+
  private:
-  std::deque<std::shared_ptr<CmdThreadPoolTask>> fast_tasks_;  // fast task queue
+  CmdFairQueue fast_tasks_;                                    // fast task queue
   std::deque<std::shared_ptr<CmdThreadPoolTask>> slow_tasks_;  // slow task queue
 
-  std::vector<std::thread> threads_;
-  std::vector<std::shared_ptr<CmdWorkThreadPoolWorker>> workers_;
+  std::vector<WorkerThread> fast_workers_;
+  std::vector<WorkerThread> slow_workers_;
+  std::vector<WorkerThread> retired_;  // stopped by Resize, not joined yet
+  std::mutex resize_mutex_;
+  std::vector<int> cpus_;
   std::string name_;  // thread pool name
-  int fast_thread_num_ = 0;
+  std::atomic<int> fast_thread_num_ = 0;
   int slow_thread_num_ = 0;
+  std::atomic<int64_t> busy_us_ = 0;
+  std::atomic<int> throttled_workers_ = 0;
+  std::atomic<uint64_t> throttle_overflows_ = 0;
   std::mutex fast_mutex_;
   std::condition_variable fast_condition_;
   std::mutex slow_mutex_;
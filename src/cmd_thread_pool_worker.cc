@@ -12,12 +12,14 @@
 #include "env.h"
 #include "log.h"
 #include "pikiwidb.h"
+#include "store.h"
 
 namespace pikiwidb {
 
 void CmdWorkThreadPoolWorker::Work() {
   while (running_) {
     LoadWork();
+    auto batch_start = std::chrono::steady_clock::now();
     for (const auto &task : self_task_) {
       if (task->Client()->State() != ClientState::kOK) {  // the client is closed
         continue;
@@ -32,12 +34,30 @@ void CmdWorkThreadPoolWorker::Work() {
         } else {
           task->Client()->SetRes(CmdRes::kInvalidParameter);
         }
+        task->Client()->FlagExecWrong();
         g_pikiwidb->PushWriteTask(task->Client());
         continue;
       }
 
       if (!cmdPtr->CheckArg(task->Client()->ParamsSize())) {
         task->Client()->SetRes(CmdRes::kWrongNum, task->CmdName());
+        task->Client()->FlagExecWrong();
+        g_pikiwidb->PushWriteTask(task->Client());
+        continue;
+      }
+
+      // inside MULTI everything except the transaction commands is queued until EXEC
+      if (task->Client()->IsFlagOn(kClientFlagMulti) && !(cmdPtr->AclCategory() & kAclCategoryTransaction)) {
+        if (cmdPtr->HasFlag(kCmdFlagsExclusive) || cmdPtr->HasFlag(kCmdFlagsNoMulti)) {
+          // EXEC already holds the DB locks these commands take themselves
+          task->Client()->SetRes(CmdRes::kErrOther, "command '" + task->CmdName() + "' is not allowed in MULTI");
+          task->Client()->FlagExecWrong();
+        } else {
+          if (!task->Client()->IsFlagOn(kClientFlagWrongExec)) {
+            task->Client()->QueueCmd();
+          }
+          task->Client()->SetLineString("+QUEUED");
+        }
         g_pikiwidb->PushWriteTask(task->Client());
         continue;
       }
@@ -57,30 +77,40 @@ void CmdWorkThreadPoolWorker::Work() {
       (*cmdstat_map)[task->CmdName()].cmd_count_.fetch_add(1);
       (*cmdstat_map)[task->CmdName()].cmd_time_consuming_.fetch_add(task->Client()->GetTimeStat()->GetTotalTime());
 
+      // a blocking read found nothing, a write to its keys or the timeout sends the reply
+      if (task->Client()->IsFlagOn(kClientFlagBlocked)) {
+        PSTORE.GetBackend(task->Client()->GetCurrentDB())->BlockClient(task->Client());
+        continue;
+      }
+
       g_pikiwidb->PushWriteTask(task->Client());
     }
+    if (!self_task_.empty()) {
+      auto busy = std::chrono::steady_clock::now() - batch_start;
+      pool_->busy_us_.fetch_add(std::chrono::duration_cast<std::chrono::microseconds>(busy).count(),
+                                std::memory_order_relaxed);
+    }
     self_task_.clear();
   }
   INFO("worker [{}] goodbye...", name_);
+  exited_.store(true, std::memory_order_release);
 }
 
 void CmdWorkThreadPoolWorker::Stop() { running_ = false; }
 
 void CmdFastWorker::LoadWork() {
   std::unique_lock lock(pool_->fast_mutex_);
-  while (pool_->fast_tasks_.empty()) {
+  while (pool_->fast_tasks_.Pop(once_task_, &self_task_) == 0) {
     if (!running_) {
       return;
     }
-    pool_->fast_condition_.wait(lock);
-  }
-
-  if (pool_->fast_tasks_.empty()) {
-    return;
+    if (pool_->fast_tasks_.Empty()) {
+      pool_->fast_condition_.wait(lock);
+    } else {
+      // only DBs over their rate limits have tasks, sleep until the first of them has its tokens
+      pool_->fast_condition_.wait_until(lock, pool_->fast_tasks_.NextReady());
+    }
   }
-  const auto num = std::min(static_cast<int>(pool_->fast_tasks_.size()), once_task_);
-  std::move(pool_->fast_tasks_.begin(), pool_->fast_tasks_.begin() + num, std::back_inserter(self_task_));
-  pool_->fast_tasks_.erase(pool_->fast_tasks_.begin(), pool_->fast_tasks_.begin() + num);
 }
 
 void CmdSlowWorker::LoadWork() {
@@ -105,12 +135,7 @@ void CmdSlowWorker::LoadWork() {
   {
     std::unique_lock lock(pool_->fast_mutex_);
     loop_more_ = true;
-
-    const auto num = std::min(static_cast<int>(pool_->fast_tasks_.size()), once_task_);
-    if (num > 0) {
-      std::move(pool_->fast_tasks_.begin(), pool_->fast_tasks_.begin() + num, std::back_inserter(self_task_));
-      pool_->fast_tasks_.erase(pool_->fast_tasks_.begin(), pool_->fast_tasks_.begin() + num);
-    }
+    pool_->fast_tasks_.Pop(once_task_, &self_task_);
   }
 }
 
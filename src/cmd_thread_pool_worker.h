@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <utility>
 
@@ -29,6 +30,9 @@ class CmdWorkThreadPoolWorker {
 
   void Stop();
 
+  // whether Work has returned after Stop
+  inline bool Exited() const { return exited_.load(std::memory_order_acquire); }
+
   // load the task from the thread pool
   virtual void LoadWork() = 0;
 
@@ -39,7 +43,8 @@ class CmdWorkThreadPoolWorker {
   CmdThreadPool *pool_ = nullptr;
   const int once_task_ = 0;  // the max task num that the worker can get from the thread pool
   const std::string name_;
-  bool running_ = true;
+  std::atomic<bool> running_ = true;
+  std::atomic<bool> exited_ = false;
 
   pikiwidb::CmdTableManager cmd_table_manager_;
 };
@@ -215,6 +215,7 @@ ZsetUIstoreParentCmd::ZsetUIstoreParentCmd(const std::string& name, int16_t arit
 bool ZsetUIstoreParentCmd::DoInitial(PClient* client) {
   auto argv_ = client->argv_;
   dest_key_ = argv_[1];
+  client->SetKey(dest_key_);
   if (pstd::String2int(argv_[2].data(), argv_[2].size(), &num_keys_) == 0) {
     client->SetRes(CmdRes::kInvalidInt);
     return false;
@@ -7,11 +7,13 @@
   Responsible for managing the runtime configuration information of PikiwiDB.
  */
 
+#include <algorithm>
 #include <string>
 #include <system_error>
 #include <vector>
 
 #include "config.h"
+#include "pstd/pstd_cpu.h"
 #include "pstd/pstd_string.h"
 #include "store.h"
 
@@ -44,6 +46,143 @@ static Status CheckYesNo(const std::string& value) {
   return Status::OK();
 }
 
+static Status CheckBlockCacheType(const std::string& value) {
+  if (!pstd::StringEqualCaseInsensitive(value, "lru") && !pstd::StringEqualCaseInsensitive(value, "hyperclock")) {
+    return Status::InvalidArgument("The value must be lru / hyperclock.");
+  }
+  return Status::OK();
+}
+
+static Status CheckCpuList(const std::string& value) {
+  std::vector<int> cpus;
+  if (!pstd::ParseCpuList(value, &cpus)) {
+    return Status::InvalidArgument("The value must be a CPU list like 0-3,8.");
+  }
+  return Status::OK();
+}
+
+static Status CheckUnixSocketPerm(const std::string& value) {
+  if (value.find_first_not_of("01234567") != std::string::npos || value.size() > 4) {
+    return Status::InvalidArgument("The value must be octal permissions like 700.");
+  }
+  return Status::OK();
+}
+
+static Status CheckUidList(const std::string& value) {
+  std::vector<std::string> uids;
+  pstd::StringSplit(value, ',', uids);
+  for (const auto& uid : uids) {
+    int64_t v = 0;
+    if (pstd::String2int(pstd::StringTrim(uid), &v) == 0 || v < 0) {
+      return Status::InvalidArgument("The value must be a list of uids like 0,1000.");
+    }
+  }
+  return Status::OK();
+}
+
+bool ParseDbValueList(const std::string& list, std::map<int, int64_t>* values) {
+  std::vector<std::string> items;
+  pstd::StringSplit(list, ',', items);
+  for (const auto& item : items) {
+    auto pair = pstd::StringTrim(item);
+    if (pair.empty()) {
+      continue;
+    }
+    auto colon = pair.find(':');
+    int64_t db = 0;
+    int64_t value = 0;
+    if (colon == std::string::npos || pstd::String2int(pstd::StringTrim(pair.substr(0, colon)), &db) == 0 ||
+        pstd::String2int(pstd::StringTrim(pair.substr(colon + 1)), &value) == 0 || db < 0 || db >= DBNUMBER_MAX ||
+        value < 0) {
+      return false;
+    }
+    (*values)[static_cast<int>(db)] = value;
+  }
+  return true;
+}
+
+static Status CheckDbValueList(const std::string& value) {
+  std::map<int, int64_t> values;
+  if (!ParseDbValueList(value, &values)) {
+    return Status::InvalidArgument("The value must be a list of db:number like 0:4,2:1.");
+  }
+  return Status::OK();
+}
+
+static Status CheckDataFormat(const std::string& value) {
+  std::map<int, int64_t> values;
+  if (!ParseDbValueList(value, &values) ||
+      std::any_of(values.begin(), values.end(), [](const auto& v) { return v.second != 1 && v.second != 2; })) {
+    return Status::InvalidArgument("The value must be a list of db:format like 0:2,1:1, format 1 or 2.");
+  }
+  return Status::OK();
+}
+
+static Status CheckDataTypeList(const std::string& value) {
+  static const std::vector<std::string> kTypes{"string", "hash", "set", "list", "zset", "stream"};
+  std::vector<std::string> types;
+  pstd::StringSplit(value, ',', types);
+  for (const auto& type : types) {
+    auto name = pstd::StringTrim(type);
+    if (!name.empty() && std::find(kTypes.begin(), kTypes.end(), name) == kTypes.end()) {
+      return Status::InvalidArgument("The value must be a list of string / hash / set / list / zset / stream.");
+    }
+  }
+  return Status::OK();
+}
+
+bool ParseCompactionStyleList(const std::string& list, std::map<std::string, rocksdb::CompactionStyle>* styles) {
+  std::vector<std::string> items;
+  pstd::StringSplit(list, ',', items);
+  for (const auto& item : items) {
+    auto pair = pstd::StringTrim(item);
+    if (pair.empty()) {
+      continue;
+    }
+    auto colon = pair.find(':');
+    if (colon == std::string::npos) {
+      return false;
+    }
+    auto name = pstd::StringTrim(pair.substr(0, colon));
+    auto style = pstd::StringTrim(pair.substr(colon + 1));
+    if (pstd::StringEqualCaseInsensitive(style, "level")) {
+      (*styles)[name] = rocksdb::kCompactionStyleLevel;
+    } else if (pstd::StringEqualCaseInsensitive(style, "universal")) {
+      (*styles)[name] = rocksdb::kCompactionStyleUniversal;
+    } else if (pstd::StringEqualCaseInsensitive(style, "fifo")) {
+      (*styles)[name] = rocksdb::kCompactionStyleFIFO;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+static Status CheckCompactionStyles(const std::string& value) {
+  static const std::vector<std::string> kTypes{"string", "hash", "set", "list", "zset", "stream"};
+  std::map<std::string, rocksdb::CompactionStyle> styles;
+  // FIFO drops the SSTs whatever keys they hold, only a whole DB of strings may take it
+  if (!ParseCompactionStyleList(value, &styles) || std::any_of(styles.begin(), styles.end(), [](const auto& s) {
+        return std::find(kTypes.begin(), kTypes.end(), s.first) == kTypes.end() ||
+               s.second == rocksdb::kCompactionStyleFIFO;
+      })) {
+    return Status::InvalidArgument(
+        "The value must be a list of type:style like list:universal, style level or universal.");
+  }
+  return Status::OK();
+}
+
+static Status CheckDbCompactionStyles(const std::string& value) {
+  std::map<std::string, rocksdb::CompactionStyle> styles;
+  if (!ParseCompactionStyleList(value, &styles) || std::any_of(styles.begin(), styles.end(), [](const auto& s) {
+        int64_t db = 0;
+        return pstd::String2int(s.first, &db) == 0 || db < 0 || db >= DBNUMBER_MAX;
+      })) {
+    return Status::InvalidArgument("The value must be a list of db:style like 3:fifo, style level, universal or fifo.");
+  }
+  return Status::OK();
+}
+
 static Status CheckLogLevel(const std::string& value) {
   if (!pstd::StringEqualCaseInsensitive(value, "debug") && !pstd::StringEqualCaseInsensitive(value, "verbose") &&
       !pstd::StringEqualCaseInsensitive(value, "notice") && !pstd::StringEqualCaseInsensitive(value, "warning")) {
@@ -115,18 +254,35 @@ PConfig::PConfig() {
   AddNumberWithLimit<size_t>("databases", false, &databases, 1, DBNUMBER_MAX);
   AddString("requirepass", true, {&password});
   AddNumber("maxclients", true, &max_clients);
-  AddNumberWithLimit<uint32_t>("worker-threads", false, &worker_threads_num, 1, THREAD_MAX);
+  AddNumberWithLimit<uint32_t>("worker-threads", true, &worker_threads_num, 1, THREAD_MAX);
   AddNumberWithLimit<uint32_t>("slave-threads", false, &worker_threads_num, 1, THREAD_MAX);
+  AddBool("reuseport-cpu-steering", &CheckYesNo, false, &reuseport_cpu_steering);
+  AddNumberWithLimit<uint32_t>("io-busy-poll-us", true, &io_busy_poll_us, 0, 1000000);
+  AddStringWithFunc("io-threads-cpu-list", &CheckCpuList, false, {&io_threads_cpu_list});
+  AddStringWithFunc("cmd-threads-cpu-list", &CheckCpuList, false, {&cmd_threads_cpu_list});
+  AddStringWithFunc("rocksdb-threads-cpu-list", &CheckCpuList, false, {&rocksdb_threads_cpu_list});
+  AddString("unixsocket", false, {&unix_socket});
+  AddStringWithFunc("unixsocketperm", &CheckUnixSocketPerm, false, {&unix_socket_perm});
+  AddStringWithFunc("unixsocket-allowed-uids", &CheckUidList, false, {&unix_socket_allowed_uids});
   AddNumber("slowlog-log-slower-than", true, &slow_log_time);
   AddNumber("slowlog-max-len", true, &slow_log_max_len);
   AddNumberWithLimit<size_t>("db-instance-num", true, &db_instance_num, 1, ROCKSDB_INSTANCE_NUMBER_MAX);
-  AddNumberWithLimit<int32_t>("fast-cmd-threads-num", false, &fast_cmd_threads_num, 1, THREAD_MAX);
+  AddNumberWithLimit<int32_t>("fast-cmd-threads-num", true, &fast_cmd_threads_num, 1, THREAD_MAX);
   AddNumberWithLimit<int32_t>("slow-cmd-threads-num", false, &slow_cmd_threads_num, 1, THREAD_MAX);
+  AddBool("cmd-threads-autoscale", &CheckYesNo, true, &cmd_threads_autoscale);
+  AddNumberWithLimit<int32_t>("cmd-threads-autoscale-max", true, &cmd_threads_autoscale_max, 1, THREAD_MAX);
+  AddStringWithFunc("qos-db-weights", &CheckDbValueList, true, {&qos_db_weights});
+  AddStringWithFunc("qos-db-ops-limit", &CheckDbValueList, true, {&qos_db_ops_limit});
+  AddStringWithFunc("qos-db-bytes-limit", &CheckDbValueList, true, {&qos_db_bytes_limit});
+  AddStringWithFunc("qos-db-max-queued", &CheckDbValueList, true, {&qos_db_max_queued});
+  AddStringWithFunc("data-format", &CheckDataFormat, false, {&data_format});
   AddNumber("max-client-response-size", true, &max_client_response_size);
   AddString("runid", false, {&run_id});
   AddNumber("small-compaction-threshold", true, &small_compaction_threshold);
   AddNumber("small-compaction-duration-threshold", true, &small_compaction_duration_threshold);
   AddBool("use-raft", &CheckYesNo, false, &use_raft);
+  AddBool("raft-log-as-wal", &CheckYesNo, false, &raft_log_as_wal);
+  AddNumber("raft-max-replay-gap", false, &raft_max_replay_gap);
 
   // rocksdb config
   AddNumber("rocksdb-max-subcompactions", false, &rocksdb_max_subcompactions);
@@ -140,6 +296,27 @@ PConfig::PConfig() {
   AddNumber("rocksdb-level0-slowdown-writes-trigger", false, &rocksdb_level0_slowdown_writes_trigger);
   AddNumber("rocksdb-level0-stop-writes-trigger", false, &rocksdb_level0_stop_writes_trigger);
   AddNumber("rocksdb-level0-slowdown-writes-trigger", false, &rocksdb_level0_slowdown_writes_trigger);
+  AddNumber("rocksdb-block-cache-size", false, &rocksdb_block_cache_size);
+  AddStringWithFunc("rocksdb-block-cache-type", &CheckBlockCacheType, false, {&rocksdb_block_cache_type});
+  AddNumber("rocksdb-secondary-cache-size", false, &rocksdb_secondary_cache_size);
+  AddString("rocksdb-cold-path", false, {&rocksdb_cold_path});
+  AddNumber("rocksdb-hot-path-size", false, &rocksdb_hot_path_size);
+  AddStringWithFunc("rocksdb-cold-data-types", &CheckDataTypeList, false, {&rocksdb_cold_data_types});
+  AddNumber("rocksdb-cold-data-seconds", false, &rocksdb_cold_data_seconds);
+  AddStringWithFunc("rocksdb-compaction-styles", &CheckCompactionStyles, false, {&rocksdb_compaction_styles});
+  AddStringWithFunc("rocksdb-db-compaction-styles", &CheckDbCompactionStyles, false, {&rocksdb_db_compaction_styles});
+  AddNumber("rocksdb-fifo-ttl", false, &rocksdb_fifo_ttl);
+  AddNumber("iterator-max-idle-ms", false, &iterator_max_idle_ms);
+  AddString("backup-path", true, {&backup_path});
+  AddNumber("backup-keep", true, &backup_keep);
+  AddNumber("backup-rate-limit", true, &backup_rate_limit);
+  AddNumber("backup-threads", true, &backup_threads);
+  AddString("backup-restore-path", false, {&backup_restore_path});
+  AddBool("write-throttle", &CheckYesNo, true, &write_throttle);
+  AddNumber("write-throttle-max-delay-us", true, &write_throttle_max_delay_us);
+  AddNumber("write-throttle-reject-percent", true, &write_throttle_reject_percent);
+  AddNumber("rocksdb-write-buffer-manager-size", false, &rocksdb_write_buffer_manager_size);
+  AddBool("rocksdb-write-buffer-manager-stall", &CheckYesNo, false, &rocksdb_write_buffer_manager_stall);
 }
 
 bool PConfig::LoadFromFile(const std::string& file_name) {
@@ -216,6 +393,11 @@ rocksdb::Options PConfig::GetRocksDBOptions() {
 
 rocksdb::BlockBasedTableOptions PConfig::GetRocksDBBlockBasedTableOptions() {
   rocksdb::BlockBasedTableOptions options;
+  // index and filter blocks live in the shared block cache too, so they count against its capacity,
+  // they are kept at high priority and the L0 ones are pinned since every read checks them
+  options.cache_index_and_filter_blocks = true;
+  options.cache_index_and_filter_blocks_with_high_priority = true;
+  options.pin_l0_filter_and_index_blocks_in_cache = true;
   return options;
 }
 
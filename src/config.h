@@ -34,6 +34,13 @@ class PConfig;
 
 extern PConfig g_config;
 
+// Parses a list of per DB values like "0:4,2:1", false when it is malformed
+bool ParseDbValueList(const std::string& list, std::map<int, int64_t>* values);
+
+// Parses a list like "list:universal,3:fifo" of level / universal / fifo by
+// data type or DB, false when it is malformed
+bool ParseCompactionStyleList(const std::string& list, std::map<std::string, rocksdb::CompactionStyle>* styles);
+
 class BaseValue {
  public:
   BaseValue(const std::string& key, CheckFunc check_func_ptr, bool rewritable = false)
@@ -228,6 +235,35 @@ class PConfig {
   std::atomic_int32_t fast_cmd_threads_num = 4;
   std::atomic_int32_t slow_cmd_threads_num = 4;
 
+  /*
+   * With autoscale on, the fast pool grows by a worker a second while its
+   * workers are busy more than 85% of the time or the queue backs up, up to
+   * cmd_threads_autoscale_max, and shrinks back towards fast_cmd_threads_num
+   * once they idle below 30%.
+   */
+  std::atomic_bool cmd_threads_autoscale = false;
+  std::atomic_int32_t cmd_threads_autoscale_max = 16;
+
+  /*
+   * The fast pool serves the DBs round robin, each taking as many commands
+   * per round as its weight (default 1), so a busy DB cannot starve the
+   * others. A DB may also be held to ops/sec and request bytes/sec, and a
+   * client gets -BUSY once its DB has max_queued commands waiting. All are
+   * lists like "0:4,2:1", the DBs left out are unlimited.
+   */
+  AtomicString qos_db_weights;
+  AtomicString qos_db_ops_limit;
+  AtomicString qos_db_bytes_limit;
+  AtomicString qos_db_max_queued;
+
+  /*
+   * The format new hashes, sets and zsets are written in, by DB: 1 is the full
+   * format, 2 the compact one with varint versions and 4 byte ctimes in the
+   * values. A list like "0:2,1:1", the DBs left out use 1. Both formats are
+   * read either way, CONVERTFORMAT rewrites the keys of a DB already written.
+   */
+  AtomicString data_format;
+
   // Limit the maximum number of bytes returned to the client.
   std::atomic_uint64_t max_client_response_size = 1073741824;
 
@@ -290,12 +326,53 @@ class PConfig {
   std::atomic_uint32_t worker_threads_num = 2;
   std::atomic_uint32_t slave_threads_num = 2;
 
+  /*
+   * Every network thread listens on its own SO_REUSEPORT socket. With
+   * this on, a new connection goes to the thread of the CPU that received
+   * it instead of by hash, which pays off when those threads are pinned.
+   */
+  std::atomic_bool reuseport_cpu_steering = false;
+
+  /*
+   * After handling events a network thread keeps polling without blocking
+   * for this many microseconds, so the next request of a busy client is
+   * picked up without a wakeup. 0 always blocks.
+   */
+  std::atomic_uint32_t io_busy_poll_us = 0;
+
+  /*
+   * CPU lists like "0-3,8", empty leaves the threads unpinned. Network
+   * thread i runs on the i-th CPU of its list and so does command worker
+   * i. The workers share one queue, so a command runs on whichever worker
+   * is free: the lists keep the threads on those CPUs, not a connection
+   * and its worker on one NUMA node. RocksDB background threads are pinned
+   * once the DBs are open, and again whenever RocksDB starts more.
+   */
+  AtomicString io_threads_cpu_list;
+  AtomicString cmd_threads_cpu_list;
+  AtomicString rocksdb_threads_cpu_list;
+
+  /*
+   * A Unix socket served next to the TCP port for the clients on this host,
+   * "@name" for the Linux abstract namespace. The permissions are octal,
+   * and unixsocket_allowed_uids ("0,1000") restricts the peers by uid.
+   */
+  AtomicString unix_socket;
+  AtomicString unix_socket_perm;
+  AtomicString unix_socket_allowed_uids;
+
   // How many RocksDB Instances will be opened?
   std::atomic<size_t> db_instance_num = 3;
 
   // Use raft protocol?
   std::atomic_bool use_raft = true;
 
+  // With raft, the writes skip the RocksDB WAL and the logs not yet flushed
+  // are replayed from the Raft log after a crash. A flush is forced once
+  // raft_max_replay_gap logs are in the memtables.
+  std::atomic_bool raft_log_as_wal = false;
+  std::atomic_int64_t raft_max_replay_gap = 1000;
+
   /*
    * PikiwiDB use the RocksDB to store the data,
    * and these options below will set to rocksdb::Options,
@@ -323,6 +400,70 @@ class PConfig {
   std::atomic_int rocksdb_level0_slowdown_writes_trigger = 20;
   std::atomic_int rocksdb_level0_stop_writes_trigger = 36;
 
+  /*
+   * One block cache and one write buffer manager are shared by every DB,
+   * RocksDB instance and column family, so these bound the memory of the
+   * whole process. The memtables are charged to the block cache as well.
+   */
+  // default 1G
+  std::atomic<size_t> rocksdb_block_cache_size = 1UL << 30;
+  // lru or hyperclock
+  AtomicString rocksdb_block_cache_type = "hyperclock";
+  // a compressed tier behind the block cache, 0 disables it
+  std::atomic<size_t> rocksdb_secondary_cache_size = 0;
+
+  /*
+   * Hot/cold tiering, off while rocksdb_cold_path is empty. The levels of the
+   * column families of rocksdb_cold_data_types that do not fit in
+   * rocksdb_hot_path_size bytes, per column family and RocksDB instance, go
+   * to rocksdb_cold_path and the last level is marked cold. The data written
+   * in the last rocksdb_cold_data_seconds is held out of the last level.
+   */
+  AtomicString rocksdb_cold_path;
+  std::atomic_uint64_t rocksdb_hot_path_size = 4ULL << 30;
+  AtomicString rocksdb_cold_data_types = "hash,set,list,zset,stream";
+  std::atomic_uint64_t rocksdb_cold_data_seconds = 0;
+
+  /*
+   * The compaction style of the column families of a data type, like
+   * "list:universal", and of all those of a DB, like "3:fifo", which wins.
+   * Under FIFO the SSTs older than rocksdb_fifo_ttl are dropped whole.
+   */
+  AtomicString rocksdb_compaction_styles;
+  AtomicString rocksdb_db_compaction_styles;
+  std::atomic_uint64_t rocksdb_fifo_ttl = 0;
+
+  // The iterators of the collection reads and SCANs are parked per thread
+  // and refreshed for the next read instead of built anew. One idle for
+  // longer than this is dropped, since it pins memtables and SSTs. 0 is off.
+  std::atomic_uint64_t iterator_max_idle_ms = 1000;
+
+  /*
+   * BGBACKUP backs every DB up under backup_path, a RocksDB BackupEngine per
+   * instance, so only the SSTs new since the last backup are copied. The
+   * latest backup_keep are kept. At startup the DBs with an empty path are
+   * restored from the latest backup under backup_restore_path.
+   */
+  AtomicString backup_path;
+  std::atomic_uint32_t backup_keep = 7;
+  std::atomic_uint64_t backup_rate_limit = 0;
+  std::atomic_uint32_t backup_threads = 4;
+  AtomicString backup_restore_path;
+
+  /*
+   * A write to a RocksDB instance with a compaction backlog first waits, up
+   * to write_throttle_max_delay_us as the backlog nears a write stop, and is
+   * turned away with BUSY once its pressure reaches
+   * write_throttle_reject_percent (0 for never), before RocksDB stops it.
+   */
+  std::atomic_bool write_throttle = true;
+  std::atomic_uint64_t write_throttle_max_delay_us = 2000;
+  std::atomic_uint32_t write_throttle_reject_percent = 90;
+  // default 512M
+  std::atomic<size_t> rocksdb_write_buffer_manager_size = 512UL << 20;
+  // stall the writes once the memtables exceed the budget
+  std::atomic_bool rocksdb_write_buffer_manager_stall = true;
+
   // 86400 * 7 = 604800
   std::atomic_uint64_t rocksdb_ttl_second = 604800;
 
@@ -11,23 +11,111 @@
 #include "db.h"
 #include <algorithm>
 
+#include "client.h"
+#include "cmd_thread_pool.h"
 #include "config.h"
+#include "pikiwidb.h"
 #include "praft/praft.h"
 #include "pstd/log.h"
+#include "pstd/pstd_string.h"
+#include "store.h"
 
 extern pikiwidb::PConfig g_config;
 
 namespace pikiwidb {
 
+static bool UseCompactDataFormat(int db_index) {
+  std::map<int, int64_t> formats;
+  ParseDbValueList(g_config.data_format.ToString(), &formats);
+  auto it = formats.find(db_index);
+  return it != formats.end() && it->second == 2;
+}
+
+static void SetTiering(storage::StorageOptions* storage_options) {
+  storage_options->cold_path = g_config.rocksdb_cold_path.ToString();
+  storage_options->hot_path_size = g_config.rocksdb_hot_path_size.load();
+  storage_options->cold_data_seconds = g_config.rocksdb_cold_data_seconds.load();
+  std::vector<std::string> names;
+  pstd::StringSplit(g_config.rocksdb_cold_data_types.ToString(), ',', names);
+  for (const auto& name : names) {
+    for (auto type : {storage::DataType::kStrings, storage::DataType::kHashes, storage::DataType::kSets,
+                      storage::DataType::kLists, storage::DataType::kZSets, storage::DataType::kStreams}) {
+      if (pstd::StringTrim(name) == storage::DataTypeToString(type)) {
+        storage_options->cold_data_types.push_back(type);
+      }
+    }
+  }
+}
+
+static void SetCompactionStyles(int db_index, storage::StorageOptions* storage_options) {
+  static const std::vector<storage::DataType> kTypes{storage::DataType::kStrings, storage::DataType::kHashes,
+                                                     storage::DataType::kSets,    storage::DataType::kLists,
+                                                     storage::DataType::kZSets,   storage::DataType::kStreams};
+  std::map<std::string, rocksdb::CompactionStyle> styles;
+  ParseCompactionStyleList(g_config.rocksdb_compaction_styles.ToString(), &styles);
+  for (auto type : kTypes) {
+    auto it = styles.find(storage::DataTypeToString(type));
+    if (it != styles.end()) {
+      storage_options->compaction_styles[type] = it->second;
+    }
+  }
+
+  // the style of the DB is for all its column families
+  std::map<std::string, rocksdb::CompactionStyle> db_styles;
+  ParseCompactionStyleList(g_config.rocksdb_db_compaction_styles.ToString(), &db_styles);
+  auto it = db_styles.find(std::to_string(db_index));
+  if (it != db_styles.end()) {
+    for (auto type : kTypes) {
+      storage_options->compaction_styles[type] = it->second;
+    }
+  }
+  storage_options->fifo_ttl_seconds = g_config.rocksdb_fifo_ttl.load();
+}
+
 DB::DB(int db_index, const std::string& db_path)
     : db_index_(db_index), db_path_(db_path + std::to_string(db_index_) + '/') {}
 
 DB::~DB() { INFO("DB{} is closing...", db_index_); }
 
+// the DBs whose lock the thread holds, a command locks one or a few
+static thread_local std::vector<const DB*> t_locked_dbs;
+
+void DB::Lock() {
+  storage_mutex_.lock();
+  t_locked_dbs.push_back(this);
+}
+
+void DB::UnLock() {
+  std::erase(t_locked_dbs, this);
+  storage_mutex_.unlock();
+}
+
+void DB::LockShared() {
+  storage_mutex_.lock_shared();
+  t_locked_dbs.push_back(this);
+}
+
+void DB::UnLockShared() {
+  std::erase(t_locked_dbs, this);
+  storage_mutex_.unlock_shared();
+}
+
+bool DB::LockSharedUnlessHeld() {
+  if (std::find(t_locked_dbs.begin(), t_locked_dbs.end(), this) != t_locked_dbs.end()) {
+    return false;
+  }
+  LockShared();
+  return true;
+}
+
 rocksdb::Status DB::Open() {
   storage::StorageOptions storage_options;
   storage_options.options = g_config.GetRocksDBOptions();
   storage_options.table_options = g_config.GetRocksDBBlockBasedTableOptions();
+  storage_options.table_options.block_cache = PSTORE.GetBlockCache();
+  storage_options.share_block_cache = true;
+  storage_options.options.write_buffer_manager = PSTORE.GetWriteBufferManager();
+  storage_options.options.statistics = PSTORE.GetStatistics();
 
   storage_options.options.ttl = g_config.rocksdb_ttl_second.load(std::memory_order_relaxed);
   storage_options.options.periodic_compaction_seconds =
@@ -44,11 +132,22 @@ rocksdb::Status DB::Open() {
       raft->DoSnapshot(std::forward<decltype(self_snapshot_index)>(self_snapshot_index),
                        std::forward<decltype(is_sync)>(is_sync));
     };
+    storage_options.raft_log_as_wal = g_config.raft_log_as_wal.load();
+    storage_options.max_gap = g_config.raft_max_replay_gap.load();
   }
 
   storage_options.db_instance_num = g_config.db_instance_num.load();
   storage_options.db_id = db_index_;
+  storage_options.compact_data_format = UseCompactDataFormat(db_index_);
+  SetTiering(&storage_options);
+  SetCompactionStyles(db_index_, &storage_options);
+  storage_options.iterator_max_idle_ms = g_config.iterator_max_idle_ms.load();
+  storage_options.open_progress_function = [db = db_index_](size_t index, storage::OpenStage stage) {
+    PSTORE.UpdateOpenProgress(db, index, stage);
+  };
 
+  StopBackup();
+  std::lock_guard backupLock(backup_mutex_);
   std::unique_ptr<storage::Storage> old_storage = std::move(storage_);
   if (old_storage != nullptr) {
     old_storage->Close();
@@ -62,6 +161,8 @@ rocksdb::Status DB::Open() {
   }
 
   opened_ = true;
+  // the data may have been replaced (e.g. FLUSHDB), so abort every pending transaction
+  TouchAllKeys();
   INFO("Open DB{} success!", db_index_);
   return rocksdb::Status::OK();
 }
@@ -82,6 +183,70 @@ void DB::CreateCheckpoint(const std::string& checkpoint_path, bool sync) {
   }
 }
 
+rocksdb::Status DB::CreateBackup(const std::string& path, const storage::BackupOptions& options) {
+  auto backup_sub_path = path + '/' + std::to_string(db_index_);
+  if (0 != pstd::CreatePath(backup_sub_path)) {
+    WARN("Create dir {} fail !", backup_sub_path);
+    return rocksdb::Status::IOError("Create directory fail", backup_sub_path);
+  }
+
+  // Only the start of the backup takes the shared lock, the copy runs without it so a FLUSHDB
+  // is not held up for that long. The instances outlive the backup: a reopen stops it, which
+  // fails it, and then waits on backup_mutex_ only for the copy threads to return.
+  std::lock_guard backupLock(backup_mutex_);
+  std::vector<std::future<rocksdb::Status>> results;
+  {
+    std::shared_lock sharedLock(storage_mutex_);
+    if (!opened_) {
+      return rocksdb::Status::Incomplete("DB is not open");
+    }
+    results = storage_->CreateBackup(backup_sub_path, options);
+  }
+  rocksdb::Status status;
+  for (auto& r : results) {
+    auto s = r.get();
+    if (status.ok() && !s.ok()) {
+      status = s;
+    }
+  }
+  return status;
+}
+
+void DB::StopBackup() {
+  std::shared_lock sharedLock(storage_mutex_);
+  if (storage_ != nullptr) {
+    storage_->StopBackup();
+  }
+}
+
+rocksdb::Status DB::RestoreBackup(const std::string& path) {
+  auto backup_sub_path = path + '/' + std::to_string(db_index_);
+  if (0 != pstd::IsDir(backup_sub_path)) {
+    return rocksdb::Status::OK();
+  }
+  std::vector<std::string> children;
+  if (0 == pstd::IsDir(db_path_) && (pstd::GetChildren(db_path_, children) != 0 || !children.empty())) {
+    INFO("DB{} has data in {}, the backup {} is not restored", db_index_, db_path_, backup_sub_path);
+    return rocksdb::Status::OK();
+  }
+
+  rocksdb::Status status;
+  for (auto& r : storage::Storage::RestoreBackup(backup_sub_path, db_path_, g_config.db_instance_num.load())) {
+    auto s = r.get();
+    if (status.ok() && !s.ok()) {
+      status = s;
+    }
+  }
+  if (!status.ok()) {
+    // the path was empty, removing what was copied lets the next start restore it again
+    pstd::DeleteDirIfExist(db_path_);
+    WARN("DB{} restore the backup {} fail: {}", db_index_, backup_sub_path, status.ToString());
+    return status;
+  }
+  INFO("DB{} restore the backup {} success!", db_index_, backup_sub_path);
+  return status;
+}
+
 void DB::LoadDBFromCheckpoint(const std::string& checkpoint_path, bool sync [[maybe_unused]]) {
   auto checkpoint_sub_path = checkpoint_path + '/' + std::to_string(db_index_);
   if (0 != pstd::IsDir(checkpoint_sub_path)) {
@@ -95,6 +260,8 @@ void DB::LoadDBFromCheckpoint(const std::string& checkpoint_path, bool sync [[ma
     }
   }
 
+  StopBackup();
+  std::lock_guard backupLock(backup_mutex_);
   std::lock_guard<std::shared_mutex> lock(storage_mutex_);
   opened_ = false;
   // close the old storage, then open the new storage
@@ -112,8 +279,17 @@ void DB::LoadDBFromCheckpoint(const std::string& checkpoint_path, bool sync [[ma
 
   storage::StorageOptions storage_options;
   storage_options.options = g_config.GetRocksDBOptions();
+  storage_options.table_options = g_config.GetRocksDBBlockBasedTableOptions();
+  storage_options.table_options.block_cache = PSTORE.GetBlockCache();
+  storage_options.share_block_cache = true;
+  storage_options.options.write_buffer_manager = PSTORE.GetWriteBufferManager();
+  storage_options.options.statistics = PSTORE.GetStatistics();
   storage_options.db_instance_num = g_config.db_instance_num.load();
   storage_options.db_id = db_index_;
+  storage_options.compact_data_format = UseCompactDataFormat(db_index_);
+  SetTiering(&storage_options);
+  SetCompactionStyles(db_index_, &storage_options);
+  storage_options.iterator_max_idle_ms = g_config.iterator_max_idle_ms.load();
 
   // options for CF
   storage_options.options.ttl = g_config.rocksdb_ttl_second.load(std::memory_order_relaxed);
@@ -125,6 +301,8 @@ void DB::LoadDBFromCheckpoint(const std::string& checkpoint_path, bool sync [[ma
     };
     storage_options.do_snapshot_function =
         std::bind(&pikiwidb::PRaft::DoSnapshot, &pikiwidb::PRAFT, std::placeholders::_1, std::placeholders::_2);
+    storage_options.raft_log_as_wal = g_config.raft_log_as_wal.load();
+    storage_options.max_gap = g_config.raft_max_replay_gap.load();
   }
 
   if (auto s = storage_->Open(storage_options, db_path_); !s.ok()) {
@@ -138,6 +316,187 @@ void DB::LoadDBFromCheckpoint(const std::string& checkpoint_path, bool sync [[ma
   }
 
   opened_ = true;
+  TouchAllKeys();
   INFO("DB{} load a checkpoint from {} success!", db_index_, checkpoint_path);
 }
+
+uint64_t DB::WatchKey(const std::string& key) {
+  std::lock_guard lock(watch_mutex_);
+  auto [it, inserted] = watched_keys_.try_emplace(key);
+  if (inserted) {
+    it->second.version = watch_version_;
+    watched_key_count_.fetch_add(1, std::memory_order_release);
+  }
+  ++it->second.watchers;
+  return it->second.version;
+}
+
+void DB::UnWatchKey(const std::string& key) {
+  std::lock_guard lock(watch_mutex_);
+  auto it = watched_keys_.find(key);
+  if (it == watched_keys_.end()) {
+    return;
+  }
+  if (--it->second.watchers == 0) {
+    watched_keys_.erase(it);
+    watched_key_count_.fetch_sub(1, std::memory_order_release);
+  }
+}
+
+uint64_t DB::KeyVersion(const std::string& key) const {
+  std::lock_guard lock(watch_mutex_);
+  auto it = watched_keys_.find(key);
+  return it == watched_keys_.end() ? 0 : it->second.version;
+}
+
+void DB::TouchKeys(std::span<const std::string> keys) {
+  if (!HasWatchedKeys()) {
+    return;
+  }
+  std::lock_guard lock(watch_mutex_);
+  for (const auto& key : keys) {
+    if (auto it = watched_keys_.find(key); it != watched_keys_.end()) {
+      it->second.version = ++watch_version_;
+    }
+  }
+}
+
+rocksdb::Status DB::Flush() {
+  std::lock_guard lock(storage_mutex_);
+  auto s = storage_->FlushDB();
+  if (s.ok()) {
+    TouchAllKeys();
+  }
+  return s;
+}
+
+void DB::TouchAllKeys() {
+  if (!HasWatchedKeys()) {
+    return;
+  }
+  std::lock_guard lock(watch_mutex_);
+  ++watch_version_;
+  for (auto& [_, watched] : watched_keys_) {
+    watched.version = watch_version_;
+  }
+}
+
+void DB::BlockClient(const std::shared_ptr<PClient>& client) {
+  bool parked = false;
+  // read before the client is parked, once it is a write may run its command again
+  auto deadline = client->BlockDeadline();
+  {
+    std::lock_guard lock(block_mutex_);
+    // Published before the version is checked again: SignalKeyReady bumps the
+    // version before reading the count, so one of the two always sees the other.
+    blocked_client_count_.fetch_add(1);
+    // a client closed before it got here is not parked, OnClose has run or drops it under the lock
+    if (client->BlockReadyVersion() == ready_version_.load() && client->State() == ClientState::kOK) {
+      for (const auto& key : client->Keys()) {
+        blocked_keys_[key].push_back(client);
+      }
+      blocked_clients_[client->GetConnId()] = client;
+      parked = true;
+    } else {
+      blocked_client_count_.fetch_sub(1);
+    }
+  }
+
+  if (parked) {
+    if (deadline != std::chrono::steady_clock::time_point::max()) {
+      auto expire = std::chrono::ceil<std::chrono::milliseconds>(deadline.time_since_epoch()).count();
+      std::weak_ptr<PClient> weak = client;
+      g_pikiwidb->AddClientTimer(client, expire, [this, weak] {
+        if (auto client = weak.lock()) {
+          ExpireBlockedClient(client);
+        }
+      });
+    }
+    return;
+  }
+  if (client->State() != ClientState::kOK) {
+    return;
+  }
+
+  // a key got ready while the command was reading, run it again
+  client->ClearFlag(kClientFlagBlocked);
+  g_pikiwidb->SubmitFast(std::make_shared<CmdThreadPoolTask>(client), false);
+}
+
+void DB::SignalKeyReady(const std::string& key) {
+  ready_version_.fetch_add(1);
+  if (blocked_client_count_.load() == 0) {
+    return;
+  }
+
+  std::vector<std::shared_ptr<PClient>> ready;
+  {
+    std::lock_guard lock(block_mutex_);
+    auto it = blocked_keys_.find(key);
+    if (it == blocked_keys_.end()) {
+      return;
+    }
+    for (const auto& weak : it->second) {
+      if (auto client = weak.lock()) {
+        ready.push_back(std::move(client));
+      }
+    }
+    for (const auto& client : ready) {
+      UnblockClientLocked(client);
+    }
+  }
+
+  for (const auto& client : ready) {
+    if (client->State() == ClientState::kOK) {
+      client->ClearFlag(kClientFlagBlocked);
+      g_pikiwidb->SubmitFast(std::make_shared<CmdThreadPoolTask>(client), false);
+    }
+  }
+}
+
+void DB::UnblockClient(const std::shared_ptr<PClient>& client) {
+  std::lock_guard lock(block_mutex_);
+  // Keys() only stays put while the client is parked, a running command may change it
+  if (blocked_clients_.contains(client->GetConnId())) {
+    UnblockClientLocked(client);
+  }
+}
+
+void DB::ExpireBlockedClient(const std::shared_ptr<PClient>& client) {
+  {
+    std::lock_guard lock(block_mutex_);
+    // woken up or closed meanwhile, or parked again with a later deadline and a timer of its own
+    auto it = blocked_clients_.find(client->GetConnId());
+    if (it == blocked_clients_.end() || it->second.lock() != client ||
+        client->BlockDeadline() > std::chrono::steady_clock::now()) {
+      return;
+    }
+    UnblockClientLocked(client);
+  }
+
+  client->ClearBlock();
+  client->AppendArrayLen(-1);
+  g_pikiwidb->PushWriteTask(client);
+}
+
+void DB::UnblockClientLocked(const std::shared_ptr<PClient>& client) {
+  auto is_client = [&client](const std::weak_ptr<PClient>& weak) {
+    auto other = weak.lock();
+    return !other || other == client;
+  };
+  for (const auto& key : client->Keys()) {
+    auto it = blocked_keys_.find(key);
+    if (it == blocked_keys_.end()) {
+      continue;
+    }
+    std::erase_if(it->second, is_client);
+    if (it->second.empty()) {
+      blocked_keys_.erase(it);
+    }
+  }
+  if (blocked_clients_.erase(client->GetConnId()) > 0) {
+    blocked_client_count_.fetch_sub(1);
+  }
+}
+
 }  // namespace pikiwidb
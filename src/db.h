@@ -10,8 +10,15 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <filesystem>
+#include <memory>
+#include <mutex>
+#include <span>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "pstd/log.h"
 #include "pstd/noncopyable.h"
@@ -19,6 +26,8 @@
 
 namespace pikiwidb {
 
+class PClient;
+
 class DB {
  public:
   DB(int db_index, const std::string& db_path);
@@ -28,21 +37,68 @@ class DB {
 
   std::unique_ptr<storage::Storage>& GetStorage() { return storage_; }
 
-  void Lock() { storage_mutex_.lock(); }
+  void Lock();
+
+  void UnLock();
 
-  void UnLock() { storage_mutex_.unlock(); }
+  void LockShared();
 
-  void LockShared() { storage_mutex_.lock_shared(); }
+  void UnLockShared();
 
-  void UnLockShared() { storage_mutex_.unlock_shared(); }
+  // For the code that may run inside a command, e.g. INFO: the command already holds the lock
+  // of its DB, and EXEC the exclusive one of its DBs, taking it again would deadlock. Takes the
+  // shared lock unless the calling thread holds the lock, returns whether it took it.
+  bool LockSharedUnlessHeld();
 
   void CreateCheckpoint(const std::string& path, bool sync);
 
   void LoadDBFromCheckpoint(const std::string& path, bool sync = true);
 
+  // Backs the DB up under <path>/<db index>, only the SSTs new since the last backup are copied
+  rocksdb::Status CreateBackup(const std::string& path, const storage::BackupOptions& options);
+
+  // Fills the DB path from the latest backup under <path>/<db index> before Open, a DB with data is left as it is
+  rocksdb::Status RestoreBackup(const std::string& path);
+
+  // Empties the DB in place, the exclusive lock is only held while the range deletions are written
+  rocksdb::Status Flush();
+
   int GetDbIndex() { return db_index_; }
 
+  // Optimistic transactions: WATCH remembers the version of a key and EXEC
+  // compares it again. Only watched keys are tracked, so a write to a key
+  // nobody watches costs a single atomic load.
+  uint64_t WatchKey(const std::string& key);
+  void UnWatchKey(const std::string& key);
+  uint64_t KeyVersion(const std::string& key) const;
+  void TouchKeys(std::span<const std::string> keys);
+  void TouchAllKeys();
+  bool HasWatchedKeys() const { return watched_key_count_.load(std::memory_order_acquire) > 0; }
+
+  // Blocking reads: a read that found nothing parks its client on the keys,
+  // a write to one of them submits the command again. A client reads
+  // ReadyVersion() before looking at the data, if a key got ready in the
+  // meantime BlockClient retries at once instead of missing the wake up.
+  uint64_t ReadyVersion() const { return ready_version_.load(std::memory_order_acquire); }
+  // A timer on the I/O thread of the client expires it at its deadline.
+  void BlockClient(const std::shared_ptr<PClient>& client);
+  void SignalKeyReady(const std::string& key);
+  // drops a closed client
+  void UnblockClient(const std::shared_ptr<PClient>& client);
+
  private:
+  // drops the client from blocked_keys_ and blocked_clients_, block_mutex_ must be held
+  void UnblockClientLocked(const std::shared_ptr<PClient>& client);
+  // replies the null array to the client if it is still parked here once its timeout expired
+  void ExpireBlockedClient(const std::shared_ptr<PClient>& client);
+  // fails the running backup, so a reopen only waits for its copy threads to return
+  void StopBackup();
+
+  struct WatchedKey {
+    uint64_t version = 0;
+    uint32_t watchers = 0;
+  };
+
   const int db_index_ = 0;
   const std::string db_path_;
   /**
@@ -54,6 +110,19 @@ class DB {
   std::shared_mutex storage_mutex_;
   std::unique_ptr<storage::Storage> storage_;
   bool opened_ = false;
+  // held by a backup, which runs without the storage lock, and by a reopen, which stops it first
+  std::mutex backup_mutex_;
+
+  mutable std::mutex watch_mutex_;
+  std::unordered_map<std::string, WatchedKey> watched_keys_;
+  std::atomic<size_t> watched_key_count_ = 0;
+  uint64_t watch_version_ = 0;  // DB wide clock, so a re-watched key never repeats an old version
+
+  std::mutex block_mutex_;
+  std::unordered_map<std::string, std::vector<std::weak_ptr<PClient>>> blocked_keys_;
+  std::unordered_map<uint64_t, std::weak_ptr<PClient>> blocked_clients_;  // by connection id
+  std::atomic<size_t> blocked_client_count_ = 0;
+  std::atomic<uint64_t> ready_version_ = 0;
 };
 
 }  // namespace pikiwidb
@@ -0,0 +1,356 @@
+// Copyright (c) 2024-present, OpenAtom Foundation, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory
+
+/*
+  Implemented the geohash helpers of the geo commands.
+ */
+
+#include "geohash.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#  include <emmintrin.h>
+#elif defined(__aarch64__)
+#  include <arm_neon.h>
+#endif
+
+namespace pikiwidb {
+
+// the constants Redis uses, so distances match
+static constexpr double kEarthRadiusInMeters = 6372797.560856;
+static constexpr double kMercatorMax = 20037726.37;
+static constexpr double kDegToRad = M_PI / 180.0;
+
+static inline double DegRad(double ang) { return ang * kDegToRad; }
+static inline double RadDeg(double ang) { return ang / kDegToRad; }
+
+// spreads the low 32 bits of x to the even bits
+static uint64_t Interleave(uint32_t x) {
+  uint64_t v = x;
+  v = (v | (v << 16)) & 0x0000FFFF0000FFFFULL;
+  v = (v | (v << 8)) & 0x00FF00FF00FF00FFULL;
+  v = (v | (v << 4)) & 0x0F0F0F0F0F0F0F0FULL;
+  v = (v | (v << 2)) & 0x3333333333333333ULL;
+  v = (v | (v << 1)) & 0x5555555555555555ULL;
+  return v;
+}
+
+// gathers the even bits of v
+static uint32_t Deinterleave(uint64_t v) {
+  v &= 0x5555555555555555ULL;
+  v = (v | (v >> 1)) & 0x3333333333333333ULL;
+  v = (v | (v >> 2)) & 0x0F0F0F0F0F0F0F0FULL;
+  v = (v | (v >> 4)) & 0x00FF00FF00FF00FFULL;
+  v = (v | (v >> 8)) & 0x0000FFFF0000FFFFULL;
+  v = (v | (v >> 16)) & 0x00000000FFFFFFFFULL;
+  return static_cast<uint32_t>(v);
+}
+
+bool GeoCoordValid(double lon, double lat) {
+  return lon >= kGeoLongMin && lon <= kGeoLongMax && lat >= kGeoLatMin && lat <= kGeoLatMax;
+}
+
+// latitude in the even bits, longitude in the odd ones
+uint64_t GeoHashEncode(double lon, double lat, int step) {
+  double lat_offset = (lat - kGeoLatMin) / (kGeoLatMax - kGeoLatMin);
+  double lon_offset = (lon - kGeoLongMin) / (kGeoLongMax - kGeoLongMin);
+  auto cells = static_cast<double>(1ULL << step);
+  auto lat_cell = std::min<uint64_t>(static_cast<uint64_t>(lat_offset * cells), (1ULL << step) - 1);
+  auto lon_cell = std::min<uint64_t>(static_cast<uint64_t>(lon_offset * cells), (1ULL << step) - 1);
+  return Interleave(static_cast<uint32_t>(lat_cell)) | (Interleave(static_cast<uint32_t>(lon_cell)) << 1);
+}
+
+GeoHashArea GeoHashDecode(uint64_t bits, int step) {
+  auto cells = static_cast<double>(1ULL << step);
+  double lat_cell = Deinterleave(bits);
+  double lon_cell = Deinterleave(bits >> 1);
+  GeoHashArea area;
+  area.lat_min = kGeoLatMin + (lat_cell / cells) * (kGeoLatMax - kGeoLatMin);
+  area.lat_max = kGeoLatMin + ((lat_cell + 1) / cells) * (kGeoLatMax - kGeoLatMin);
+  area.lon_min = kGeoLongMin + (lon_cell / cells) * (kGeoLongMax - kGeoLongMin);
+  area.lon_max = kGeoLongMin + ((lon_cell + 1) / cells) * (kGeoLongMax - kGeoLongMin);
+  return area;
+}
+
+void GeoHashDecodeCenter(uint64_t bits, double* lon, double* lat) {
+  GeoHashArea area = GeoHashDecode(bits);
+  *lon = std::clamp((area.lon_min + area.lon_max) / 2, kGeoLongMin, kGeoLongMax);
+  *lat = std::clamp((area.lat_min + area.lat_max) / 2, kGeoLatMin, kGeoLatMax);
+}
+
+double GeoDistance(double lon1, double lat1, double lon2, double lat2) {
+  double lat1r = DegRad(lat1);
+  double lat2r = DegRad(lat2);
+  double u = std::sin((lat2r - lat1r) / 2);
+  double v = std::sin((DegRad(lon2) - DegRad(lon1)) / 2);
+  return 2.0 * kEarthRadiusInMeters * std::asin(std::sqrt(u * u + std::cos(lat1r) * std::cos(lat2r) * v * v));
+}
+
+// the coarsest step whose cells are still about as large as the radius
+static int EstimateSteps(double range, double lat) {
+  if (range == 0) {
+    return kGeoStepMax;
+  }
+  int step = 1;
+  while (range < kMercatorMax) {
+    range *= 2;
+    step++;
+  }
+  step -= 2;
+  // cells shrink towards the poles
+  if (lat > 66 || lat < -66) {
+    step--;
+    if (lat > 80 || lat < -80) {
+      step--;
+    }
+  }
+  return std::clamp(step, 1, kGeoStepMax);
+}
+
+// moves the cell along the longitude (odd bits) or the latitude (even bits)
+static uint64_t MoveCell(uint64_t bits, int step, int d, bool longitude) {
+  if (d == 0) {
+    return bits;
+  }
+  uint64_t mask = longitude ? 0xaaaaaaaaaaaaaaaaULL : 0x5555555555555555ULL;
+  uint64_t moving = bits & mask;
+  uint64_t fixed = bits & ~mask;
+  uint64_t zz = ~mask >> (64 - step * 2);
+  if (d > 0) {
+    moving = moving + (zz + 1);
+  } else {
+    moving = moving | zz;
+    moving = moving - (zz + 1);
+  }
+  moving &= mask >> (64 - step * 2);
+  return moving | fixed;
+}
+
+std::vector<std::pair<double, double>> GeoCoverShape(const GeoShape& shape) {
+  double half_width = shape.type == GeoShape::kRadius ? shape.radius : shape.width / 2;
+  double half_height = shape.type == GeoShape::kRadius ? shape.radius : shape.height / 2;
+
+  // bounding box of the shape
+  double lat_delta = RadDeg(half_height / kEarthRadiusInMeters);
+  double lon_delta_top = RadDeg(half_width / kEarthRadiusInMeters / std::cos(DegRad(shape.lat + lat_delta)));
+  double lon_delta_bottom = RadDeg(half_width / kEarthRadiusInMeters / std::cos(DegRad(shape.lat - lat_delta)));
+  double lon_delta = std::max(lon_delta_top, lon_delta_bottom);
+  GeoHashArea bounds{shape.lon - lon_delta, shape.lon + lon_delta, shape.lat - lat_delta, shape.lat + lat_delta};
+
+  int step = EstimateSteps(std::sqrt(half_width * half_width + half_height * half_height), shape.lat);
+  uint64_t center = GeoHashEncode(shape.lon, shape.lat, step);
+  // the neighbours must reach the bounding box, otherwise use larger cells
+  if (step > 1) {
+    GeoHashArea north = GeoHashDecode(MoveCell(center, step, 1, false), step);
+    GeoHashArea south = GeoHashDecode(MoveCell(center, step, -1, false), step);
+    GeoHashArea east = GeoHashDecode(MoveCell(center, step, 1, true), step);
+    GeoHashArea west = GeoHashDecode(MoveCell(center, step, -1, true), step);
+    if (north.lat_max < bounds.lat_max || south.lat_min > bounds.lat_min || east.lon_max < bounds.lon_max ||
+        west.lon_min > bounds.lon_min) {
+      step--;
+      center = GeoHashEncode(shape.lon, shape.lat, step);
+    }
+  }
+
+  static constexpr int kMoves[9][2] = {{0, 0},  {0, 1},   {0, -1}, {1, 0},  {-1, 0},
+                                       {1, 1},  {-1, 1},  {1, -1}, {-1, -1}};
+  std::vector<uint64_t> cells;
+  std::vector<std::pair<double, double>> ranges;
+  int shift = (kGeoStepMax - step) * 2;
+  for (const auto& move : kMoves) {
+    uint64_t cell = MoveCell(MoveCell(center, step, move[0], true), step, move[1], false);
+    if (std::find(cells.begin(), cells.end(), cell) != cells.end()) {
+      continue;
+    }
+    cells.push_back(cell);
+    GeoHashArea area = GeoHashDecode(cell, step);
+    // a neighbour can sit completely outside the bounding box when the step was not lowered
+    if (move[0] != 0 || move[1] != 0) {
+      if (area.lat_min > bounds.lat_max || area.lat_max < bounds.lat_min ||
+          (bounds.lon_min >= kGeoLongMin && bounds.lon_max <= kGeoLongMax &&
+           (area.lon_min > bounds.lon_max || area.lon_max < bounds.lon_min))) {
+        continue;
+      }
+    }
+    ranges.emplace_back(static_cast<double>(cell << shift), static_cast<double>((cell + 1) << shift));
+  }
+  return ranges;
+}
+
+// what GeoFilterBatch checks a point against, in radians
+struct GeoFilterArgs {
+  bool radius = true;
+  double lat0 = 0;
+  double lon0 = 0;
+  double cos_lat0 = 0;
+  double limit = 0;      // kRadius: the largest haversine term inside the circle
+  double lat_limit = 0;  // kBox: the largest latitude difference inside the box
+  double lon_limit = 0;  // kBox: the largest |cos(lat) * sin(dlon / 2)| inside the box
+};
+
+#if defined(__SSE2__) || defined(__aarch64__)
+
+// Two points per step, on SSE2 or NEON. sin and cos are a polynomial over the
+// lanes, the rest is plain lane arithmetic.
+
+#  if defined(__SSE2__)
+using GeoLanes = __m128d;
+using GeoMask = __m128d;
+
+static inline GeoLanes LanesSet(double x) { return _mm_set1_pd(x); }
+static inline GeoLanes LanesLoad(const double* p) { return _mm_loadu_pd(p); }
+static inline void LanesStore(double* p, GeoLanes x) { _mm_storeu_pd(p, x); }
+static inline GeoLanes LanesAdd(GeoLanes a, GeoLanes b) { return _mm_add_pd(a, b); }
+static inline GeoLanes LanesSub(GeoLanes a, GeoLanes b) { return _mm_sub_pd(a, b); }
+static inline GeoLanes LanesMul(GeoLanes a, GeoLanes b) { return _mm_mul_pd(a, b); }
+static inline GeoLanes LanesAbs(GeoLanes x) { return _mm_andnot_pd(_mm_set1_pd(-0.0), x); }
+static inline GeoMask LanesLe(GeoLanes a, GeoLanes b) { return _mm_cmple_pd(a, b); }
+static inline GeoMask LanesGt(GeoLanes a, GeoLanes b) { return _mm_cmpgt_pd(a, b); }
+static inline GeoMask MaskAnd(GeoMask a, GeoMask b) { return _mm_and_pd(a, b); }
+static inline GeoLanes LanesSelect(GeoMask mask, GeoLanes a, GeoLanes b) {
+  return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b));
+}
+static inline void MaskStore(uint8_t* p, GeoMask mask) {
+  int bits = _mm_movemask_pd(mask);
+  p[0] = bits & 1;
+  p[1] = (bits >> 1) & 1;
+}
+#  else
+using GeoLanes = float64x2_t;
+using GeoMask = uint64x2_t;
+
+static inline GeoLanes LanesSet(double x) { return vdupq_n_f64(x); }
+static inline GeoLanes LanesLoad(const double* p) { return vld1q_f64(p); }
+static inline void LanesStore(double* p, GeoLanes x) { vst1q_f64(p, x); }
+static inline GeoLanes LanesAdd(GeoLanes a, GeoLanes b) { return vaddq_f64(a, b); }
+static inline GeoLanes LanesSub(GeoLanes a, GeoLanes b) { return vsubq_f64(a, b); }
+static inline GeoLanes LanesMul(GeoLanes a, GeoLanes b) { return vmulq_f64(a, b); }
+static inline GeoLanes LanesAbs(GeoLanes x) { return vabsq_f64(x); }
+static inline GeoMask LanesLe(GeoLanes a, GeoLanes b) { return vcleq_f64(a, b); }
+static inline GeoMask LanesGt(GeoLanes a, GeoLanes b) { return vcgtq_f64(a, b); }
+static inline GeoMask MaskAnd(GeoMask a, GeoMask b) { return vandq_u64(a, b); }
+static inline GeoLanes LanesSelect(GeoMask mask, GeoLanes a, GeoLanes b) { return vbslq_f64(mask, a, b); }
+static inline void MaskStore(uint8_t* p, GeoMask mask) {
+  p[0] = vgetq_lane_u64(mask, 0) != 0;
+  p[1] = vgetq_lane_u64(mask, 1) != 0;
+}
+#  endif
+
+static constexpr size_t kGeoLanes = 2;
+
+// the Taylor series of sin up to x^21, highest term first, within an ulp or two of std::sin on [-pi/2, pi/2]
+static constexpr double kSinTerms[] = {1.0 / 51090942171709440000.0,
+                                       -1.0 / 121645100408832000.0,
+                                       1.0 / 355687428096000.0,
+                                       -1.0 / 1307674368000.0,
+                                       1.0 / 6227020800.0,
+                                       -1.0 / 39916800.0,
+                                       1.0 / 362880.0,
+                                       -1.0 / 5040.0,
+                                       1.0 / 120.0,
+                                       -1.0 / 6.0,
+                                       1.0};
+
+// sin of every lane, |x| <= pi
+static inline GeoLanes LanesSin(GeoLanes x) {
+  // sin(x) = sin(pi - x) = sin(-pi - x) folds x into [-pi/2, pi/2]
+  x = LanesSelect(LanesGt(x, LanesSet(M_PI / 2)), LanesSub(LanesSet(M_PI), x), x);
+  x = LanesSelect(LanesGt(LanesSet(-M_PI / 2), x), LanesSub(LanesSet(-M_PI), x), x);
+  GeoLanes x2 = LanesMul(x, x);
+  GeoLanes sum = LanesSet(kSinTerms[0]);
+  for (size_t i = 1; i < sizeof(kSinTerms) / sizeof(kSinTerms[0]); i++) {
+    sum = LanesAdd(LanesMul(sum, x2), LanesSet(kSinTerms[i]));
+  }
+  return LanesMul(sum, x);
+}
+
+// the haversine term of kGeoLanes points into dists, and whether they are inside into keep
+static inline void FilterLanes(const GeoFilterArgs& args, const double* lons, const double* lats, double* dists,
+                               uint8_t* keep) {
+  GeoLanes lat = LanesMul(LanesLoad(lats), LanesSet(kDegToRad));
+  GeoLanes lon = LanesMul(LanesLoad(lons), LanesSet(kDegToRad));
+  GeoLanes dlat = LanesSub(lat, LanesSet(args.lat0));
+  GeoLanes u = LanesSin(LanesMul(dlat, LanesSet(0.5)));
+  GeoLanes v = LanesSin(LanesMul(LanesSub(lon, LanesSet(args.lon0)), LanesSet(0.5)));
+  // |lat| <= pi/2, so cos(lat) = sin(pi/2 - |lat|) needs no folding
+  GeoLanes cos_lat = LanesSin(LanesSub(LanesSet(M_PI / 2), LanesAbs(lat)));
+  GeoLanes cos_v = LanesMul(cos_lat, v);
+  GeoLanes a = LanesAdd(LanesMul(u, u), LanesMul(LanesMul(LanesSet(args.cos_lat0), cos_v), v));
+  LanesStore(dists, a);
+  if (args.radius) {
+    MaskStore(keep, LanesLe(a, LanesSet(args.limit)));
+  } else {
+    MaskStore(keep, MaskAnd(LanesLe(LanesAbs(dlat), LanesSet(args.lat_limit)),
+                            LanesLe(LanesAbs(cos_v), LanesSet(args.lon_limit))));
+  }
+}
+
+static void FilterPoints(const GeoFilterArgs& args, const double* lons, const double* lats, size_t n, double* dists,
+                         uint8_t* keep) {
+  size_t i = 0;
+  for (; i + kGeoLanes <= n; i += kGeoLanes) {
+    FilterLanes(args, lons + i, lats + i, dists + i, keep + i);
+  }
+  if (i < n) {
+    // the odd point last, its lanes padded with itself
+    double lon[kGeoLanes] = {lons[i], lons[i]};
+    double lat[kGeoLanes] = {lats[i], lats[i]};
+    double dist[kGeoLanes];
+    uint8_t kept[kGeoLanes];
+    FilterLanes(args, lon, lat, dist, kept);
+    dists[i] = dist[0];
+    keep[i] = kept[0];
+  }
+}
+
+#else
+
+static void FilterPoints(const GeoFilterArgs& args, const double* lons, const double* lats, size_t n, double* dists,
+                         uint8_t* keep) {
+  for (size_t i = 0; i < n; i++) {
+    double lat = lats[i] * kDegToRad;
+    double dlat = lat - args.lat0;
+    double u = std::sin(dlat / 2);
+    double v = std::sin((lons[i] * kDegToRad - args.lon0) / 2);
+    double cos_v = std::cos(lat) * v;
+    dists[i] = u * u + args.cos_lat0 * cos_v * v;
+    keep[i] = args.radius ? dists[i] <= args.limit
+                          : std::fabs(dlat) <= args.lat_limit && std::fabs(cos_v) <= args.lon_limit;
+  }
+}
+
+#endif
+
+void GeoFilterBatch(const GeoShape& shape, const double* lons, const double* lats, size_t n, double* dists,
+                    uint8_t* keep) {
+  GeoFilterArgs args;
+  args.radius = shape.type == GeoShape::kRadius;
+  args.lat0 = DegRad(shape.lat);
+  args.lon0 = DegRad(shape.lon);
+  args.cos_lat0 = std::cos(args.lat0);
+  if (args.radius) {
+    // inside iff haversine(a) <= radius, i.e. a <= sin^2(radius / 2R), so no asin is needed to decide
+    double half_angle = std::min(shape.radius / kEarthRadiusInMeters / 2, M_PI / 2);
+    args.limit = std::sin(half_angle) * std::sin(half_angle);
+  } else {
+    // the latitude distance R * |dlat| first, then the longitude distance along the latitude of the point,
+    // 2R * asin(|cos(lat) * sin(dlon / 2)|), both compared without the asin
+    args.lat_limit = shape.height / 2 / kEarthRadiusInMeters;
+    double half_angle = shape.width / 2 / kEarthRadiusInMeters / 2;
+    args.lon_limit = half_angle < M_PI / 2 ? std::sin(half_angle) : 1;
+  }
+
+  FilterPoints(args, lons, lats, n, dists, keep);
+
+  for (size_t i = 0; i < n; i++) {
+    if (keep[i]) {
+      dists[i] = 2.0 * kEarthRadiusInMeters * std::asin(std::sqrt(dists[i]));
+    }
+  }
+}
+
+}  // namespace pikiwidb
@@ -0,0 +1,69 @@
+// Copyright (c) 2024-present, OpenAtom Foundation, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory
+
+/*
+  Geohash helpers of the geo commands. A geo set is a zset whose scores are
+  the 52 bit interleaved geohash of its members, the same encoding as Redis,
+  so every cell of the grid is one contiguous score range.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace pikiwidb {
+
+constexpr int kGeoStepMax = 26;  // 26 * 2 = 52 bits, exact in a double score
+constexpr double kGeoLatMin = -85.05112878;
+constexpr double kGeoLatMax = 85.05112878;
+constexpr double kGeoLongMin = -180;
+constexpr double kGeoLongMax = 180;
+
+struct GeoHashArea {
+  double lon_min = 0;
+  double lon_max = 0;
+  double lat_min = 0;
+  double lat_max = 0;
+};
+
+struct GeoShape {
+  enum Type { kRadius, kBox };
+  Type type = kRadius;
+  double lon = 0;
+  double lat = 0;
+  // in meters
+  double radius = 0;
+  double width = 0;
+  double height = 0;
+};
+
+bool GeoCoordValid(double lon, double lat);
+
+uint64_t GeoHashEncode(double lon, double lat, int step = kGeoStepMax);
+
+GeoHashArea GeoHashDecode(uint64_t bits, int step = kGeoStepMax);
+
+// the center of the cell, which is what GEOPOS reports for a member
+void GeoHashDecodeCenter(uint64_t bits, double* lon, double* lat);
+
+// great-circle distance in meters
+double GeoDistance(double lon1, double lat1, double lon2, double lat2);
+
+// The score ranges [min, max) of the cells covering the shape: the cell of the
+// center first, then its neighbours, without duplicates.
+std::vector<std::pair<double, double>> GeoCoverShape(const GeoShape& shape);
+
+// Checks a batch of candidates against the shape, keep[i] tells whether the
+// point is inside and dists[i] is then its distance to the center. Two points
+// go per step on SSE2 and NEON, with a polynomial sin, and one at a time with
+// std::sin elsewhere. The shape test needs no asin, which only runs for the
+// kept points.
+void GeoFilterBatch(const GeoShape& shape, const double* lons, const double* lats, size_t n, double* dists,
+                    uint8_t* keep);
+
+}  // namespace pikiwidb
@@ -8,20 +8,31 @@
 #pragma once
 
 #include <unistd.h>
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <iterator>
 #include <latch>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <utility>
+#include <vector>
 
 #include "callback_function.h"
 #include "net_event.h"
 #include "timer.h"
+#include "timing_wheel.h"
 
 namespace net {
 
+struct PollStats {
+  uint64_t blockingPolls = 0;  // polls that could put the loop to sleep
+  uint64_t busyPollHits = 0;   // events found while spinning, a wakeup avoided each
+};
+
 class BaseEvent : public std::enable_shared_from_this<BaseEvent> {
  public:
   // Currently, there are two types of multiplexing: epoll and kqueue
@@ -69,6 +80,43 @@ class BaseEvent : public std::enable_shared_from_this<BaseEvent> {
 
   void AddTimer(const std::shared_ptr<Timer> &timer) { timer_ = timer; };
 
+  // A Unix listen socket served next to the TCP one, must be set before Init
+  void SetUnixListen(const std::shared_ptr<NetEvent> &listen) { unixListen_ = listen; }
+
+  // The timers of this loop, e.g. one per connection for idle timeouts. They
+  // need no lock, so they must only be touched from the loop thread.
+  inline TimingWheel &LoopTimers() { return loopTimers_; }
+
+  // Add a timer to the wheel of the loop from any thread, the callback runs on the loop thread
+  void PostTimer(int64_t expire, TimingWheel::Callback callback, int64_t interval = 0) {
+    {
+      std::lock_guard lock(postedMutex_);
+      postedTimers_.push_back({expire, interval, std::move(callback)});
+    }
+    // one byte wakes the loop up, later posts ride on it until the loop took them
+    if (!timersPosted_.exchange(true)) {
+      char signal_byte = 'T';
+      ::write(pipeFd_[1], &signal_byte, sizeof(signal_byte));
+    }
+  }
+
+  // The timers of a stopped loop, posted ones included, for another loop to take over
+  std::vector<TimingWheel::Timer> TakeTimers() {
+    auto timers = loopTimers_.TakeAll();
+    std::lock_guard lock(postedMutex_);
+    std::move(postedTimers_.begin(), postedTimers_.end(), std::back_inserter(timers));
+    postedTimers_.clear();
+    return timers;
+  }
+
+  // Keep polling without blocking for us microseconds after the loop handled
+  // events, trading idle CPU for latency. 0 always blocks. May be changed while running.
+  inline void SetBusyPoll(int64_t us) { busyPollUs_.store(us, std::memory_order_relaxed); }
+
+  inline PollStats GetPollStats() const {
+    return {blockingPolls_.load(std::memory_order_relaxed), busyPollHits_.load(std::memory_order_relaxed)};
+  }
+
   void Close() {
     bool run = true;
     if (running_.compare_exchange_strong(run, false)) {
@@ -97,6 +145,27 @@ class BaseEvent : public std::enable_shared_from_this<BaseEvent> {
   inline int8_t Type() const { return type_; }
 
  protected:
+  // Moves the posted timers into the wheel, on the loop thread
+  void AddPostedTimers() {
+    if (!timersPosted_.exchange(false)) {
+      return;
+    }
+    std::vector<TimingWheel::Timer> posted;
+    {
+      std::lock_guard lock(postedMutex_);
+      posted.swap(postedTimers_);
+    }
+    for (auto &timer : posted) {
+      loopTimers_.Add(timer.expire, std::move(timer.callback), timer.interval);
+    }
+  }
+
+  // Empties the pipe once PostTimer or Close wrote to it
+  void DrainPipe() {
+    char buf[64];
+    ::read(pipeFd_[0], buf, sizeof(buf));
+  }
+
   int evFd_ = 0;  // event fd
   std::atomic<bool> running_ = true;
 
@@ -112,9 +181,22 @@ class BaseEvent : public std::enable_shared_from_this<BaseEvent> {
 
   std::shared_ptr<Timer> timer_;
 
+  TimingWheel loopTimers_;
+
+  std::mutex postedMutex_;
+  std::vector<TimingWheel::Timer> postedTimers_;  // guarded by postedMutex_
+  std::atomic<bool> timersPosted_ = false;
+
+  std::atomic<int64_t> busyPollUs_ = 0;
+  std::atomic<uint64_t> blockingPolls_ = 0;
+  std::atomic<uint64_t> busyPollHits_ = 0;
+
   // listening socket
   std::shared_ptr<NetEvent> listen_;
 
+  // Unix listening socket, shared by all the loops
+  std::shared_ptr<NetEvent> unixListen_;
+
   // callback function when a new connection is created
   std::function<void(uint64_t, std::shared_ptr<Connection>)> onCreate_;
 
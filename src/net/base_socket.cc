@@ -18,6 +18,8 @@ int BaseSocket::CreateTCPSocket() { return ::socket(AF_INET, SOCK_STREAM, IPPROT
 
 int BaseSocket::CreateUDPSocket() { return ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP); }
 
+int BaseSocket::CreateUnixSocket() { return ::socket(AF_UNIX, SOCK_STREAM, 0); }
+
 void BaseSocket::Close() {
   auto fd = Fd();
   if (fd_.compare_exchange_strong(fd, 0)) {
@@ -30,7 +32,9 @@ void BaseSocket::OnCreate() {
 #ifndef HAVE_ACCEPT4
   SetNonBlock(true);
 #endif
-  SetNodelay();
+  if (SocketType() != SOCKET_UNIX) {
+    SetNodelay();
+  }
   SetSndBuf();
   SetRcvBuf();
 }
@@ -28,6 +28,8 @@ class BaseSocket : public NetEvent {
     SOCKET_UDP,
     SOCKET_LISTEN_TCP,
     SOCKET_LISTEN_UDP,
+    SOCKET_UNIX,
+    SOCKET_LISTEN_UNIX,
   };
 
   explicit BaseSocket(int fd) : NetEvent(fd) {}
@@ -42,6 +44,8 @@ class BaseSocket : public NetEvent {
 
   static int CreateUDPSocket();
 
+  static int CreateUnixSocket();
+
   // Called when the socket is created
   void OnCreate();
 
@@ -9,6 +9,10 @@
 
 #ifdef HAVE_EPOLL
 
+#  include <sys/ioctl.h>
+#  include <algorithm>
+#  include <chrono>
+
 #  include "callback_function.h"
 #  include "log.h"
 
@@ -25,15 +29,31 @@ bool EpollEvent::Init() {
     ERROR("epoll_create1 error errno:{}", errno);
     return false;
   }
-  if (mode_ & EVENT_MODE_READ) {  // Add the listen socket to epoll for read
-    AddEvent(listen_->Fd(), listen_->Fd(), EVENT_READ);
+  if (mode_ & EVENT_MODE_READ) {  // Add the listen sockets to epoll for read
+    for (const auto &listen : {listen_, unixListen_}) {
+      if (!listen) {
+        continue;
+      }
+#  ifdef EPOLLEXCLUSIVE
+      // Without SO_REUSEPORT all the threads share one listen socket,
+      // so wake up only one of them for a new connection
+      struct epoll_event ev {};
+      ev.events = EVENT_READ | EPOLLEXCLUSIVE;
+      ev.data.u64 = FdId(listen->Fd());
+      if (epoll_ctl(EvFd(), EPOLL_CTL_ADD, listen->Fd(), &ev) == -1) {
+        AddEvent(FdId(listen->Fd()), listen->Fd(), EVENT_READ);
+      }
+#  else
+      AddEvent(FdId(listen->Fd()), listen->Fd(), EVENT_READ);
+#  endif
+    }
   }
   if (pipe(pipeFd_) == -1) {
     ERROR("pipe error errno:{}", errno);
     return false;
   }
 
-  AddEvent(pipeFd_[0], pipeFd_[0], EVENT_READ);
+  AddEvent(FdId(pipeFd_[0]), pipeFd_[0], EVENT_READ);
 
   return true;
 }
@@ -67,7 +87,8 @@ void EpollEvent::AddWriteEvent(uint64_t id, int fd) {
       ERROR("AddWriteEvent id:{},EvFd:{},fd:{}, epoll add RW error errno:{}", id, EvFd(), fd, errno);
     }
   } else {  // If it is a write multiplex, add the event
-    if (epoll_ctl(EvFd(), EPOLL_CTL_ADD, fd, &ev) == -1) {
+    // EEXIST: armed already, its write is pending
+    if (epoll_ctl(EvFd(), EPOLL_CTL_ADD, fd, &ev) == -1 && errno != EEXIST) {
       ERROR("AddWriteEvent id:{},EvFd:{},fd:{}, epoll add W error errno:{}", id, EvFd(), fd, errno);
     }
   }
@@ -88,15 +109,45 @@ void EpollEvent::DelWriteEvent(uint64_t id, int fd) {
   }
 }
 
+static inline int64_t NowUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
 void EpollEvent::EventRead() {
   struct epoll_event events[eventsSize];
   int waitInterval = -1;
   if (timer_) {
     waitInterval = static_cast<int>(timer_->Interval());
   }
+  int64_t busyPollApplied = 0;
+  int64_t spinUntil = 0;  // keep polling without blocking until then, a request usually follows a reply
   while (running_.load()) {
-    int nfds = epoll_wait(EvFd(), events, eventsSize, waitInterval);
+    auto busyPoll = busyPollUs_.load(std::memory_order_relaxed);
+    if (busyPoll != busyPollApplied) {
+      SetBusyPollParams(busyPoll);
+      busyPollApplied = busyPoll;
+    }
+
+    int wait = waitInterval;
+    if (auto next = loopTimers_.TimeToNext(); next >= 0 && (wait < 0 || next < wait)) {
+      wait = static_cast<int>(next);
+    }
+    bool spinning = busyPoll > 0 && NowUs() < spinUntil;
+    int nfds = epoll_wait(EvFd(), events, eventsSize, spinning ? 0 : wait);
+    if (!spinning) {
+      blockingPolls_.fetch_add(1, std::memory_order_relaxed);
+    } else if (nfds > 0) {
+      busyPollHits_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (nfds > 0 && busyPoll > 0) {
+      spinUntil = NowUs() + busyPoll;
+    }
     for (int i = 0; i < nfds; ++i) {
+      if (events[i].data.u64 == FdId(pipeFd_[0])) {  // woken up by PostTimer or Close
+        DrainPipe();
+        continue;
+      }
       if ((events[i].events & EVENT_HUB) || (events[i].events & EVENT_ERROR)) {
         // If the event is an error event, call DoError
         DoError(events[i], "");
@@ -105,7 +156,8 @@ void EpollEvent::EventRead() {
       std::shared_ptr<Connection> conn;
       if (events[i].events & EVENT_READ) {
         // If the event is less than the listen socket, it is a new connection
-        if (events[i].data.u64 != listen_->Fd()) {
+        if (events[i].data.u64 != FdId(listen_->Fd()) &&
+            (!unixListen_ || events[i].data.u64 != FdId(unixListen_->Fd()))) {
           conn = getConn_(events[i].data.u64);
         }
         DoRead(events[i], conn);
@@ -124,6 +176,8 @@ void EpollEvent::EventRead() {
     if (timer_) {
       timer_->OnTimer();
     }
+    AddPostedTimers();
+    loopTimers_.Advance();
   }
 }
 
@@ -147,15 +201,36 @@ void EpollEvent::EventWrite() {
   }
 }
 
-void EpollEvent::DoRead(const epoll_event &event, const std::shared_ptr<Connection> &conn) {
-  if (event.data.u64 == listen_->Fd()) {
+void EpollEvent::DoAccept(const std::shared_ptr<NetEvent> &listen) {
+  // Drain the backlog in one wakeup, a reconnect storm would cost one epoll_wait per connection otherwise.
+  // The batch is bounded so the connections already served by this thread are not starved.
+  for (int i = 0; i < kAcceptBatch; ++i) {
     auto newConn = std::make_shared<Connection>(nullptr);
-    auto connFd = listen_->OnReadable(newConn, nullptr);
+    auto connFd = listen->OnReadable(newConn, nullptr);
     if (connFd < 0) {
-      DoError(event, "accept error");
+      if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR && errno != ECONNABORTED) {
+        ERROR("accept on listen fd:{} error errno:{}", listen->Fd(), errno);
+      }
+      if (errno == ECONNABORTED) {
+        continue;
+      }
       return;
     }
+#  ifdef SO_BUSY_POLL
+    if (int busyPoll = static_cast<int>(busyPollUs_.load(std::memory_order_relaxed)); busyPoll > 0) {
+      // best effort, above net.core.busy_read it needs CAP_NET_ADMIN
+      setsockopt(connFd, SOL_SOCKET, SO_BUSY_POLL, &busyPoll, sizeof(busyPoll));
+    }
+#  endif
     onCreate_(connFd, newConn);
+  }
+}
+
+void EpollEvent::DoRead(const epoll_event &event, const std::shared_ptr<Connection> &conn) {
+  if (event.data.u64 == FdId(listen_->Fd())) {
+    DoAccept(listen_);
+  } else if (unixListen_ && event.data.u64 == FdId(unixListen_->Fd())) {
+    DoAccept(unixListen_);
   } else if (conn) {
     std::string readBuff;
     int ret = conn->netEvent_->OnReadable(conn, &readBuff);
@@ -180,6 +255,34 @@ void EpollEvent::DoWrite(const epoll_event &event, const std::shared_ptr<Connect
   }
   if (ret == 0) {
     DelWriteEvent(event.data.u64, conn->fd_);
+    // A reply queued between the drain and the removal found the event still armed and did not
+    // arm it again, so look once more. One queued after this arms it again by itself.
+    ret = conn->netEvent_->OnWritable();
+    if (ret == NE_ERROR) {
+      DoError(event, "write error,errno: " + std::to_string(errno));
+    } else if (ret > 0) {
+      AddWriteEvent(event.data.u64, conn->fd_);
+    }
+  }
+}
+
+// EPIOCSPARAMS of <linux/eventpoll.h>, which cannot be included along with <sys/epoll.h>
+struct EpollParams {
+  uint32_t busyPollUsecs;
+  uint16_t busyPollBudget;
+  uint8_t preferBusyPoll;
+  uint8_t pad;
+};
+constexpr unsigned long kEpollSetParams = _IOW(0x8A, 0x01, EpollParams);
+
+void EpollEvent::SetBusyPollParams(int64_t us) {
+  EpollParams params{};
+  params.busyPollUsecs = static_cast<uint32_t>(std::min<int64_t>(us, UINT32_MAX));
+  params.busyPollBudget = 8;  // the kernel default, above 64 it needs CAP_NET_ADMIN
+  params.preferBusyPoll = us > 0 ? 1 : 0;
+  if (ioctl(EvFd(), kEpollSetParams, &params) == -1 && us > 0) {
+    // older kernels, the loop still spins in user space
+    INFO("epoll fd:{} busy poll params not supported errno:{}", EvFd(), errno);
   }
 }
 
@@ -51,6 +51,9 @@ class EpollEvent : public BaseEvent {
   // Handle write event
   void EventWrite();
 
+  // Accept a batch of new connections of the listen socket
+  void DoAccept(const std::shared_ptr<NetEvent> &listen);
+
   // Do read event
   void DoRead(const epoll_event &event, const std::shared_ptr<Connection> &conn);
 
@@ -60,8 +63,20 @@ class EpollEvent : public BaseEvent {
   // Handle error event
   void DoError(const epoll_event &event, std::string &&err);
 
+  // Let the kernel busy poll the NIC queues of the sockets on epoll_wait, needs Linux 6.9
+  void SetBusyPollParams(int64_t us);
+
  private:
   const int eventsSize = 1024;
+
+  // The most connections accepted per wakeup of the listen socket
+  static constexpr int kAcceptBatch = 64;
+
+  // The listen sockets and the pipe are registered under their fd with the top bit set,
+  // connection ids are small numbers too and would be taken for them otherwise
+  static constexpr uint64_t kFdTag = 1ULL << 63;
+
+  static inline uint64_t FdId(int fd) { return kFdTag | static_cast<uint64_t>(fd); }
 };
 
 }  // namespace net
@@ -7,10 +7,13 @@
 
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <condition_variable>
 #include <functional>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include "base_socket.h"
 #include "callback_function.h"
@@ -25,7 +28,7 @@ template <typename T>
 requires HasSetFdFunction<T>
 class EventServer final {
  public:
-  explicit EventServer(int8_t threadNum) : threadNum_(threadNum) { threadsManager_.reserve(threadNum_); }
+  explicit EventServer(int8_t threadNum) : threadNum_(threadNum) {}
 
   ~EventServer() = default;
 
@@ -41,8 +44,30 @@ class EventServer final {
 
   inline void AddListenAddr(const SocketAddr &addr) { listenAddrs_ = addr; }
 
+  // Also listen on a Unix socket, "@name" for the Linux abstract namespace. The connections
+  // go through the same threads as the TCP ones. Peers whose uid is not in uids are
+  // rejected, an empty list accepts every peer.
+  inline void AddUnixListen(const std::string &path, mode_t perm = 0, std::vector<uid_t> uids = {}) {
+    unixPath_ = path;
+    unixPerm_ = perm;
+    unixUids_ = std::move(uids);
+  }
+
   inline void SetRwSeparation(bool separation = true) { rwSeparation_ = separation; }
 
+  // Steer the connections to the thread of the CPU that received them, needs SO_REUSEPORT
+  inline void SetCpuSteering(bool steering = true) { cpuSteering_ = steering; }
+
+  // Pin thread i to cpus[i % cpus.size()], an empty list leaves the threads unpinned
+  inline void SetCpuList(std::vector<int> cpus) { cpus_ = std::move(cpus); }
+
+  // Spin for us microseconds after handling events before blocking again, 0 turns it off.
+  // May be called while running.
+  void SetBusyPoll(int64_t us);
+
+  // The poll counters summed over the threads
+  PollStats GetPollStats();
+
   void InitTimer(int64_t interval) { timer_ = std::make_shared<Timer>(interval); }
 
   inline int64_t AddTimerTask(const std::shared_ptr<ITimerTask> &task) { return timer_->AddTask(task); }
@@ -56,12 +81,25 @@ class EventServer final {
   // Stop the server
   void StopServer();
 
+  // Grow or shrink the I/O threads of a running server. A retiring thread takes
+  // what is queued on its listen socket, closes it and hands its connections
+  // over to the remaining threads. Thread 0 runs the timer and always stays.
+  bool Resize(int8_t threadNum);
+
+  inline int8_t ThreadNum() const { return threadNum_.load(std::memory_order_relaxed); }
+
   // Send message to the client
   void SendPacket(const T &conn, std::string &&msg);
 
+  // Send one shared message to many clients, grouped by their I/O thread
+  void SendPacket(const std::vector<T> &conns, const std::shared_ptr<const std::string> &msg);
+
   // Server Active close the connection
   void CloseConnection(const T &conn);
 
+  // Run the callback on the I/O thread of the connection at expire (ms, TimingWheel::NowMs)
+  void AddConnTimer(const T &conn, int64_t expire, TimingWheel::Callback callback);
+
   // When the service is started, the main thread is blocked,
   // and when all the subthreads are finished, the function unblocks and returns
   void Wait() {
@@ -76,6 +114,22 @@ class EventServer final {
  private:
   int StartThreadManager(bool serverMode);
 
+  std::unique_ptr<ThreadManager<T>> NewThreadManager(int8_t index);
+
+  // Fills the slot index of threadsManager_ and publishes it, the slots are filled in order
+  void AddThreadManager(int8_t index) {
+    threadsManager_[index] = NewThreadManager(index);
+    threadManagerNum_.store(static_cast<int8_t>(index + 1), std::memory_order_release);
+  }
+
+  // The filled slots of threadsManager_, running or retired
+  inline int8_t ThreadManagerNum() const { return threadManagerNum_.load(std::memory_order_acquire); }
+
+  // A new TCP listen socket joining the SO_REUSEPORT group, nullptr on failure
+  std::shared_ptr<ListenSocket> NewListen();
+
+  static constexpr int8_t kMaxThreadNum = INT8_MAX;  // the thread index is an int8_t
+
  private:
   OnInit<T> onInit_;  // The callback function used to initialize data before creating a connection
 
@@ -89,13 +143,35 @@ class EventServer final {
 
   SocketAddr listenAddrs_;  // The address to listen on
 
+  std::string unixPath_;  // The Unix socket to listen on, empty for none
+  mode_t unixPerm_ = 0;
+  std::vector<uid_t> unixUids_;
+
   std::atomic<bool> running_ = true;  // Whether the server is running
 
   bool rwSeparation_ = true;  // Whether to separate read and write
 
-  int8_t threadNum_ = 1;  // The number of threads
+  bool cpuSteering_ = false;  // Whether to attach the CPU steering program to the listen sockets
+
+  std::vector<int> cpus_;  // The CPUs the threads are pinned to
+
+  int64_t busyPollUs_ = 0;  // How long the threads keep polling after activity
+
+  std::atomic<int8_t> threadNum_ = 1;  // The number of threads
+
+  // [0, threadNum_) run, the ones after them have been retired by Resize and forward to a running one.
+  // A fixed array: Resize fills new slots while the other threads look theirs up by index, and
+  // a slot is never moved or emptied, the connections keep pointing at it.
+  std::array<std::unique_ptr<ThreadManager<T>>, kMaxThreadNum> threadsManager_;
+  std::atomic<int8_t> threadManagerNum_ = 0;  // the filled slots of threadsManager_
+
+  bool serverMode_ = false;
 
-  std::vector<std::unique_ptr<ThreadManager<T>>> threadsManager_;
+  std::mutex resizeMutex_;
+
+  std::shared_ptr<ListenSocket> listen_;  // The listen socket of thread 0, shared by all without SO_REUSEPORT
+
+  std::shared_ptr<ListenSocket> unixListen_;
 
   std::mutex mtx_;
   std::condition_variable cv_;
@@ -125,16 +201,15 @@ requires HasSetFdFunction<T> std::pair<bool, std::string> EventServer<T>::StartS
     InitTimer(interval);
   }
 
+  if (threadNum_ > kMaxThreadNum) {
+    return std::pair(false, "thread num is too large");
+  }
+
   for (int8_t i = 0; i < threadNum_; ++i) {
-    auto tm = std::make_unique<ThreadManager<T>>(i, rwSeparation_);
-    tm->SetOnInit(onInit_);
-    tm->SetOnCreate(onCreate_);
-    tm->SetOnConnect(onConnect_);
-    tm->SetOnMessage(onMessage_);
-    tm->SetOnClose(onClose_);
-    threadsManager_.emplace_back(std::move(tm));
+    AddThreadManager(i);
   }
 
+  serverMode_ = true;
   if (StartThreadManager(true) != static_cast<int>(NetListen::OK)) {
     return std::pair(false, "StartThreadManager function error");
   }
@@ -161,12 +236,7 @@ requires HasSetFdFunction<T> std::pair<bool, std::string> EventServer<T>::StartC
   }
 
   for (int8_t i = 0; i < threadNum_; ++i) {
-    auto tm = std::make_unique<ThreadManager<T>>(i, rwSeparation_);
-    tm->SetOnInit(onInit_);
-    tm->SetOnConnect(onConnect_);
-    tm->SetOnMessage(onMessage_);
-    tm->SetOnClose(onClose_);
-    threadsManager_.emplace_back(std::move(tm));
+    AddThreadManager(i);
   }
 
   if (StartThreadManager(false) != static_cast<int>(NetListen::OK)) {
@@ -181,8 +251,8 @@ requires HasSetFdFunction<T>
 void EventServer<T>::StopServer() {
   bool expected = true;
   if (running_.compare_exchange_strong(expected, false)) {
-    for (const auto &thread : threadsManager_) {
-      thread->Stop();
+    for (int8_t i = 0; i < ThreadManagerNum(); ++i) {
+      threadsManager_[i]->Stop();
     }
   }
   cv_.notify_one();
@@ -200,6 +270,27 @@ void EventServer<T>::SendPacket(const T &conn, std::string &&msg) {
   threadsManager_[thIndex]->SendPacket(conn, std::move(msg));
 }
 
+template <typename T>
+requires HasSetFdFunction<T>
+void EventServer<T>::SendPacket(const std::vector<T> &conns, const std::shared_ptr<const std::string> &msg) {
+  std::vector<std::vector<T>> batches(ThreadManagerNum());
+  for (const auto &conn : conns) {
+    int thIndex;
+    if constexpr (IsPointer_v<T>) {
+      thIndex = conn->GetThreadIndex();
+    } else {
+      thIndex = conn.GetThreadIndex();
+    }
+    batches[thIndex].push_back(conn);
+  }
+
+  for (size_t i = 0; i < batches.size(); ++i) {
+    if (!batches[i].empty()) {
+      threadsManager_[i]->SendPacket(batches[i], msg);
+    }
+  }
+}
+
 template <typename T>
 requires HasSetFdFunction<T>
 void EventServer<T>::CloseConnection(const T &conn) {
@@ -216,6 +307,18 @@ void EventServer<T>::CloseConnection(const T &conn) {
   threadsManager_[thIndex]->CloseConnection(connId);
 }
 
+template <typename T>
+requires HasSetFdFunction<T>
+void EventServer<T>::AddConnTimer(const T &conn, int64_t expire, TimingWheel::Callback callback) {
+  int thIndex;
+  if constexpr (IsPointer_v<T>) {
+    thIndex = conn->GetThreadIndex();
+  } else {
+    thIndex = conn.GetThreadIndex();
+  }
+  threadsManager_[thIndex]->AddTimer(expire, std::move(callback));
+}
+
 template <typename T>
 requires HasSetFdFunction<T>
 void EventServer<T>::TCPConnect(const SocketAddr &addr, OnCreate<T> onConnect,
@@ -248,30 +351,151 @@ int EventServer<T>::StartThreadManager(bool serverMode) {
   if (serverMode) {
     listen->SetListenAddr(listenAddrs_);
 
-    if (auto ret = listen->Init() != static_cast<int>(NetListen::OK)) {
+    if (auto ret = listen->Init(); ret != static_cast<int>(NetListen::OK)) {
+      return ret;
+    }
+  }
+  listen_ = listen;
+
+  // Unix sockets have no SO_REUSEPORT groups, the threads share one listen socket
+  std::shared_ptr<ListenSocket> unixListen;
+  if (serverMode && !unixPath_.empty()) {
+    unixListen.reset(ListenSocket::CreateUnixListen());
+    unixListen->SetUnixPath(unixPath_);
+    unixListen->SetUnixPerm(unixPerm_);
+    unixListen->SetAllowedUids(unixUids_);
+    if (auto ret = unixListen->Init(); ret != static_cast<int>(NetListen::OK)) {
       return ret;
     }
   }
+  unixListen_ = unixListen;
 
-  int i = 0;
-  for (const auto &thread : threadsManager_) {
+  // Every thread gets its own listen socket when SO_REUSEPORT works,
+  // otherwise they share one which is registered with EPOLLEXCLUSIVE
+  for (int8_t i = 0; i < ThreadManagerNum(); ++i) {
+    const auto &thread = threadsManager_[i];
     if (i > 0 && ListenSocket::REUSE_PORT && serverMode) {
-      listen.reset(ListenSocket::CreateTCPListen());
-      listen->SetListenAddr(listenAddrs_);
-      if (auto ret = listen->Init() != static_cast<int>(NetListen::OK)) {
-        return ret;
+      listen = NewListen();
+      if (!listen) {
+        return -1;
       }
     }
 
+    thread->SetUnixListen(unixListen);
+
     // timer only works in the first thread
     bool ret = i == 0 ? thread->Start(listen, timer_) : thread->Start(listen, nullptr);
     if (!ret) {
       return -1;
     }
-    ++i;
+  }
+
+  // the program is shared by the whole group, so attaching it to the last socket is enough
+  if (serverMode && cpuSteering_ && ListenSocket::REUSE_PORT && threadNum_ > 1) {
+    listen->AttachCpuSteering(static_cast<uint32_t>(threadNum_));
   }
 
   return static_cast<int>(NetListen::OK);
 }
 
+template <typename T>
+requires HasSetFdFunction<T> std::unique_ptr<ThreadManager<T>> EventServer<T>::NewThreadManager(int8_t index) {
+  auto tm = std::make_unique<ThreadManager<T>>(index, rwSeparation_);
+  if (!cpus_.empty()) {
+    tm->SetCpu(cpus_[index % cpus_.size()]);
+  }
+  tm->SetOnInit(onInit_);
+  tm->SetOnCreate(onCreate_);
+  tm->SetOnConnect(onConnect_);
+  tm->SetOnMessage(onMessage_);
+  tm->SetOnClose(onClose_);
+  tm->SetBusyPoll(busyPollUs_);
+  return tm;
+}
+
+template <typename T>
+requires HasSetFdFunction<T>
+void EventServer<T>::SetBusyPoll(int64_t us) {
+  std::lock_guard lock(resizeMutex_);
+  busyPollUs_ = us;
+  for (int8_t i = 0; i < ThreadManagerNum(); ++i) {
+    threadsManager_[i]->SetBusyPoll(us);
+  }
+}
+
+template <typename T>
+requires HasSetFdFunction<T> PollStats EventServer<T>::GetPollStats() {
+  PollStats stats;
+  std::lock_guard lock(resizeMutex_);
+  for (int8_t i = 0; i < ThreadManagerNum(); ++i) {
+    threadsManager_[i]->AddPollStats(&stats);
+  }
+  return stats;
+}
+
+template <typename T>
+requires HasSetFdFunction<T> std::shared_ptr<ListenSocket> EventServer<T>::NewListen() {
+  std::shared_ptr<ListenSocket> listen(ListenSocket::CreateTCPListen());
+  listen->SetListenAddr(listenAddrs_);
+  if (listen->Init() != static_cast<int>(NetListen::OK)) {
+    return nullptr;
+  }
+  return listen;
+}
+
+template <typename T>
+requires HasSetFdFunction<T>
+bool EventServer<T>::Resize(int8_t threadNum) {
+  if (threadNum <= 0) {
+    return false;
+  }
+  std::lock_guard lock(resizeMutex_);
+  if (!running_ || ThreadManagerNum() == 0) {
+    return false;
+  }
+  int8_t old = threadNum_;
+  if (threadNum == old) {
+    return true;
+  }
+  bool ownListen = serverMode_ && ListenSocket::REUSE_PORT;
+
+  if (threadNum > old) {
+    for (int8_t i = old; i < threadNum; ++i) {
+      std::shared_ptr<ListenSocket> listen = listen_;
+      if (ownListen) {
+        listen = NewListen();
+        if (!listen) {
+          threadNum = i;
+          break;
+        }
+      }
+      // a retired thread is started again in its old slot, the connections it handed over stay where they are
+      if (i >= ThreadManagerNum()) {
+        AddThreadManager(i);
+      }
+      threadsManager_[i]->SetUnixListen(unixListen_);
+      if (!threadsManager_[i]->Start(listen, nullptr)) {
+        threadNum = i;
+        break;
+      }
+    }
+    if (threadNum <= old) {
+      return false;
+    }
+    threadNum_ = threadNum;
+  } else {
+    // stop accepting on the retiring threads first, so no new connection lands there
+    threadNum_ = threadNum;
+    for (int8_t i = old - 1; i >= threadNum; --i) {
+      threadsManager_[i]->Retire(threadsManager_[i % threadNum].get(), ownListen);
+    }
+  }
+
+  // the group changed, so has the CPU to socket mapping of the steering program
+  if (serverMode_ && cpuSteering_ && ListenSocket::REUSE_PORT && listen_) {
+    listen_->AttachCpuSteering(static_cast<uint32_t>(threadNum_));
+  }
+  return true;
+}
+
 }  // namespace net
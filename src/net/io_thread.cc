@@ -7,6 +7,8 @@
 
 #include "io_thread.h"
 
+#include "pstd_cpu.h"
+
 namespace net {
 
 void IOThread::Stop() {
@@ -28,7 +30,13 @@ bool IOThread::Run() {
     return false;
   }
 
-  thread_ = std::thread([this] { baseEvent_->EventPoll(); });
+  thread_ = std::thread([this] {
+    // pinned before the loop allocates its buffers, so they come from the node of the CPU
+    if (cpu_ >= 0) {
+      pstd::BindThreadToCpus({cpu_});
+    }
+    baseEvent_->EventPoll();
+  });
   return true;
 }
 
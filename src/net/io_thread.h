@@ -20,6 +20,9 @@ class IOThread {
 
   ~IOThread() = default;
 
+  // Pin the event loop thread to the CPU before it starts, -1 leaves it unpinned
+  inline void SetCpu(int cpu) { cpu_ = cpu; }
+
   // Initialize the event and run the event loop
   bool Run();
 
@@ -34,12 +37,29 @@ class IOThread {
   // Add read event to epoll when send message to client
   inline void SetWriteEvent(uint64_t id, int fd) { baseEvent_->AddWriteEvent(id, fd); }
 
+  inline void SetBusyPoll(int64_t us) { baseEvent_->SetBusyPoll(us); }
+
+  inline PollStats GetPollStats() const { return baseEvent_->GetPollStats(); }
+
+  // The timers of the loop, only to be used from the loop thread
+  inline TimingWheel &LoopTimers() { return baseEvent_->LoopTimers(); }
+
+  // Add a timer to the loop from any thread, see BaseEvent::PostTimer
+  inline void PostTimer(int64_t expire, TimingWheel::Callback callback, int64_t interval = 0) {
+    baseEvent_->PostTimer(expire, std::move(callback), interval);
+  }
+
+  // The timers of the loop once it stopped
+  inline std::vector<TimingWheel::Timer> TakeTimers() { return baseEvent_->TakeTimers(); }
+
   // Add new event to epoll when new connection
   inline void AddNewEvent(uint64_t connId, int fd, int mask) { baseEvent_->AddEvent(connId, fd, mask); }
 
  protected:
   std::atomic<bool> running_ = true;
 
+  int cpu_ = -1;  // The CPU the thread is pinned to
+
   std::thread thread_;
 
   std::shared_ptr<BaseEvent> baseEvent_;  // Event object
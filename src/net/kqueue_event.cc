@@ -8,6 +8,8 @@
 #include "kqueue_event.h"
 
 #ifdef HAVE_KQUEUE
+#  include <algorithm>
+
 #  include "log.h"
 
 namespace net {
@@ -25,6 +27,9 @@ bool KqueueEvent::Init() {
   }
   if (mode_ & EVENT_MODE_READ) {
     AddEvent(0, listen_->Fd(), EVENT_READ);
+    if (unixListen_) {
+      AddEvent(0, unixListen_->Fd(), EVENT_READ);
+    }
   }
   if (pipe(pipeFd_) == -1) {
     ERROR("pipe error:{}", errno);
@@ -88,25 +93,36 @@ void KqueueEvent::EventPoll() {
 
 void KqueueEvent::EventRead() {
   struct kevent events[eventsSize];
-  struct timespec *pTimeout = nullptr;
   struct timespec timeout {};
+  int waitInterval = -1;
   if (timer_) {
-    pTimeout = &timeout;
-    int waitInterval = static_cast<int>(timer_->Interval());
-    timeout.tv_sec = waitInterval / 1000;
-    timeout.tv_nsec = (waitInterval % 1000) * 1000000;
+    waitInterval = static_cast<int>(timer_->Interval());
   }
 
   while (running_.load()) {
+    int wait = waitInterval;
+    if (auto next = loopTimers_.TimeToNext(); next >= 0 && (wait < 0 || next < wait)) {
+      wait = static_cast<int>(next);
+    }
+    struct timespec *pTimeout = nullptr;
+    if (wait >= 0) {
+      pTimeout = &timeout;
+      timeout.tv_sec = wait / 1000;
+      timeout.tv_nsec = (wait % 1000) * 1000000;
+    }
     int nev = kevent(EvFd(), nullptr, 0, events, eventsSize, pTimeout);
     for (int i = 0; i < nev; ++i) {
+      if (events[i].ident == pipeFd_[0]) {  // woken up by PostTimer or Close
+        DrainPipe();
+        continue;
+      }
       if ((events[i].flags & EVENT_HUB) || (events[i].flags & EVENT_ERROR)) {
         DoError(events[i], "");
         continue;
       }
       std::shared_ptr<Connection> conn;
       if (events[i].filter == EVENT_READ) {
-        if (events[i].ident != listen_->Fd()) {
+        if (events[i].ident != listen_->Fd() && (!unixListen_ || events[i].ident != unixListen_->Fd())) {
 #  ifdef HAVE_64BIT
           auto connId = reinterpret_cast<uint64_t>(events[i].udata);
 #  else
@@ -134,6 +150,8 @@ void KqueueEvent::EventRead() {
     if (timer_) {
       timer_->OnTimer();
     }
+    AddPostedTimers();
+    loopTimers_.Advance();
   }
 }
 
@@ -164,11 +182,27 @@ void KqueueEvent::EventWrite() {
   }
 }
 
-void KqueueEvent::DoRead(const struct kevent &event, const std::shared_ptr<Connection> &conn) {
-  if (event.ident == listen_->Fd()) {
+void KqueueEvent::DoAccept(const struct kevent &event, const std::shared_ptr<NetEvent> &listen) {
+  // event.data is the backlog size, accept a bounded batch of it in one wakeup
+  auto pending = std::min<int64_t>(std::max<int64_t>(event.data, 1), kAcceptBatch);
+  for (int64_t i = 0; i < pending; ++i) {
     auto newConn = std::make_shared<Connection>(nullptr);
-    auto connFd = listen_->OnReadable(newConn, nullptr);
+    auto connFd = listen->OnReadable(newConn, nullptr);
+    if (connFd < 0) {
+      if (errno == ECONNABORTED) {
+        continue;
+      }
+      break;
+    }
     onCreate_(connFd, newConn);
+  }
+}
+
+void KqueueEvent::DoRead(const struct kevent &event, const std::shared_ptr<Connection> &conn) {
+  if (event.ident == listen_->Fd()) {
+    DoAccept(event, listen_);
+  } else if (unixListen_ && event.ident == unixListen_->Fd()) {
+    DoAccept(event, unixListen_);
   } else if (conn) {
     std::string readBuff;
     int ret = conn->netEvent_->OnReadable(conn, &readBuff);
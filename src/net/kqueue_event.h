@@ -44,6 +44,8 @@ class KqueueEvent : public BaseEvent {
 
   void EventWrite();
 
+  void DoAccept(const struct kevent &event, const std::shared_ptr<NetEvent> &listen);
+
   void DoRead(const struct kevent &event, const std::shared_ptr<Connection> &conn);
 
   void DoWrite(const struct kevent &event, const std::shared_ptr<Connection> &conn);
@@ -52,6 +54,9 @@ class KqueueEvent : public BaseEvent {
 
  private:
   const int eventsSize = 1024;
+
+  // The most connections accepted per wakeup of the listen socket
+  static constexpr int kAcceptBatch = 64;
 };
 
 }  // namespace net
@@ -6,6 +6,14 @@
  */
 
 #include <netinet/tcp.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstddef>
+#ifdef __linux__
+#  include <linux/filter.h>
+#endif
 
 #include "config.h"
 #include "listen_socket.h"
@@ -18,23 +26,43 @@ const int ListenSocket::LISTENQ = 1024;
 
 bool ListenSocket::REUSE_PORT = true;
 
+ListenSocket::~ListenSocket() {
+  if (unlinkPath_) {
+    ::unlink(unixPath_.c_str());
+  }
+}
+
 int ListenSocket::OnReadable(const std::shared_ptr<Connection> &conn, std::string *readBuff) {
-  struct sockaddr_in clientAddr {};
-  auto newConnFd = Accept(&clientAddr);
-  if (newConnFd == 0) {
-    ERROR("ListenSocket fd:{},Accept error:{}", Fd(), errno);
+  struct sockaddr_storage clientAddr {};
+  socklen_t addrLength = sizeof(clientAddr);
+  auto newConnFd = Accept(reinterpret_cast<sockaddr *>(&clientAddr), &addrLength);
+  if (newConnFd < 0) {
+    // the backlog is drained (EAGAIN) or the accept failed, the caller checks errno
     return NE_ERROR;
   }
 
-  auto newConn = std::make_unique<StreamSocket>(newConnFd, SocketType());
+  if (SocketType() == SOCKET_LISTEN_UNIX) {
+    if (!PeerAllowed(newConnFd)) {
+      ::close(newConnFd);
+      // the caller goes on with the backlog as for a connection aborted before it was accepted
+      errno = ECONNABORTED;
+      return NE_ERROR;
+    }
+    auto newConn = std::make_unique<StreamSocket>(newConnFd, SOCKET_UNIX);
+    newConn->OnCreate();
+    conn->netEvent_ = std::move(newConn);
+    conn->fd_ = newConnFd;
+    // a Unix peer is on this host, it is seen as a loopback client
+    conn->addr_.Init("127.0.0.1", 0);
+    return newConnFd;
+  }
 
-  char clientIP[INET_ADDRSTRLEN];
-  inet_ntop(AF_INET, &(clientAddr.sin_addr), clientIP, INET_ADDRSTRLEN);
+  auto newConn = std::make_unique<StreamSocket>(newConnFd, SocketType());
 
   newConn->OnCreate();
   conn->netEvent_ = std::move(newConn);
   conn->fd_ = newConnFd;
-  conn->addr_.Init(clientAddr);
+  conn->addr_.Init(*reinterpret_cast<sockaddr_in *>(&clientAddr));
 
   return newConnFd;
 }
@@ -62,6 +90,15 @@ bool ListenSocket::Open() {
     return false;
   }
 
+  if (SocketType() == SOCKET_LISTEN_UNIX) {
+    if (unixPath_.empty() || unixPath_.size() >= sizeof(sockaddr_un::sun_path)) {
+      ERROR("ListenSocket unix path:{} is invalid", unixPath_);
+      return false;
+    }
+    fd_ = CreateUnixSocket();
+    return Fd() > 0;
+  }
+
   if (!addr_.IsValid()) {
     ERROR("ListenSocket addr IP:{}, PORT:{} is invalid", addr_.GetIP(), addr_.GetPort());
     return false;
@@ -83,6 +120,9 @@ bool ListenSocket::Bind() {
   }
 
   SetNonBlock(true);
+  if (SocketType() == SOCKET_LISTEN_UNIX) {
+    return BindUnix();
+  }
   SetNodelay();
   SetReuseAddr();
   if (!SetReusePort()) {
@@ -100,6 +140,63 @@ bool ListenSocket::Bind() {
   return true;
 }
 
+bool ListenSocket::BindUnix() {
+  struct sockaddr_un serv {};
+  serv.sun_family = AF_UNIX;
+  bool abstract = unixPath_[0] == '@';
+  socklen_t len;
+  if (abstract) {
+    // sun_path starts with a NUL and the name is not NUL terminated
+    memcpy(serv.sun_path + 1, unixPath_.data() + 1, unixPath_.size() - 1);
+    len = static_cast<socklen_t>(offsetof(struct sockaddr_un, sun_path) + unixPath_.size());
+  } else {
+    // a file left by an earlier run would make bind fail
+    ::unlink(unixPath_.c_str());
+    memcpy(serv.sun_path, unixPath_.data(), unixPath_.size());
+    len = sizeof(serv);
+  }
+
+  if (::bind(Fd(), reinterpret_cast<struct sockaddr *>(&serv), len) != 0) {
+    ERROR("ListenSocket fd:{},Bind unix path:{} error:{}", Fd(), unixPath_, errno);
+    Close();
+    return false;
+  }
+  if (!abstract) {
+    unlinkPath_ = true;
+    if (unixPerm_ != 0 && ::chmod(unixPath_.c_str(), unixPerm_) != 0) {
+      WARN("ListenSocket chmod unix path:{} error:{}", unixPath_, errno);
+    }
+  }
+  return true;
+}
+
+bool ListenSocket::PeerAllowed(int fd) {
+  if (allowedUids_.empty()) {
+    return true;
+  }
+  uid_t uid;
+#ifdef SO_PEERCRED
+  struct ucred cred {};
+  socklen_t len = sizeof(cred);
+  if (::getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0) {
+    WARN("ListenSocket fd:{},SO_PEERCRED error:{}", fd, errno);
+    return false;
+  }
+  uid = cred.uid;
+#else
+  gid_t gid;
+  if (::getpeereid(fd, &uid, &gid) != 0) {
+    WARN("ListenSocket fd:{},getpeereid error:{}", fd, errno);
+    return false;
+  }
+#endif
+  if (std::find(allowedUids_.begin(), allowedUids_.end(), uid) == allowedUids_.end()) {
+    WARN("ListenSocket unix path:{} rejects the peer of uid:{}", unixPath_, uid);
+    return false;
+  }
+  return true;
+}
+
 bool ListenSocket::Listen() {
   int ret = ::listen(Fd(), ListenSocket::LISTENQ);
   if (0 != ret) {
@@ -110,12 +207,28 @@ bool ListenSocket::Listen() {
   return true;
 }
 
-int ListenSocket::Accept(sockaddr_in *clientAddr) {
-  socklen_t addrLength = sizeof(*clientAddr);
+bool ListenSocket::AttachCpuSteering(uint32_t groups) {
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+  // A = cpu of the softirq that received the SYN; A = A % groups; return A
+  struct sock_filter code[] = {
+      {BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU)},
+      {BPF_ALU | BPF_MOD | BPF_K, 0, 0, groups},
+      {BPF_RET | BPF_A, 0, 0, 0},
+  };
+  struct sock_fprog prog = {sizeof(code) / sizeof(code[0]), code};
+  if (::setsockopt(Fd(), SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)) == 0) {
+    return true;
+  }
+  WARN("ListenSocket fd:{},attach reuseport cbpf error:{}", Fd(), errno);
+#endif
+  return false;
+}
+
+int ListenSocket::Accept(sockaddr *clientAddr, socklen_t *addrLength) {
 #ifdef HAVE_ACCEPT4
-  return ::accept4(Fd(), reinterpret_cast<struct sockaddr *>(clientAddr), &addrLength, SOCK_NONBLOCK);
+  return ::accept4(Fd(), clientAddr, addrLength, SOCK_NONBLOCK);
 #else
-  return ::accept(Fd(), reinterpret_cast<struct sockaddr *>(clientAddr), &addrLength);
+  return ::accept(Fd(), clientAddr, addrLength);
 #endif
 }
 
@@ -10,7 +10,10 @@
 #include <arpa/inet.h>
 #include <atomic>
 #include <cstring>
+#include <sys/types.h>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "base_socket.h"
 
@@ -22,11 +25,25 @@ class ListenSocket : public BaseSocket {
 
   static ListenSocket *CreateUDPListen() { return new ListenSocket(SOCKET_LISTEN_UDP); }
 
+  static ListenSocket *CreateUnixListen() { return new ListenSocket(SOCKET_LISTEN_UNIX); }
+
+  ~ListenSocket() override;
+
   static const int LISTENQ;
   static bool REUSE_PORT;  // Determine whether REUSE_PORT can be used
 
   inline void SetListenAddr(const SocketAddr &addr) { addr_ = addr; }
 
+  // The path of a Unix listen socket, "@name" binds name in the Linux abstract namespace,
+  // which leaves no file behind and is not subject to file permissions
+  inline void SetUnixPath(const std::string &path) { unixPath_ = path; }
+
+  // The permissions of the socket file, 0 keeps the ones given by the umask
+  inline void SetUnixPerm(mode_t perm) { unixPerm_ = perm; }
+
+  // Only accept the Unix peers running as one of the uids, empty accepts every peer
+  inline void SetAllowedUids(std::vector<uid_t> uids) { allowedUids_ = std::move(uids); }
+
   // Accept new connection and create new connection object
   // when the connection is established, the OnCreate function is called
   int OnReadable(const std::shared_ptr<Connection> &conn, std::string *readBuff) override;
@@ -35,11 +52,16 @@ class ListenSocket : public BaseSocket {
   int OnWritable() override;
 
   // The function is cant be used
+  using BaseSocket::SendPacket;
   bool SendPacket(std::string &&msg) override;
 
   // Initialize the socket and bind the address
   int Init() override;
 
+  // Steer every new connection of the SO_REUSEPORT group to the listener
+  // cpu % groups, so it is accepted by the thread of the CPU that received it
+  bool AttachCpuSteering(uint32_t groups);
+
  private:
   explicit ListenSocket(int type) : BaseSocket(0) { SetSocketType(type); }
 
@@ -54,9 +76,19 @@ class ListenSocket : public BaseSocket {
 
  private:
   // Accept new connection
-  int Accept(sockaddr_in *clientAddr);
+  int Accept(sockaddr *clientAddr, socklen_t *addrLength);
+
+  bool BindUnix();
+
+  // Whether the peer of the Unix connection may connect, by its credentials
+  bool PeerAllowed(int fd);
 
   SocketAddr addr_;  // Listen address
+
+  std::string unixPath_;  // Listen path of a Unix socket
+  mode_t unixPerm_ = 0;
+  std::vector<uid_t> allowedUids_;
+  bool unlinkPath_ = false;  // Whether the socket file is ours to remove
 };
 
 }  // namespace net
@@ -8,6 +8,8 @@
 #pragma once
 
 #include <atomic>
+#include <memory>
+#include <string>
 
 #include "callback_function.h"
 
@@ -48,6 +50,9 @@ class NetEvent {
   // Send data
   virtual bool SendPacket(std::string &&msg) = 0;
 
+  // Send data that may be shared with other connections, e.g. a published message
+  virtual bool SendPacket(const std::shared_ptr<const std::string> &msg) { return SendPacket(std::string(*msg)); }
+
   virtual void Close() = 0;
 
   inline int Fd() const { return fd_.load(); }
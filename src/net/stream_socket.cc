@@ -6,6 +6,9 @@
  */
 
 #include "stream_socket.h"
+
+#include <sys/uio.h>
+
 #include "log.h"
 
 namespace net {
@@ -15,26 +18,60 @@ int StreamSocket::OnReadable(const std::shared_ptr<Connection> &conn, std::strin
 // return bytes that have not yet been sent
 int StreamSocket::OnWritable() {
   std::lock_guard<std::mutex> lock(sendMutex_);
-  size_t ret = ::write(Fd(), sendData_.c_str() + sendPos_, sendData_.size() - sendPos_);
-  if (ret == -1) {
-    if (EAGAIN == errno || EWOULDBLOCK == errno) {
-      return NE_OK;
+  while (!sendData_.empty()) {
+    struct iovec iov[kMaxWriteIov];
+    int iovCnt = 0;
+    size_t pos = sendPos_;
+    for (auto it = sendData_.begin(); it != sendData_.end() && iovCnt < kMaxWriteIov; ++it) {
+      iov[iovCnt].iov_base = const_cast<char *>((*it)->data() + pos);
+      iov[iovCnt].iov_len = (*it)->size() - pos;
+      ++iovCnt;
+      pos = 0;
+    }
+
+    ssize_t ret = ::writev(Fd(), iov, iovCnt);
+    if (ret == -1) {
+      if (EAGAIN == errno || EWOULDBLOCK == errno) {
+        return static_cast<int>(sendBytes_);
+      }
+      ERROR("StreamSocket fd: {} write error: {}", Fd(), errno);
+      return NE_ERROR;
+    }
+
+    auto written = static_cast<size_t>(ret);
+    sendBytes_ -= written;
+    while (written > 0) {
+      size_t left = sendData_.front()->size() - sendPos_;
+      if (written < left) {
+        sendPos_ += written;
+        break;
+      }
+      written -= left;
+      sendPos_ = 0;
+      sendData_.pop_front();
+    }
+
+    if (sendPos_ != 0) {  // the socket buffer is full, wait for the next writable event
+      return static_cast<int>(sendBytes_);
     }
-    ERROR("StreamSocket fd: {} write error: {}", Fd(), errno);
-    return NE_ERROR;
-  }
-  sendPos_ += ret;
-  if (sendPos_ == sendData_.size()) {
-    sendPos_ = 0;
-    sendData_.clear();
-    return 0;
   }
-  return static_cast<int>(sendData_.size() - sendPos_);
+  return 0;
 }
 
 bool StreamSocket::SendPacket(std::string &&msg) {
+  if (msg.empty()) {
+    return true;
+  }
+  return SendPacket(std::make_shared<const std::string>(std::move(msg)));
+}
+
+bool StreamSocket::SendPacket(const std::shared_ptr<const std::string> &msg) {
+  if (!msg || msg->empty()) {
+    return true;
+  }
   std::lock_guard<std::mutex> lock(sendMutex_);
-  sendData_.append(msg);
+  sendBytes_ += msg->size();
+  sendData_.push_back(msg);
   return true;
 }
 
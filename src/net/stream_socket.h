@@ -11,6 +11,7 @@
 #include <netinet/in.h>
 #include <atomic>
 #include <cstring>
+#include <deque>
 #include <memory>
 #include <mutex>
 
@@ -30,15 +31,22 @@ class StreamSocket : public BaseSocket {
 
   bool SendPacket(std::string &&msg) override;
 
+  bool SendPacket(const std::shared_ptr<const std::string> &msg) override;
+
   int Read(std::string *readBuff);
 
  private:
   const int readBuffSize_ = 4 * 1024;  // read from socket buff size 4K
 
+  static constexpr int kMaxWriteIov = 64;  // max buffers flushed by one writev
+
   std::mutex sendMutex_;  // send data buff mutex
 
-  std::string sendData_;  // send data buff
-  size_t sendPos_ = 0;    // send data buff pos
+  // Pending send buffers. A buffer may be shared by many sockets (e.g. one
+  // published message fanned out to all subscribers), so it is never modified.
+  std::deque<std::shared_ptr<const std::string>> sendData_;
+  size_t sendPos_ = 0;    // send pos in the front buffer
+  size_t sendBytes_ = 0;  // total bytes not yet sent
 };
 
 }  // namespace net
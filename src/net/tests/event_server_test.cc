@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2024-present, OpenAtom Foundation, Inc.  All rights reserved.
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include "event_server.h"
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <mutex>
+#include <thread>
+
+#include "log.h"
+
+class EchoClient {
+ public:
+  void SetConnId(uint64_t id) { connId_ = id; }
+  uint64_t GetConnId() { return connId_; }
+  void SetThreadIndex(int8_t index) { index_ = index; }
+  int8_t GetThreadIndex() { return index_; }
+
+ private:
+  uint64_t connId_ = 0;
+  std::atomic<int8_t> index_ = 0;
+};
+
+using EchoServer = net::EventServer<std::shared_ptr<EchoClient>>;
+
+class EventServerTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() { logger::Init("event_server_test.log"); }
+
+  void SetUp() override {
+    server_ = std::make_unique<EchoServer>(3);
+    server_->SetOnInit([](std::shared_ptr<EchoClient> *client) { *client = std::make_shared<EchoClient>(); });
+    server_->SetOnCreate([this](uint64_t, std::shared_ptr<EchoClient> &client, const net::SocketAddr &) {
+      std::lock_guard lock(clientsMutex_);
+      clients_.push_back(client);
+    });
+    server_->SetOnMessage([this](std::string &&msg, std::shared_ptr<EchoClient> &client) {
+      server_->SendPacket(client, std::move(msg));
+    });
+    server_->SetOnClose([](std::shared_ptr<EchoClient> &, std::string &&) {});
+
+    // port 0 would give every socket of the group its own port, and the
+    // listen sockets of the servers of the earlier tests are still open
+    static uint16_t nextPort = 41000;
+    for (port_ = nextPort; port_ < nextPort + 100; ++port_) {
+      server_->AddListenAddr(net::SocketAddr("127.0.0.1", port_));
+      if (server_->StartServer().first) {
+        nextPort = port_ + 1;
+        return;
+      }
+    }
+    FAIL() << "no free port";
+  }
+
+  void TearDown() override { server_->StopServer(); }
+
+  int Connect() const {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port_);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0) {
+      ::close(fd);
+      return -1;
+    }
+    struct timeval tv = {2, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    return fd;
+  }
+
+  static bool Echo(int fd, const std::string &msg) {
+    if (::write(fd, msg.data(), msg.size()) != static_cast<ssize_t>(msg.size())) {
+      return false;
+    }
+    std::string reply;
+    char buf[256];
+    while (reply.size() < msg.size()) {
+      auto n = ::read(fd, buf, sizeof(buf));
+      if (n <= 0) {
+        return false;
+      }
+      reply.append(buf, n);
+    }
+    return reply == msg;
+  }
+
+  std::unique_ptr<EchoServer> server_;
+  uint16_t port_ = 0;
+  std::mutex clientsMutex_;
+  std::vector<std::shared_ptr<EchoClient>> clients_;  // guarded by clientsMutex_
+};
+
+TEST_F(EventServerTest, ResizeKeepsConnections) {
+  std::vector<int> fds;
+  for (int i = 0; i < 12; i++) {
+    fds.push_back(Connect());
+    ASSERT_GE(fds.back(), 0);
+    ASSERT_TRUE(Echo(fds.back(), "ping" + std::to_string(i)));
+  }
+
+  ASSERT_TRUE(server_->Resize(1));
+  ASSERT_EQ(server_->ThreadNum(), 1);
+  for (size_t i = 0; i < fds.size(); i++) {
+    ASSERT_TRUE(Echo(fds[i], "after shrink " + std::to_string(i))) << i;
+  }
+
+  ASSERT_TRUE(server_->Resize(4));
+  ASSERT_EQ(server_->ThreadNum(), 4);
+  for (int i = 0; i < 12; i++) {
+    fds.push_back(Connect());
+    ASSERT_GE(fds.back(), 0);
+  }
+  for (size_t i = 0; i < fds.size(); i++) {
+    ASSERT_TRUE(Echo(fds[i], "after grow " + std::to_string(i)));
+  }
+
+  ASSERT_FALSE(server_->Resize(0));
+  for (auto fd : fds) {
+    ::close(fd);
+  }
+}
+
+TEST_F(EventServerTest, ConnTimersFollowConnections) {
+  std::vector<int> fds;
+  for (int i = 0; i < 6; i++) {
+    fds.push_back(Connect());
+    ASSERT_GE(fds.back(), 0);
+    ASSERT_TRUE(Echo(fds.back(), "ping" + std::to_string(i)));
+  }
+  std::vector<std::shared_ptr<EchoClient>> clients;
+  {
+    std::lock_guard lock(clientsMutex_);
+    clients = clients_;
+  }
+  ASSERT_EQ(clients.size(), fds.size());
+
+  std::atomic<int> fired = 0;
+  auto expire = net::TimingWheel::NowMs() + 300;
+  for (const auto &client : clients) {
+    server_->AddConnTimer(client, expire, [&fired] { fired++; });
+  }
+  // the timers of the retired threads go along with their connections
+  ASSERT_TRUE(server_->Resize(1));
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  ASSERT_EQ(fired, 0);
+  for (int i = 0; i < 100 && fired < static_cast<int>(clients.size()); i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_EQ(fired.load(), clients.size());
+  ASSERT_GE(net::TimingWheel::NowMs(), expire);
+
+  for (auto fd : fds) {
+    ::close(fd);
+  }
+}
+
+TEST_F(EventServerTest, BusyPollAvoidsWakeups) {
+  int fd = Connect();
+  ASSERT_GE(fd, 0);
+  ASSERT_TRUE(Echo(fd, "warm up"));
+  ASSERT_EQ(server_->GetPollStats().busyPollHits, 0);
+
+  // long enough for the next request to arrive while the loop is still spinning
+  server_->SetBusyPoll(200 * 1000);
+  for (int i = 0; i < 100; i++) {
+    ASSERT_TRUE(Echo(fd, "ping" + std::to_string(i)));
+  }
+  auto stats = server_->GetPollStats();
+  ASSERT_GT(stats.busyPollHits, 50);
+
+  server_->SetBusyPoll(0);
+  ASSERT_TRUE(Echo(fd, "blocking again"));
+  ::close(fd);
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2024-present, OpenAtom Foundation, Inc.  All rights reserved.
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include "listen_socket.h"
+#include <gtest/gtest.h>
+
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cstddef>
+
+#include "log.h"
+
+class ListenSocketTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() { logger::Init("listen_socket_test.log"); }
+};
+
+static int ConnectUnix(const std::string& path) {
+  int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  struct sockaddr_un addr {};
+  addr.sun_family = AF_UNIX;
+  socklen_t len = sizeof(addr);
+  if (path[0] == '@') {
+    memcpy(addr.sun_path + 1, path.data() + 1, path.size() - 1);
+    len = static_cast<socklen_t>(offsetof(struct sockaddr_un, sun_path) + path.size());
+  } else {
+    memcpy(addr.sun_path, path.data(), path.size());
+  }
+  if (::connect(fd, reinterpret_cast<struct sockaddr*>(&addr), len) != 0) {
+    ::close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static void AcceptAndReject(const std::string& path) {
+  std::unique_ptr<net::ListenSocket> listen(net::ListenSocket::CreateUnixListen());
+  listen->SetUnixPath(path);
+  listen->SetUnixPerm(0700);
+  ASSERT_EQ(listen->Init(), static_cast<int>(net::NetListen::OK));
+
+  int client = ConnectUnix(path);
+  ASSERT_GE(client, 0);
+  auto conn = std::make_shared<net::Connection>(nullptr);
+  auto fd = listen->OnReadable(conn, nullptr);
+  ASSERT_GT(fd, 0);
+  ASSERT_EQ(conn->addr_.GetIP(), "127.0.0.1");
+  ::close(client);
+
+  // the peer runs as the uid of this process, which is not allowed
+  listen->SetAllowedUids({getuid() + 1});
+  client = ConnectUnix(path);
+  ASSERT_GE(client, 0);
+  ASSERT_EQ(listen->OnReadable(conn, nullptr), net::NE_ERROR);
+  ASSERT_EQ(errno, ECONNABORTED);
+  ::close(client);
+
+  listen->SetAllowedUids({getuid()});
+  client = ConnectUnix(path);
+  ASSERT_GT(listen->OnReadable(conn, nullptr), 0);
+  ::close(client);
+}
+
+TEST_F(ListenSocketTest, UnixPath) {
+  std::string path = "listen_socket_test.sock";
+  AcceptAndReject(path);
+  struct stat st {};
+  // removed with the listen socket
+  ASSERT_NE(::stat(path.c_str(), &st), 0);
+}
+
+#ifdef __linux__
+TEST_F(ListenSocketTest, UnixAbstract) { AcceptAndReject("@listen_socket_test"); }
+#endif
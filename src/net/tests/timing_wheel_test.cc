@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2024-present, OpenAtom Foundation, Inc.  All rights reserved.
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include "timing_wheel.h"
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <iostream>
+#include <queue>
+#include <random>
+
+class TimingWheelTest : public ::testing::Test {};
+
+TEST(TimingWheelTest, ExpireInOrder) {
+  net::TimingWheel wheel(1000);
+  std::vector<int64_t> fired;
+  for (int64_t delay : {300, 1, 70000, 255, 256, 5, 20000000, 100000000}) {
+    wheel.Add(1000 + delay, [&fired, delay] { fired.push_back(delay); });
+  }
+  ASSERT_EQ(wheel.Size(), 8);
+
+  ASSERT_EQ(wheel.Advance(1000), 0);
+  ASSERT_EQ(wheel.Advance(1005), 2);
+  ASSERT_EQ(fired, std::vector<int64_t>({1, 5}));
+  ASSERT_EQ(wheel.Advance(1255), 1);
+  ASSERT_EQ(wheel.Advance(1256), 1);
+  ASSERT_EQ(wheel.Advance(1299), 0);
+  ASSERT_EQ(wheel.Advance(1300), 1);
+  ASSERT_EQ(wheel.Advance(1000 + 69999), 0);
+  ASSERT_EQ(wheel.Advance(1000 + 70000), 1);
+  ASSERT_EQ(wheel.Advance(1000 + 19999999), 0);
+  ASSERT_EQ(wheel.Advance(1000 + 20000000), 1);
+  // beyond the span of the wheel
+  ASSERT_EQ(wheel.Advance(1000 + 99999999), 0);
+  ASSERT_EQ(wheel.Advance(1000 + 100000000), 1);
+  ASSERT_EQ(fired, std::vector<int64_t>({1, 5, 255, 256, 300, 70000, 20000000, 100000000}));
+  ASSERT_EQ(wheel.Size(), 0);
+}
+
+TEST(TimingWheelTest, Overdue) {
+  net::TimingWheel wheel(1000);
+  int fired = 0;
+  wheel.Add(10, [&fired] { fired++; });
+  ASSERT_EQ(wheel.TimeToNext(), 1);
+  ASSERT_EQ(wheel.Advance(1001), 1);
+  ASSERT_EQ(fired, 1);
+  ASSERT_EQ(wheel.TimeToNext(), -1);
+}
+
+TEST(TimingWheelTest, Cancel) {
+  net::TimingWheel wheel(0);
+  int fired = 0;
+  auto id = wheel.Add(10, [&fired] { fired++; });
+  wheel.Add(10, [&fired] { fired += 10; });
+  ASSERT_TRUE(wheel.Cancel(id));
+  ASSERT_FALSE(wheel.Cancel(id));
+  ASSERT_FALSE(wheel.Cancel(0));
+  ASSERT_EQ(wheel.Advance(10), 1);
+  ASSERT_EQ(fired, 10);
+
+  // a callback cancels a later timer of its own batch, whose node is then reused,
+  // the timers of one tick run the last added first
+  auto later = wheel.Add(20, [&fired] { fired++; });
+  wheel.Add(20, [&] {
+    wheel.Cancel(later);
+    wheel.Add(20, [&fired] { fired += 100; });
+  });
+  ASSERT_EQ(wheel.Advance(20), 1);
+  ASSERT_EQ(wheel.Advance(21), 1);
+  ASSERT_EQ(fired, 110);
+  ASSERT_EQ(wheel.Size(), 0);
+}
+
+TEST(TimingWheelTest, Periodic) {
+  net::TimingWheel wheel(0);
+  int fired = 0;
+  uint64_t id = 0;
+  id = wheel.Add(100, [&] {
+    if (++fired == 3) {
+      wheel.Cancel(id);
+    }
+  }, 100);
+  ASSERT_EQ(wheel.Advance(99), 0);
+  ASSERT_EQ(wheel.Advance(100), 1);
+  ASSERT_EQ(wheel.TimeToNext(), 100);
+  ASSERT_EQ(wheel.Advance(1000), 2);
+  ASSERT_EQ(fired, 3);
+  ASSERT_EQ(wheel.Size(), 0);
+}
+
+TEST(TimingWheelTest, TakeAll) {
+  net::TimingWheel wheel(0);
+  int fired = 0;
+  auto id = wheel.Add(10, [&fired] { fired++; });
+  wheel.Add(100000, [&fired] { fired += 10; }, 50);
+  wheel.Add(30, [&fired] { fired += 100; });
+  ASSERT_TRUE(wheel.Cancel(id));
+
+  auto timers = wheel.TakeAll();
+  ASSERT_EQ(timers.size(), 2);
+  ASSERT_EQ(wheel.Size(), 0);
+  ASSERT_EQ(wheel.TimeToNext(), -1);
+  ASSERT_EQ(wheel.Advance(200000), 0);
+
+  // another wheel runs them
+  net::TimingWheel other(0);
+  for (auto &timer : timers) {
+    other.Add(timer.expire, std::move(timer.callback), timer.interval);
+  }
+  ASSERT_EQ(other.Advance(30), 1);
+  ASSERT_EQ(other.Advance(100050), 2);
+  ASSERT_EQ(fired, 120);
+}
+
+// 1M timers spread over the first ten minutes, like one idle timeout per connection
+TEST(TimingWheelTest, OneMillionTimers) {
+  constexpr int kTimers = 1000000;
+  constexpr int64_t kSpread = 600000;
+  std::mt19937_64 rng(42);
+  std::vector<int64_t> expires(kTimers);
+  for (auto& expire : expires) {
+    expire = 1 + static_cast<int64_t>(rng() % kSpread);
+  }
+  auto elapsed = [](auto start) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+  };
+
+  net::TimingWheel wheel(0);
+  size_t fired = 0;
+  std::vector<uint64_t> ids(kTimers);
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kTimers; i++) {
+    ids[i] = wheel.Add(expires[i], [&fired] { fired++; });
+  }
+  auto add_ms = elapsed(start);
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kTimers; i += 2) {
+    wheel.Cancel(ids[i]);
+  }
+  auto cancel_ms = elapsed(start);
+
+  // one Advance per 10ms, the interval of the server timer
+  start = std::chrono::steady_clock::now();
+  for (int64_t now = 10; now <= kSpread; now += 10) {
+    wheel.Advance(now);
+  }
+  auto expire_ms = elapsed(start);
+  ASSERT_EQ(fired, kTimers / 2);
+  ASSERT_EQ(wheel.Size(), 0);
+
+  // the same work on a binary heap with lazy deletes, as net::Timer did before
+  std::priority_queue<std::pair<int64_t, int>, std::vector<std::pair<int64_t, int>>, std::greater<>> heap;
+  std::vector<bool> deleted(kTimers);
+  size_t heap_fired = 0;
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kTimers; i++) {
+    heap.emplace(expires[i], i);
+  }
+  for (int i = 0; i < kTimers; i += 2) {
+    deleted[i] = true;
+  }
+  for (int64_t now = 10; now <= kSpread; now += 10) {
+    while (!heap.empty() && heap.top().first <= now) {
+      heap_fired += !deleted[heap.top().second];
+      heap.pop();
+    }
+  }
+  auto heap_ms = elapsed(start);
+  ASSERT_EQ(heap_fired, fired);
+
+  std::cout << "timing wheel, " << kTimers << " timers: add " << add_ms << "ms, cancel half " << cancel_ms
+            << "ms, expire " << expire_ms << "ms; binary heap in total " << heap_ms << "ms" << std::endl;
+}
@@ -8,10 +8,12 @@
 #pragma once
 
 #include <atomic>
+#include <cerrno>
 #include <memory>
 #include <mutex>
 #include <shared_mutex>
 #include <unordered_map>
+#include <vector>
 
 #include "callback_function.h"
 #include "config.h"
@@ -53,12 +55,32 @@ class ThreadManager {
   // set close connect callback function
   inline void SetOnClose(const OnClose<T> &func) { onClose_ = func; }
 
+  // Serve a Unix listen socket next to the TCP one, must be set before Start
+  inline void SetUnixListen(const std::shared_ptr<NetEvent> &listen) { unixListen_ = listen; }
+
+  // Pin the read and write threads to the CPU, -1 leaves them unpinned
+  inline void SetCpu(int cpu) { cpu_ = cpu; }
+
+  // Busy poll of the read thread, see BaseEvent::SetBusyPoll
+  void SetBusyPoll(int64_t us);
+
+  // Adds the counters of the read thread to stats
+  void AddPollStats(PollStats *stats);
+
   // Start the thread and initialize the event
   bool Start(const std::shared_ptr<NetEvent> &listen, const std::shared_ptr<Timer> &timer);
 
   // Stop the thread
   void Stop();
 
+  // Stop the thread and hand everything over to successor: the connections waiting on
+  // the listen socket when ownListen, and the open ones. Calls for them on this thread
+  // are forwarded to successor from then on. Start brings a retired thread back.
+  void Retire(ThreadManager<T> *successor, bool ownListen);
+
+  // Take over a connection of a retiring thread
+  void Adopt(uint64_t connId, T t, const std::shared_ptr<Connection> &conn);
+
   // Create a new connection callback function
   void OnNetEventCreate(int fd, const std::shared_ptr<Connection> &conn);
 
@@ -71,6 +93,10 @@ class ThreadManager {
   // Server actively closes the connection
   void CloseConnection(uint64_t connId);
 
+  // Run the callback on the read thread at expire (ms, TimingWheel::NowMs), from any thread.
+  // The timers of a retired thread go along with its connections.
+  void AddTimer(int64_t expire, TimingWheel::Callback callback, int64_t interval = 0);
+
   void TCPConnect(const SocketAddr &addr, std::unique_ptr<NetEvent> netEvent);
 
   void TCPConnect(const SocketAddr &addr, std::unique_ptr<NetEvent> netEvent, OnCreate<T> onConnect);
@@ -80,6 +106,9 @@ class ThreadManager {
   // Send message to the client
   void SendPacket(const T &conn, std::string &&msg);
 
+  // Send one shared message to a batch of clients of this thread
+  void SendPacket(const std::vector<T> &conns, const std::shared_ptr<const std::string> &msg);
+
  private:
   // Create read thread
   bool CreateReadThread(const std::shared_ptr<NetEvent> &listen, const std::shared_ptr<Timer> &timer);
@@ -89,10 +118,24 @@ class ThreadManager {
 
   uint64_t DoTCPConnect(T &t, int fd, const std::shared_ptr<Connection> &conn);
 
+  // Arm the write event of a connection with data queued
+  inline void SetWriteEvent(uint64_t connId, int fd) {
+    if (rwSeparation_) {
+      writeThread_->SetWriteEvent(connId, fd);
+    } else {
+      readThread_->SetWriteEvent(connId, fd);
+    }
+  }
+
  private:
   const bool rwSeparation_ = true;    // Whether to separate read and write threads
   const int8_t index_ = 0;            // The index of the thread
+  int cpu_ = -1;                      // The CPU of the read and write threads
+  std::atomic<int64_t> busyPollUs_ = 0;
+  std::shared_ptr<NetEvent> unixListen_;
   std::atomic<bool> running_ = true;  // Whether the thread is running
+  std::shared_ptr<NetEvent> listen_;
+  std::atomic<ThreadManager<T> *> successor_ = nullptr;  // Who took over the connections once retired
 
   std::unique_ptr<IOThread> readThread_;   // Read thread
   std::unique_ptr<IOThread> writeThread_;  // Write thread
@@ -119,6 +162,9 @@ requires HasSetFdFunction<T> ThreadManager<T>::~ThreadManager() { Stop(); }
 template <typename T>
 requires HasSetFdFunction<T>
 bool ThreadManager<T>::Start(const std::shared_ptr<NetEvent> &listen, const std::shared_ptr<Timer> &timer) {
+  listen_ = listen;
+  running_ = true;
+  successor_ = nullptr;
   if (!CreateReadThread(listen, timer)) {
     return false;
   }
@@ -140,6 +186,87 @@ void ThreadManager<T>::Stop() {
   }
 }
 
+template <typename T>
+requires HasSetFdFunction<T>
+void ThreadManager<T>::SetBusyPoll(int64_t us) {
+  busyPollUs_ = us;
+  if (readThread_) {
+    readThread_->SetBusyPoll(us);
+  }
+}
+
+template <typename T>
+requires HasSetFdFunction<T>
+void ThreadManager<T>::AddPollStats(PollStats *stats) {
+  if (!readThread_) {
+    return;
+  }
+  auto pollStats = readThread_->GetPollStats();
+  stats->blockingPolls += pollStats.blockingPolls;
+  stats->busyPollHits += pollStats.busyPollHits;
+}
+
+template <typename T>
+requires HasSetFdFunction<T>
+void ThreadManager<T>::Retire(ThreadManager<T> *successor, bool ownListen) {
+  {
+    // from now on SendPacket only queues the data, Adopt arms the write event on the successor
+    std::lock_guard lock(mutex_);
+    running_ = false;
+  }
+  readThread_->Stop();
+  if (rwSeparation_) {
+    writeThread_->Stop();
+  }
+
+  // The connections still in the accept queue would be reset along with the socket.
+  // Those arriving between the drain and the close are moved to another socket of
+  // the group by the kernel when net.ipv4.tcp_migrate_req is on.
+  if (ownListen && listen_) {
+    while (true) {
+      auto newConn = std::make_shared<Connection>(nullptr);
+      auto connFd = listen_->OnReadable(newConn, nullptr);
+      if (connFd < 0) {
+        if (errno == ECONNABORTED || errno == EINTR) {
+          continue;
+        }
+        break;
+      }
+      successor->OnNetEventCreate(connFd, newConn);
+    }
+    listen_->Close();
+  }
+  listen_.reset();
+
+  std::lock_guard lock(mutex_);
+  successor_ = successor;
+  for (auto &[connId, conn] : connections_) {
+    successor->Adopt(connId, conn.first, conn.second);
+  }
+  connections_.clear();
+  for (auto &timer : readThread_->TakeTimers()) {
+    successor->AddTimer(timer.expire, std::move(timer.callback), timer.interval);
+  }
+}
+
+template <typename T>
+requires HasSetFdFunction<T>
+void ThreadManager<T>::Adopt(uint64_t connId, T t, const std::shared_ptr<Connection> &conn) {
+  if constexpr (IsPointer_v<T>) {
+    t->SetThreadIndex(index_);
+  } else {
+    t.SetThreadIndex(index_);
+  }
+
+  {
+    std::lock_guard lock(mutex_);
+    connections_.emplace(connId, std::make_pair(t, conn));
+  }
+  readThread_->AddNewEvent(connId, conn->fd_, BaseEvent::EVENT_READ);
+  // flush what was sent while the connection was on its way
+  SetWriteEvent(connId, conn->fd_);
+}
+
 template <typename T>
 requires HasSetFdFunction<T>
 void ThreadManager<T>::OnNetEventCreate(int fd, const std::shared_ptr<Connection> &conn) {
@@ -201,7 +328,13 @@ void ThreadManager<T>::OnNetEventClose(uint64_t connId, std::string &&err) {
 
 template <typename T>
 requires HasSetFdFunction<T>
-void ThreadManager<T>::CloseConnection(uint64_t connId) { OnNetEventClose(connId, ""); }
+void ThreadManager<T>::CloseConnection(uint64_t connId) {
+  if (auto successor = successor_.load(); successor) {
+    successor->CloseConnection(connId);
+    return;
+  }
+  OnNetEventClose(connId, "");
+}
 
 template <typename T>
 requires HasSetFdFunction<T>
@@ -248,6 +381,11 @@ void ThreadManager<T>::SendPacket(const T &conn, std::string &&msg) {
   {
     auto iter = connections_.find(connId);
     if (iter == connections_.end()) {
+      // handed over by Retire while the reply was being built
+      if (auto successor = successor_.load(); successor) {
+        lock.unlock();
+        successor->SendPacket(conn, std::move(msg));
+      }
       return;
     }
     connPtr = iter->second.second;
@@ -255,11 +393,56 @@ void ThreadManager<T>::SendPacket(const T &conn, std::string &&msg) {
 
   connPtr->netEvent_->SendPacket(std::move(msg));
 
-  if (rwSeparation_) {
-    writeThread_->SetWriteEvent(connId, connPtr->fd_);
-  } else {
-    readThread_->SetWriteEvent(connId, connPtr->fd_);
+  if (running_) {
+    SetWriteEvent(connId, connPtr->fd_);
+  }
+}
+
+template <typename T>
+requires HasSetFdFunction<T>
+void ThreadManager<T>::SendPacket(const std::vector<T> &conns, const std::shared_ptr<const std::string> &msg) {
+  std::vector<T> moved;  // handed over by Retire
+  std::shared_lock lock(mutex_);
+  for (const auto &conn : conns) {
+    uint64_t connId = 0;
+    if constexpr (IsPointer_v<T>) {
+      connId = conn->GetConnId();
+    } else {
+      connId = conn.GetConnId();
+    }
+    auto iter = connections_.find(connId);
+    if (iter == connections_.end()) {
+      if (successor_.load()) {
+        moved.push_back(conn);
+      }
+      continue;
+    }
+    const auto &connPtr = iter->second.second;
+
+    connPtr->netEvent_->SendPacket(msg);
+
+    if (running_) {
+      SetWriteEvent(connId, connPtr->fd_);
+    }
+  }
+  lock.unlock();
+
+  if (!moved.empty()) {
+    successor_.load()->SendPacket(moved, msg);
+  }
+}
+
+template <typename T>
+requires HasSetFdFunction<T>
+void ThreadManager<T>::AddTimer(int64_t expire, TimingWheel::Callback callback, int64_t interval) {
+  // under the lock, so Retire takes the timer along if it posts to a stopped loop
+  std::shared_lock lock(mutex_);
+  if (auto successor = successor_.load(); successor) {
+    lock.unlock();
+    successor->AddTimer(expire, std::move(callback), interval);
+    return;
   }
+  readThread_->PostTimer(expire, std::move(callback), interval);
 }
 
 template <typename T>
@@ -278,6 +461,8 @@ bool ThreadManager<T>::CreateReadThread(const std::shared_ptr<NetEvent> &listen,
 #endif
 
   event->AddTimer(timer);
+  event->SetUnixListen(unixListen_);
+  event->SetBusyPoll(busyPollUs_);
 
   event->SetOnCreate(
       [this](uint64_t connId, const std::shared_ptr<Connection> &conn) { OnNetEventCreate(connId, conn); });
@@ -297,6 +482,7 @@ bool ThreadManager<T>::CreateReadThread(const std::shared_ptr<NetEvent> &listen,
   });
 
   readThread_ = std::make_unique<IOThread>(event);
+  readThread_->SetCpu(cpu_);
   return readThread_->Run();
 }
 
@@ -322,6 +508,7 @@ bool ThreadManager<T>::CreateWriteThread() {
   });
 
   writeThread_ = std::make_unique<IOThread>(event);
+  writeThread_->SetCpu(cpu_);
   return writeThread_->Run();
 }
 
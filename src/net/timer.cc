@@ -14,53 +14,28 @@ int64_t Timer::AddTask(const std::shared_ptr<ITimerTask>& task) {
     return -1;
   }
   std::unique_lock l(lock_);
-  int64_t _taskId = TaskId();
-  task->SetId(_taskId);
-  queue_.push(task);
-  return _taskId;
+  auto taskId = static_cast<int64_t>(wheel_.Add(
+      task->Start(),
+      [task] {
+        task->TimeOut();
+        task->Next();
+      },
+      task->Interval()));
+  task->SetId(taskId);
+  return taskId;
 }
 
-void Timer::RePushTask() {
-  for (const auto& task : list_) {
-    task->Next();
-    { queue_.push(task); }
-  }
-  list_.clear();
-}
-
-void Timer::PopTask(std::shared_ptr<ITimerTask>& task, bool deleted) {
-  if (!task) {
-    return;
-  }
-  if (deleted) {
-    DelMark(task->Id());
-  } else {
-    list_.emplace_back(task);
-  }
-
-  queue_.pop();
+void Timer::DelTask(int64_t taskId) {
+  std::unique_lock l(lock_);
+  wheel_.Cancel(static_cast<uint64_t>(taskId));
 }
 
 void Timer::OnTimer() {
-  std::unique_lock l(lock_);
-  auto now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch())
-                 .count();
-
-  while (!queue_.empty()) {
-    auto task = queue_.top();
-    if (Deleted(task->Id())) {
-      PopTask(task, true);
-      continue;
-    }
-    if (now >= task->Start()) {
-      task->TimeOut();
-      PopTask(task, false);
-    } else {
-      break;
-    }
+  std::unique_lock l(lock_, std::try_to_lock);
+  if (!l.owns_lock()) {
+    return;  // another loop is running the due tasks
   }
-
-  RePushTask();  // reload the task
+  wheel_.Advance();
 }
 
 }  // namespace net
@@ -7,19 +7,18 @@
 
 #pragma once
 
-#include <atomic>
-#include <map>
 #include <memory>
 #include <mutex>
-#include <queue>
-#include <set>
-#include <shared_mutex>
-#include <thread>
 
 #include "timer_task.h"
+#include "timing_wheel.h"
 
 namespace net {
 
+// The timer shared by the event loops of a server. The tasks sit in a timing
+// wheel, so adding and deleting one is O(1) however many there are. Every
+// loop calls OnTimer, whichever gets the lock first advances the wheel and
+// the others go on without waiting.
 class Timer {
  public:
   explicit Timer(int64_t interval) : interval_(interval) {}
@@ -27,42 +26,19 @@ class Timer {
   ~Timer() = default;
 
  private:
-  std::shared_mutex lock_;
-  std::shared_mutex lockSet_;
+  // recursive, so a task may add or delete tasks from TimeOut
+  std::recursive_mutex lock_;
   int64_t interval_;
-  int64_t taskId_ = 0;
-  std::set<int64_t> markDel;
-  std::priority_queue<std::shared_ptr<ITimerTask>> queue_;
-  std::vector<std::shared_ptr<ITimerTask>> list_;
+  TimingWheel wheel_;
 
  public:
   inline int64_t Interval() const { return interval_; }
 
   int64_t AddTask(const std::shared_ptr<ITimerTask>& task);
 
-  inline void DelTask(int64_t taskId) {
-    std::unique_lock l(lockSet_);
-    markDel.insert(taskId);
-  }
+  void DelTask(int64_t taskId);
 
   void OnTimer();
-
- private:
-  inline int64_t TaskId() { return ++taskId_; }
-
-  inline bool Deleted(int64_t taskId) {
-    std::shared_lock l(lockSet_);
-    return markDel.count(taskId);
-  }
-
-  inline void DelMark(int64_t taskId) {
-    std::unique_lock l(lockSet_);
-    markDel.erase(taskId);
-  }
-
-  void RePushTask();
-
-  void PopTask(std::shared_ptr<ITimerTask>& task, bool deleted);
 };
 
 }  // namespace net
@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2024-present, OpenAtom Foundation, Inc.  All rights reserved.
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include "timing_wheel.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace net {
+
+TimingWheel::TimingWheel(int64_t now) : current_(now) {
+  slots_.assign(kRootSlots + kLevelSlots * (kLevels - 1), kNil);
+}
+
+int64_t TimingWheel::NowMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+uint64_t TimingWheel::Add(int64_t expire, Callback callback, int64_t interval) {
+  uint32_t index;
+  if (!free_.empty()) {
+    index = free_.back();
+    free_.pop_back();
+  } else {
+    index = static_cast<uint32_t>(nodes_.size());
+    nodes_.emplace_back();
+  }
+  auto &node = nodes_[index];
+  node.expire = expire;
+  node.interval = std::max<int64_t>(interval, 0);
+  node.active = true;
+  node.callback = std::move(callback);
+  Link(index);
+  size_++;
+  return MakeId(index, node.gen);
+}
+
+bool TimingWheel::Cancel(uint64_t id) {
+  auto node = Find(id);
+  if (!node) {
+    return false;
+  }
+  auto index = static_cast<uint32_t>((id & UINT32_MAX) - 1);
+  // a node of the batch being expired is not linked, freeing it is enough for the batch to skip it
+  if (node->slot >= 0) {
+    Unlink(index);
+  }
+  Free(index);
+  return true;
+}
+
+std::vector<TimingWheel::Timer> TimingWheel::TakeAll() {
+  std::vector<Timer> timers;
+  timers.reserve(size_);
+  for (uint32_t index = 0; index < nodes_.size(); index++) {
+    auto &node = nodes_[index];
+    if (!node.active) {
+      continue;
+    }
+    timers.push_back({node.expire, node.interval, std::move(node.callback)});
+    Unlink(index);
+    Free(index);
+  }
+  return timers;
+}
+
+TimingWheel::Node *TimingWheel::Find(uint64_t id) {
+  auto low = id & UINT32_MAX;
+  if (low == 0 || low > nodes_.size()) {
+    return nullptr;
+  }
+  auto &node = nodes_[low - 1];
+  if (!node.active || node.gen != static_cast<uint32_t>(id >> 32)) {
+    return nullptr;
+  }
+  return &node;
+}
+
+void TimingWheel::Link(uint32_t index) {
+  auto &node = nodes_[index];
+  // an overdue timer expires on the next tick
+  int64_t when = std::max(node.expire, current_ + 1);
+  int64_t delta = when - current_;
+  int level = 0;
+  while (level < kLevels - 1 && delta >= (1LL << Shift(level + 1))) {
+    level++;
+  }
+  if (delta >= kMaxSpan) {
+    // parked in the last slot the top level reaches, Cascade puts it back in place when it comes round
+    when = current_ + kMaxSpan - 1;
+  }
+  int64_t mask = level == 0 ? kRootSlots - 1 : kLevelSlots - 1;
+  auto slot = static_cast<int32_t>(SlotBase(level) + ((when >> Shift(level)) & mask));
+
+  node.slot = slot;
+  node.prev = kNil;
+  node.next = slots_[slot];
+  if (node.next != kNil) {
+    nodes_[node.next].prev = index;
+  }
+  slots_[slot] = index;
+  levelSize_[level]++;
+}
+
+void TimingWheel::Unlink(uint32_t index) {
+  auto &node = nodes_[index];
+  if (node.prev != kNil) {
+    nodes_[node.prev].next = node.next;
+  } else {
+    slots_[node.slot] = node.next;
+  }
+  if (node.next != kNil) {
+    nodes_[node.next].prev = node.prev;
+  }
+  int level = node.slot < kRootSlots ? 0 : 1 + static_cast<int>((node.slot - kRootSlots) / kLevelSlots);
+  levelSize_[level]--;
+  node.slot = -1;
+  node.prev = kNil;
+  node.next = kNil;
+}
+
+void TimingWheel::Free(uint32_t index) {
+  auto &node = nodes_[index];
+  node.active = false;
+  node.gen++;
+  node.callback = nullptr;
+  free_.push_back(index);
+  size_--;
+}
+
+void TimingWheel::Cascade(int level) {
+  auto slot = SlotBase(level) + ((current_ >> Shift(level)) & (kLevelSlots - 1));
+  auto index = slots_[slot];
+  slots_[slot] = kNil;
+  while (index != kNil) {
+    auto next = nodes_[index].next;
+    nodes_[index].slot = -1;
+    levelSize_[level]--;
+    Link(index);
+    index = next;
+  }
+}
+
+size_t TimingWheel::Advance(int64_t now) {
+  size_t fired = 0;
+  while (current_ < now) {
+    if (size_ == 0) {
+      current_ = now;
+      break;
+    }
+    // nothing can expire before the root level wraps, jump to the end of its round
+    if (levelSize_[0] == 0) {
+      int64_t round_end = current_ | (kRootSlots - 1);
+      if (round_end > current_) {
+        current_ = std::min(round_end, now);
+        continue;
+      }
+    }
+
+    current_++;
+    // a level moves on to its next slot each time the level below wraps
+    for (int level = 1; level < kLevels; level++) {
+      if ((current_ & ((1LL << Shift(level)) - 1)) != 0) {
+        break;
+      }
+      Cascade(level);
+    }
+
+    // detach the whole slot first, the callbacks may add or cancel timers
+    auto slot = static_cast<int32_t>(current_ & (kRootSlots - 1));
+    auto index = slots_[slot];
+    slots_[slot] = kNil;
+    while (index != kNil) {
+      auto &node = nodes_[index];
+      auto next = node.next;
+      node.slot = -1;
+      node.prev = kNil;
+      node.next = kNil;
+      levelSize_[0]--;
+      expired_.emplace_back(index, node.gen);
+      index = next;
+    }
+
+    for (auto [i, gen] : expired_) {
+      if (!nodes_[i].active || nodes_[i].gen != gen) {
+        continue;  // cancelled by an earlier callback of the batch
+      }
+      // the callback may grow nodes_, so it runs from a local
+      auto callback = std::move(nodes_[i].callback);
+      callback();
+      fired++;
+      auto &node = nodes_[i];
+      if (!node.active || node.gen != gen) {
+        continue;  // cancelled by its own callback
+      }
+      if (node.interval > 0) {
+        node.expire += node.interval;
+        node.callback = std::move(callback);
+        Link(i);
+      } else {
+        Free(i);
+      }
+    }
+    expired_.clear();
+  }
+  return fired;
+}
+
+int64_t TimingWheel::TimeToNext() const {
+  if (size_ == 0) {
+    return -1;
+  }
+  // the upper levels are only looked at when the root level wraps
+  int64_t wrap = (current_ | (kRootSlots - 1)) + 1;
+  if (levelSize_[0] > 0) {
+    for (int64_t tick = current_ + 1; tick < wrap; tick++) {
+      if (slots_[tick & (kRootSlots - 1)] != kNil) {
+        return tick - current_;
+      }
+    }
+  }
+  return wrap - current_;
+}
+
+}  // namespace net
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2024-present, OpenAtom Foundation, Inc.  All rights reserved.
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace net {
+
+// A hierarchical timing wheel with a tick of one millisecond. Adding and
+// cancelling a timer is O(1), the timers of a tick expire as one batch and
+// the far ones are cascaded down a level at a time. It is not thread safe:
+// it belongs to one thread, usually an event loop, and is only touched there.
+class TimingWheel {
+ public:
+  using Callback = std::function<void()>;
+
+  // A timer out of the wheel, e.g. on its way to the wheel of another thread
+  struct Timer {
+    int64_t expire = 0;
+    int64_t interval = 0;
+    Callback callback;
+  };
+
+  explicit TimingWheel(int64_t now = NowMs());
+
+  TimingWheel(const TimingWheel &) = delete;
+  TimingWheel &operator=(const TimingWheel &) = delete;
+
+  // Run the callback at the absolute time expire (ms, steady clock), then every
+  // interval ms if interval > 0. Returns the id to cancel it, never 0.
+  uint64_t Add(int64_t expire, Callback callback, int64_t interval = 0);
+
+  // Returns false if the timer has already expired or been cancelled
+  bool Cancel(uint64_t id);
+
+  // Expire every timer due by now, returns how many callbacks ran
+  size_t Advance(int64_t now = NowMs());
+
+  // How long until the next tick with work to do, -1 when there is no timer
+  int64_t TimeToNext() const;
+
+  // Removes every timer and returns them, their ids are no longer valid.
+  // Not to be called from a callback.
+  std::vector<Timer> TakeAll();
+
+  inline size_t Size() const { return size_; }
+
+  static int64_t NowMs();
+
+ private:
+  static constexpr uint32_t kNil = UINT32_MAX;
+  static constexpr int kLevels = 4;
+  static constexpr int kRootBits = 8;  // 256 slots of 1ms
+  static constexpr int kLevelBits = 6;  // 64 slots of the span of the level below
+  static constexpr int64_t kRootSlots = 1 << kRootBits;
+  static constexpr int64_t kLevelSlots = 1 << kLevelBits;
+  // the wheel spans 2^26 ms (18.6 hours), later timers wait in the top level and are put back
+  static constexpr int64_t kMaxSpan = 1LL << (kRootBits + kLevelBits * (kLevels - 1));
+
+  struct Node {
+    int64_t expire = 0;
+    int64_t interval = 0;
+    uint32_t prev = kNil;
+    uint32_t next = kNil;
+    uint32_t gen = 0;       // bumped whenever the node is freed, so stale ids are rejected
+    int32_t slot = -1;      // index into slots_, -1 when the node is not linked
+    bool active = false;    // false once freed
+    Callback callback;
+  };
+
+  static inline int Shift(int level) { return level == 0 ? 0 : kRootBits + kLevelBits * (level - 1); }
+
+  static inline int SlotBase(int level) { return level == 0 ? 0 : kRootSlots + kLevelSlots * (level - 1); }
+
+  static inline uint64_t MakeId(uint32_t index, uint32_t gen) { return (static_cast<uint64_t>(gen) << 32) | (index + 1); }
+
+  Node *Find(uint64_t id);
+
+  void Link(uint32_t index);
+  void Unlink(uint32_t index);
+  void Free(uint32_t index);
+  void Cascade(int level);
+
+  int64_t current_ = 0;  // the last tick processed
+  size_t size_ = 0;
+  std::vector<Node> nodes_;
+  std::vector<uint32_t> free_;
+  std::vector<uint32_t> slots_;  // head of each slot, the root level first
+  std::array<size_t, kLevels> levelSize_{};
+  std::vector<std::pair<uint32_t, uint32_t>> expired_;  // the batch of the current tick, index and gen
+};
+
+}  // namespace net
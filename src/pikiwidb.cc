@@ -18,18 +18,22 @@
 #include <sys/wait.h>
 #include <time.h>
 #include <unistd.h>
+#include <algorithm>
 #include <cstdio>
 #include <iostream>
 #include <thread>
 
 #include "praft/praft.h"
 #include "pstd/log.h"
+#include "pstd/pstd_cpu.h"
+#include "pstd/pstd_string.h"
 #include "pstd/pstd_util.h"
 
 #include "client.h"
 #include "config.h"
 #include "helper.h"
 #include "pikiwidb_logo.h"
+#include "pubsub.h"
 #include "slow_log.h"
 #include "store.h"
 
@@ -180,7 +184,12 @@ bool PikiwiDB::Init() {
     ERROR("init cmd thread pool failed: {}", status.ToString());
     return false;
   }
+  std::vector<int> cmd_cpus;
+  pstd::ParseCpuList(g_config.cmd_threads_cpu_list.ToString(), &cmd_cpus);
+  cmd_threads_.SetCpuList(std::move(cmd_cpus));
+  ApplyQosLimits();
 
+  // the DBs are opened in the background, clients get -LOADING until they are ready
   PSTORE.Init(g_config.databases.load(std::memory_order_relaxed));
 
   PSlowLog::Instance().SetThreshold(g_config.slow_log_time.load());
@@ -194,11 +203,32 @@ bool PikiwiDB::Init() {
   event_server_ = std::make_unique<net::EventServer<std::shared_ptr<PClient>>>(num);
 
   event_server_->SetRwSeparation(true);
+  event_server_->SetCpuSteering(g_config.reuseport_cpu_steering.load());
+  std::vector<int> io_cpus;
+  pstd::ParseCpuList(g_config.io_threads_cpu_list.ToString(), &io_cpus);
+  event_server_->SetCpuList(std::move(io_cpus));
+  event_server_->SetBusyPoll(g_config.io_busy_poll_us.load());
 
   net::SocketAddr addr(g_config.ip.ToString(), g_config.port.load());
   INFO("Add listen addr:{}, port:{}", g_config.ip.ToString(), g_config.port.load());
   event_server_->AddListenAddr(addr);
 
+  if (!g_config.unix_socket.empty()) {
+    auto perm = g_config.unix_socket_perm.ToString();
+    std::vector<uid_t> uids;
+    std::vector<std::string> items;
+    pstd::StringSplit(g_config.unix_socket_allowed_uids.ToString(), ',', items);
+    for (const auto& item : items) {
+      int64_t uid = 0;
+      if (pstd::String2int(pstd::StringTrim(item), &uid) != 0) {
+        uids.push_back(static_cast<uid_t>(uid));
+      }
+    }
+    INFO("Add listen unix socket:{}", g_config.unix_socket.ToString());
+    event_server_->AddUnixListen(g_config.unix_socket.ToString(),
+                                 perm.empty() ? 0 : static_cast<mode_t>(std::stoul(perm, nullptr, 8)), std::move(uids));
+  }
+
   event_server_->SetOnInit([](std::shared_ptr<PClient>* client) { *client = std::make_shared<PClient>(); });
 
   event_server_->SetOnCreate([](uint64_t connID, std::shared_ptr<PClient>& client, const net::SocketAddr& addr) {
@@ -222,6 +252,16 @@ bool PikiwiDB::Init() {
   timerTask->SetCallback([]() { PREPL.Cron(); });
   event_server_->AddTimerTask(timerTask);
 
+  autoscale_time_ = std::chrono::steady_clock::now();
+  auto autoscaleTimerTask = std::make_shared<net::CommonTimerTask>(1000);
+  autoscaleTimerTask->SetCallback([this]() { AutoscaleCmdThreads(); });
+  event_server_->AddTimerTask(autoscaleTimerTask);
+
+  // the subscribers of closed connections are only dropped here, publishers hold a shared lock
+  auto pubsubTimerTask = std::make_shared<net::CommonTimerTask>(100);
+  pubsubTimerTask->SetCallback([]() { PPubsub::Instance().RecycleClients(); });
+  event_server_->AddTimerTask(pubsubTimerTask);
+
   time(&start_time_s_);
 
   return true;
@@ -247,6 +287,81 @@ void PikiwiDB::Stop() {
   event_server_->StopServer();
 }
 
+pstd::Status PikiwiDB::OnConfigSet(const std::string& key) {
+  if (key == "worker-threads") {
+    auto num = g_config.worker_threads_num.load() + g_config.slave_threads_num.load();
+    if (num > INT8_MAX || !event_server_->Resize(static_cast<int8_t>(num))) {
+      return pstd::Status::Corruption("resize the network threads to " + std::to_string(num) + " failed");
+    }
+    INFO("network threads resized to {}", num);
+  } else if (key == "io-busy-poll-us") {
+    event_server_->SetBusyPoll(g_config.io_busy_poll_us.load());
+  } else if (key == "fast-cmd-threads-num") {
+    auto num = g_config.fast_cmd_threads_num.load();
+    // the autoscaler takes it as its lower bound
+    if (g_config.cmd_threads_autoscale.load() && cmd_threads_.FastThreadNum() > num) {
+      return pstd::Status::OK();
+    }
+    auto s = cmd_threads_.Resize(num);
+    if (!s.ok()) {
+      return s;
+    }
+    INFO("fast command workers resized to {}", num);
+  } else if (key.starts_with("qos-db-")) {
+    ApplyQosLimits();
+  }
+  return pstd::Status::OK();
+}
+
+void PikiwiDB::ApplyQosLimits() {
+  std::vector<pikiwidb::CmdQosLimits> limits(g_config.databases.load());
+  auto apply = [&limits](const pikiwidb::AtomicString& list, int64_t pikiwidb::CmdQosLimits::*field) {
+    std::map<int, int64_t> values;
+    pikiwidb::ParseDbValueList(list.ToString(), &values);
+    for (const auto& [db, value] : values) {
+      if (db < static_cast<int>(limits.size())) {
+        limits[db].*field = value;
+      }
+    }
+  };
+  apply(g_config.qos_db_weights, &pikiwidb::CmdQosLimits::weight);
+  apply(g_config.qos_db_ops_limit, &pikiwidb::CmdQosLimits::ops_limit);
+  apply(g_config.qos_db_bytes_limit, &pikiwidb::CmdQosLimits::bytes_limit);
+  apply(g_config.qos_db_max_queued, &pikiwidb::CmdQosLimits::max_queued);
+  cmd_threads_.SetQosLimits(std::move(limits));
+}
+
+void PikiwiDB::AutoscaleCmdThreads() {
+  auto now = std::chrono::steady_clock::now();
+  auto busy = cmd_threads_.BusyMicros();
+  auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(now - autoscale_time_).count();
+  auto busy_delta = busy - autoscale_busy_us_;
+  autoscale_time_ = now;
+  autoscale_busy_us_ = busy;
+  if (!g_config.cmd_threads_autoscale.load() || elapsed <= 0) {
+    return;
+  }
+
+  int threads = cmd_threads_.FastThreadNum();
+  int min_threads = g_config.fast_cmd_threads_num.load();
+  int max_threads = std::max(g_config.cmd_threads_autoscale_max.load(), min_threads);
+  double util = static_cast<double>(busy_delta) / static_cast<double>(elapsed * threads);
+  auto queued = cmd_threads_.FastQueueSize();
+
+  int target = threads;
+  if (util > 0.85 || queued > 4 * static_cast<size_t>(threads)) {
+    target = std::min(threads + 1, max_threads);
+  } else if (util < 0.3 && queued == 0) {
+    target = std::max(threads - 1, min_threads);
+  }
+  // also brings the pool back into the bounds after they were changed
+  target = std::clamp(target, min_threads, max_threads);
+  if (target != threads && cmd_threads_.Resize(target).ok()) {
+    INFO("fast command workers autoscaled from {} to {}, busy {:.0f}%, {} queued", threads, target, util * 100,
+         queued);
+  }
+}
+
 void PikiwiDB::TCPConnect(
     const net::SocketAddr& addr,
     const std::function<void(uint64_t, std::shared_ptr<pikiwidb::PClient>&, const net::SocketAddr&)>& onConnect,
@@ -8,6 +8,8 @@
   the PikiwiDB server.
  */
 
+#include <chrono>
+
 #include "cmd_table_manager.h"
 #include "cmd_thread_pool.h"
 #include "common.h"
@@ -43,7 +45,9 @@ class PikiwiDB final {
   //  pikiwidb::CmdTableManager& GetCmdTableManager();
   uint32_t GetCmdID() { return ++cmd_id_; };
 
-  void SubmitFast(const std::shared_ptr<pikiwidb::CmdThreadPoolTask>& runner) { cmd_threads_.SubmitFast(runner); }
+  bool SubmitFast(const std::shared_ptr<pikiwidb::CmdThreadPoolTask>& runner, bool admit = true) {
+    return cmd_threads_.SubmitFast(runner, admit);
+  }
   void SubmitSlow(const std::shared_ptr<pikiwidb::CmdThreadPoolTask>& runner) { cmd_threads_.SubmitSlow(runner); }
 
   void PushWriteTask(const std::shared_ptr<pikiwidb::PClient>& client) {
@@ -57,10 +61,22 @@ class PikiwiDB final {
     event_server_->SendPacket(client, std::move(msg));
   }
 
+  // Fan out one formatted message to many clients without copying it per client
+  inline void SendPacket2Clients(const std::vector<std::shared_ptr<pikiwidb::PClient>>& clients,
+                                 const std::shared_ptr<const std::string>& msg) {
+    event_server_->SendPacket(clients, msg);
+  }
+
   inline void CloseConnection(const std::shared_ptr<pikiwidb::PClient>& client) {
     event_server_->CloseConnection(client);
   }
 
+  // Run the callback on the I/O thread of the client at expire (ms, net::TimingWheel::NowMs)
+  inline void AddClientTimer(const std::shared_ptr<pikiwidb::PClient>& client, int64_t expire,
+                             net::TimingWheel::Callback callback) {
+    event_server_->AddConnTimer(client, expire, std::move(callback));
+  }
+
   void TCPConnect(
       const net::SocketAddr& addr,
       const std::function<void(uint64_t, std::shared_ptr<pikiwidb::PClient>&, const net::SocketAddr&)>& onConnect,
@@ -68,6 +84,18 @@ class PikiwiDB final {
 
   time_t Start_time_s() { return start_time_s_; }
 
+  net::PollStats GetPollStats() { return event_server_->GetPollStats(); }
+
+  std::vector<pikiwidb::CmdQosStats> GetQosStats() { return cmd_threads_.QosStats(); }
+
+  bool EnterWriteThrottle() { return cmd_threads_.EnterWriteThrottle(); }
+  void LeaveWriteThrottle() { cmd_threads_.LeaveWriteThrottle(); }
+  int ThrottledWorkers() const { return cmd_threads_.ThrottledWorkers(); }
+  uint64_t ThrottleOverflows() const { return cmd_threads_.ThrottleOverflows(); }
+
+  // Apply a configuration item changed by CONFIG SET to the running server, key is lower case
+  pstd::Status OnConfigSet(const std::string& key);
+
  public:
   PString cfg_file_;
   uint16_t port_{0};
@@ -84,6 +112,14 @@ class PikiwiDB final {
   std::unique_ptr<net::EventServer<std::shared_ptr<pikiwidb::PClient>>> event_server_;
   uint32_t cmd_id_ = 0;
 
+  // Hands the qos-db-* lists to the command thread pool
+  void ApplyQosLimits();
+
+  // Grow or shrink the fast command workers by their busy time, runs once a second
+  void AutoscaleCmdThreads();
+  int64_t autoscale_busy_us_ = 0;
+  std::chrono::steady_clock::time_point autoscale_time_;
+
   time_t start_time_s_ = 0;
 };
 
@@ -0,0 +1,118 @@
+// Copyright (c) 2024-present, OpenAtom Foundation, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+
+#include "pstd_cpu.h"
+
+#ifdef __linux__
+#  include <dirent.h>
+#  include <sched.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#endif
+
+#include <cstring>
+#include <fstream>
+
+#include "pstd_string.h"
+
+namespace pstd {
+
+bool ParseCpuList(const std::string& list, std::vector<int>* cpus) {
+  cpus->clear();
+  std::vector<std::string> items;
+  StringSplit(list, ',', items);
+  for (auto& item : items) {
+    item = StringTrim(item);
+    if (item.empty()) {
+      continue;
+    }
+    auto dash = item.find('-');
+    int64_t first = 0;
+    int64_t last = 0;
+    if (dash == std::string::npos) {
+      if (String2int(item, &first) == 0) {
+        return false;
+      }
+      last = first;
+    } else if (String2int(item.substr(0, dash), &first) == 0 || String2int(item.substr(dash + 1), &last) == 0) {
+      return false;
+    }
+    if (first < 0 || last < first || last >= 1024) {
+      return false;
+    }
+    for (auto cpu = first; cpu <= last; ++cpu) {
+      cpus->push_back(static_cast<int>(cpu));
+    }
+  }
+  return true;
+}
+
+#ifdef __linux__
+static bool BindTid(pid_t tid, const std::vector<int>& cpus) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (auto cpu : cpus) {
+    CPU_SET(cpu, &set);
+  }
+  return sched_setaffinity(tid, sizeof(set), &set) == 0;
+}
+#endif
+
+bool BindThreadToCpus(const std::vector<int>& cpus) {
+  if (cpus.empty()) {
+    return true;
+  }
+#ifdef __linux__
+  return BindTid(0, cpus);
+#else
+  return false;
+#endif
+}
+
+int BindThreadsByName(const std::string& prefix, const std::vector<int>& cpus) {
+  int bound = 0;
+  if (cpus.empty()) {
+    return bound;
+  }
+#ifdef __linux__
+  DIR* dir = opendir("/proc/self/task");
+  if (dir == nullptr) {
+    return bound;
+  }
+  while (auto entry = readdir(dir)) {
+    int64_t tid = 0;
+    if (String2int(entry->d_name, strlen(entry->d_name), &tid) == 0) {
+      continue;
+    }
+    std::ifstream comm(std::string("/proc/self/task/") + entry->d_name + "/comm");
+    std::string name;
+    if (std::getline(comm, name) && name.compare(0, prefix.size(), prefix) == 0 &&
+        BindTid(static_cast<pid_t>(tid), cpus)) {
+      bound++;
+    }
+  }
+  closedir(dir);
+#endif
+  return bound;
+}
+
+int CountThreads() {
+#ifdef __linux__
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.compare(0, 8, "Threads:") == 0) {
+      int64_t threads = 0;
+      if (String2int(StringTrim(line.substr(8), " \t"), &threads) != 0) {
+        return static_cast<int>(threads);
+      }
+      break;
+    }
+  }
+#endif
+  return 0;
+}
+
+}  // namespace pstd
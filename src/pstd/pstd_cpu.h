@@ -0,0 +1,31 @@
+// Copyright (c) 2024-present, OpenAtom Foundation, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace pstd {
+
+// Parses a CPU list in the format of taskset / cpuset, e.g. "0-3,8,10-11".
+// An empty list is valid and gives no CPU.
+bool ParseCpuList(const std::string& list, std::vector<int>* cpus);
+
+// Pins the calling thread to the CPUs. Memory is allocated on the node of
+// the CPU that touches it first, so a thread pinned before it allocates its
+// buffers also gets them from the local node. Does nothing for an empty list.
+bool BindThreadToCpus(const std::vector<int>& cpus);
+
+// Pins every thread of the process whose name starts with prefix, for the
+// threads created by libraries, e.g. the "rocksdb:" background threads.
+// Returns how many threads were pinned.
+int BindThreadsByName(const std::string& prefix, const std::vector<int>& cpus);
+
+// The number of threads of the process, 0 when it is unknown. Cheap enough
+// to poll for the threads a library starts later.
+int CountThreads();
+
+}  // namespace pstd
@@ -0,0 +1,60 @@
+// Copyright (c) 2024-present, OpenAtom Foundation, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+
+#include "pstd/pstd_cpu.h"
+#include <gtest/gtest.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+class CpuTest : public ::testing::Test {};
+
+TEST(CpuTest, ParseCpuList) {
+  std::vector<int> cpus;
+  ASSERT_TRUE(pstd::ParseCpuList("0-3,8, 10-11", &cpus));
+  ASSERT_EQ(cpus, std::vector<int>({0, 1, 2, 3, 8, 10, 11}));
+
+  ASSERT_TRUE(pstd::ParseCpuList("", &cpus));
+  ASSERT_TRUE(cpus.empty());
+
+  ASSERT_TRUE(pstd::ParseCpuList("5", &cpus));
+  ASSERT_EQ(cpus, std::vector<int>({5}));
+}
+
+TEST(CpuTest, ParseCpuListInvalid) {
+  std::vector<int> cpus;
+  ASSERT_FALSE(pstd::ParseCpuList("a", &cpus));
+  ASSERT_FALSE(pstd::ParseCpuList("3-1", &cpus));
+  ASSERT_FALSE(pstd::ParseCpuList("-1", &cpus));
+  ASSERT_FALSE(pstd::ParseCpuList("0-", &cpus));
+}
+
+TEST(CpuTest, BindThreadToCpus) {
+  ASSERT_TRUE(pstd::BindThreadToCpus({}));
+  ASSERT_EQ(pstd::BindThreadsByName("no-such-thread", {0}), 0);
+}
+
+#ifdef __linux__
+TEST(CpuTest, CountThreads) {
+  int before = pstd::CountThreads();
+  ASSERT_GT(before, 0);
+
+  std::mutex mutex;
+  std::condition_variable cond;
+  bool done = false;
+  std::thread thread([&] {
+    std::unique_lock lock(mutex);
+    cond.wait(lock, [&] { return done; });
+  });
+  ASSERT_EQ(pstd::CountThreads(), before + 1);
+  {
+    std::lock_guard lock(mutex);
+    done = true;
+  }
+  cond.notify_one();
+  thread.join();
+}
+#endif
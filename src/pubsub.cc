@@ -11,6 +11,7 @@
 
 #include "client.h"
 #include "log.h"
+#include "pikiwidb.h"
 #include "pubsub.h"
 
 namespace pikiwidb {
@@ -19,16 +20,34 @@ PPubsub& PPubsub::Instance() {
   return ps;
 }
 
-size_t PPubsub::Subscribe(PClient* client, const PString& channel) {
-  if (client && client->Subscribe(channel)) {
-    auto it(channels_.find(channel));
-    if (it == channels_.end()) {
-      it = channels_.insert(ChannelClients::value_type(channel, Clients())).first;
-    }
+PPubsub::ChannelShard& PPubsub::shardOf(const PString& channel) {
+  return channelShards_[std::hash<PString>{}(channel) % kChannelShardNum];
+}
+
+const PPubsub::ChannelShard& PPubsub::shardOf(const PString& channel) const {
+  return channelShards_[std::hash<PString>{}(channel) % kChannelShardNum];
+}
 
-    assert(it != channels_.end());
+PString PPubsub::patternPrefix(const PString& pattern) {
+  // FNM_NOESCAPE is used when matching, so a backslash is an ordinary character
+  return pattern.substr(0, std::min(pattern.find_first_of("*?["), pattern.size()));
+}
 
-    bool succ = it->second.insert(std::static_pointer_cast<PClient>(client->shared_from_this())).second;
+void PPubsub::collectClients(const Clients& clients, std::vector<std::shared_ptr<PClient> >& res) {
+  res.reserve(res.size() + clients.size());
+  for (const auto& weak : clients) {
+    // expired clients are left to RecycleClients, publishers only hold a shared lock
+    if (auto cli = weak.lock()) {
+      res.push_back(std::move(cli));
+    }
+  }
+}
+
+size_t PPubsub::Subscribe(PClient* client, const PString& channel) {
+  if (client && client->Subscribe(channel)) {
+    auto& shard = shardOf(channel);
+    std::unique_lock lock(shard.mutex);
+    bool succ = shard.channels[channel].insert(std::static_pointer_cast<PClient>(client->shared_from_this())).second;
     assert(succ);
     return 1;
   }
@@ -38,8 +57,10 @@ size_t PPubsub::Subscribe(PClient* client, const PString& channel) {
 
 std::size_t PPubsub::UnSubscribe(PClient* client, const PString& channel) {
   if (client && client->UnSubscribe(channel)) {
-    auto it(channels_.find(channel));
-    assert(it != channels_.end());
+    auto& shard = shardOf(channel);
+    std::unique_lock lock(shard.mutex);
+    auto it(shard.channels.find(channel));
+    assert(it != shard.channels.end());
 
     Clients& clientSet = it->second;
 
@@ -47,7 +68,7 @@ std::size_t PPubsub::UnSubscribe(PClient* client, const PString& channel) {
     assert(n == 1);
 
     if (clientSet.empty()) {
-      channels_.erase(it);
+      shard.channels.erase(it);
     }
 
     return client->ChannelCount();
@@ -62,7 +83,8 @@ std::size_t PPubsub::UnSubscribeAll(PClient* client) {
   }
 
   std::size_t n = 0;
-  const auto& channels = client->GetChannels();
+  // copy it, UnSubscribe erases from the client's channel set
+  const auto channels = client->GetChannels();
   for (const auto& channel : channels) {
     n += UnSubscribe(client, channel);
   }
@@ -72,9 +94,11 @@ std::size_t PPubsub::UnSubscribeAll(PClient* client) {
 
 size_t PPubsub::PSubscribe(PClient* client, const PString& channel) {
   if (client && client->PSubscribe(channel)) {
+    std::unique_lock lock(patternMutex_);
     auto it(patternChannels_.find(channel));
     if (it == patternChannels_.end()) {
       it = patternChannels_.insert(ChannelClients::value_type(channel, Clients())).first;
+      patternPrefixes_[patternPrefix(channel)].insert(channel);
     }
 
     assert(it != patternChannels_.end());
@@ -89,6 +113,7 @@ size_t PPubsub::PSubscribe(PClient* client, const PString& channel) {
 
 std::size_t PPubsub::PUnSubscribe(PClient* client, const PString& channel) {
   if (client && client->PUnSubscribe(channel)) {
+    std::unique_lock lock(patternMutex_);
     auto it(patternChannels_.find(channel));
     assert(it != patternChannels_.end());
 
@@ -99,6 +124,13 @@ std::size_t PPubsub::PUnSubscribe(PClient* client, const PString& channel) {
 
     if (clientSet.empty()) {
       patternChannels_.erase(it);
+
+      auto prefix = patternPrefixes_.find(patternPrefix(channel));
+      assert(prefix != patternPrefixes_.end());
+      prefix->second.erase(channel);
+      if (prefix->second.empty()) {
+        patternPrefixes_.erase(prefix);
+      }
     }
 
     return client->PatternChannelCount();
@@ -113,7 +145,7 @@ std::size_t PPubsub::PUnSubscribeAll(PClient* client) {
   }
 
   std::size_t n = 0;
-  const auto& channels = client->GetPatternChannels();
+  const auto channels = client->GetPatternChannels();
   for (const auto& channel : channels) {
     n += PUnSubscribe(client, channel);
   }
@@ -121,68 +153,91 @@ std::size_t PPubsub::PUnSubscribeAll(PClient* client) {
   return n;
 }
 
+// The message is formatted once per channel (and once per matched pattern),
+// then the same buffer is handed to the I/O threads of all the receivers.
 std::size_t PPubsub::PublishMsg(const PString& channel, const PString& msg) {
   std::size_t n = 0;
+  std::vector<std::shared_ptr<PClient> > receivers;
+
+  {
+    const auto& shard = shardOf(channel);
+    std::shared_lock lock(shard.mutex);
+    auto it(shard.channels.find(channel));
+    if (it != shard.channels.end()) {
+      collectClients(it->second, receivers);
+    }
+  }
 
-  auto it(channels_.find(channel));
-  if (it != channels_.end()) {
-    Clients& clientSet = it->second;
-    for (auto itCli(clientSet.begin()); itCli != clientSet.end();) {
-      auto cli = itCli->lock();
-      if (!cli) {
-        clientSet.erase(itCli++);
-      } else {
-        INFO("Publish msg:{} to {}:{}", msg, cli->PeerIP(), cli->PeerPort());
+  if (!receivers.empty()) {
+    UnboundedBuffer reply;
+    PreFormatMultiBulk(3, &reply);
+    FormatBulk("message", 7, &reply);
+    FormatBulk(channel, &reply);
+    FormatBulk(msg, &reply);
+    g_pikiwidb->SendPacket2Clients(receivers, std::make_shared<const std::string>(reply.ToString()));
+    n += receivers.size();
+  }
 
-        UnboundedBuffer reply;
-        PreFormatMultiBulk(3, &reply);
-        FormatBulk("message", 7, &reply);
-        FormatBulk(channel, &reply);
-        FormatBulk(msg, &reply);
-        cli->SendPacket(reply);
+  std::shared_lock lock(patternMutex_);
+  if (patternPrefixes_.empty()) {
+    return n;
+  }
 
-        ++itCli;
-        ++n;
-      }
+  std::string_view name(channel);
+  for (std::size_t len = 0; len <= name.size(); ++len) {
+    auto prefix = patternPrefixes_.find(name.substr(0, len));
+    if (prefix == patternPrefixes_.end()) {
+      continue;
     }
-  }
 
-  // TODO refactor
-  for (auto& pattern : patternChannels_) {
-    if (fnmatch(pattern.first.c_str(), channel.c_str(), FNM_NOESCAPE) == 0) {
-      INFO("{} match {}", channel, pattern.first);
-      Clients& clientSet = pattern.second;
-      for (auto itCli(clientSet.begin()); itCli != clientSet.end();) {
-        auto cli = itCli->lock();
-        if (!cli) {
-          clientSet.erase(itCli++);
-        } else {
-          INFO("Publish msg:{} to {}:{}", msg, cli->PeerIP(), cli->PeerPort());
-
-          UnboundedBuffer reply;
-          PreFormatMultiBulk(4, &reply);
-          FormatBulk("pmessage", 8, &reply);
-          FormatBulk(pattern.first, &reply);
-          FormatBulk(channel, &reply);
-          FormatBulk(msg, &reply);
-          cli->SendPacket(reply);
-
-          ++itCli;
-          ++n;
-        }
+    for (const auto& pattern : prefix->second) {
+      if (fnmatch(pattern.c_str(), channel.c_str(), FNM_NOESCAPE) != 0) {
+        continue;
       }
+
+      auto it(patternChannels_.find(pattern));
+      assert(it != patternChannels_.end());
+      receivers.clear();
+      collectClients(it->second, receivers);
+      if (receivers.empty()) {
+        continue;
+      }
+
+      UnboundedBuffer reply;
+      PreFormatMultiBulk(4, &reply);
+      FormatBulk("pmessage", 8, &reply);
+      FormatBulk(pattern, &reply);
+      FormatBulk(channel, &reply);
+      FormatBulk(msg, &reply);
+      g_pikiwidb->SendPacket2Clients(receivers, std::make_shared<const std::string>(reply.ToString()));
+      n += receivers.size();
     }
   }
 
   return n;
 }
 
-void PPubsub::RecycleClients(PString& startChannel, PString& startPattern) {
-  recycleClients(channels_, startChannel);
-  recycleClients(patternChannels_, startPattern);
+void PPubsub::RecycleClients() {
+  for (auto& shard : channelShards_) {
+    std::unique_lock lock(shard.mutex);
+    recycleClients(shard.channels, shard.recycleStart);
+  }
+
+  std::unique_lock lock(patternMutex_);
+  std::vector<PString> erased;
+  recycleClients(patternChannels_, startPattern_, &erased);
+  for (const auto& pattern : erased) {
+    auto prefix = patternPrefixes_.find(patternPrefix(pattern));
+    if (prefix != patternPrefixes_.end()) {
+      prefix->second.erase(pattern);
+      if (prefix->second.empty()) {
+        patternPrefixes_.erase(prefix);
+      }
+    }
+  }
 }
 
-void PPubsub::recycleClients(ChannelClients& channels, PString& start) {
+void PPubsub::recycleClients(ChannelClients& channels, PString& start, std::vector<PString>* erased) {
   auto it(start.empty() ? channels.begin() : channels.find(start));
   if (it == channels.end()) {
     it = channels.begin();
@@ -201,7 +256,10 @@ void PPubsub::recycleClients(ChannelClients& channels, PString& start) {
     }
 
     if (cls.empty()) {
-      INFO("erase channel {}", it->first);
+      DEBUG("erase channel {}", it->first);
+      if (erased) {
+        erased->push_back(it->first);
+      }
       channels.erase(it++);
     } else {
       ++it;
@@ -215,27 +273,25 @@ void PPubsub::recycleClients(ChannelClients& channels, PString& start) {
   }
 }
 
-void PPubsub::InitPubsubTimer() {
-  //  auto loop = EventLoop::Self();
-  //  loop->ScheduleRepeatedly(
-  //      100, [&](std::string& channel, std::string& pattern) { PPubsub::Instance().RecycleClients(channel, pattern);
-  //      }, std::ref(startChannel_), std::ref(startPattern_));
-}
-
 void PPubsub::PubsubChannels(std::vector<PString>& res, const char* pattern) const {
   res.clear();
 
-  for (const auto& elem : channels_) {
-    if (!pattern || fnmatch(pattern, elem.first.c_str(), FNM_NOESCAPE) == 0) {
-      res.push_back(elem.first);
+  for (const auto& shard : channelShards_) {
+    std::shared_lock lock(shard.mutex);
+    for (const auto& elem : shard.channels) {
+      if (!pattern || fnmatch(pattern, elem.first.c_str(), FNM_NOESCAPE) == 0) {
+        res.push_back(elem.first);
+      }
     }
   }
 }
 
 size_t PPubsub::PubsubNumsub(const PString& channel) const {
-  auto it = channels_.find(channel);
+  const auto& shard = shardOf(channel);
+  std::shared_lock lock(shard.mutex);
+  auto it = shard.channels.find(channel);
 
-  if (it != channels_.end()) {
+  if (it != shard.channels.end()) {
     return it->second.size();
   }
 
@@ -245,6 +301,7 @@ size_t PPubsub::PubsubNumsub(const PString& channel) const {
 size_t PPubsub::PubsubNumpat() const {
   std::size_t n = 0;
 
+  std::shared_lock lock(patternMutex_);
   for (const auto& elem : patternChannels_) {
     n += elem.second.size();
   }
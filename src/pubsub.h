@@ -10,9 +10,11 @@
 
 #pragma once
 
+#include <array>
 #include <map>
 #include <memory>
 #include <set>
+#include <shared_mutex>
 #include <vector>
 
 #include "common.h"
@@ -41,8 +43,9 @@ class PPubsub {
   std::size_t PubsubNumsub(const PString& channel) const;
   std::size_t PubsubNumpat() const;
 
-  void InitPubsubTimer();
-  void RecycleClients(PString& startChannel, PString& startPattern);
+  // Drops up to 20 expired subscribers per shard and the channels left empty,
+  // resuming where the last call stopped. Runs on a timer.
+  void RecycleClients();
 
  private:
   PPubsub() = default;
@@ -50,12 +53,32 @@ class PPubsub {
   using Clients = std::set<std::weak_ptr<PClient>, std::owner_less<std::weak_ptr<PClient> > >;
   using ChannelClients = std::map<PString, Clients>;
 
-  ChannelClients channels_;
-  ChannelClients patternChannels_;
+  // Channels are sharded by name, so publishers of different channels
+  // don't contend on the same lock.
+  static constexpr std::size_t kChannelShardNum = 16;
+
+  struct ChannelShard {
+    mutable std::shared_mutex mutex;
+    ChannelClients channels;
+    PString recycleStart;
+  };
+
+  ChannelShard& shardOf(const PString& channel);
+  const ChannelShard& shardOf(const PString& channel) const;
 
-  PString startChannel_;
+  std::array<ChannelShard, kChannelShardNum> channelShards_;
+
+  // Patterns are also indexed by their literal prefix (the part before the
+  // first glob character), so a publish only runs fnmatch against the
+  // patterns whose prefix is a prefix of the channel.
+  mutable std::shared_mutex patternMutex_;
+  ChannelClients patternChannels_;
+  std::map<PString, std::set<PString>, std::less<> > patternPrefixes_;
   PString startPattern_;
-  static void recycleClients(ChannelClients& channels, PString& start);
+
+  static PString patternPrefix(const PString& pattern);
+  static void collectClients(const Clients& clients, std::vector<std::shared_ptr<PClient> >& res);
+  static void recycleClients(ChannelClients& channels, PString& start, std::vector<PString>* erased = nullptr);
 };
 
 }  // namespace pikiwidb
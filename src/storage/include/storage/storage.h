@@ -7,11 +7,13 @@
 #define INCLUDE_STORAGE_STORAGE_H_
 
 #include <unistd.h>
+#include <atomic>
 #include <cstdint>
 #include <functional>
 #include <future>
 #include <limits>
 #include <map>
+#include <mutex>
 #include <queue>
 #include <string>
 #include <utility>
@@ -28,12 +30,18 @@
 #include "pstd/env.h"
 #include "pstd/pstd_mutex.h"
 #include "src/base_data_value_format.h"
+#include "src/iterator_pool.h"
+#include "src/write_throttle.h"
 #include "storage/slot_indexer.h"
 
 namespace pikiwidb {
 class Binlog;
 }
 
+namespace rocksdb {
+class BackupEngine;
+}
+
 namespace storage {
 
 inline constexpr double ZSET_SCORE_MAX = std::numeric_limits<double>::max();
@@ -65,6 +73,28 @@ class LRUCache;
 using AppendLogFunction = std::function<void(const pikiwidb::Binlog&, std::promise<Status>&&)>;
 using DoSnapshotFunction = std::function<void(LogIndex, bool)>;
 
+// the stages a RocksDB instance goes through in Storage::Open
+enum class OpenStage { kPending = 0, kOpening, kLoadingLogIndex, kOpened, kFailed };
+using OpenProgressFunction = std::function<void(size_t, OpenStage)>;
+
+// A backup keeps a BackupEngine per RocksDB instance, so an SST already in an
+// older backup of the instance is not copied again
+struct BackupOptions {
+  uint32_t keep = 7;                              // the backups kept per instance, the older are purged
+  uint64_t rate_limit = 0;                        // bytes per second per instance, 0 for no limit
+  int threads = 4;                                // the files of an instance copied at once
+  std::atomic<uint64_t>* copied_bytes = nullptr;  // grows by 4MB steps as the files are copied
+};
+
+// Where a conversion to the compact format is, see Storage::ConvertToCompactFormat
+struct ConvertCursor {
+  size_t instance = 0;   // the RocksDB instance it is in
+  std::string next_key;  // the meta key of the instance it goes on from, empty for the first
+  bool done = false;
+  int64_t scanned = 0;    // the keys looked at so far
+  int64_t converted = 0;  // the keys rewritten so far
+};
+
 struct StorageOptions {
   mutable rocksdb::Options options;
   rocksdb::BlockBasedTableOptions table_options;
@@ -75,10 +105,32 @@ struct StorageOptions {
   size_t small_compaction_duration_threshold = 10000;
   size_t db_instance_num = 3;  // default = 3
   int db_id = 0;
+  bool compact_data_format = false;  // new hashes, sets and zsets and the data values take the compact format
+
+  // With cold_path set, the levels of the CFs of cold_data_types that do not
+  // fit in hot_path_size bytes go under cold_path, the last level marked cold.
+  // The data younger than cold_data_seconds is held out of the last level.
+  std::string cold_path;
+  uint64_t hot_path_size = 4ULL << 30;
+  std::vector<DataType> cold_data_types;
+  uint64_t cold_data_seconds = 0;
+  // The compaction style of the CFs of a data type, options.compaction_style
+  // for the types not in it, kStrings for the meta CF. Under FIFO the SSTs
+  // older than fifo_ttl_seconds (0 for never) are dropped whole, without the
+  // compaction filters, so it only fits a DB of strings with shorter TTLs.
+  std::map<DataType, rocksdb::CompactionStyle> compaction_styles;
+  uint64_t fifo_ttl_seconds = 0;
+  // how long an idle iterator is kept for the next read of its thread, 0 turns the pooling off
+  uint64_t iterator_max_idle_ms = 1000;
   AppendLogFunction append_log_function = nullptr;
   DoSnapshotFunction do_snapshot_function = nullptr;
+  OpenProgressFunction open_progress_function = nullptr;
 
   uint32_t raft_timeout_s = std::numeric_limits<uint32_t>::max();
+  // With append_log_function, the Raft log is the only WAL: the writes skip
+  // the RocksDB WAL, the CFs flush together, and the logs past the flushed
+  // log index are replayed after a crash. max_gap bounds the logs to replay.
+  bool raft_log_as_wal = false;
   int64_t max_gap = 1000;
   uint64_t mem_manager_size = 100000000;
   Status ResetOptions(const OptionType& option_type, const std::unordered_map<std::string, std::string>& options_map);
@@ -141,6 +193,75 @@ struct ScoreMember {
   bool operator==(const ScoreMember& sm) const { return (sm.score == score && sm.member == member); }
 };
 
+struct StreamID {
+  StreamID() = default;
+  StreamID(uint64_t t_ms, uint64_t t_seq) : ms(t_ms), seq(t_seq) {}
+  uint64_t ms = 0;
+  uint64_t seq = 0;
+
+  static StreamID Min() { return {0, 0}; }
+  static StreamID Max() { return {UINT64_MAX, UINT64_MAX}; }
+  // the smallest ID greater than this one, false when this is already the maximum
+  bool Incr() {
+    if (seq == UINT64_MAX) {
+      if (ms == UINT64_MAX) {
+        return false;
+      }
+      ms++;
+      seq = 0;
+    } else {
+      seq++;
+    }
+    return true;
+  }
+  // the greatest ID smaller than this one, false when this is already the minimum
+  bool Decr() {
+    if (seq == 0) {
+      if (ms == 0) {
+        return false;
+      }
+      ms--;
+      seq = UINT64_MAX;
+    } else {
+      seq--;
+    }
+    return true;
+  }
+  std::string ToString() const { return std::to_string(ms) + "-" + std::to_string(seq); }
+  bool operator==(const StreamID& id) const { return ms == id.ms && seq == id.seq; }
+  bool operator!=(const StreamID& id) const { return !(*this == id); }
+  bool operator<(const StreamID& id) const { return ms < id.ms || (ms == id.ms && seq < id.seq); }
+  bool operator<=(const StreamID& id) const { return !(id < *this); }
+};
+
+struct StreamEntry {
+  StreamID id;
+  // field, value, field, value... empty when a pending entry was deleted from the stream
+  std::vector<std::string> field_values;
+};
+
+struct StreamTrimArgs {
+  enum Strategy { kNone, kMaxLen, kMinID };
+  Strategy strategy = kNone;
+  uint64_t maxlen = 0;
+  StreamID minid;
+};
+
+struct StreamAddArgs {
+  StreamID id;
+  bool id_given = false;   // the ms part was given, otherwise the ID is generated from the clock
+  bool seq_given = false;  // the seq part was given as well, 'ms-*' generates only the seq
+  bool no_mkstream = false;
+  StreamTrimArgs trim;
+};
+
+struct StreamPendingEntry {
+  StreamID id;
+  std::string consumer;
+  uint64_t delivery_time = 0;  // unix time in milliseconds of the last delivery
+  uint64_t delivery_count = 0;
+};
+
 enum BeforeOrAfter { Before, After };
 
 enum class OptionType {
@@ -183,6 +304,20 @@ class Storage {
 
   Status LoadCheckpointInternal(const std::string& dump_path, const std::string& db_path, int index);
 
+  std::vector<std::future<Status>> CreateBackup(const std::string& backup_path, const BackupOptions& options);
+
+  Status CreateBackupInternal(const std::string& backup_path, const BackupOptions& options, int index);
+
+  // Fails the running backup of the instances, and every backup started later, with
+  // Incomplete. A reopen calls it so it does not wait for the copy to finish.
+  void StopBackup();
+
+  // Restores the latest backup of each instance, while no Storage is open on db_path
+  static std::vector<std::future<Status>> RestoreBackup(const std::string& backup_path, const std::string& db_path,
+                                                        size_t db_instance_num);
+
+  static Status RestoreBackupInternal(const std::string& backup_path, const std::string& db_path, int index);
+
   Status LoadCursorStartKey(const DataType& dtype, int64_t cursor, char* type, std::string* start_key);
 
   Status StoreCursorStartKey(const DataType& dtype, int64_t cursor, char type, const std::string& next_key);
@@ -326,6 +461,11 @@ class Storage {
   // hash or key does not exist.
   Status HGet(const Slice& key, const Slice& field, std::string* value);
 
+  // Returns the value associated with field in each of the hashes stored at
+  // keys, reading the keys of every instance in one batch. Keys that do not
+  // exist or are not hashes get a NotFound status.
+  Status HGetMultiKeys(const std::vector<std::string>& keys, const Slice& field, std::vector<ValueStatus>* vss);
+
   // Sets the specified fields to their respective values in the hash stored at
   // key. This command overwrites any specified fields already existing in the
   // hash. If key does not exist, a new key holding a hash is created.
@@ -957,6 +1097,76 @@ class Storage {
   Status ZScan(const Slice& key, int64_t cursor, const std::string& pattern, int64_t count,
                std::vector<ScoreMember>* score_members, int64_t* next_cursor);
 
+  // Streams Commands
+
+  // Note:
+  // Errors a client should see as they are (an ID that is too small, a
+  // missing consumer group...) are returned as Corruption carrying the
+  // complete Redis error line, e.g. "NOGROUP No such key ...".
+
+  // Appends an entry made of field_values (field, value, field, value...) to
+  // the stream stored at key and returns its ID. The ID is generated from the
+  // clock unless args gives one, which must be greater than the last ID of the
+  // stream. The stream is created if it does not exist, unless no_mkstream is
+  // set, then NotFound is returned. The trim strategy of args is applied in
+  // the same write.
+  Status XAdd(const Slice& key, const std::vector<std::string>& field_values, const StreamAddArgs& args, StreamID* id);
+
+  // Returns the number of entries in the stream stored at key.
+  Status XLen(const Slice& key, uint64_t* len);
+
+  // Returns the greatest ID ever added to the stream stored at key, 0-0 when
+  // the key does not exist.
+  Status XLastID(const Slice& key, StreamID* id);
+
+  // Returns at most count (all when count is negative) entries of the stream
+  // stored at key with an ID between start and end (both inclusive), in ID
+  // order. XRevRange returns them from end down to start.
+  Status XRange(const Slice& key, const StreamID& start, const StreamID& end, int64_t count,
+                std::vector<StreamEntry>* entries);
+  Status XRevRange(const Slice& key, const StreamID& end, const StreamID& start, int64_t count,
+                   std::vector<StreamEntry>* entries);
+
+  // Removes the entries with the given IDs from the stream stored at key and
+  // returns the number of entries actually deleted.
+  Status XDel(const Slice& key, const std::vector<StreamID>& ids, int64_t* ret);
+
+  // Evicts the oldest entries of the stream stored at key until it satisfies
+  // the trim strategy and returns the number of evicted entries. The evicted
+  // head is removed with a single range deletion.
+  Status XTrim(const Slice& key, const StreamTrimArgs& args, int64_t* ret);
+
+  // Creates the consumer group named group on the stream stored at key, the
+  // group starts delivering after id, or after the last ID of the stream when
+  // last_id is set. With mkstream an empty stream is created if needed.
+  Status XGroupCreate(const Slice& key, const Slice& group, const StreamID& id, bool last_id, bool mkstream);
+
+  // Sets the last delivered ID of the consumer group.
+  Status XGroupSetID(const Slice& key, const Slice& group, const StreamID& id, bool last_id);
+
+  // Destroys the consumer group and its pending entries, ret is 1 when the
+  // group existed.
+  Status XGroupDestroy(const Slice& key, const Slice& group, int32_t* ret);
+
+  // Reads the stream stored at key on behalf of consumer in group. With
+  // new_entries, returns at most count entries never delivered to the group
+  // and adds them to the pending entries of the consumer unless noack is set.
+  // Otherwise returns the pending entries of the consumer with an ID greater
+  // than start, an entry deleted from the stream meanwhile has no fields.
+  // A count of 0 or less means no limit, as COUNT 0 does.
+  Status XReadGroup(const Slice& key, const Slice& group, const Slice& consumer, const StreamID& start,
+                    bool new_entries, int64_t count, bool noack, std::vector<StreamEntry>* entries);
+
+  // Removes the IDs from the pending entries of the consumer group and returns
+  // the number of entries acknowledged.
+  Status XAck(const Slice& key, const Slice& group, const std::vector<StreamID>& ids, int64_t* ret);
+
+  // Returns at most count (all when count is negative) pending entries of the
+  // consumer group with an ID between start and end, only those of consumer
+  // when it is not empty.
+  Status XPending(const Slice& key, const Slice& group, const StreamID& start, const StreamID& end, int64_t count,
+                  const Slice& consumer, std::vector<StreamPendingEntry>* pendings);
+
   // Keys Commands
 
   // Note:
@@ -1083,6 +1293,17 @@ class Storage {
   Status AddBGTask(const BGTask& bg_task);
 
   Status Compact(const DataType& type, bool sync = false);
+
+  // Drops every key at once with range deletions and leaves reclaiming the
+  // space to a background compaction, the DB stays open all along.
+  Status FlushDB();
+
+  // Rewrites the hashes, sets and zsets still in the full format in the compact
+  // one, key by key while serving. converted is the number of keys rewritten.
+  Status ConvertToCompactFormat(int64_t* converted);
+  // Goes on from cursor for at most max_keys keys, the caller drives it to done
+  // a step at a time and holds no lock in between
+  Status ConvertToCompactFormat(ConvertCursor* cursor, size_t max_keys);
   Status CompactRange(const DataType& type, const std::string& start, const std::string& end, bool sync = false);
   Status DoCompactRange(const DataType& type, const std::string& start, const std::string& end);
   Status DoCompactSpecificKey(const DataType& type, const std::string& key);
@@ -1103,11 +1324,30 @@ class Storage {
 
   Status SetOptions(const OptionType& option_type, const std::unordered_map<std::string, std::string>& options);
   void GetRocksDBInfo(std::string& info);
+  // The bytes of the SSTs on the hot path, the DB path, and on the cold path
+  void GetTierUsage(uint64_t* hot_bytes, uint64_t* cold_bytes);
+  // Drops the iterators parked for longer than their max idle time
+  void TrimIteratorPools();
+  IteratorPoolStats GetIteratorPoolStats();
+  // Recomputes the write throttle of every instance from the stall metrics of its RocksDB
+  void RefreshWriteThrottle(const WriteThrottleOptions& options);
+  // The microseconds a write to keys should wait, the longest of their instances,
+  // WriteThrottle::kReject when one of them turns it away
+  int64_t AdmitWrite(const std::vector<std::string>& keys);
+  // Whether any instance throttles its writes, a write needs its keys for AdmitWrite only then
+  bool WriteThrottled() const;
+  std::vector<WriteThrottleStats> GetWriteThrottleStats();
   Status OnBinlogWrite(const pikiwidb::Binlog& log, LogIndex log_idx);
 
   LogIndex GetSmallestFlushedLogIndex() const;
 
  private:
+  // Group keys by the instance owning them and call fn once per instance,
+  // with the keys of the instance and their positions in the input.
+  Status ForEachInstanceKeys(
+      const std::vector<std::string>& keys,
+      const std::function<Status(Redis*, const std::vector<std::string>&, const std::vector<size_t>&)>& fn);
+
   std::vector<std::unique_ptr<Redis>> insts_;
   std::unique_ptr<SlotIndexer> slot_indexer_;
   std::atomic<bool> is_opened_ = false;
@@ -1123,6 +1363,10 @@ class Storage {
   std::atomic<int> current_task_type_ = kNone;
   std::atomic<bool> bg_tasks_should_exit_ = false;
 
+  std::mutex backup_engines_mutex_;
+  std::vector<rocksdb::BackupEngine*> backup_engines_;  // of the running backup, guarded by backup_engines_mutex_
+  bool backup_stopped_ = false;                         // guarded by backup_engines_mutex_
+
   // For scan keys in data base
   std::atomic<bool> scan_keynum_exit_ = false;
   size_t db_instance_num_ = 3;
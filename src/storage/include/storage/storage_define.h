@@ -34,6 +34,21 @@ const int kListValueIndexLength = 16;
 const int kTypeLength = 1;
 const int kTimestampLength = 8;
 
+/*
+ * The compact data format of the hash, set and zset members. A version with
+ * kCompactVersionFlag tells the data keys of that version leave out the
+ * reserved bytes, see BaseDataKey. Compact data values end with
+ * kCompactFormatTag instead, see BaseDataValue.
+ */
+const uint64_t kCompactVersionFlag = 1ULL << 40;
+const char kCompactFormatTag = '\x02';
+const int kCompactTimestampLength = 4;
+
+inline bool IsCompactVersion(uint64_t version) { return (version & kCompactVersionFlag) != 0; }
+
+// the version without the format flag, which is what gets compared with the time
+inline uint64_t VersionTime(uint64_t version) { return version & ~kCompactVersionFlag; }
+
 /*
  * kMetaCF is used to store the metadata of all types of
  * data and all information of type string
@@ -45,7 +60,8 @@ enum ColumnFamilyIndex {
   kListsDataCF = 3,
   kZsetsDataCF = 4,
   kZsetsScoreCF = 5,
-  kColumnFamilyNum = 6,
+  kStreamsDataCF = 6,
+  kColumnFamilyNum = 7,
 };
 
 const static char kNeedTransformCharacter = '\u0000';
@@ -17,6 +17,10 @@ using namespace pstd;
  * used for Hash/Set/Zset's member data key. format:
  * | reserve1 | key | version | data | reserve2 |
  * |    8B    |     |    8B   |      |   16B    |
+ *
+ * or the compact format when the version has kCompactVersionFlag:
+ * | tag | key | version | data |
+ * | 1B  |     | varint  |      |
  */
 class BaseDataKey {
  public:
@@ -29,6 +33,9 @@ class BaseDataKey {
   }
 
   Slice EncodeSeekKey() {
+    if (IsCompactVersion(version_)) {
+      return EncodeCompact();
+    }
     size_t meta_size = sizeof(reserve1_) + sizeof(version_);
     size_t usize = key_.size() + data_.size() + kEncodedKeyDelimSize;
     size_t nzero = std::count(key_.data(), key_.data() + key_.size(), kNeedTransformCharacter);
@@ -62,6 +69,9 @@ class BaseDataKey {
   }
 
   Slice Encode() {
+    if (IsCompactVersion(version_)) {
+      return EncodeCompact();
+    }
     size_t meta_size = sizeof(reserve1_) + sizeof(version_) + sizeof(reserve2_);
     size_t usize = key_.size() + data_.size() + kEncodedKeyDelimSize;
     size_t nzero = std::count(key_.data(), key_.data() + key_.size(), kNeedTransformCharacter);
@@ -97,6 +107,30 @@ class BaseDataKey {
   }
 
  private:
+  // nothing follows the data, so the seek key is the key itself
+  Slice EncodeCompact() {
+    size_t nzero = std::count(key_.data(), key_.data() + key_.size(), kNeedTransformCharacter);
+    size_t needed = sizeof(kCompactFormatTag) + key_.size() + nzero + kEncodedKeyDelimSize + VarintLength(version_) +
+                    data_.size();
+    char* dst;
+    if (needed <= sizeof(space_)) {
+      dst = space_;
+    } else {
+      dst = new char[needed];
+      // Need to allocate space, delete previous space
+      if (start_ != space_) {
+        delete[] start_;
+      }
+    }
+
+    start_ = dst;
+    *dst++ = kCompactFormatTag;
+    dst = EncodeUserKey(key_, dst, nzero);
+    dst = EncodeVarint64(dst, version_);
+    memcpy(dst, data_.data(), data_.size());
+    return Slice(start_, needed);
+  }
+
   char* start_ = nullptr;
   char space_[200];
   char reserve1_[8] = {0};
@@ -121,7 +155,12 @@ class ParsedBaseDataKey {
   }
 
   void decode(const char* ptr, const char* end_ptr) {
-    const char* start = ptr;
+    if (ptr != end_ptr && *ptr == kCompactFormatTag) {
+      ptr = DecodeUserKey(ptr + 1, std::distance(ptr + 1, end_ptr), &key_str_);
+      ptr = GetVarint64Ptr(ptr, end_ptr, &version_);
+      data_ = ptr ? Slice(ptr, std::distance(ptr, end_ptr)) : Slice();
+      return;
+    }
     // skip head reserve1_
     ptr += sizeof(reserve1_);
     // skip tail reserve2_
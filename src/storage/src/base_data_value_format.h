@@ -22,6 +22,10 @@ namespace storage {
  * hash/set/zset/list data value format
  * | value | reserve | ctime |
  * |       |   16B   |   8B  |
+ *
+ * or the compact format, told apart by its last byte since ctime < 2^56:
+ * | value | ctime | tag |
+ * |       |  4B   | 1B  |
  */
 class BaseDataValue : public InternalValue {
  public:
@@ -43,6 +47,19 @@ class BaseDataValue : public InternalValue {
     return rocksdb::Slice(start_pos, needed);
   }
 
+  rocksdb::Slice EncodeCompact() {
+    size_t needed = user_value_.size() + kCompactTimestampLength + sizeof(kCompactFormatTag);
+    char* dst = ReAllocIfNeeded(needed);
+    char* start_pos = dst;
+
+    memcpy(dst, user_value_.data(), user_value_.size());
+    dst += user_value_.size();
+    EncodeFixed32(dst, static_cast<uint32_t>(ctime_));
+    dst += kCompactTimestampLength;
+    *dst = kCompactFormatTag;
+    return rocksdb::Slice(start_pos, needed);
+  }
+
  private:
   const size_t kDefaultValueSuffixLength = kSuffixReserveLength + kTimestampLength;
 };
@@ -53,11 +70,7 @@ class ParsedBaseDataValue : public ParsedInternalValue {
   // the implement of user interfaces and may need to modify the
   // original value suffix, so the value_ must point to the string
   explicit ParsedBaseDataValue(std::string* value) : ParsedInternalValue(value) {
-    if (value_->size() >= kBaseDataValueSuffixLength) {
-      user_value_ = rocksdb::Slice(value_->data(), value_->size() - kBaseDataValueSuffixLength);
-      memcpy(reserve_, value_->data() + user_value_.size(), kSuffixReserveLength);
-      ctime_ = DecodeFixed64(value_->data() + user_value_.size() + kSuffixReserveLength);
-    }
+    Decode(value_->data(), value_->size());
   }
 
   // Use this constructor in rocksdb::CompactionFilter::Filter(),
@@ -65,26 +78,30 @@ class ParsedBaseDataValue : public ParsedInternalValue {
   // the rocksdb::Slice, so don't need to modify the original value, value_ can be
   // set to nullptr
   explicit ParsedBaseDataValue(const rocksdb::Slice& value) : ParsedInternalValue(value) {
-    if (value.size() >= kBaseDataValueSuffixLength) {
-      user_value_ = rocksdb::Slice(value.data(), value.size() - kBaseDataValueSuffixLength);
-      memcpy(reserve_, value.data() + user_value_.size(), kSuffixReserveLength);
-      ctime_ = DecodeFixed64(value.data() + user_value_.size() + kSuffixReserveLength);
-    }
+    Decode(value.data(), value.size());
   }
 
   virtual ~ParsedBaseDataValue() = default;
 
+  bool IsCompact() const { return suffix_length_ == kCompactSuffixLength; }
+
+  uint64_t Ctime() const { return ctime_; }
+
   void SetEtimeToValue() override {}
 
   void SetCtimeToValue() override {
-    if (value_) {
-      char* dst = const_cast<char*>(value_->data()) + value_->size() - kTimestampLength;
-      EncodeFixed64(dst, ctime_);
+    if (value_ && suffix_length_ != 0) {
+      char* dst = const_cast<char*>(value_->data()) + user_value_.size();
+      if (IsCompact()) {
+        EncodeFixed32(dst, static_cast<uint32_t>(ctime_));
+      } else {
+        EncodeFixed64(dst + kSuffixReserveLength, ctime_);
+      }
     }
   }
 
   void SetReserveToValue() {
-    if (value_) {
+    if (value_ && suffix_length_ == kBaseDataValueSuffixLength) {
       char* dst = const_cast<char*>(value_->data()) + value_->size() - kBaseDataValueSuffixLength;
       memcpy(dst, reserve_, kSuffixReserveLength);
     }
@@ -92,7 +109,7 @@ class ParsedBaseDataValue : public ParsedInternalValue {
 
   virtual void StripSuffix() override {
     if (value_) {
-      value_->erase(value_->size() - kBaseDataValueSuffixLength, kBaseDataValueSuffixLength);
+      value_->erase(value_->size() - suffix_length_, suffix_length_);
     }
   }
 
@@ -100,7 +117,22 @@ class ParsedBaseDataValue : public ParsedInternalValue {
   virtual void SetVersionToValue() override{};
 
  private:
-  const size_t kBaseDataValueSuffixLength = kSuffixReserveLength + kTimestampLength;
+  void Decode(const char* data, size_t size) {
+    if (size >= kCompactSuffixLength && data[size - 1] == kCompactFormatTag) {
+      suffix_length_ = kCompactSuffixLength;
+      user_value_ = rocksdb::Slice(data, size - suffix_length_);
+      ctime_ = DecodeFixed32(data + user_value_.size());
+    } else if (size >= kBaseDataValueSuffixLength) {
+      suffix_length_ = kBaseDataValueSuffixLength;
+      user_value_ = rocksdb::Slice(data, size - suffix_length_);
+      memcpy(reserve_, data + user_value_.size(), kSuffixReserveLength);
+      ctime_ = DecodeFixed64(data + user_value_.size() + kSuffixReserveLength);
+    }
+  }
+
+  static const size_t kBaseDataValueSuffixLength = kSuffixReserveLength + kTimestampLength;
+  static const size_t kCompactSuffixLength = kCompactTimestampLength + sizeof(kCompactFormatTag);
+  size_t suffix_length_ = 0;
 };
 
 }  //  namespace storage
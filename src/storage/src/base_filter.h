@@ -26,12 +26,16 @@ namespace storage {
 
 class BaseMetaFilter : public rocksdb::CompactionFilter {
  public:
-  BaseMetaFilter() = default;
+  // the time is taken once per compaction, the filter is created for each
+  BaseMetaFilter() {
+    int64_t unix_time = 0;
+    rocksdb::Env::Default()->GetCurrentTime(&unix_time);
+    cur_time_ = static_cast<int32_t>(unix_time);
+  }
+
   bool Filter(int level, const rocksdb::Slice& key, const rocksdb::Slice& value, std::string* new_value,
               bool* value_changed) const override {
-    int64_t unix_time;
-    rocksdb::Env::Default()->GetCurrentTime(&unix_time);
-    auto cur_time = static_cast<int32_t>(unix_time);
+    auto cur_time = cur_time_;
     /*
      * For the filtering of meta information, because the field designs of string
      * and list are different, their filtering policies are written separately.
@@ -58,11 +62,11 @@ class BaseMetaFilter : public rocksdb::CompactionFilter {
             parsed_lists_meta_value.Version());
 
       if (parsed_lists_meta_value.Etime() != 0 && parsed_lists_meta_value.Etime() < cur_time &&
-          parsed_lists_meta_value.Version() < cur_time) {
+          VersionTime(parsed_lists_meta_value.Version()) < cur_time) {
         DEBUG("Drop[Stale & version < cur_time]");
         return true;
       }
-      if (parsed_lists_meta_value.Count() == 0 && parsed_lists_meta_value.Version() < cur_time) {
+      if (parsed_lists_meta_value.Count() == 0 && VersionTime(parsed_lists_meta_value.Version()) < cur_time) {
         DEBUG("Drop[Empty & version < cur_time]");
         return true;
       }
@@ -74,11 +78,11 @@ class BaseMetaFilter : public rocksdb::CompactionFilter {
             parsed_base_meta_value.Count(), parsed_base_meta_value.Etime(), cur_time, parsed_base_meta_value.Version());
 
       if (parsed_base_meta_value.Etime() != 0 && parsed_base_meta_value.Etime() < cur_time &&
-          parsed_base_meta_value.Version() < cur_time) {
+          VersionTime(parsed_base_meta_value.Version()) < cur_time) {
         DEBUG("Drop[Stale & version < cur_time]");
         return true;
       }
-      if (parsed_base_meta_value.Count() == 0 && parsed_base_meta_value.Version() < cur_time) {
+      if (parsed_base_meta_value.Count() == 0 && VersionTime(parsed_base_meta_value.Version()) < cur_time) {
         DEBUG("Drop[Empty & version < cur_time]");
         return true;
       }
@@ -88,6 +92,9 @@ class BaseMetaFilter : public rocksdb::CompactionFilter {
   }
 
   const char* Name() const override { return "BaseMetaFilter"; }
+
+ private:
+  int32_t cur_time_ = 0;
 };
 
 class BaseMetaFilterFactory : public rocksdb::CompactionFilterFactory {
@@ -103,7 +110,9 @@ class BaseMetaFilterFactory : public rocksdb::CompactionFilterFactory {
 class BaseDataFilter : public rocksdb::CompactionFilter {
  public:
   BaseDataFilter(rocksdb::DB* db, std::vector<rocksdb::ColumnFamilyHandle*>* cf_handles_ptr, enum DataType type)
-      : db_(db), cf_handles_ptr_(cf_handles_ptr), type_(type) {}
+      : db_(db), cf_handles_ptr_(cf_handles_ptr), type_(type) {
+    rocksdb::Env::Default()->GetCurrentTime(&cur_time_);
+  }
 
   bool Filter(int level, const Slice& key, const rocksdb::Slice& value, std::string* new_value,
               bool* value_changed) const override {
@@ -117,8 +126,16 @@ class BaseDataFilter : public rocksdb::CompactionFilter {
 
     const char* ptr = key.data();
     int key_size = key.size();
-    ptr = SeekUserkeyDelim(ptr + kPrefixReserveLength, key_size - kPrefixReserveLength);
-    std::string meta_key_enc(key.data(), std::distance(key.data(), ptr));
+    std::string meta_key_enc;
+    if (key_size != 0 && key[0] == kCompactFormatTag) {
+      // the meta key is in the full format
+      ptr = SeekUserkeyDelim(ptr + 1, key_size - 1);
+      meta_key_enc.assign(kPrefixReserveLength, kNeedTransformCharacter);
+      meta_key_enc.append(key.data() + 1, ptr);
+    } else {
+      ptr = SeekUserkeyDelim(ptr + kPrefixReserveLength, key_size - kPrefixReserveLength);
+      meta_key_enc.assign(key.data(), ptr);
+    }
     meta_key_enc.append(kSuffixReserveLength, kNeedTransformCharacter);
 
     if (meta_key_enc != cur_key_) {
@@ -141,7 +158,8 @@ class BaseDataFilter : public rocksdb::CompactionFilter {
         auto type = static_cast<enum DataType>(static_cast<uint8_t>(meta_value[0]));
         if (type != type_) {
           return true;
-        } else if (type == DataType::kHashes || type == DataType::kSets || type == DataType::kZSets) {
+        } else if (type == DataType::kHashes || type == DataType::kSets || type == DataType::kZSets ||
+                   type == DataType::kStreams) {
           ParsedBaseMetaValue parsed_base_meta_value(&meta_value);
           meta_not_found_ = false;
           cur_meta_version_ = parsed_base_meta_value.Version();
@@ -163,14 +181,13 @@ class BaseDataFilter : public rocksdb::CompactionFilter {
       return true;
     }
 
-    int64_t unix_time;
-    rocksdb::Env::Default()->GetCurrentTime(&unix_time);
-    if (cur_meta_etime_ != 0 && cur_meta_etime_ < static_cast<uint64_t>(unix_time)) {
+    if (cur_meta_etime_ != 0 && cur_meta_etime_ < static_cast<uint64_t>(cur_time_)) {
       TRACE("Drop[Timeout]");
       return true;
     }
 
-    if (cur_meta_version_ > parsed_base_data_key.Version()) {
+    // a version of the other format is older too, the times of the versions only grow
+    if (VersionTime(cur_meta_version_) > VersionTime(parsed_base_data_key.Version())) {
       TRACE("Drop[data_key_version < cur_meta_version]");
       return true;
     } else {
@@ -189,6 +206,7 @@ class BaseDataFilter : public rocksdb::CompactionFilter {
   mutable bool meta_not_found_ = false;
   mutable uint64_t cur_meta_version_ = 0;
   mutable uint64_t cur_meta_etime_ = 0;
+  int64_t cur_time_ = 0;
   enum DataType type_ = DataType::kNones;
 };
 
@@ -224,6 +242,9 @@ using ZSetsMetaFilterFactory = BaseMetaFilterFactory;
 using ZSetsDataFilter = BaseDataFilter;
 using ZSetsDataFilterFactory = BaseDataFilterFactory;
 
+using StreamsDataFilter = BaseDataFilter;
+using StreamsDataFilterFactory = BaseDataFilterFactory;
+
 using MetaFilter = BaseMetaFilter;
 using MetaFilterFactory = BaseMetaFilterFactory;
 
@@ -47,14 +47,10 @@ class BaseMetaValue : public InternalValue {
     return rocksdb::Slice(start_, needed);
   }
 
-  uint64_t UpdateVersion() {
-    int64_t unix_time;
-    rocksdb::Env::Default()->GetCurrentTime(&unix_time);
-    if (version_ >= uint64_t(unix_time)) {
-      version_++;
-    } else {
-      version_ = uint64_t(unix_time);
-    }
+  // compact gives the new version kCompactVersionFlag, its data keys get the compact format
+  uint64_t UpdateVersion(bool compact = false) {
+    uint64_t time = NextVersionTime(VersionTime(version_));
+    version_ = compact ? time | kCompactVersionFlag : time;
     return version_;
   }
 };
@@ -134,11 +130,11 @@ class ParsedBaseMetaValue : public ParsedInternalValue {
     }
   }
 
-  uint64_t InitialMetaValue() {
+  uint64_t InitialMetaValue(bool compact = false) {
     this->SetCount(0);
     this->SetEtime(0);
     this->SetCtime(0);
-    return this->UpdateVersion();
+    return this->UpdateVersion(compact);
   }
 
   bool IsValid() override { return !IsStale() && Count() != 0; }
@@ -177,14 +173,9 @@ class ParsedBaseMetaValue : public ParsedInternalValue {
     }
   }
 
-  uint64_t UpdateVersion() {
-    int64_t unix_time;
-    rocksdb::Env::Default()->GetCurrentTime(&unix_time);
-    if (version_ >= static_cast<uint64_t>(unix_time)) {
-      version_++;
-    } else {
-      version_ = static_cast<uint64_t>(unix_time);
-    }
+  uint64_t UpdateVersion(bool compact = false) {
+    uint64_t time = NextVersionTime(VersionTime(version_));
+    version_ = compact ? time | kCompactVersionFlag : time;
     SetVersionToValue();
     return version_;
   }
@@ -20,16 +20,32 @@ namespace storage {
 using Status = rocksdb::Status;
 using Slice = rocksdb::Slice;
 
-enum DataType : uint8_t { kStrings = 0, kHashes = 1, kSets = 2, kLists = 3, kZSets = 4, kNones = 5, kAll = 6 };
+enum DataType : uint8_t {
+  kStrings = 0,
+  kHashes = 1,
+  kSets = 2,
+  kLists = 3,
+  kZSets = 4,
+  kStreams = 5,
+  kNones = 6,
+  kAll = 7
+};
 
-static const char* DataTypeStrings[] = {"string", "hash", "set", "list", "zset", "none", "all"};
+static const char* DataTypeStrings[] = {"string", "hash", "set", "list", "zset", "stream", "none", "all"};
 
-static const char DataTypeTag[] = {'k', 'h', 's', 'l', 'z', 'n', 'a'};
+static const char DataTypeTag[] = {'k', 'h', 's', 'l', 'z', 'x', 'n', 'a'};
 
 const char* DataTypeToString(DataType type);
 
 const char DataTypeToTag(DataType type);
 
+// The time part of the next version of a key whose last version had old_time, 0
+// for a new key. It is past the floor RaiseVersionFloor set.
+uint64_t NextVersionTime(uint64_t old_time);
+
+// Puts the versions handed out from now on past all the versions handed out so far
+void RaiseVersionFloor();
+
 class InternalValue {
  public:
   explicit InternalValue(DataType type, const Slice& user_value) : type_(type), user_value_(user_value) {
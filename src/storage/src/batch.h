@@ -15,6 +15,7 @@
 #include "rocksdb/db.h"
 
 #include "binlog.pb.h"
+#include "src/base_data_value_format.h"
 #include "src/redis.h"
 #include "storage/storage.h"
 #include "storage/storage_define.h"
@@ -27,13 +28,33 @@ class Batch {
 
   virtual void Put(ColumnFamilyIndex cf_idx, const Slice& key, const Slice& val) = 0;
   virtual void Delete(ColumnFamilyIndex cf_idx, const Slice& key) = 0;
+  // Removes the keys in [begin_key, end_key)
+  virtual void DeleteRange(ColumnFamilyIndex cf_idx, const Slice& begin_key, const Slice& end_key) = 0;
   virtual Status Commit() = 0;
   int32_t Count() const { return cnt_; }
 
   static auto CreateBatch(Redis* redis) -> std::unique_ptr<Batch>;
 
  protected:
+  // The data values of a DB in the compact format are put in it here, the
+  // readers take both formats so no other writer has to choose
+  Slice EncodeValue(ColumnFamilyIndex cf_idx, const Slice& value) {
+    if (!compact_ || cf_idx == kMetaCF || value.size() < kSuffixReserveLength + kTimestampLength) {
+      return value;
+    }
+    ParsedBaseDataValue parsed_value(value);
+    if (parsed_value.IsCompact()) {
+      return value;
+    }
+    BaseDataValue compact_value(parsed_value.UserValue());
+    compact_value.setCtime(parsed_value.Ctime());
+    value_buf_ = compact_value.EncodeCompact().ToString();
+    return value_buf_;
+  }
+
   uint32_t cnt_ = 0;
+  bool compact_ = false;
+  std::string value_buf_;
 };
 
 class RocksBatch : public Batch {
@@ -43,13 +64,17 @@ class RocksBatch : public Batch {
       : db_(db), options_(options), handles_(handles) {}
 
   void Put(ColumnFamilyIndex cf_idx, const Slice& key, const Slice& val) override {
-    batch_.Put(handles_[cf_idx], key, val);
+    batch_.Put(handles_[cf_idx], key, EncodeValue(cf_idx, val));
     cnt_++;
   }
   void Delete(ColumnFamilyIndex cf_idx, const Slice& key) override {
     batch_.Delete(handles_[cf_idx], key);
     cnt_++;
   }
+  void DeleteRange(ColumnFamilyIndex cf_idx, const Slice& begin_key, const Slice& end_key) override {
+    batch_.DeleteRange(handles_[cf_idx], begin_key, end_key);
+    cnt_++;
+  }
   Status Commit() override { return db_->Write(options_, &batch_); }
 
  private:
@@ -72,7 +97,7 @@ class BinlogBatch : public Batch {
     entry->set_cf_idx(cf_idx);
     entry->set_op_type(pikiwidb::OperateType::kPut);
     entry->set_key(key.ToString());
-    entry->set_value(value.ToString());
+    entry->set_value(EncodeValue(cf_idx, value).ToString());
     cnt_++;
   }
 
@@ -84,6 +109,15 @@ class BinlogBatch : public Batch {
     cnt_++;
   }
 
+  void DeleteRange(ColumnFamilyIndex cf_idx, const Slice& begin_key, const Slice& end_key) override {
+    auto entry = binlog_.add_entries();
+    entry->set_cf_idx(cf_idx);
+    entry->set_op_type(pikiwidb::OperateType::kDeleteRange);
+    entry->set_key(begin_key.ToString());
+    entry->set_value(end_key.ToString());
+    cnt_++;
+  }
+
   Status Commit() override {
     // FIXME(longfar): We should make sure that in non-RAFT mode, the code doesn't run here
     std::promise<Status> promise;
@@ -103,10 +137,14 @@ class BinlogBatch : public Batch {
 };
 
 inline auto Batch::CreateBatch(Redis* redis) -> std::unique_ptr<Batch> {
+  std::unique_ptr<Batch> batch;
   if (redis->GetAppendLogFunction()) {
-    return std::make_unique<BinlogBatch>(redis->GetAppendLogFunction(), redis->GetIndex(), redis->GetRaftTimeout());
+    batch = std::make_unique<BinlogBatch>(redis->GetAppendLogFunction(), redis->GetIndex(), redis->GetRaftTimeout());
+  } else {
+    batch = std::make_unique<RocksBatch>(redis->GetDB(), redis->GetWriteOptions(), redis->GetColumnFamilyHandles());
   }
-  return std::make_unique<RocksBatch>(redis->GetDB(), redis->GetWriteOptions(), redis->GetColumnFamilyHandles());
+  batch->compact_ = redis->IsCompactFormat();
+  return batch;
 }
 
 }  // namespace storage
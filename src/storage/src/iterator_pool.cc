@@ -0,0 +1,116 @@
+//  Copyright (c) 2024-present, OpenAtom Foundation, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "src/iterator_pool.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace storage {
+
+void IteratorReturner::operator()(rocksdb::Iterator* iter) const {
+  if (pool != nullptr) {
+    pool->Put(list, iter);
+  } else {
+    delete iter;
+  }
+}
+
+size_t IteratorPool::ThreadSlot() {
+  static std::atomic<size_t> next_slot = 0;
+  thread_local size_t slot = next_slot.fetch_add(1, std::memory_order_relaxed) % kSlots;
+  return slot;
+}
+
+PooledIterator IteratorPool::Get(rocksdb::DB* db, rocksdb::ColumnFamilyHandle* handle, ColumnFamilyIndex cf,
+                                 Kind kind, const rocksdb::Snapshot* snapshot) {
+  size_t slot_index = ThreadSlot();
+  size_t list = slot_index * kLists + static_cast<size_t>(cf) * kKindNum + kind;
+  std::vector<Parked> expired;  // deleted outside the lock
+  std::unique_ptr<rocksdb::Iterator> iter;
+
+  auto max_idle = std::chrono::milliseconds(max_idle_ms_.load(std::memory_order_relaxed));
+  if (max_idle.count() > 0) {
+    auto deadline = Clock::now() - max_idle;
+    auto& slot = slots_[slot_index];
+    std::lock_guard lock(slot.mutex);
+    auto& parked = slot.lists[list % kLists];
+    while (!parked.empty()) {
+      auto entry = std::move(parked.back());
+      parked.pop_back();
+      parked_.fetch_sub(1, std::memory_order_relaxed);
+      if (entry.since < deadline) {
+        expired.push_back(std::move(entry));
+        continue;
+      }
+      iter = std::move(entry.iter);
+      break;
+    }
+  }
+  expired_.fetch_add(expired.size(), std::memory_order_relaxed);
+
+  // only a superversion check when nothing was flushed or compacted since
+  if (iter && iter->Refresh(snapshot).ok()) {
+    reused_.fetch_add(1, std::memory_order_relaxed);
+    return PooledIterator(iter.release(), {this, list});
+  }
+  iter.reset();
+
+  rocksdb::ReadOptions options;
+  options.snapshot = snapshot;
+  options.fill_cache = kind != kScan;
+  created_.fetch_add(1, std::memory_order_relaxed);
+  return PooledIterator(db->NewIterator(options, handle), {this, list});
+}
+
+void IteratorPool::Put(size_t list, rocksdb::Iterator* iter) {
+  std::unique_ptr<rocksdb::Iterator> owned(iter);
+  if (max_idle_ms_.load(std::memory_order_relaxed) <= 0 || !iter->status().ok()) {
+    return;
+  }
+  Parked dropped;  // deleted outside the lock
+  auto& slot = slots_[list / kLists];
+  std::lock_guard lock(slot.mutex);
+  auto& parked = slot.lists[list % kLists];
+  if (parked.size() >= kMaxParked) {
+    dropped = std::move(parked.front());
+    parked.erase(parked.begin());
+    parked_.fetch_sub(1, std::memory_order_relaxed);
+    expired_.fetch_add(1, std::memory_order_relaxed);
+  }
+  parked.push_back({std::move(owned), Clock::now()});
+  parked_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void IteratorPool::Drain(Clock::time_point deadline, std::vector<Parked>* out) {
+  for (auto& slot : slots_) {
+    std::lock_guard lock(slot.mutex);
+    for (auto& parked : slot.lists) {
+      // the newest are at the back
+      auto keep = std::find_if(parked.begin(), parked.end(), [&](const Parked& p) { return p.since >= deadline; });
+      std::move(parked.begin(), keep, std::back_inserter(*out));
+      parked_.fetch_sub(keep - parked.begin(), std::memory_order_relaxed);
+      parked.erase(parked.begin(), keep);
+    }
+  }
+}
+
+void IteratorPool::Trim() {
+  std::vector<Parked> expired;
+  Drain(Clock::now() - std::chrono::milliseconds(max_idle_ms_.load(std::memory_order_relaxed)), &expired);
+  expired_.fetch_add(expired.size(), std::memory_order_relaxed);
+}
+
+void IteratorPool::Clear() {
+  std::vector<Parked> all;
+  Drain(Clock::time_point::max(), &all);
+}
+
+IteratorPoolStats IteratorPool::Stats() const {
+  return {created_.load(std::memory_order_relaxed), reused_.load(std::memory_order_relaxed),
+          expired_.load(std::memory_order_relaxed), parked_.load(std::memory_order_relaxed)};
+}
+
+}  // namespace storage
@@ -0,0 +1,99 @@
+//  Copyright (c) 2024-present, OpenAtom Foundation, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "rocksdb/db.h"
+
+#include "pstd/noncopyable.h"
+#include "storage/storage_define.h"
+
+namespace storage {
+
+class IteratorPool;
+
+// Gives the iterator back to its pool, or deletes it when it has none
+struct IteratorReturner {
+  IteratorPool* pool = nullptr;
+  size_t list = 0;
+
+  void operator()(rocksdb::Iterator* iter) const;
+};
+
+using PooledIterator = std::unique_ptr<rocksdb::Iterator, IteratorReturner>;
+
+struct IteratorPoolStats {
+  uint64_t created = 0;
+  uint64_t reused = 0;
+  uint64_t expired = 0;  // dropped after max_idle, or for a full list
+  uint64_t parked = 0;
+};
+
+// Keeps the iterators of a DB between the reads, by thread, CF and kind of
+// read. NewIterator allocates an arena and references a superversion, which
+// HGETALL and every SCAN page paid for; a parked iterator is Refresh()ed to
+// the snapshot of the next read instead. A parked iterator pins the memtables
+// and SSTs of its superversion, so it is dropped once idle for max_idle, by
+// the next read of its thread or by Trim(), and Clear() drops them all.
+class IteratorPool : public pstd::noncopyable {
+ public:
+  enum Kind { kRead = 0, kScan = 1, kKindNum = 2 };  // the kScan iterators do not fill the block cache
+
+  ~IteratorPool() { Clear(); }
+
+  // 0 turns the pooling off
+  void SetMaxIdle(std::chrono::milliseconds max_idle) { max_idle_ms_.store(max_idle.count()); }
+
+  // An iterator over cf reading as of snapshot, the latest data for nullptr
+  PooledIterator Get(rocksdb::DB* db, rocksdb::ColumnFamilyHandle* handle, ColumnFamilyIndex cf, Kind kind,
+                     const rocksdb::Snapshot* snapshot);
+
+  void Put(size_t list, rocksdb::Iterator* iter);
+
+  void Trim();
+
+  void Clear();
+
+  IteratorPoolStats Stats() const;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr size_t kSlots = 32;
+  static constexpr size_t kLists = kColumnFamilyNum * kKindNum;
+  static constexpr size_t kMaxParked = 2;  // per thread and list, a read seldom holds more at once
+
+  struct Parked {
+    std::unique_ptr<rocksdb::Iterator> iter;
+    Clock::time_point since;
+  };
+
+  // the threads past kSlots share the slots, each slot has its own mutex
+  struct Slot {
+    std::mutex mutex;
+    std::array<std::vector<Parked>, kLists> lists;
+  };
+
+  static size_t ThreadSlot();
+
+  // moves out the iterators parked before deadline, all of them for the max time point
+  void Drain(Clock::time_point deadline, std::vector<Parked>* out);
+
+  std::array<Slot, kSlots> slots_;
+  std::atomic<int64_t> max_idle_ms_ = 1000;
+  std::atomic<uint64_t> created_ = 0;
+  std::atomic<uint64_t> reused_ = 0;
+  std::atomic<uint64_t> expired_ = 0;
+  std::atomic<uint64_t> parked_ = 0;
+};
+
+}  // namespace storage
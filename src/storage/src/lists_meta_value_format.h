@@ -51,13 +51,7 @@ class ListsMetaValue : public InternalValue {
   }
 
   uint64_t UpdateVersion() {
-    int64_t unix_time;
-    rocksdb::Env::Default()->GetCurrentTime(&unix_time);
-    if (version_ >= static_cast<uint64_t>(unix_time)) {
-      version_++;
-    } else {
-      version_ = static_cast<uint64_t>(unix_time);
-    }
+    version_ = NextVersionTime(version_);
     return version_;
   }
 
@@ -199,13 +193,7 @@ class ParsedListsMetaValue : public ParsedInternalValue {
   }
 
   uint64_t UpdateVersion() {
-    int64_t unix_time;
-    rocksdb::Env::Default()->GetCurrentTime(&unix_time);
-    if (version_ >= static_cast<uint64_t>(unix_time)) {
-      version_++;
-    } else {
-      version_ = static_cast<uint64_t>(unix_time);
-    }
+    version_ = NextVersionTime(version_);
     SetVersionToValue();
     return version_;
   }
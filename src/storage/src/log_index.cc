@@ -11,6 +11,7 @@
 
 #include <algorithm>
 #include <cinttypes>
+#include <future>
 #include <set>
 
 #include "redis.h"
@@ -18,21 +19,43 @@
 namespace storage {
 
 rocksdb::Status storage::LogIndexOfColumnFamilies::Init(Redis *db) {
-  for (int i = 0; i < cf_.size(); i++) {
-    rocksdb::TablePropertiesCollection collection;
-    auto s = db->GetDB()->GetPropertiesOfAllTables(db->GetColumnFamilyHandles()[i], &collection);
-    if (!s.ok()) {
-      return s;
-    }
-    auto res = LogIndexTablePropertiesCollector::GetLargestLogIndexFromTableCollection(collection);
-    if (res.has_value()) {
-      auto log_index = res->GetAppliedLogIndex();
-      auto sequence_number = res->GetSequenceNumber();
-      cf_[i].applied_index.SetLogIndexSeqnoPair(log_index, sequence_number);
-      cf_[i].flushed_index.SetLogIndexSeqnoPair(log_index, sequence_number);
+  // The properties of every sst file are read, which is slow with many files,
+  // so the column families are scanned concurrently.
+  std::vector<std::future<rocksdb::Status>> results;
+  results.reserve(cf_.size());
+  for (size_t i = 0; i < cf_.size(); i++) {
+    results.push_back(std::async(std::launch::async, [this, db, i] {
+      rocksdb::TablePropertiesCollection collection;
+      auto s = db->GetDB()->GetPropertiesOfAllTables(db->GetColumnFamilyHandles()[i], &collection);
+      if (!s.ok()) {
+        return s;
+      }
+      auto res = LogIndexTablePropertiesCollector::GetLargestLogIndexFromTableCollection(collection);
+      if (res.has_value()) {
+        auto log_index = res->GetAppliedLogIndex();
+        auto sequence_number = res->GetSequenceNumber();
+        cf_[i].applied_index.SetLogIndexSeqnoPair(log_index, sequence_number);
+        cf_[i].flushed_index.SetLogIndexSeqnoPair(log_index, sequence_number);
+      }
+      return rocksdb::Status::OK();
+    }));
+  }
+
+  rocksdb::Status status;
+  for (auto &result : results) {
+    auto s = result.get();
+    if (status.ok() && !s.ok()) {
+      status = s;
     }
   }
-  return Status::OK();
+
+  // The replay starts after the largest log index in the SSTs. With the WAL
+  // the memtables are recovered anyway, without it the CFs are flushed
+  // atomically, so every log up to that index is in the SSTs of all of them.
+  for (const auto &cf : cf_) {
+    SetLastFlushIndex(cf.flushed_index.GetLogIndex(), cf.flushed_index.GetSequenceNumber());
+  }
+  return status;
 }
 
 LogIndexOfColumnFamilies::SmallestIndexRes LogIndexOfColumnFamilies::GetSmallestLogIndex(int flush_cf) const {
@@ -72,8 +95,6 @@ size_t LogIndexOfColumnFamilies::GetPendingFlushGap() const {
   return *std::prev(iter_last) - *iter_first;
 };
 
-std::atomic_int64_t LogIndexAndSequenceCollector::max_gap_ = 1000;
-
 std::optional<LogIndexAndSequencePair> storage::LogIndexTablePropertiesCollector::ReadStatsFromTableProps(
     const std::shared_ptr<const rocksdb::TableProperties> &table_props) {
   const auto &user_properties = table_props->user_collected_properties;
@@ -90,53 +111,128 @@ std::optional<LogIndexAndSequencePair> storage::LogIndexTablePropertiesCollector
   return LogIndexAndSequencePair(applied_log_index, largest_seqno);
 }
 
+LogIndexAndSequenceCollector::LogIndexAndSequenceCollector(uint8_t step_length_bit, uint64_t capacity) {
+  step_length_mask_ = (1 << step_length_bit) - 1;
+  uint64_t size = 2;
+  while (size < capacity) {
+    size <<= 1;
+  }
+  mask_ = size - 1;
+  ring_ = std::make_unique<Sample[]>(size);
+}
+
+bool LogIndexAndSequenceCollector::Read(uint64_t pos, LogIndexAndSequencePair *pair) const {
+  const auto &sample = ring_[pos & mask_];
+  if (sample.pos.load(std::memory_order_acquire) != pos) {
+    return false;
+  }
+  pair->SetAppliedLogIndex(sample.log_index.load(std::memory_order_relaxed));
+  pair->SetSequenceNumber(sample.seqno.load(std::memory_order_relaxed));
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return sample.pos.load(std::memory_order_relaxed) == pos;
+}
+
 LogIndex LogIndexAndSequenceCollector::FindAppliedLogIndex(SequenceNumber seqno) const {
   if (seqno == 0) {  // the seqno will be 0 when executing compaction
     return 0;
   }
-  std::shared_lock gd(mutex_);
-  if (list_.empty() || seqno < list_.front().GetSequenceNumber()) {
-    return 0;
-  }
-  if (seqno >= list_.back().GetSequenceNumber()) {
-    return list_.back().GetAppliedLogIndex();
-  }
-
-  auto it = std::lower_bound(
-      list_.begin(), list_.end(), seqno,
-      [](const LogIndexAndSequencePair &p, SequenceNumber tar) { return p.GetSequenceNumber() <= tar; });
-  if (it->GetSequenceNumber() > seqno) {
-    --it;
+  LogIndexAndSequencePair pair(0, 0);
+  while (true) {
+    // head first, the tail read after it can't be behind it
+    auto head = head_.load(std::memory_order_acquire);
+    auto tail = tail_.load(std::memory_order_acquire);
+    if (head == tail) {
+      return 0;
+    }
+    // A slot only changes after a purge moved the head past it, then the
+    // search starts over from the new head.
+    if (!Read(head, &pair)) {
+      continue;
+    }
+    if (seqno < pair.GetSequenceNumber()) {
+      return 0;
+    }
+    // the last sample whose seqno is not larger than the target
+    auto lo = head;
+    auto found = pair.GetAppliedLogIndex();
+    auto hi = tail;
+    bool torn = false;
+    while (hi - lo > 1) {
+      auto mid = lo + (hi - lo) / 2;
+      if (!Read(mid, &pair)) {
+        torn = true;
+        break;
+      }
+      if (pair.GetSequenceNumber() <= seqno) {
+        lo = mid;
+        found = pair.GetAppliedLogIndex();
+      } else {
+        hi = mid;
+      }
+    }
+    if (!torn) {
+      return found;
+    }
   }
-  assert(it->GetSequenceNumber() <= seqno);
-  return it->GetAppliedLogIndex();
 }
 
 void LogIndexAndSequenceCollector::Update(LogIndex smallest_applied_log_index, SequenceNumber smallest_flush_seqno) {
   // If step length > 1, log index is sampled and sacrifice precision to save memory usage.
   // It means that extra applied log may be applied again on start stage.
-  if ((smallest_applied_log_index & step_length_mask_) == 0) {
-    std::lock_guard gd(mutex_);
-    list_.emplace_back(smallest_applied_log_index, smallest_flush_seqno);
+  if ((smallest_applied_log_index & step_length_mask_) != 0) {
+    return;
+  }
+  auto tail = tail_.load(std::memory_order_relaxed);
+  if (tail - head_.load(std::memory_order_acquire) > mask_) {
+    // The ring is full and IsFlushPending() asks for a flush. Skipping the
+    // sample only makes a later flush record an older log index, so more logs
+    // are replayed on restart, none is lost.
+    return;
   }
+  auto &sample = ring_[tail & mask_];
+  sample.pos.store(kWriting, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  sample.log_index.store(smallest_applied_log_index, std::memory_order_relaxed);
+  sample.seqno.store(smallest_flush_seqno, std::memory_order_relaxed);
+  sample.pos.store(tail, std::memory_order_release);
+  tail_.store(tail + 1, std::memory_order_release);
 }
 
-// TODO(longfar): find the iterator which should be deleted and erase from begin to the iterator
 void LogIndexAndSequenceCollector::Purge(LogIndex smallest_applied_log_index) {
   // The reason that we use smallest applied log index of all column families instead of smallest flushed log index is
   // that the log index corresponding to the largest sequence number in the next flush must be greater than or equal to
   // the smallest applied log index at this moment.
   // So we just need to make sure that there is an element in the queue which is less than or equal to the smallest
   // applied log index to ensure that we can find a correct log index while doing next flush.
-  std::lock_guard gd(mutex_);
-  if (list_.size() < 2) {
-    return;
+  // Flush callbacks of different column families may purge at the same time, the head only moves by CAS.
+  LogIndexAndSequencePair second(0, 0);
+  auto head = head_.load(std::memory_order_acquire);
+  while (tail_.load(std::memory_order_acquire) - head >= 2) {
+    if (!Read(head + 1, &second)) {
+      head = head_.load(std::memory_order_acquire);
+      continue;
+    }
+    if (second.GetAppliedLogIndex() > smallest_applied_log_index) {
+      return;
+    }
+    // on failure head is reloaded and the loop checks again
+    if (head_.compare_exchange_weak(head, head + 1, std::memory_order_acq_rel)) {
+      ++head;
+    }
   }
-  auto second = std::next(list_.begin());
-  while (list_.size() >= 2 && second->GetAppliedLogIndex() <= smallest_applied_log_index) {
-    list_.pop_front();
-    ++second;
+}
+
+std::vector<LogIndexAndSequencePair> LogIndexAndSequenceCollector::GetList() const {
+  std::vector<LogIndexAndSequencePair> list;
+  LogIndexAndSequencePair pair(0, 0);
+  auto head = head_.load(std::memory_order_acquire);
+  auto tail = tail_.load(std::memory_order_acquire);
+  for (auto pos = head; pos < tail; pos++) {
+    if (Read(pos, &pair)) {
+      list.push_back(pair);
+    }
   }
+  return list;
 }
 
 auto LogIndexTablePropertiesCollector::GetLargestLogIndexFromTableCollection(
@@ -191,6 +287,11 @@ void LogIndexAndSequenceCollectorPurger::OnFlushCompleted(rocksdb::DB *db,
   assert(manul_flushing_cf_.load() == smallest_flushed_log_index_cf);
   rocksdb::FlushOptions flush_option;
   flush_option.wait = false;
+  if (db->GetDBOptions().atomic_flush) {
+    // only a flush of all the CFs moves the replay point
+    db->Flush(flush_option, *column_families_);
+    return;
+  }
   db->Flush(flush_option, column_families_->at(smallest_flushed_log_index_cf));
 }
 
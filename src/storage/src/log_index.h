@@ -9,12 +9,13 @@
 
 #include <array>
 #include <atomic>
-#include <deque>
 #include <functional>
 #include <future>
+#include <limits>
+#include <memory>
 #include <optional>
-#include <shared_mutex>
 #include <string_view>
+#include <vector>
 
 #include "fmt/core.h"
 #include "rocksdb/db.h"
@@ -143,40 +144,62 @@ class LogIndexOfColumnFamilies {
   LogIndexSeqnoPair last_flush_index_;
 };
 
+// Samples of (log index, first seqno of its batch) in apply order. The raft
+// apply thread is the only producer, flush callbacks may purge and search
+// concurrently, none of them takes a lock.
 class LogIndexAndSequenceCollector {
  public:
-  explicit LogIndexAndSequenceCollector(uint8_t step_length_bit = 0) { step_length_mask_ = (1 << step_length_bit) - 1; }
+  static constexpr uint64_t kDefaultCapacity = 1 << 12;
+
+  // capacity is rounded up to a power of 2
+  explicit LogIndexAndSequenceCollector(uint8_t step_length_bit = 0, uint64_t capacity = kDefaultCapacity);
 
   // find the index of log which contain seqno or before it
   LogIndex FindAppliedLogIndex(SequenceNumber seqno) const;
 
-  // if there's a new pair, add it to list; otherwise, do nothing
+  // if there's a new pair, add it to list; otherwise, do nothing.
+  // Must only be called from one thread.
   void Update(LogIndex smallest_applied_log_index, SequenceNumber smallest_flush_seqno);
 
   // purge out dated log index after memtable flushed.
   void Purge(LogIndex smallest_applied_log_index);
 
-  // Is manual flushing required?
-  bool IsFlushPending() const { return GetSize() >= max_gap_; }
+  // Is manual flushing required? A full ring drops samples, so it asks for one too.
+  bool IsFlushPending() const {
+    auto size = GetSize();
+    return size >= static_cast<uint64_t>(max_gap_.load(std::memory_order_relaxed)) || size > mask_;
+  }
+
+  void SetMaxGap(int64_t max_gap) { max_gap_.store(max_gap, std::memory_order_relaxed); }
+  int64_t GetMaxGap() const { return max_gap_.load(std::memory_order_relaxed); }
 
-  // for gtest
   uint64_t GetSize() const {
-    std::shared_lock<std::shared_mutex> share_lock;
-    return list_.size();
+    // head first, the tail read after it can't be behind it
+    auto head = head_.load(std::memory_order_acquire);
+    return tail_.load(std::memory_order_acquire) - head;
   }
 
-  std::deque<LogIndexAndSequencePair> &GetList() {
-    std::shared_lock<std::shared_mutex> share_lock;
-    return list_;
-  }
-
- public:
-  static std::atomic_int64_t max_gap_;
+  // a copy of the samples, for gtest
+  std::vector<LogIndexAndSequencePair> GetList() const;
 
  private:
+  // pos is the ring position the slot holds, kWriting while the producer fills it
+  struct Sample {
+    std::atomic<uint64_t> pos{kWriting};
+    std::atomic<LogIndex> log_index{0};
+    std::atomic<SequenceNumber> seqno{0};
+  };
+  static constexpr uint64_t kWriting = std::numeric_limits<uint64_t>::max();
+
+  // false if the slot was purged and reused while being read
+  bool Read(uint64_t pos, LogIndexAndSequencePair *pair) const;
+
   uint64_t step_length_mask_ = 0;
-  mutable std::shared_mutex mutex_;
-  std::deque<LogIndexAndSequencePair> list_;
+  uint64_t mask_ = 0;
+  std::unique_ptr<Sample[]> ring_;
+  std::atomic<uint64_t> head_{0};  // oldest sample
+  std::atomic<uint64_t> tail_{0};  // next free slot
+  std::atomic_int64_t max_gap_{1000};
 };
 
 class LogIndexTablePropertiesCollector : public rocksdb::TablePropertiesCollector {
@@ -3,16 +3,25 @@
 //  LICENSE file in the root directory of this source tree. An additional grant
 //  of patent rights can be found in the PATENTS file in the same directory.
 
+#include <algorithm>
+#include <atomic>
+#include <limits>
 #include <sstream>
 
+#include "pstd/env.h"
 #include "pstd/log.h"
 #include "rocksdb/env.h"
 
+#include "src/batch.h"
+
+#include "src/base_data_key_format.h"
 #include "src/base_filter.h"
 #include "src/lists_filter.h"
 #include "src/mutex.h"
 #include "src/redis.h"
+#include "src/scope_record_lock.h"
 #include "src/strings_filter.h"
+#include "src/zsets_data_key_format.h"
 #include "src/zsets_filter.h"
 
 #define ADD_TABLE_PROPERTY_COLLECTOR_FACTORY(type)              \
@@ -35,6 +44,31 @@ const char DataTypeToTag(DataType type) {
   return DataTypeTag[static_cast<uint8_t>(type)];
 }
 
+// the data entries CONVERTFORMAT writes at most in one batch
+static constexpr int32_t kConvertBatchSize = 1024;
+
+// the versions handed out from now on are at least version_floor
+static std::atomic<uint64_t> version_floor{0};
+static std::atomic<uint64_t> max_version_time{0};
+
+uint64_t NextVersionTime(uint64_t old_time) {
+  int64_t unix_time;
+  rocksdb::Env::Default()->GetCurrentTime(&unix_time);
+  uint64_t time = old_time >= static_cast<uint64_t>(unix_time) ? old_time + 1 : static_cast<uint64_t>(unix_time);
+  time = std::max(time, version_floor.load(std::memory_order_relaxed));
+  auto max_time = max_version_time.load(std::memory_order_relaxed);
+  while (time > max_time && !max_version_time.compare_exchange_weak(max_time, time, std::memory_order_relaxed)) {
+  }
+  return time;
+}
+
+void RaiseVersionFloor() {
+  auto floor = max_version_time.load(std::memory_order_relaxed) + 1;
+  auto old_floor = version_floor.load(std::memory_order_relaxed);
+  while (floor > old_floor && !version_floor.compare_exchange_weak(old_floor, floor, std::memory_order_relaxed)) {
+  }
+}
+
 const rocksdb::Comparator* ListsDataKeyComparator() {
   static ListsDataKeyComparatorImpl ldkc;
   return &ldkc;
@@ -63,6 +97,8 @@ Redis::Redis(Storage* const s, int32_t index)
 
 Redis::~Redis() {
   if (need_close_.load()) {
+    snapshots_.Reset();
+    iterators_.Clear();
     rocksdb::CancelAllBackgroundWork(db_, true);
     std::vector<rocksdb::ColumnFamilyHandle*> tmp_handles = handles_;
     handles_.clear();
@@ -80,14 +116,56 @@ Redis::~Redis() {
 Status Redis::Open(const StorageOptions& storage_options, const std::string& db_path) {
   append_log_function_ = storage_options.append_log_function;
   raft_timeout_s_ = storage_options.raft_timeout_s;
+  compact_format_ = storage_options.compact_data_format;
+  iterators_.SetMaxIdle(std::chrono::milliseconds(storage_options.iterator_max_idle_ms));
   statistics_store_->SetCapacity(storage_options.statistics_max_size);
   small_compaction_threshold_ = storage_options.small_compaction_threshold;
 
   rocksdb::BlockBasedTableOptions table_ops(storage_options.table_options);
   table_ops.filter_policy.reset(rocksdb::NewBloomFilterPolicy(10, true));
 
+  // the cold path mirrors the layout of the DB path, <cold_path>/<db>/<instance>
+  if (!storage_options.cold_path.empty()) {
+    cold_path_ = storage_options.cold_path + "/" + std::to_string(storage_options.db_id) + "/" + std::to_string(index_);
+    pstd::CreatePath(cold_path_);
+  }
+  auto set_compaction_style = [&](DataType type, rocksdb::ColumnFamilyOptions* cf_ops) {
+    auto it = storage_options.compaction_styles.find(type);
+    if (it == storage_options.compaction_styles.end()) {
+      return;
+    }
+    cf_ops->compaction_style = it->second;
+    if (it->second == rocksdb::kCompactionStyleFIFO) {
+      // only the age drops the SSTs, and the L0 files are still merged so
+      // that the reads do not go through all of them
+      cf_ops->ttl = storage_options.fifo_ttl_seconds;
+      cf_ops->compaction_options_fifo.max_table_files_size = std::numeric_limits<uint64_t>::max();
+      cf_ops->compaction_options_fifo.allow_compaction = true;
+    }
+  };
+  auto set_tiering = [&](DataType type, rocksdb::ColumnFamilyOptions* cf_ops) {
+    const auto& types = storage_options.cold_data_types;
+    // FIFO keeps all the SSTs in L0, on the first path
+    if (cold_path_.empty() || std::find(types.begin(), types.end(), type) == types.end() ||
+        cf_ops->compaction_style == rocksdb::kCompactionStyleFIFO) {
+      return;
+    }
+    // RocksDB places a level on the first path whose target size holds it and
+    // the levels above it, so the upper levels stay hot and the rest go cold
+    cf_ops->cf_paths = {{db_path, storage_options.hot_path_size}, {cold_path_, std::numeric_limits<uint64_t>::max()}};
+    cf_ops->last_level_temperature = rocksdb::Temperature::kCold;
+    cf_ops->preclude_last_level_data_seconds = storage_options.cold_data_seconds;
+  };
+
   // Set up separate configuration for RocksDB
   rocksdb::DBOptions db_ops(storage_options.options);
+  bool raft_log_as_wal = append_log_function_ && storage_options.raft_log_as_wal;
+  if (raft_log_as_wal) {
+    // Without a WAL only the SSTs survive a crash. The CFs are flushed
+    // together, so they all hold the logs up to the same index and the
+    // replay starts from a single point.
+    db_ops.atomic_flush = true;
+  }
 
   /*
    * Because zset, set, the hash, list, stream type meta
@@ -156,6 +234,32 @@ Status Redis::Open(const StorageOptions& storage_options, const std::string& db_
   zset_data_cf_ops.table_factory.reset(rocksdb::NewBlockBasedTableFactory(zset_data_cf_table_ops));
   zset_score_cf_ops.table_factory.reset(rocksdb::NewBlockBasedTableFactory(zset_score_cf_table_ops));
 
+  // stream column-family options
+  rocksdb::ColumnFamilyOptions stream_data_cf_ops(storage_options.options);
+  stream_data_cf_ops.compaction_filter_factory =
+      std::make_shared<StreamsDataFilterFactory>(&db_, &handles_, DataType::kStreams);
+  rocksdb::BlockBasedTableOptions stream_data_cf_table_ops(table_ops);
+  if (!storage_options.share_block_cache && (storage_options.block_cache_size > 0)) {
+    stream_data_cf_table_ops.block_cache = rocksdb::NewLRUCache(storage_options.block_cache_size);
+  }
+  stream_data_cf_ops.table_factory.reset(rocksdb::NewBlockBasedTableFactory(stream_data_cf_table_ops));
+
+  set_compaction_style(DataType::kStrings, &meta_cf_ops);
+  set_compaction_style(DataType::kHashes, &hash_data_cf_ops);
+  set_compaction_style(DataType::kLists, &list_data_cf_ops);
+  set_compaction_style(DataType::kSets, &set_data_cf_ops);
+  set_compaction_style(DataType::kZSets, &zset_data_cf_ops);
+  set_compaction_style(DataType::kZSets, &zset_score_cf_ops);
+  set_compaction_style(DataType::kStreams, &stream_data_cf_ops);
+
+  set_tiering(DataType::kStrings, &meta_cf_ops);
+  set_tiering(DataType::kHashes, &hash_data_cf_ops);
+  set_tiering(DataType::kLists, &list_data_cf_ops);
+  set_tiering(DataType::kSets, &set_data_cf_ops);
+  set_tiering(DataType::kZSets, &zset_data_cf_ops);
+  set_tiering(DataType::kZSets, &zset_score_cf_ops);
+  set_tiering(DataType::kStreams, &stream_data_cf_ops);
+
   if (append_log_function_) {
     // Add log index table property collector factory to each column family
     ADD_TABLE_PROPERTY_COLLECTOR_FACTORY(meta);
@@ -164,7 +268,9 @@ Status Redis::Open(const StorageOptions& storage_options, const std::string& db_
     ADD_TABLE_PROPERTY_COLLECTOR_FACTORY(set_data);
     ADD_TABLE_PROPERTY_COLLECTOR_FACTORY(zset_data);
     ADD_TABLE_PROPERTY_COLLECTOR_FACTORY(zset_score);
+    ADD_TABLE_PROPERTY_COLLECTOR_FACTORY(stream_data);
 
+    log_index_collector_.SetMaxGap(storage_options.max_gap);
     // Add a listener on flush to purge log index collector
     db_ops.listeners.push_back(std::make_shared<LogIndexAndSequenceCollectorPurger>(
         &handles_, &log_index_collector_, &log_index_of_all_cfs_, storage_options.do_snapshot_function));
@@ -183,12 +289,24 @@ Status Redis::Open(const StorageOptions& storage_options, const std::string& db_
   // zset CF
   column_families.emplace_back("zset_data_cf", zset_data_cf_ops);
   column_families.emplace_back("zset_score_cf", zset_score_cf_ops);
+  // stream CF
+  column_families.emplace_back("stream_data_cf", stream_data_cf_ops);
 
   auto s = rocksdb::DB::Open(db_ops, db_path, column_families, &handles_, &db_);
   if (!s.ok()) {
     return s;
   }
   assert(!handles_.empty());
+  if (!append_log_function_) {
+    // the log index collectors only run with raft, so no sst file carries a log index
+    return s;
+  }
+  if (raft_log_as_wal) {
+    default_write_options_.disableWAL = true;
+  }
+  if (storage_options.open_progress_function) {
+    storage_options.open_progress_function(index_, OpenStage::kLoadingLogIndex);
+  }
   return log_index_of_all_cfs_.Init(this);
 }
 
@@ -224,15 +342,179 @@ Status Redis::SetMaxCacheStatisticKeys(size_t max_cache_statistic_keys) {
 }
 
 Status Redis::CompactRange(const rocksdb::Slice* begin, const rocksdb::Slice* end) {
+  snapshots_.Reset();
+  iterators_.Clear();
   db_->CompactRange(default_compact_range_options_, begin, end);
   db_->CompactRange(default_compact_range_options_, handles_[kHashesDataCF], begin, end);
   db_->CompactRange(default_compact_range_options_, handles_[kSetsDataCF], begin, end);
   db_->CompactRange(default_compact_range_options_, handles_[kListsDataCF], begin, end);
   db_->CompactRange(default_compact_range_options_, handles_[kZsetsDataCF], begin, end);
   db_->CompactRange(default_compact_range_options_, handles_[kZsetsScoreCF], begin, end);
+  db_->CompactRange(default_compact_range_options_, handles_[kStreamsDataCF], begin, end);
   return Status::OK();
 }
 
+Status Redis::FlushDB() {
+  // every key starts with the zeroed reserve1, so the range covers the whole CF. The
+  // begin key has no user key delimiter, which the list data comparator takes too.
+  static const std::string kBeginKey(kPrefixReserveLength, '\0');
+  static const std::string kEndKey(kPrefixReserveLength + 1, '\xff');
+
+  auto batch = Batch::CreateBatch(this);
+  for (auto cf_idx : {kMetaCF, kHashesDataCF, kSetsDataCF, kListsDataCF, kZsetsDataCF, kStreamsDataCF}) {
+    batch->DeleteRange(cf_idx, kBeginKey, kEndKey);
+  }
+  // The zset score comparator skips reserve1, so no fixed bound sorts after every user
+  // key there. The range ends at the last score key instead, which goes on its own: the
+  // flush holds the DB exclusively, no key is added past it meanwhile. Left behind, the
+  // entries would show in a zset created again with their version, after a restart too.
+  rocksdb::ReadOptions iterator_options;
+  iterator_options.fill_cache = false;
+  std::unique_ptr<rocksdb::Iterator> score_iter(db_->NewIterator(iterator_options, handles_[kZsetsScoreCF]));
+  score_iter->SeekToLast();
+  if (score_iter->Valid()) {
+    ZSetsScoreKey begin_key("", 0, -std::numeric_limits<double>::infinity(), "");
+    std::string last_key = score_iter->key().ToString();
+    batch->DeleteRange(kZsetsScoreCF, begin_key.Encode(), last_key);
+    batch->Delete(kZsetsScoreCF, last_key);
+  }
+  auto s = score_iter->status();
+  score_iter.reset();
+  if (s.ok()) {
+    s = batch->Commit();
+  }
+  if (!s.ok()) {
+    return s;
+  }
+  // or the compaction after the flush keeps the data it should drop
+  snapshots_.Reset();
+  iterators_.Clear();
+
+  scan_cursors_store_->Clear();
+  spop_counts_store_->Clear();
+  statistics_store_->Clear();
+  return Status::OK();
+}
+
+Status Redis::ConvertToCompactFormat(std::string* next_key, size_t max_keys, int64_t* scanned,
+                                     int64_t* converted) {
+  *scanned = 0;
+  rocksdb::ReadOptions iterator_options;
+  iterator_options.fill_cache = false;
+  rocksdb::Iterator* iter = db_->NewIterator(iterator_options, handles_[kMetaCF]);
+  if (next_key->empty()) {
+    iter->SeekToFirst();
+  } else {
+    iter->Seek(*next_key);
+  }
+  Status s;
+  for (; iter->Valid() && static_cast<size_t>(*scanned) < max_keys; iter->Next()) {
+    ++*scanned;
+    auto type = static_cast<enum DataType>(static_cast<uint8_t>(iter->value()[0]));
+    if (type != DataType::kHashes && type != DataType::kSets && type != DataType::kZSets) {
+      continue;
+    }
+    ParsedBaseMetaValue parsed_meta_value(iter->value());
+    if (IsCompactVersion(parsed_meta_value.Version()) || !parsed_meta_value.IsValid()) {
+      continue;
+    }
+    ParsedBaseMetaKey parsed_meta_key(iter->key());
+    bool done = false;
+    s = ConvertKeyToCompactFormat(parsed_meta_key.Key(), type, &done);
+    if (!s.ok()) {
+      break;
+    }
+    *converted += done ? 1 : 0;
+  }
+  if (s.ok()) {
+    s = iter->status();
+  }
+  // where it stopped, a key that failed is tried again from here
+  if (iter->Valid()) {
+    next_key->assign(iter->key().data(), iter->key().size());
+  } else {
+    next_key->clear();
+  }
+  delete iter;
+  return s;
+}
+
+// Rewrites the data of one key under a new compact version, the data of the old
+// version is dropped by the compaction filters like after a DEL. The data goes in
+// batches of at most kConvertBatchSize entries and the meta, which moves the key
+// to the new version, with the last one. Until then readers see the old version.
+Status Redis::ConvertKeyToCompactFormat(const Slice& key, DataType type, bool* done) {
+  *done = false;
+  ScopeRecordLock l(lock_mgr_, key);
+  BaseMetaKey base_meta_key(key);
+  std::string meta_value;
+  Status s = db_->Get(default_read_options_, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
+  if (s.IsNotFound()) {
+    return Status::OK();
+  }
+  if (!s.ok()) {
+    return s;
+  }
+  // written again since the scan
+  if (!ExpectedMetaValue(type, meta_value)) {
+    return Status::OK();
+  }
+  ParsedBaseMetaValue parsed_meta_value(&meta_value);
+  if (IsCompactVersion(parsed_meta_value.Version()) || !parsed_meta_value.IsValid()) {
+    return Status::OK();
+  }
+
+  auto data_cf = type == DataType::kHashes ? kHashesDataCF : (type == DataType::kSets ? kSetsDataCF : kZsetsDataCF);
+  uint64_t version = parsed_meta_value.Version();
+  uint64_t new_version = parsed_meta_value.UpdateVersion(true);
+  auto batch = Batch::CreateBatch(this);
+
+  BaseDataKey prefix_key(key, version, Slice());
+  Slice prefix = prefix_key.EncodeSeekKey();
+  rocksdb::Iterator* iter = db_->NewIterator(default_read_options_, handles_[data_cf]);
+  for (iter->Seek(prefix); iter->Valid() && iter->key().starts_with(prefix); iter->Next()) {
+    ParsedBaseDataKey parsed_data_key(iter->key());
+    ParsedBaseDataValue parsed_value(iter->value());
+    BaseDataKey data_key(key, new_version, parsed_data_key.Data());
+    BaseDataValue data_value(parsed_value.UserValue());
+    data_value.setCtime(parsed_value.Ctime());
+    batch->Put(data_cf, data_key.Encode(), data_value.EncodeCompact());
+
+    if (type == DataType::kZSets) {
+      // the score keys keep the full format, they only move to the new version
+      uint64_t tmp = DecodeFixed64(parsed_value.UserValue().data());
+      const void* ptr_tmp = reinterpret_cast<const void*>(&tmp);
+      double score = *reinterpret_cast<const double*>(ptr_tmp);
+      ZSetsScoreKey score_key(key, new_version, score, parsed_data_key.Data());
+      BaseDataValue score_value(Slice());
+      batch->Put(kZsetsScoreCF, score_key.Encode(), score_value.Encode());
+    }
+
+    if (batch->Count() >= kConvertBatchSize) {
+      s = batch->Commit();
+      if (!s.ok()) {
+        break;
+      }
+      batch = Batch::CreateBatch(this);
+    }
+  }
+  if (s.ok()) {
+    s = iter->status();
+  }
+  delete iter;
+  if (!s.ok()) {
+    // the entries of the new version written so far stay out of sight, and no later
+    // version of the key may be theirs or they would show
+    RaiseVersionFloor();
+    return s;
+  }
+
+  batch->Put(kMetaCF, base_meta_key.Encode(), meta_value);
+  s = batch->Commit();
+  *done = s.ok();
+  return s;
+}
+
 Status Redis::SetSmallCompactionThreshold(uint64_t small_compaction_threshold) {
   small_compaction_threshold_ = small_compaction_threshold;
   return Status::OK();
@@ -301,6 +583,18 @@ Status Redis::SetOptions(const OptionType& option_type, const std::unordered_map
   return s;
 }
 
+void Redis::GetTierUsage(uint64_t* hot_bytes, uint64_t* cold_bytes) {
+  std::vector<rocksdb::LiveFileMetaData> files;
+  db_->GetLiveFilesMetaData(&files);
+  for (const auto& file : files) {
+    if (!cold_path_.empty() && file.db_path == cold_path_) {
+      *cold_bytes += file.size;
+    } else {
+      *hot_bytes += file.size;
+    }
+  }
+}
+
 void Redis::GetRocksDBInfo(std::string& info, const char* prefix) {
   std::ostringstream string_stream;
   string_stream << "#" << prefix << "RocksDB"
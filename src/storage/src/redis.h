@@ -19,10 +19,13 @@
 #include "pstd/log.h"
 #include "src/custom_comparator.h"
 #include "src/debug.h"
+#include "src/iterator_pool.h"
 #include "src/lock_mgr.h"
 #include "src/lru_cache.h"
 #include "src/mutex_impl.h"
+#include "src/scope_snapshot.h"
 #include "src/type_iterator.h"
+#include "src/write_throttle.h"
 #include "storage/storage.h"
 #include "storage/storage_define.h"
 
@@ -33,6 +36,8 @@ namespace storage {
 using Status = rocksdb::Status;
 using Slice = rocksdb::Slice;
 
+class Batch;
+
 class Redis {
  public:
   Redis(Storage* storage, int32_t index);
@@ -96,6 +101,7 @@ class Redis {
 
   Status SetOptions(const OptionType& option_type, const std::unordered_map<std::string, std::string>& options);
   void SetWriteWalOptions(const bool is_wal_disable);
+  bool IsWalDisabled() const { return default_write_options_.disableWAL; }
 
   // Common Commands
   Status Open(const StorageOptions& storage_options, const std::string& db_path);
@@ -104,6 +110,11 @@ class Redis {
 
   virtual Status CompactRange(const rocksdb::Slice* begin, const rocksdb::Slice* end);
 
+  // Range deletes the meta CF and the data CFs but the zset score one, whose entries
+  // are orphaned and dropped by its filter on compaction. The keys created again
+  // get versions past those of the flushed data.
+  Status FlushDB();
+
   virtual Status GetProperty(const std::string& property, uint64_t* out);
   bool IsApplied(size_t cf_idx, LogIndex logidx) const { return log_index_of_all_cfs_.IsApplied(cf_idx, logidx); }
   void UpdateAppliedLogIndexOfColumnFamily(size_t cf_idx, LogIndex logidx, SequenceNumber seqno) {
@@ -140,6 +151,7 @@ class Redis {
                std::string& value_to_dest, int64_t* ret);
   Status Decrby(const Slice& key, int64_t value, int64_t* ret);
   Status Get(const Slice& key, std::string* value);
+  Status MGet(const std::vector<std::string>& keys, std::vector<ValueStatus>* vss);
   Status GetWithTTL(const Slice& key, std::string* value, int64_t* ttl);
   Status GetBit(const Slice& key, int64_t offset, int32_t* ret);
   Status Getrange(const Slice& key, int64_t start_offset, int64_t end_offset, std::string* ret);
@@ -182,6 +194,7 @@ class Redis {
   Status HDel(const Slice& key, const std::vector<std::string>& fields, int32_t* ret);
   Status HExists(const Slice& key, const Slice& field);
   Status HGet(const Slice& key, const Slice& field, std::string* value);
+  Status HGetMultiKeys(const std::vector<std::string>& keys, const Slice& field, std::vector<ValueStatus>* vss);
   Status HGetall(const Slice& key, std::vector<FieldValue>* fvs);
   Status HGetallWithTTL(const Slice& key, std::vector<FieldValue>* fvs, int64_t* ttl);
   Status HIncrby(const Slice& key, const Slice& field, int64_t value, int64_t* ret);
@@ -208,10 +221,24 @@ class Redis {
   Status SetSmallCompactionThreshold(uint64_t small_compaction_threshold);
   Status SetSmallCompactionDurationThreshold(uint64_t small_compaction_duration_threshold);
   void GetRocksDBInfo(std::string& info, const char* prefix);
+  void GetTierUsage(uint64_t* hot_bytes, uint64_t* cold_bytes);
   auto GetWriteOptions() const -> const rocksdb::WriteOptions& { return default_write_options_; }
   auto GetColumnFamilyHandles() const -> const std::vector<rocksdb::ColumnFamilyHandle*>& { return handles_; }
   auto GetRaftTimeout() const -> uint32_t { return raft_timeout_s_; }
   auto GetAppendLogFunction() const -> const AppendLogFunction& { return append_log_function_; }
+  bool IsCompactFormat() const { return compact_format_; }
+
+  // A reused iterator when this thread has one parked, see IteratorPool
+  PooledIterator NewPooledIterator(ColumnFamilyIndex cf, const rocksdb::Snapshot* snapshot) {
+    return iterators_.Get(db_, handles_[cf], cf, IteratorPool::kRead, snapshot);
+  }
+  IteratorPool& GetIteratorPool() { return iterators_; }
+  WriteThrottle& GetWriteThrottle() { return write_throttle_; }
+
+  // Moves the hashes, sets and zsets still in the full format to the compact one, online.
+  // It scans at most max_keys meta keys from next_key on and leaves next_key at the
+  // one to go on from, empty once the instance is done. converted counts up.
+  Status ConvertToCompactFormat(std::string* next_key, size_t max_keys, int64_t* scanned, int64_t* converted);
 
   // Sets Commands
   Status SAdd(const Slice& key, const std::vector<std::string>& members, int32_t* ret);
@@ -290,6 +317,25 @@ class Redis {
   Status ZPopMax(const Slice& key, int64_t count, std::vector<ScoreMember>* score_members);
   Status ZPopMin(const Slice& key, int64_t count, std::vector<ScoreMember>* score_members);
 
+  // Streams Commands
+  Status XAdd(const Slice& key, const std::vector<std::string>& field_values, const StreamAddArgs& args, StreamID* id);
+  Status XLen(const Slice& key, uint64_t* len);
+  Status XLastID(const Slice& key, StreamID* id);
+  Status XRange(const Slice& key, const StreamID& start, const StreamID& end, int64_t count,
+                std::vector<StreamEntry>* entries);
+  Status XRevRange(const Slice& key, const StreamID& end, const StreamID& start, int64_t count,
+                   std::vector<StreamEntry>* entries);
+  Status XDel(const Slice& key, const std::vector<StreamID>& ids, int64_t* ret);
+  Status XTrim(const Slice& key, const StreamTrimArgs& args, int64_t* ret);
+  Status XGroupCreate(const Slice& key, const Slice& group, const StreamID& id, bool last_id, bool mkstream);
+  Status XGroupSetID(const Slice& key, const Slice& group, const StreamID& id, bool last_id);
+  Status XGroupDestroy(const Slice& key, const Slice& group, int32_t* ret);
+  Status XReadGroup(const Slice& key, const Slice& group, const Slice& consumer, const StreamID& start,
+                    bool new_entries, int64_t count, bool noack, std::vector<StreamEntry>* entries);
+  Status XAck(const Slice& key, const Slice& group, const std::vector<StreamID>& ids, int64_t* ret);
+  Status XPending(const Slice& key, const Slice& group, const StreamID& start, const StreamID& end, int64_t count,
+                  const Slice& consumer, std::vector<StreamPendingEntry>* pendings);
+
   void ScanDatabase();
   void ScanStrings();
   void ScanHashes();
@@ -308,28 +354,38 @@ class Redis {
 
   TypeIterator* CreateIterator(const char& type, const std::string& pattern, const Slice* lower_bound,
                                const Slice* upper_bound) {
-    rocksdb::ReadOptions options;
-    options.fill_cache = false;
-    options.iterate_lower_bound = lower_bound;
-    options.iterate_upper_bound = upper_bound;
+    PooledIterator raw_iter;
+    if (lower_bound == nullptr && upper_bound == nullptr) {
+      raw_iter = iterators_.Get(db_, handles_[kMetaCF], kMetaCF, IteratorPool::kScan, nullptr);
+    } else {
+      // the pooled iterators cannot take bounds
+      rocksdb::ReadOptions options;
+      options.fill_cache = false;
+      options.iterate_lower_bound = lower_bound;
+      options.iterate_upper_bound = upper_bound;
+      raw_iter.reset(db_->NewIterator(options, handles_[kMetaCF]));
+    }
     switch (type) {
       case 'k':
-        return new StringsIterator(options, db_, handles_[kMetaCF], pattern);
+        return new StringsIterator(std::move(raw_iter), pattern);
         break;
       case 'h':
-        return new HashesIterator(options, db_, handles_[kMetaCF], pattern);
+        return new HashesIterator(std::move(raw_iter), pattern);
         break;
       case 's':
-        return new SetsIterator(options, db_, handles_[kMetaCF], pattern);
+        return new SetsIterator(std::move(raw_iter), pattern);
         break;
       case 'l':
-        return new ListsIterator(options, db_, handles_[kMetaCF], pattern);
+        return new ListsIterator(std::move(raw_iter), pattern);
         break;
       case 'z':
-        return new ZsetsIterator(options, db_, handles_[kMetaCF], pattern);
+        return new ZsetsIterator(std::move(raw_iter), pattern);
+        break;
+      case 'x':
+        return new StreamsIterator(std::move(raw_iter), pattern);
         break;
       case 'a':
-        return new AllIterator(options, db_, handles_[kMetaCF], pattern);
+        return new AllIterator(std::move(raw_iter), pattern);
       default:
         WARN("Invalid datatype to create iterator");
         return nullptr;
@@ -355,7 +411,8 @@ class Redis {
     switch (meta_type) {
       case DataType::kZSets:
       case DataType::kSets:
-      case DataType::kHashes: {
+      case DataType::kHashes:
+      case DataType::kStreams: {
         ParsedBaseMetaValue parsed_meta_value(&meta_value);
         return (parsed_meta_value.IsStale() || parsed_meta_value.Count() == 0);
       }
@@ -378,11 +435,17 @@ class Redis {
   LogIndexAndSequenceCollector& GetCollector() { return log_index_collector_; }
 
  private:
+  Status ConvertKeyToCompactFormat(const Slice& key, DataType type, bool* done);
+
   int32_t index_ = 0;
   std::atomic<bool> need_close_ = false;
   Storage* const storage_;
   std::shared_ptr<LockMgr> lock_mgr_;
   rocksdb::DB* db_ = nullptr;
+  SnapshotCache snapshots_;  // shared by the reads that need a consistent view
+  std::string cold_path_;     // empty without a cold tier
+  IteratorPool iterators_;
+  WriteThrottle write_throttle_;
 
   std::vector<rocksdb::ColumnFamilyHandle*> handles_;
   rocksdb::WriteOptions default_write_options_;
@@ -398,11 +461,21 @@ class Redis {
   Status StoreScanNextPoint(const DataType& type, const Slice& key, const Slice& pattern, int64_t cursor,
                             const std::string& next_point);
 
+  // For Streams
+  // NotFound for a missing, stale or empty stream, InvalidArgument for another type
+  Status GetStreamMeta(const Slice& key, const rocksdb::ReadOptions& read_options, std::string* meta_value);
+  // Loads the meta value for a write, a stream without records gets a fresh version
+  Status PrepareStreamMeta(const Slice& key, std::string* meta_value, bool* exists);
+  Status TrimStream(Batch* batch, const Slice& key, uint64_t version, uint64_t length, const StreamTrimArgs& args,
+                    const StreamID* new_id, int64_t* removed, bool* keep_new);
+
   // For Statistics
   std::atomic_uint64_t small_compaction_threshold_;
   std::atomic_uint64_t small_compaction_duration_threshold_;
   std::unique_ptr<LRUCache<std::string, KeyStatistics>> statistics_store_;
 
+  bool compact_format_ = false;
+
   // For raft
   uint32_t raft_timeout_s_ = 10;
   AppendLogFunction append_log_function_;
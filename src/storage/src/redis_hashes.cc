@@ -30,7 +30,7 @@ Status Redis::ScanHashesKeyNum(KeyInfo* key_info) {
 
   rocksdb::ReadOptions iterator_options;
   const rocksdb::Snapshot* snapshot;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   iterator_options.snapshot = snapshot;
   iterator_options.fill_cache = false;
 
@@ -76,14 +76,12 @@ Status Redis::HDel(const Slice& key, const std::vector<std::string>& fields, int
 
   auto batch = Batch::CreateBatch(this);
   rocksdb::ReadOptions read_options;
-  const rocksdb::Snapshot* snapshot;
 
   std::string meta_value;
   int32_t del_cnt = 0;
   uint64_t version = 0;
+  // the record lock keeps the other writers of the key out, no snapshot needed
   ScopeRecordLock l(lock_mgr_, key);
-  ScopeSnapshot ss(db_, &snapshot);
-  read_options.snapshot = snapshot;
 
   BaseMetaKey base_meta_key(key);
   Status s = db_->Get(read_options, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
@@ -138,10 +136,9 @@ Status Redis::HExists(const Slice& key, const Slice& field) {
 Status Redis::HGet(const Slice& key, const Slice& field, std::string* value) {
   std::string meta_value;
   uint64_t version = 0;
+  // no snapshot: the data keys carry the version, so a write landing between
+  // the two reads still leaves this read ordered either before or after it
   rocksdb::ReadOptions read_options;
-  const rocksdb::Snapshot* snapshot;
-  ScopeSnapshot ss(db_, &snapshot);
-  read_options.snapshot = snapshot;
 
   BaseMetaKey base_meta_key(key);
   Status s = db_->Get(read_options, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
@@ -166,13 +163,76 @@ Status Redis::HGet(const Slice& key, const Slice& field, std::string* value) {
   return s;
 }
 
+Status Redis::HGetMultiKeys(const std::vector<std::string>& keys, const Slice& field, std::vector<ValueStatus>* vss) {
+  vss->clear();
+  vss->assign(keys.size(), {std::string(), Status::NotFound()});
+
+  rocksdb::ReadOptions read_options;
+  const rocksdb::Snapshot* snapshot;
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
+  read_options.snapshot = snapshot;
+
+  // first round: the meta values of all keys
+  std::vector<std::string> encoded_keys;
+  encoded_keys.reserve(keys.size());
+  for (const auto& key : keys) {
+    BaseMetaKey base_meta_key(key);
+    encoded_keys.emplace_back(base_meta_key.Encode().ToString());
+  }
+  std::vector<Slice> key_slices(encoded_keys.begin(), encoded_keys.end());
+  std::vector<rocksdb::PinnableSlice> values(keys.size());
+  std::vector<Status> statuses(keys.size());
+  db_->MultiGet(read_options, handles_[kMetaCF], keys.size(), key_slices.data(), values.data(), statuses.data());
+
+  // second round: the field of every live hash
+  std::vector<size_t> hash_indexes;
+  encoded_keys.clear();
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (statuses[i].IsNotFound()) {
+      continue;
+    } else if (!statuses[i].ok()) {
+      vss->clear();
+      return statuses[i];
+    }
+    std::string meta_value = values[i].ToString();
+    if (IsStale(meta_value) || !ExpectedMetaValue(DataType::kHashes, meta_value)) {
+      continue;
+    }
+    ParsedHashesMetaValue parsed_hashes_meta_value(&meta_value);
+    HashesDataKey data_key(keys[i], parsed_hashes_meta_value.Version(), field);
+    encoded_keys.emplace_back(data_key.Encode().ToString());
+    hash_indexes.push_back(i);
+  }
+  if (hash_indexes.empty()) {
+    return Status::OK();
+  }
+
+  key_slices.assign(encoded_keys.begin(), encoded_keys.end());
+  values = std::vector<rocksdb::PinnableSlice>(hash_indexes.size());
+  statuses.assign(hash_indexes.size(), Status::OK());
+  db_->MultiGet(read_options, handles_[kHashesDataCF], hash_indexes.size(), key_slices.data(), values.data(),
+                statuses.data());
+  for (size_t i = 0; i < hash_indexes.size(); ++i) {
+    if (statuses[i].ok()) {
+      std::string value = values[i].ToString();
+      ParsedBaseDataValue parsed_internal_value(&value);
+      parsed_internal_value.StripSuffix();
+      (*vss)[hash_indexes[i]] = {std::move(value), Status::OK()};
+    } else if (!statuses[i].IsNotFound()) {
+      vss->clear();
+      return statuses[i];
+    }
+  }
+  return Status::OK();
+}
+
 Status Redis::HGetall(const Slice& key, std::vector<FieldValue>* fvs) {
   rocksdb::ReadOptions read_options;
   const rocksdb::Snapshot* snapshot;
 
   std::string meta_value;
   uint64_t version = 0;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   read_options.snapshot = snapshot;
 
   BaseMetaKey base_meta_key(key);
@@ -190,13 +250,12 @@ Status Redis::HGetall(const Slice& key, std::vector<FieldValue>* fvs) {
       HashesDataKey hashes_data_key(key, version, "");
       Slice prefix = hashes_data_key.EncodeSeekKey();
       KeyStatisticsDurationGuard guard(this, DataType::kHashes, key.ToString());
-      auto iter = db_->NewIterator(read_options, handles_[kHashesDataCF]);
+      auto iter = NewPooledIterator(kHashesDataCF, read_options.snapshot);
       for (iter->Seek(prefix); iter->Valid() && iter->key().starts_with(prefix); iter->Next()) {
         ParsedHashesDataKey parsed_hashes_data_key(iter->key());
         ParsedBaseDataValue parsed_internal_value(iter->value());
         fvs->push_back({parsed_hashes_data_key.field().ToString(), parsed_internal_value.UserValue().ToString()});
       }
-      delete iter;
     }
   }
   return s;
@@ -208,7 +267,7 @@ Status Redis::HGetallWithTTL(const Slice& key, std::vector<FieldValue>* fvs, int
 
   std::string meta_value;
   uint64_t version = 0;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   read_options.snapshot = snapshot;
   BaseMetaKey base_meta_key(key);
   Status s = db_->Get(read_options, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
@@ -235,13 +294,12 @@ Status Redis::HGetallWithTTL(const Slice& key, std::vector<FieldValue>* fvs, int
       HashesDataKey hashes_data_key(key, version, "");
       Slice prefix = hashes_data_key.EncodeSeekKey();
       KeyStatisticsDurationGuard guard(this, DataType::kHashes, key.ToString());
-      auto iter = db_->NewIterator(read_options, handles_[kHashesDataCF]);
+      auto iter = NewPooledIterator(kHashesDataCF, read_options.snapshot);
       for (iter->Seek(prefix); iter->Valid() && iter->key().starts_with(prefix); iter->Next()) {
         ParsedHashesDataKey parsed_hashes_data_key(iter->key());
         ParsedBaseDataValue parsed_internal_value(iter->value());
         fvs->push_back({parsed_hashes_data_key.field().ToString(), parsed_internal_value.UserValue().ToString()});
       }
-      delete iter;
     }
   }
   return s;
@@ -273,7 +331,7 @@ Status Redis::HIncrby(const Slice& key, const Slice& field, int64_t value, int64
   if (s.ok()) {
     ParsedHashesMetaValue parsed_hashes_meta_value(&meta_value);
     if (parsed_hashes_meta_value.IsStale() || parsed_hashes_meta_value.Count() == 0) {
-      version = parsed_hashes_meta_value.UpdateVersion();
+      version = parsed_hashes_meta_value.UpdateVersion(compact_format_);
       parsed_hashes_meta_value.SetCount(1);
       parsed_hashes_meta_value.SetEtime(0);
       batch->Put(kMetaCF, base_meta_key.Encode(), meta_value);
@@ -318,7 +376,7 @@ Status Redis::HIncrby(const Slice& key, const Slice& field, int64_t value, int64
   } else if (s.IsNotFound()) {
     EncodeFixed32(meta_value_buf, 1);
     HashesMetaValue hashes_meta_value(DataType::kHashes, Slice(meta_value_buf, 4));
-    version = hashes_meta_value.UpdateVersion();
+    version = hashes_meta_value.UpdateVersion(compact_format_);
     batch->Put(kMetaCF, base_meta_key.Encode(), hashes_meta_value.Encode());
     HashesDataKey hashes_data_key(key, version, field);
 
@@ -364,7 +422,7 @@ Status Redis::HIncrbyfloat(const Slice& key, const Slice& field, const Slice& by
   if (s.ok()) {
     ParsedHashesMetaValue parsed_hashes_meta_value(&meta_value);
     if (parsed_hashes_meta_value.IsStale() || parsed_hashes_meta_value.Count() == 0) {
-      version = parsed_hashes_meta_value.UpdateVersion();
+      version = parsed_hashes_meta_value.UpdateVersion(compact_format_);
       parsed_hashes_meta_value.SetCount(1);
       parsed_hashes_meta_value.SetEtime(0);
       batch.Put(handles_[kMetaCF], base_meta_key.Encode(), meta_value);
@@ -409,7 +467,7 @@ Status Redis::HIncrbyfloat(const Slice& key, const Slice& field, const Slice& by
   } else if (s.IsNotFound()) {
     EncodeFixed32(meta_value_buf, 1);
     HashesMetaValue hashes_meta_value(DataType::kHashes, Slice(meta_value_buf, 4));
-    version = hashes_meta_value.UpdateVersion();
+    version = hashes_meta_value.UpdateVersion(compact_format_);
     batch.Put(handles_[kMetaCF], base_meta_key.Encode(), hashes_meta_value.Encode());
 
     HashesDataKey hashes_data_key(key, version, field);
@@ -430,7 +488,7 @@ Status Redis::HKeys(const Slice& key, std::vector<std::string>* fields) {
 
   std::string meta_value;
   uint64_t version = 0;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   read_options.snapshot = snapshot;
 
   BaseMetaKey base_meta_key(key);
@@ -448,12 +506,11 @@ Status Redis::HKeys(const Slice& key, std::vector<std::string>* fields) {
       HashesDataKey hashes_data_key(key, version, "");
       Slice prefix = hashes_data_key.EncodeSeekKey();
       KeyStatisticsDurationGuard guard(this, DataType::kHashes, key.ToString());
-      auto iter = db_->NewIterator(read_options, handles_[kHashesDataCF]);
+      auto iter = NewPooledIterator(kHashesDataCF, read_options.snapshot);
       for (iter->Seek(prefix); iter->Valid() && iter->key().starts_with(prefix); iter->Next()) {
         ParsedHashesDataKey parsed_hashes_data_key(iter->key());
         fields->push_back(parsed_hashes_data_key.field().ToString());
       }
-      delete iter;
     }
   }
   return s;
@@ -492,7 +549,7 @@ Status Redis::HMGet(const Slice& key, const std::vector<std::string>& fields, st
   std::string meta_value;
   rocksdb::ReadOptions read_options;
   const rocksdb::Snapshot* snapshot;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   read_options.snapshot = snapshot;
   BaseMetaKey base_meta_key(key);
   Status s = db_->Get(read_options, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
@@ -566,7 +623,7 @@ Status Redis::HMSet(const Slice& key, const std::vector<FieldValue>& fvs) {
   if (s.ok()) {
     ParsedHashesMetaValue parsed_hashes_meta_value(&meta_value);
     if (parsed_hashes_meta_value.IsStale() || parsed_hashes_meta_value.Count() == 0) {
-      version = parsed_hashes_meta_value.InitialMetaValue();
+      version = parsed_hashes_meta_value.InitialMetaValue(compact_format_);
       if (!parsed_hashes_meta_value.check_set_count(static_cast<int32_t>(filtered_fvs.size()))) {
         return Status::InvalidArgument("hash size overflow");
       }
@@ -604,7 +661,7 @@ Status Redis::HMSet(const Slice& key, const std::vector<FieldValue>& fvs) {
   } else if (s.IsNotFound()) {
     EncodeFixed32(meta_value_buf, filtered_fvs.size());
     HashesMetaValue hashes_meta_value(DataType::kHashes, Slice(meta_value_buf, 4));
-    version = hashes_meta_value.UpdateVersion();
+    version = hashes_meta_value.UpdateVersion(compact_format_);
     batch->Put(kMetaCF, base_meta_key.Encode(), hashes_meta_value.Encode());
     for (const auto& fv : filtered_fvs) {
       HashesDataKey hashes_data_key(key, version, fv.field);
@@ -640,7 +697,7 @@ Status Redis::HSet(const Slice& key, const Slice& field, const Slice& value, int
   if (s.ok()) {
     ParsedHashesMetaValue parsed_hashes_meta_value(&meta_value);
     if (parsed_hashes_meta_value.IsStale() || parsed_hashes_meta_value.Count() == 0) {
-      version = parsed_hashes_meta_value.InitialMetaValue();
+      version = parsed_hashes_meta_value.InitialMetaValue(compact_format_);
       parsed_hashes_meta_value.SetCount(1);
       batch->Put(kMetaCF, base_meta_key.Encode(), meta_value);
       HashesDataKey data_key(key, version, field);
@@ -677,7 +734,7 @@ Status Redis::HSet(const Slice& key, const Slice& field, const Slice& value, int
   } else if (s.IsNotFound()) {
     EncodeFixed32(meta_value_buf, 1);
     HashesMetaValue hashes_meta_value(DataType::kHashes, Slice(meta_value_buf, 4));
-    version = hashes_meta_value.UpdateVersion();
+    version = hashes_meta_value.UpdateVersion(compact_format_);
     batch->Put(kMetaCF, base_meta_key.Encode(), hashes_meta_value.Encode());
     HashesDataKey data_key(key, version, field);
     BaseDataValue internal_value(value);
@@ -714,7 +771,7 @@ Status Redis::HSetnx(const Slice& key, const Slice& field, const Slice& value, i
   if (s.ok()) {
     ParsedHashesMetaValue parsed_hashes_meta_value(&meta_value);
     if (parsed_hashes_meta_value.IsStale() || parsed_hashes_meta_value.Count() == 0) {
-      version = parsed_hashes_meta_value.InitialMetaValue();
+      version = parsed_hashes_meta_value.InitialMetaValue(compact_format_);
       parsed_hashes_meta_value.SetCount(1);
       batch->Put(kMetaCF, base_meta_key.Encode(), meta_value);
       HashesDataKey hashes_data_key(key, version, field);
@@ -742,7 +799,7 @@ Status Redis::HSetnx(const Slice& key, const Slice& field, const Slice& value, i
   } else if (s.IsNotFound()) {
     EncodeFixed32(meta_value_buf, 1);
     HashesMetaValue hashes_meta_value(DataType::kHashes, Slice(meta_value_buf, 4));
-    version = hashes_meta_value.UpdateVersion();
+    version = hashes_meta_value.UpdateVersion(compact_format_);
     batch->Put(kMetaCF, base_meta_key.Encode(), hashes_meta_value.Encode());
     HashesDataKey hashes_data_key(key, version, field);
     batch->Put(kHashesDataCF, hashes_data_key.Encode(), internal_value.Encode());
@@ -759,7 +816,7 @@ Status Redis::HVals(const Slice& key, std::vector<std::string>* values) {
 
   std::string meta_value;
   uint64_t version = 0;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   read_options.snapshot = snapshot;
 
   BaseMetaKey base_meta_key(key);
@@ -777,12 +834,11 @@ Status Redis::HVals(const Slice& key, std::vector<std::string>* values) {
       HashesDataKey hashes_data_key(key, version, "");
       Slice prefix = hashes_data_key.EncodeSeekKey();
       KeyStatisticsDurationGuard guard(this, DataType::kHashes, key.ToString());
-      auto iter = db_->NewIterator(read_options, handles_[kHashesDataCF]);
+      auto iter = NewPooledIterator(kHashesDataCF, read_options.snapshot);
       for (iter->Seek(prefix); iter->Valid() && iter->key().starts_with(prefix); iter->Next()) {
         ParsedBaseDataValue parsed_internal_value(iter->value());
         values->push_back(parsed_internal_value.UserValue().ToString());
       }
-      delete iter;
     }
   }
   return s;
@@ -814,7 +870,7 @@ Status Redis::HScan(const Slice& key, int64_t cursor, const std::string& pattern
   const rocksdb::Snapshot* snapshot;
 
   std::string meta_value;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   read_options.snapshot = snapshot;
 
   BaseMetaKey base_meta_key(key);
@@ -847,7 +903,7 @@ Status Redis::HScan(const Slice& key, int64_t cursor, const std::string& pattern
       HashesDataKey hashes_start_data_key(key, version, start_point);
       std::string prefix = hashes_data_prefix.EncodeSeekKey().ToString();
       KeyStatisticsDurationGuard guard(this, DataType::kHashes, key.ToString());
-      rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[kHashesDataCF]);
+      auto iter = NewPooledIterator(kHashesDataCF, read_options.snapshot);
       for (iter->Seek(hashes_start_data_key.Encode()); iter->Valid() && rest > 0 && iter->key().starts_with(prefix);
            iter->Next()) {
         ParsedHashesDataKey parsed_hashes_data_key(iter->key());
@@ -867,7 +923,6 @@ Status Redis::HScan(const Slice& key, int64_t cursor, const std::string& pattern
       } else {
         *next_cursor = 0;
       }
-      delete iter;
     }
   } else {
     *next_cursor = 0;
@@ -885,7 +940,7 @@ Status Redis::HScanx(const Slice& key, const std::string& start_field, const std
   std::string meta_value;
   rocksdb::ReadOptions read_options;
   const rocksdb::Snapshot* snapshot;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   read_options.snapshot = snapshot;
 
   BaseMetaKey base_meta_key(key);
@@ -905,7 +960,7 @@ Status Redis::HScanx(const Slice& key, const std::string& start_field, const std
       HashesDataKey hashes_start_data_key(key, version, start_field);
       std::string prefix = hashes_data_prefix.EncodeSeekKey().ToString();
       KeyStatisticsDurationGuard guard(this, DataType::kHashes, key.ToString());
-      rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[kHashesDataCF]);
+      auto iter = NewPooledIterator(kHashesDataCF, read_options.snapshot);
       for (iter->Seek(hashes_start_data_key.Encode()); iter->Valid() && rest > 0 && iter->key().starts_with(prefix);
            iter->Next()) {
         ParsedHashesDataKey parsed_hashes_data_key(iter->key());
@@ -923,7 +978,6 @@ Status Redis::HScanx(const Slice& key, const std::string& start_field, const std
       } else {
         *next_field = "";
       }
-      delete iter;
     }
   } else {
     *next_field = "";
@@ -1018,7 +1072,7 @@ Status Redis::PKHScanRange(const Slice& key, const Slice& field_start, const std
   std::string meta_value;
   rocksdb::ReadOptions read_options;
   const rocksdb::Snapshot* snapshot;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   read_options.snapshot = snapshot;
 
   bool start_no_limit = field_start.compare("") == 0;
@@ -1083,7 +1137,7 @@ Status Redis::PKHRScanRange(const Slice& key, const Slice& field_start, const st
   std::string meta_value;
   rocksdb::ReadOptions read_options;
   const rocksdb::Snapshot* snapshot;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   read_options.snapshot = snapshot;
 
   bool start_no_limit = field_start.compare("") == 0;
@@ -1105,7 +1159,7 @@ Status Redis::PKHRScanRange(const Slice& key, const Slice& field_start, const st
     } else {
       ParsedHashesMetaValue parsed_hashes_meta_value(&meta_value);
       uint64_t version = parsed_hashes_meta_value.Version();
-      int32_t start_key_version = start_no_limit ? version + 1 : version;
+      uint64_t start_key_version = start_no_limit ? version + 1 : version;
       std::string start_key_field = start_no_limit ? "" : field_start.ToString();
       HashesDataKey hashes_data_prefix(key, version, Slice());
       HashesDataKey hashes_start_data_key(key, start_key_version, start_key_field);
@@ -1167,7 +1221,7 @@ Status Redis::HashesRename(const Slice& key, Redis* new_inst, const Slice& newke
   new_inst->UpdateSpecificKeyStatistics(DataType::kHashes, newkey.ToString(), statistic);
 
   // HashesDel key
-  parsed_hashes_meta_value.InitialMetaValue();
+  parsed_hashes_meta_value.InitialMetaValue(compact_format_);
   s = db_->Put(default_write_options_, handles_[kMetaCF], base_meta_key.Encode(), meta_value);
   UpdateSpecificKeyStatistics(DataType::kHashes, key.ToString(), statistic);
 
@@ -1210,7 +1264,7 @@ Status Redis::HashesRenamenx(const Slice& key, Redis* new_inst, const Slice& new
   new_inst->UpdateSpecificKeyStatistics(DataType::kHashes, newkey.ToString(), statistic);
 
   // HashesDel key
-  parsed_hashes_meta_value.InitialMetaValue();
+  parsed_hashes_meta_value.InitialMetaValue(compact_format_);
   s = db_->Put(default_write_options_, handles_[kMetaCF], base_meta_key.Encode(), meta_value);
   UpdateSpecificKeyStatistics(DataType::kHashes, key.ToString(), statistic);
 
@@ -1220,7 +1274,7 @@ Status Redis::HashesRenamenx(const Slice& key, Redis* new_inst, const Slice& new
 void Redis::ScanHashes() {
   rocksdb::ReadOptions iterator_options;
   const rocksdb::Snapshot* snapshot;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   iterator_options.snapshot = snapshot;
   iterator_options.fill_cache = false;
   auto current_time = static_cast<int32_t>(time(nullptr));
@@ -24,7 +24,7 @@ Status Redis::ScanListsKeyNum(KeyInfo* key_info) {
 
   rocksdb::ReadOptions iterator_options;
   const rocksdb::Snapshot* snapshot;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   iterator_options.snapshot = snapshot;
   iterator_options.fill_cache = false;
 
@@ -60,7 +60,7 @@ Status Redis::LIndex(const Slice& key, int64_t index, std::string* element) {
   rocksdb::ReadOptions read_options;
   const rocksdb::Snapshot* snapshot;
 
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   read_options.snapshot = snapshot;
   std::string meta_value;
 
@@ -366,7 +366,7 @@ Status Redis::LRange(const Slice& key, int64_t start, int64_t stop, std::vector<
   rocksdb::ReadOptions read_options;
   const rocksdb::Snapshot* snapshot;
 
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   read_options.snapshot = snapshot;
 
   std::string meta_value;
@@ -397,7 +397,7 @@ Status Redis::LRange(const Slice& key, int64_t start, int64_t stop, std::vector<
         if (sublist_right_index > origin_right_index) {
           sublist_right_index = origin_right_index;
         }
-        rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[kListsDataCF]);
+        auto iter = NewPooledIterator(kListsDataCF, read_options.snapshot);
         uint64_t current_index = sublist_left_index;
         ListsDataKey start_data_key(key, version, current_index);
         for (iter->Seek(start_data_key.Encode()); iter->Valid() && current_index <= sublist_right_index;
@@ -405,7 +405,6 @@ Status Redis::LRange(const Slice& key, int64_t start, int64_t stop, std::vector<
           ParsedBaseDataValue parsed_value(iter->value());
           ret->push_back(parsed_value.UserValue().ToString());
         }
-        delete iter;
         return Status::OK();
       }
     }
@@ -419,7 +418,7 @@ Status Redis::LRangeWithTTL(const Slice& key, int64_t start, int64_t stop, std::
   rocksdb::ReadOptions read_options;
   const rocksdb::Snapshot* snapshot;
 
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   read_options.snapshot = snapshot;
 
   std::string meta_value;
@@ -460,15 +459,14 @@ Status Redis::LRangeWithTTL(const Slice& key, int64_t start, int64_t stop, std::
         if (sublist_right_index > origin_right_index) {
           sublist_right_index = origin_right_index;
         }
-        rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[kListsDataCF]);
+        auto iter = NewPooledIterator(kListsDataCF, read_options.snapshot);
         uint64_t current_index = sublist_left_index;
         ListsDataKey start_data_key(key, version, current_index);
         for (iter->Seek(start_data_key.Encode()); iter->Valid() && current_index <= sublist_right_index;
              iter->Next(), current_index++) {
           ParsedBaseDataValue parsed_value(iter->value());
-          ret->push_back(iter->value().ToString());
+          ret->push_back(parsed_value.UserValue().ToString());
         }
-        delete iter;
         return Status::OK();
       }
     }
@@ -1050,7 +1048,7 @@ Status Redis::ListsRenamenx(const Slice& key, Redis* new_inst, const Slice& newk
 void Redis::ScanLists() {
   rocksdb::ReadOptions iterator_options;
   const rocksdb::Snapshot* snapshot;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   iterator_options.snapshot = snapshot;
   iterator_options.fill_cache = false;
   auto current_time = static_cast<int32_t>(time(nullptr));
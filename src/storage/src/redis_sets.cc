@@ -31,7 +31,7 @@ rocksdb::Status Redis::ScanSetsKeyNum(KeyInfo* key_info) {
 
   rocksdb::ReadOptions iterator_options;
   const rocksdb::Snapshot* snapshot;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   iterator_options.snapshot = snapshot;
   iterator_options.fill_cache = false;
 
@@ -93,7 +93,7 @@ rocksdb::Status Redis::SAdd(const Slice& key, const std::vector<std::string>& me
   if (s.ok()) {
     ParsedSetsMetaValue parsed_sets_meta_value(&meta_value);
     if (parsed_sets_meta_value.IsStale() || parsed_sets_meta_value.Count() == 0) {
-      version = parsed_sets_meta_value.InitialMetaValue();
+      version = parsed_sets_meta_value.InitialMetaValue(compact_format_);
       if (!parsed_sets_meta_value.check_set_count(static_cast<int32_t>(filtered_members.size()))) {
         return Status::InvalidArgument("set size overflow");
       }
@@ -136,7 +136,7 @@ rocksdb::Status Redis::SAdd(const Slice& key, const std::vector<std::string>& me
     char str[4];
     EncodeFixed32(str, filtered_members.size());
     SetsMetaValue sets_meta_value(DataType::kSets, Slice(str, 4));
-    version = sets_meta_value.UpdateVersion();
+    version = sets_meta_value.UpdateVersion(compact_format_);
     batch->Put(kMetaCF, base_meta_key.Encode(), sets_meta_value.Encode());
     for (const auto& member : filtered_members) {
       SetsMemberKey sets_member_key(key, version, member);
@@ -184,7 +184,7 @@ rocksdb::Status Redis::SDiff(const std::vector<std::string>& keys, std::vector<s
 
   std::string meta_value;
   uint64_t version = 0;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   read_options.snapshot = snapshot;
   std::vector<KeyVersion> valid_sets;
   rocksdb::Status s;
@@ -225,7 +225,7 @@ rocksdb::Status Redis::SDiff(const std::vector<std::string>& keys, std::vector<s
       SetsMemberKey sets_member_key(keys[0], version, Slice());
       prefix = sets_member_key.EncodeSeekKey();
       KeyStatisticsDurationGuard guard(this, DataType::kSets, keys[0]);
-      auto iter = db_->NewIterator(read_options, handles_[kSetsDataCF]);
+      auto iter = NewPooledIterator(kSetsDataCF, read_options.snapshot);
       for (iter->Seek(prefix); iter->Valid() && iter->key().starts_with(prefix); iter->Next()) {
         ParsedSetsMemberKey parsed_sets_member_key(iter->key());
         Slice member = parsed_sets_member_key.member();
@@ -238,7 +238,6 @@ rocksdb::Status Redis::SDiff(const std::vector<std::string>& keys, std::vector<s
             found = true;
             break;
           } else if (!s.IsNotFound()) {
-            delete iter;
             return s;
           }
         }
@@ -246,7 +245,6 @@ rocksdb::Status Redis::SDiff(const std::vector<std::string>& keys, std::vector<s
           members->push_back(member.ToString());
         }
       }
-      delete iter;
     }
   } else if (!s.IsNotFound()) {
     return s;
@@ -267,7 +265,7 @@ rocksdb::Status Redis::SDiffstore(const Slice& destination, const std::vector<st
   std::string meta_value;
   uint64_t version = 0;
   ScopeRecordLock l(lock_mgr_, destination);
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   read_options.snapshot = snapshot;
   std::vector<KeyVersion> valid_sets;
   rocksdb::Status s;
@@ -341,7 +339,7 @@ rocksdb::Status Redis::SDiffstore(const Slice& destination, const std::vector<st
   if (s.ok() && ExpectedMetaValue(DataType::kSets, meta_value)) {
     ParsedSetsMetaValue parsed_sets_meta_value(&meta_value);
     statistic = parsed_sets_meta_value.Count();
-    version = parsed_sets_meta_value.InitialMetaValue();
+    version = parsed_sets_meta_value.InitialMetaValue(compact_format_);
     if (!parsed_sets_meta_value.check_set_count(static_cast<int32_t>(members.size()))) {
       return Status::InvalidArgument("set size overflow");
     }
@@ -351,7 +349,7 @@ rocksdb::Status Redis::SDiffstore(const Slice& destination, const std::vector<st
     char str[4];
     EncodeFixed32(str, members.size());
     SetsMetaValue sets_meta_value(DataType::kSets, Slice(str, sizeof(int32_t)));
-    version = sets_meta_value.UpdateVersion();
+    version = sets_meta_value.UpdateVersion(compact_format_);
     batch->Put(kMetaCF, base_destination.Encode(), sets_meta_value.Encode());
   }
 
@@ -377,7 +375,7 @@ rocksdb::Status Redis::SInter(const std::vector<std::string>& keys, std::vector<
 
   std::string meta_value;
   uint64_t version = 0;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   read_options.snapshot = snapshot;
   std::vector<KeyVersion> valid_sets;
   rocksdb::Status s;
@@ -420,7 +418,7 @@ rocksdb::Status Redis::SInter(const std::vector<std::string>& keys, std::vector<
       SetsMemberKey sets_member_key(keys[0], version, Slice());
       KeyStatisticsDurationGuard guard(this, DataType::kSets, keys[0]);
       Slice prefix = sets_member_key.EncodeSeekKey();
-      auto iter = db_->NewIterator(read_options, handles_[kSetsDataCF]);
+      auto iter = NewPooledIterator(kSetsDataCF, read_options.snapshot);
       for (iter->Seek(prefix); iter->Valid() && iter->key().starts_with(prefix); iter->Next()) {
         ParsedSetsMemberKey parsed_sets_member_key(iter->key());
         Slice member = parsed_sets_member_key.member();
@@ -435,7 +433,6 @@ rocksdb::Status Redis::SInter(const std::vector<std::string>& keys, std::vector<
             reliable = false;
             break;
           } else {
-            delete iter;
             return s;
           }
         }
@@ -443,7 +440,6 @@ rocksdb::Status Redis::SInter(const std::vector<std::string>& keys, std::vector<
           members->push_back(member.ToString());
         }
       }
-      delete iter;
     }
   } else if (s.IsNotFound()) {
     return rocksdb::Status::OK();
@@ -467,7 +463,7 @@ rocksdb::Status Redis::SInterstore(const Slice& destination, const std::vector<s
   uint64_t version = 0;
   bool have_invalid_sets = false;
   ScopeRecordLock l(lock_mgr_, destination);
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   read_options.snapshot = snapshot;
   std::vector<KeyVersion> valid_sets;
   rocksdb::Status s;
@@ -551,7 +547,7 @@ rocksdb::Status Redis::SInterstore(const Slice& destination, const std::vector<s
   if (s.ok() && ExpectedMetaValue(DataType::kSets, meta_value)) {
     ParsedSetsMetaValue parsed_sets_meta_value(&meta_value);
     statistic = parsed_sets_meta_value.Count();
-    version = parsed_sets_meta_value.InitialMetaValue();
+    version = parsed_sets_meta_value.InitialMetaValue(compact_format_);
     if (!parsed_sets_meta_value.check_set_count(static_cast<int32_t>(members.size()))) {
       return Status::InvalidArgument("set size overflow");
     }
@@ -561,7 +557,7 @@ rocksdb::Status Redis::SInterstore(const Slice& destination, const std::vector<s
     char str[4];
     EncodeFixed32(str, members.size());
     SetsMetaValue sets_meta_value(DataType::kSets, Slice(str, sizeof(int32_t)));
-    version = sets_meta_value.UpdateVersion();
+    version = sets_meta_value.UpdateVersion(compact_format_);
     batch->Put(kMetaCF, base_destination.Encode(), sets_meta_value.Encode());
   }
 
@@ -579,13 +575,11 @@ rocksdb::Status Redis::SInterstore(const Slice& destination, const std::vector<s
 
 rocksdb::Status Redis::SIsmember(const Slice& key, const Slice& member, int32_t* ret) {
   *ret = 0;
+  // meta and one member, consistent without a snapshot like HGet
   rocksdb::ReadOptions read_options;
-  const rocksdb::Snapshot* snapshot;
 
   std::string meta_value;
   uint64_t version = 0;
-  ScopeSnapshot ss(db_, &snapshot);
-  read_options.snapshot = snapshot;
 
   BaseMetaKey base_meta_key(key);
   rocksdb::Status s = db_->Get(read_options, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
@@ -616,7 +610,7 @@ rocksdb::Status Redis::SMembers(const Slice& key, std::vector<std::string>* memb
 
   std::string meta_value;
   uint64_t version = 0;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   read_options.snapshot = snapshot;
 
   BaseMetaKey base_meta_key(key);
@@ -634,12 +628,11 @@ rocksdb::Status Redis::SMembers(const Slice& key, std::vector<std::string>* memb
       SetsMemberKey sets_member_key(key, version, Slice());
       Slice prefix = sets_member_key.EncodeSeekKey();
       KeyStatisticsDurationGuard guard(this, DataType::kSets, key.ToString());
-      auto iter = db_->NewIterator(read_options, handles_[kSetsDataCF]);
+      auto iter = NewPooledIterator(kSetsDataCF, read_options.snapshot);
       for (iter->Seek(prefix); iter->Valid() && iter->key().starts_with(prefix); iter->Next()) {
         ParsedSetsMemberKey parsed_sets_member_key(iter->key());
         members->push_back(parsed_sets_member_key.member().ToString());
       }
-      delete iter;
     }
   }
   return s;
@@ -651,7 +644,7 @@ Status Redis::SMembersWithTTL(const Slice& key, std::vector<std::string>* member
 
   std::string meta_value;
   uint64_t version = 0;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   read_options.snapshot = snapshot;
   BaseMetaKey base_meta_key(key);
   rocksdb::Status s = db_->Get(read_options, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
@@ -678,12 +671,11 @@ Status Redis::SMembersWithTTL(const Slice& key, std::vector<std::string>* member
       SetsMemberKey sets_member_key(key, version, Slice());
       Slice prefix = sets_member_key.EncodeSeekKey();
       KeyStatisticsDurationGuard guard(this, DataType::kSets, key.ToString());
-      auto iter = db_->NewIterator(read_options, handles_[kSetsDataCF]);
+      auto iter = NewPooledIterator(kSetsDataCF, read_options.snapshot);
       for (iter->Seek(prefix); iter->Valid() && iter->key().starts_with(prefix); iter->Next()) {
         ParsedSetsMemberKey parsed_sets_member_key(iter->key());
         members->push_back(parsed_sets_member_key.member().ToString());
       }
-      delete iter;
     }
   }
   return s;
@@ -758,7 +750,7 @@ rocksdb::Status Redis::SMove(const Slice& source, const Slice& destination, cons
   if (s.ok()) {
     ParsedSetsMetaValue parsed_sets_meta_value(&meta_value);
     if (parsed_sets_meta_value.IsStale() || parsed_sets_meta_value.Count() == 0) {
-      version = parsed_sets_meta_value.InitialMetaValue();
+      version = parsed_sets_meta_value.InitialMetaValue(compact_format_);
       parsed_sets_meta_value.SetCount(1);
       batch->Put(kMetaCF, base_destination.Encode(), meta_value);
       SetsMemberKey sets_member_key(destination, version, member);
@@ -785,7 +777,7 @@ rocksdb::Status Redis::SMove(const Slice& source, const Slice& destination, cons
     char str[4];
     EncodeFixed32(str, 1);
     SetsMetaValue sets_meta_value(DataType::kSets, Slice(str, 4));
-    version = sets_meta_value.UpdateVersion();
+    version = sets_meta_value.UpdateVersion(compact_format_);
     batch->Put(kMetaCF, base_destination.Encode(), sets_meta_value.Encode());
     SetsMemberKey sets_member_key(destination, version, member);
     BaseDataValue iter_value(Slice{});
@@ -1027,7 +1019,7 @@ rocksdb::Status Redis::SUnion(const std::vector<std::string>& keys, std::vector<
   const rocksdb::Snapshot* snapshot;
 
   std::string meta_value;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   read_options.snapshot = snapshot;
   std::vector<KeyVersion> valid_sets;
   rocksdb::Status s;
@@ -1057,7 +1049,7 @@ rocksdb::Status Redis::SUnion(const std::vector<std::string>& keys, std::vector<
     SetsMemberKey sets_member_key(key_version.key, key_version.version, Slice());
     prefix = sets_member_key.EncodeSeekKey();
     KeyStatisticsDurationGuard guard(this, DataType::kSets, key_version.key);
-    auto iter = db_->NewIterator(read_options, handles_[kSetsDataCF]);
+    auto iter = NewPooledIterator(kSetsDataCF, read_options.snapshot);
     for (iter->Seek(prefix); iter->Valid() && iter->key().starts_with(prefix); iter->Next()) {
       ParsedSetsMemberKey parsed_sets_member_key(iter->key());
       std::string member = parsed_sets_member_key.member().ToString();
@@ -1066,7 +1058,6 @@ rocksdb::Status Redis::SUnion(const std::vector<std::string>& keys, std::vector<
         result_flag[member] = true;
       }
     }
-    delete iter;
   }
   return rocksdb::Status::OK();
 }
@@ -1085,7 +1076,7 @@ rocksdb::Status Redis::SUnionstore(const Slice& destination, const std::vector<s
   std::string meta_value;
   uint64_t version = 0;
   ScopeRecordLock l(lock_mgr_, destination);
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   read_options.snapshot = snapshot;
   std::vector<KeyVersion> valid_sets;
   rocksdb::Status s;
@@ -1134,7 +1125,7 @@ rocksdb::Status Redis::SUnionstore(const Slice& destination, const std::vector<s
   if (s.ok() && ExpectedMetaValue(DataType::kSets, meta_value)) {
     ParsedSetsMetaValue parsed_sets_meta_value(&meta_value);
     statistic = parsed_sets_meta_value.Count();
-    version = parsed_sets_meta_value.InitialMetaValue();
+    version = parsed_sets_meta_value.InitialMetaValue(compact_format_);
     if (!parsed_sets_meta_value.check_set_count(static_cast<int32_t>(members.size()))) {
       return Status::InvalidArgument("set size overflow");
     }
@@ -1144,7 +1135,7 @@ rocksdb::Status Redis::SUnionstore(const Slice& destination, const std::vector<s
     char str[4];
     EncodeFixed32(str, members.size());
     SetsMetaValue sets_meta_value(DataType::kSets, Slice(str, sizeof(int32_t)));
-    version = sets_meta_value.UpdateVersion();
+    version = sets_meta_value.UpdateVersion(compact_format_);
     batch->Put(kMetaCF, base_destination.Encode(), sets_meta_value.Encode());
   }
   for (const auto& member : members) {
@@ -1174,7 +1165,7 @@ rocksdb::Status Redis::SScan(const Slice& key, int64_t cursor, const std::string
   const rocksdb::Snapshot* snapshot;
 
   std::string meta_value;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   read_options.snapshot = snapshot;
 
   BaseMetaKey base_meta_key(key);
@@ -1207,7 +1198,7 @@ rocksdb::Status Redis::SScan(const Slice& key, int64_t cursor, const std::string
       SetsMemberKey sets_member_key(key, version, start_point);
       std::string prefix = sets_member_prefix.EncodeSeekKey().ToString();
       KeyStatisticsDurationGuard guard(this, DataType::kSets, key.ToString());
-      rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[kSetsDataCF]);
+      auto iter = NewPooledIterator(kSetsDataCF, read_options.snapshot);
       for (iter->Seek(sets_member_key.EncodeSeekKey()); iter->Valid() && rest > 0 && iter->key().starts_with(prefix);
            iter->Next()) {
         ParsedSetsMemberKey parsed_sets_member_key(iter->key());
@@ -1226,7 +1217,6 @@ rocksdb::Status Redis::SScan(const Slice& key, int64_t cursor, const std::string
       } else {
         *next_cursor = 0;
       }
-      delete iter;
     }
   } else {
     *next_cursor = 0;
@@ -1266,7 +1256,7 @@ Status Redis::SetsRename(const Slice& key, Redis* new_inst, const Slice& newkey)
   new_inst->UpdateSpecificKeyStatistics(DataType::kSets, newkey.ToString(), statistic);
 
   // SetsDel key
-  parsed_sets_meta_value.InitialMetaValue();
+  parsed_sets_meta_value.InitialMetaValue(compact_format_);
   s = db_->Put(default_write_options_, handles_[kMetaCF], base_meta_key.Encode(), meta_value);
   UpdateSpecificKeyStatistics(DataType::kSets, key.ToString(), statistic);
 
@@ -1311,7 +1301,7 @@ Status Redis::SetsRenamenx(const Slice& key, Redis* new_inst, const Slice& newke
   new_inst->UpdateSpecificKeyStatistics(DataType::kSets, newkey.ToString(), statistic);
 
   // SetsDel key
-  parsed_sets_meta_value.InitialMetaValue();
+  parsed_sets_meta_value.InitialMetaValue(compact_format_);
   s = db_->Put(default_write_options_, handles_[kMetaCF], base_meta_key.Encode(), meta_value);
   UpdateSpecificKeyStatistics(DataType::kSets, key.ToString(), statistic);
 
@@ -1321,7 +1311,7 @@ Status Redis::SetsRenamenx(const Slice& key, Redis* new_inst, const Slice& newke
 void Redis::ScanSets() {
   rocksdb::ReadOptions iterator_options;
   const rocksdb::Snapshot* snapshot;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   iterator_options.snapshot = snapshot;
   iterator_options.fill_cache = false;
   auto current_time = static_cast<int32_t>(time(nullptr));
@@ -0,0 +1,694 @@
+//  Copyright (c) 2024-present, OpenAtom Foundation, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "src/redis.h"
+
+#include <memory>
+#include <unordered_set>
+
+#include <fmt/core.h>
+
+#include "batch.h"
+#include "pstd/log.h"
+#include "src/base_data_key_format.h"
+#include "src/base_data_value_format.h"
+#include "src/base_key_format.h"
+#include "src/scope_record_lock.h"
+#include "src/scope_snapshot.h"
+#include "src/streams_data_key_format.h"
+#include "src/streams_meta_value_format.h"
+
+namespace storage {
+
+namespace {
+
+const char* kStreamIDTooSmall = "ERR The ID specified in XADD is equal or smaller than the target stream top item";
+const char* kStreamGroupKeyMissing =
+    "ERR The XGROUP subcommand requires the key to exist. Note that for CREATE you may want to use the MKSTREAM "
+    "option to create an empty stream automatically.";
+
+Status NoGroupError(const Slice& key, const Slice& group) {
+  return Status::Corruption(
+      fmt::format("NOGROUP No such key '{}' or consumer group '{}'", key.ToString(), group.ToString()));
+}
+
+uint64_t NowMillis() { return pstd::NowMicros() / 1000; }
+
+}  // namespace
+
+Status Redis::GetStreamMeta(const Slice& key, const rocksdb::ReadOptions& read_options, std::string* meta_value) {
+  BaseMetaKey base_meta_key(key);
+  Status s = db_->Get(read_options, handles_[kMetaCF], base_meta_key.Encode(), meta_value);
+  if (!s.ok()) {
+    return s;
+  }
+  if (IsStale(*meta_value)) {
+    return Status::NotFound("Stale");
+  }
+  if (!ExpectedMetaValue(DataType::kStreams, *meta_value)) {
+    return Status::InvalidArgument(fmt::format("WRONGTYPE, key: {}, expect type: {}, get type: {}", key.ToString(),
+                                               DataTypeStrings[static_cast<int>(DataType::kStreams)],
+                                               DataTypeStrings[static_cast<int>(GetMetaValueType(*meta_value))]));
+  }
+  return Status::OK();
+}
+
+Status Redis::PrepareStreamMeta(const Slice& key, std::string* meta_value, bool* exists) {
+  BaseMetaKey base_meta_key(key);
+  Status s = db_->Get(default_read_options_, handles_[kMetaCF], base_meta_key.Encode(), meta_value);
+  if (s.ok() && !ExpectedMetaValue(DataType::kStreams, *meta_value)) {
+    if (!IsStale(*meta_value)) {
+      return Status::InvalidArgument(fmt::format("WRONGTYPE, key: {}, expect type: {}, get type: {}", key.ToString(),
+                                                 DataTypeStrings[static_cast<int>(DataType::kStreams)],
+                                                 DataTypeStrings[static_cast<int>(GetMetaValueType(*meta_value))]));
+    }
+    s = Status::NotFound();
+  }
+
+  if (s.ok()) {
+    ParsedStreamsMetaValue parsed_streams_meta_value(meta_value);
+    *exists = !parsed_streams_meta_value.IsStale() && parsed_streams_meta_value.Count() != 0;
+    if (!*exists) {
+      // bump the version so the records of the old stream are dropped by compaction
+      parsed_streams_meta_value.InitialMetaValue();
+    }
+  } else if (s.IsNotFound()) {
+    StreamsMetaValue streams_meta_value;
+    streams_meta_value.UpdateVersion();
+    *meta_value = streams_meta_value.Encode().ToString();
+    *exists = false;
+  } else {
+    return s;
+  }
+  if (!*exists) {
+    ParsedStreamsMetaValue parsed_streams_meta_value(meta_value);
+    parsed_streams_meta_value.SetCount(kStreamSelfCount);
+  }
+  return Status::OK();
+}
+
+Status Redis::TrimStream(Batch* batch, const Slice& key, uint64_t version, uint64_t length, const StreamTrimArgs& args,
+                         const StreamID* new_id, int64_t* removed, bool* keep_new) {
+  *removed = 0;
+  *keep_new = true;
+  uint64_t to_remove = 0;
+  if (args.strategy == StreamTrimArgs::kMaxLen) {
+    uint64_t total = length + (new_id ? 1 : 0);
+    to_remove = total > args.maxlen ? total - args.maxlen : 0;
+    if (to_remove > length) {
+      *keep_new = false;
+      to_remove = length;
+    }
+    if (to_remove == 0) {
+      return Status::OK();
+    }
+  } else if (args.strategy == StreamTrimArgs::kMinID) {
+    *keep_new = !new_id || !(*new_id < args.minid);
+  } else {
+    return Status::OK();
+  }
+
+  // Walk the head of the stream up to the first entry that stays, then drop
+  // everything before it with a single range tombstone
+  rocksdb::ReadOptions read_options;
+  read_options.fill_cache = false;
+  BaseDataKey entry_prefix_key(key, version, Slice(&kStreamEntryTag, 1));
+  std::string prefix = entry_prefix_key.EncodeSeekKey().ToString();
+  std::string end_key;
+  std::unique_ptr<rocksdb::Iterator> iter(db_->NewIterator(read_options, handles_[kStreamsDataCF]));
+  for (iter->Seek(prefix); iter->Valid() && iter->key().starts_with(prefix); iter->Next()) {
+    if (args.strategy == StreamTrimArgs::kMaxLen) {
+      if (static_cast<uint64_t>(*removed) == to_remove) {
+        end_key = iter->key().ToString();
+        break;
+      }
+    } else {
+      ParsedBaseDataKey parsed_data_key(iter->key());
+      if (!(DecodeStreamID(parsed_data_key.Data()) < args.minid)) {
+        end_key = iter->key().ToString();
+        break;
+      }
+    }
+    (*removed)++;
+  }
+  if (!iter->status().ok()) {
+    return iter->status();
+  }
+
+  if (*removed > 0) {
+    BaseDataKey begin_key(key, version, StreamEntryData(StreamID::Min()));
+    if (end_key.empty()) {
+      // every entry goes, end right behind the entry tag
+      BaseDataKey entry_end_key(key, version, std::string(1, kStreamEntryTag + 1));
+      end_key = entry_end_key.Encode().ToString();
+    }
+    batch->DeleteRange(kStreamsDataCF, begin_key.Encode(), end_key);
+  }
+  return Status::OK();
+}
+
+Status Redis::XAdd(const Slice& key, const std::vector<std::string>& field_values, const StreamAddArgs& args,
+                   StreamID* id) {
+  auto batch = Batch::CreateBatch(this);
+  ScopeRecordLock l(lock_mgr_, key);
+
+  std::string meta_value;
+  bool exists = false;
+  Status s = PrepareStreamMeta(key, &meta_value, &exists);
+  if (!s.ok()) {
+    return s;
+  }
+  if (!exists && args.no_mkstream) {
+    return Status::NotFound();
+  }
+
+  ParsedStreamsMetaValue parsed_streams_meta_value(&meta_value);
+  StreamID last_id = parsed_streams_meta_value.LastID();
+  if (!args.id_given) {
+    *id = StreamID(NowMillis(), 0);
+    if (*id <= last_id) {
+      *id = last_id;
+      if (!id->Incr()) {
+        return Status::Corruption("ERR The stream has exhausted the last possible ID, unable to add more items");
+      }
+    }
+  } else if (!args.seq_given) {
+    if (args.id.ms < last_id.ms || (args.id.ms == last_id.ms && last_id.seq == UINT64_MAX)) {
+      return Status::Corruption(kStreamIDTooSmall);
+    }
+    *id = StreamID(args.id.ms, args.id.ms == last_id.ms ? last_id.seq + 1 : 0);
+  } else {
+    if (args.id == StreamID::Min()) {
+      return Status::Corruption("ERR The ID specified in XADD must be greater than 0-0");
+    }
+    if (args.id <= last_id) {
+      return Status::Corruption(kStreamIDTooSmall);
+    }
+    *id = args.id;
+  }
+
+  uint64_t version = parsed_streams_meta_value.Version();
+  int64_t trimmed = 0;
+  bool keep_new = true;
+  s = TrimStream(batch.get(), key, version, parsed_streams_meta_value.Length(), args.trim, id, &trimmed, &keep_new);
+  if (!s.ok()) {
+    return s;
+  }
+
+  int32_t delta = (keep_new ? 1 : 0) - static_cast<int32_t>(trimmed);
+  if (!parsed_streams_meta_value.CheckModifyCount(delta)) {
+    return Status::Corruption("ERR stream size overflow");
+  }
+  if (keep_new) {
+    BaseDataKey entry_key(key, version, StreamEntryData(*id));
+    BaseDataValue entry_value(EncodeStreamFieldValues(field_values));
+    batch->Put(kStreamsDataCF, entry_key.Encode(), entry_value.Encode());
+  }
+  parsed_streams_meta_value.ModifyCount(delta);
+  parsed_streams_meta_value.SetLastID(*id);
+  BaseMetaKey base_meta_key(key);
+  batch->Put(kMetaCF, base_meta_key.Encode(), meta_value);
+  s = batch->Commit();
+  UpdateSpecificKeyStatistics(DataType::kStreams, key.ToString(), trimmed);
+  return s;
+}
+
+Status Redis::XLen(const Slice& key, uint64_t* len) {
+  *len = 0;
+  std::string meta_value;
+  Status s = GetStreamMeta(key, default_read_options_, &meta_value);
+  if (s.ok()) {
+    ParsedStreamsMetaValue parsed_streams_meta_value(&meta_value);
+    *len = parsed_streams_meta_value.Length();
+  }
+  return s;
+}
+
+Status Redis::XLastID(const Slice& key, StreamID* id) {
+  *id = StreamID();
+  std::string meta_value;
+  Status s = GetStreamMeta(key, default_read_options_, &meta_value);
+  if (s.ok()) {
+    ParsedStreamsMetaValue parsed_streams_meta_value(&meta_value);
+    *id = parsed_streams_meta_value.LastID();
+  }
+  return s;
+}
+
+Status Redis::XRange(const Slice& key, const StreamID& start, const StreamID& end, int64_t count,
+                     std::vector<StreamEntry>* entries) {
+  rocksdb::ReadOptions read_options;
+  const rocksdb::Snapshot* snapshot;
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
+  read_options.snapshot = snapshot;
+
+  std::string meta_value;
+  Status s = GetStreamMeta(key, read_options, &meta_value);
+  if (!s.ok() || count == 0 || end < start) {
+    return s;
+  }
+  ParsedStreamsMetaValue parsed_streams_meta_value(&meta_value);
+  uint64_t version = parsed_streams_meta_value.Version();
+
+  BaseDataKey entry_prefix_key(key, version, Slice(&kStreamEntryTag, 1));
+  std::string prefix = entry_prefix_key.EncodeSeekKey().ToString();
+  BaseDataKey start_key(key, version, StreamEntryData(start));
+  KeyStatisticsDurationGuard guard(this, DataType::kStreams, key.ToString());
+  std::unique_ptr<rocksdb::Iterator> iter(db_->NewIterator(read_options, handles_[kStreamsDataCF]));
+  for (iter->Seek(start_key.Encode()); iter->Valid() && iter->key().starts_with(prefix); iter->Next()) {
+    ParsedBaseDataKey parsed_data_key(iter->key());
+    StreamID id = DecodeStreamID(parsed_data_key.Data());
+    if (end < id) {
+      break;
+    }
+    ParsedBaseDataValue parsed_value(iter->value());
+    StreamEntry entry{id, {}};
+    DecodeStreamFieldValues(parsed_value.UserValue(), &entry.field_values);
+    entries->push_back(std::move(entry));
+    if (count > 0 && static_cast<int64_t>(entries->size()) == count) {
+      break;
+    }
+  }
+  return iter->status();
+}
+
+Status Redis::XRevRange(const Slice& key, const StreamID& end, const StreamID& start, int64_t count,
+                        std::vector<StreamEntry>* entries) {
+  rocksdb::ReadOptions read_options;
+  const rocksdb::Snapshot* snapshot;
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
+  read_options.snapshot = snapshot;
+
+  std::string meta_value;
+  Status s = GetStreamMeta(key, read_options, &meta_value);
+  if (!s.ok() || count == 0 || end < start) {
+    return s;
+  }
+  ParsedStreamsMetaValue parsed_streams_meta_value(&meta_value);
+  uint64_t version = parsed_streams_meta_value.Version();
+
+  BaseDataKey entry_prefix_key(key, version, Slice(&kStreamEntryTag, 1));
+  std::string prefix = entry_prefix_key.EncodeSeekKey().ToString();
+  BaseDataKey end_key(key, version, StreamEntryData(end));
+  KeyStatisticsDurationGuard guard(this, DataType::kStreams, key.ToString());
+  std::unique_ptr<rocksdb::Iterator> iter(db_->NewIterator(read_options, handles_[kStreamsDataCF]));
+  for (iter->SeekForPrev(end_key.Encode()); iter->Valid() && iter->key().starts_with(prefix); iter->Prev()) {
+    ParsedBaseDataKey parsed_data_key(iter->key());
+    StreamID id = DecodeStreamID(parsed_data_key.Data());
+    if (id < start) {
+      break;
+    }
+    ParsedBaseDataValue parsed_value(iter->value());
+    StreamEntry entry{id, {}};
+    DecodeStreamFieldValues(parsed_value.UserValue(), &entry.field_values);
+    entries->push_back(std::move(entry));
+    if (count > 0 && static_cast<int64_t>(entries->size()) == count) {
+      break;
+    }
+  }
+  return iter->status();
+}
+
+Status Redis::XDel(const Slice& key, const std::vector<StreamID>& ids, int64_t* ret) {
+  *ret = 0;
+  auto batch = Batch::CreateBatch(this);
+  ScopeRecordLock l(lock_mgr_, key);
+
+  std::string meta_value;
+  Status s = GetStreamMeta(key, default_read_options_, &meta_value);
+  if (!s.ok()) {
+    return s;
+  }
+  ParsedStreamsMetaValue parsed_streams_meta_value(&meta_value);
+  uint64_t version = parsed_streams_meta_value.Version();
+
+  int32_t del_cnt = 0;
+  std::string entry_value;
+  std::unordered_set<std::string> deleted;
+  for (const auto& id : ids) {
+    BaseDataKey entry_key(key, version, StreamEntryData(id));
+    std::string encoded = entry_key.Encode().ToString();
+    if (deleted.count(encoded) != 0) {
+      continue;
+    }
+    s = db_->Get(default_read_options_, handles_[kStreamsDataCF], encoded, &entry_value);
+    if (s.ok()) {
+      batch->Delete(kStreamsDataCF, encoded);
+      deleted.insert(std::move(encoded));
+      del_cnt++;
+    } else if (!s.IsNotFound()) {
+      return s;
+    }
+  }
+  if (del_cnt == 0) {
+    return Status::OK();
+  }
+
+  parsed_streams_meta_value.ModifyCount(-del_cnt);
+  BaseMetaKey base_meta_key(key);
+  batch->Put(kMetaCF, base_meta_key.Encode(), meta_value);
+  s = batch->Commit();
+  if (s.ok()) {
+    *ret = del_cnt;
+  }
+  UpdateSpecificKeyStatistics(DataType::kStreams, key.ToString(), del_cnt);
+  return s;
+}
+
+Status Redis::XTrim(const Slice& key, const StreamTrimArgs& args, int64_t* ret) {
+  *ret = 0;
+  auto batch = Batch::CreateBatch(this);
+  ScopeRecordLock l(lock_mgr_, key);
+
+  std::string meta_value;
+  Status s = GetStreamMeta(key, default_read_options_, &meta_value);
+  if (!s.ok()) {
+    return s;
+  }
+  ParsedStreamsMetaValue parsed_streams_meta_value(&meta_value);
+  int64_t trimmed = 0;
+  bool keep_new = true;
+  s = TrimStream(batch.get(), key, parsed_streams_meta_value.Version(), parsed_streams_meta_value.Length(), args,
+                 nullptr, &trimmed, &keep_new);
+  if (!s.ok() || trimmed == 0) {
+    return s;
+  }
+
+  parsed_streams_meta_value.ModifyCount(-static_cast<int32_t>(trimmed));
+  BaseMetaKey base_meta_key(key);
+  batch->Put(kMetaCF, base_meta_key.Encode(), meta_value);
+  s = batch->Commit();
+  if (s.ok()) {
+    *ret = trimmed;
+  }
+  UpdateSpecificKeyStatistics(DataType::kStreams, key.ToString(), trimmed);
+  return s;
+}
+
+Status Redis::XGroupCreate(const Slice& key, const Slice& group, const StreamID& id, bool last_id, bool mkstream) {
+  auto batch = Batch::CreateBatch(this);
+  ScopeRecordLock l(lock_mgr_, key);
+
+  std::string meta_value;
+  bool exists = false;
+  Status s = PrepareStreamMeta(key, &meta_value, &exists);
+  if (!s.ok()) {
+    return s;
+  }
+  if (!exists && !mkstream) {
+    return Status::Corruption(kStreamGroupKeyMissing);
+  }
+
+  ParsedStreamsMetaValue parsed_streams_meta_value(&meta_value);
+  BaseDataKey group_key(key, parsed_streams_meta_value.Version(), StreamGroupData(group));
+  std::string group_value;
+  s = db_->Get(default_read_options_, handles_[kStreamsDataCF], group_key.Encode(), &group_value);
+  if (s.ok()) {
+    return Status::Corruption("BUSYGROUP Consumer Group name already exists");
+  } else if (!s.IsNotFound()) {
+    return s;
+  }
+  if (!parsed_streams_meta_value.CheckModifyCount(1)) {
+    return Status::Corruption("ERR stream size overflow");
+  }
+
+  std::string last_delivered;
+  EncodeStreamID(last_id ? parsed_streams_meta_value.LastID() : id, &last_delivered);
+  BaseDataValue internal_value(last_delivered);
+  batch->Put(kStreamsDataCF, group_key.Encode(), internal_value.Encode());
+  parsed_streams_meta_value.ModifyCount(1);
+  parsed_streams_meta_value.SetGroups(parsed_streams_meta_value.Groups() + 1);
+  BaseMetaKey base_meta_key(key);
+  batch->Put(kMetaCF, base_meta_key.Encode(), meta_value);
+  return batch->Commit();
+}
+
+Status Redis::XGroupSetID(const Slice& key, const Slice& group, const StreamID& id, bool last_id) {
+  auto batch = Batch::CreateBatch(this);
+  ScopeRecordLock l(lock_mgr_, key);
+
+  std::string meta_value;
+  Status s = GetStreamMeta(key, default_read_options_, &meta_value);
+  if (s.IsNotFound()) {
+    return Status::Corruption(kStreamGroupKeyMissing);
+  } else if (!s.ok()) {
+    return s;
+  }
+
+  ParsedStreamsMetaValue parsed_streams_meta_value(&meta_value);
+  BaseDataKey group_key(key, parsed_streams_meta_value.Version(), StreamGroupData(group));
+  std::string group_value;
+  s = db_->Get(default_read_options_, handles_[kStreamsDataCF], group_key.Encode(), &group_value);
+  if (s.IsNotFound()) {
+    return NoGroupError(key, group);
+  } else if (!s.ok()) {
+    return s;
+  }
+
+  std::string last_delivered;
+  EncodeStreamID(last_id ? parsed_streams_meta_value.LastID() : id, &last_delivered);
+  BaseDataValue internal_value(last_delivered);
+  batch->Put(kStreamsDataCF, group_key.Encode(), internal_value.Encode());
+  return batch->Commit();
+}
+
+Status Redis::XGroupDestroy(const Slice& key, const Slice& group, int32_t* ret) {
+  *ret = 0;
+  auto batch = Batch::CreateBatch(this);
+  ScopeRecordLock l(lock_mgr_, key);
+
+  std::string meta_value;
+  Status s = GetStreamMeta(key, default_read_options_, &meta_value);
+  if (s.IsNotFound()) {
+    return Status::Corruption(kStreamGroupKeyMissing);
+  } else if (!s.ok()) {
+    return s;
+  }
+
+  ParsedStreamsMetaValue parsed_streams_meta_value(&meta_value);
+  uint64_t version = parsed_streams_meta_value.Version();
+  BaseDataKey group_key(key, version, StreamGroupData(group));
+  std::string group_value;
+  s = db_->Get(default_read_options_, handles_[kStreamsDataCF], group_key.Encode(), &group_value);
+  if (s.IsNotFound()) {
+    return Status::OK();
+  } else if (!s.ok()) {
+    return s;
+  }
+
+  // the pending entries of the group go with it, they all share the group prefix
+  BaseDataKey pending_begin_key(key, version, StreamPendingData(group));
+  BaseDataKey pending_end_key(key, version, StreamPendingData(group) + std::string(kStreamIDLength + 1, '\xff'));
+  batch->Delete(kStreamsDataCF, group_key.Encode());
+  batch->DeleteRange(kStreamsDataCF, pending_begin_key.Encode(), pending_end_key.Encode());
+  parsed_streams_meta_value.ModifyCount(-1);
+  parsed_streams_meta_value.SetGroups(parsed_streams_meta_value.Groups() - 1);
+  BaseMetaKey base_meta_key(key);
+  batch->Put(kMetaCF, base_meta_key.Encode(), meta_value);
+  s = batch->Commit();
+  if (s.ok()) {
+    *ret = 1;
+  }
+  return s;
+}
+
+Status Redis::XReadGroup(const Slice& key, const Slice& group, const Slice& consumer, const StreamID& start,
+                         bool new_entries, int64_t count, bool noack, std::vector<StreamEntry>* entries) {
+  auto batch = Batch::CreateBatch(this);
+  ScopeRecordLock l(lock_mgr_, key);
+
+  std::string meta_value;
+  Status s = GetStreamMeta(key, default_read_options_, &meta_value);
+  if (s.IsNotFound()) {
+    return NoGroupError(key, group);
+  } else if (!s.ok()) {
+    return s;
+  }
+
+  ParsedStreamsMetaValue parsed_streams_meta_value(&meta_value);
+  uint64_t version = parsed_streams_meta_value.Version();
+  BaseDataKey group_key(key, version, StreamGroupData(group));
+  std::string group_value;
+  s = db_->Get(default_read_options_, handles_[kStreamsDataCF], group_key.Encode(), &group_value);
+  if (s.IsNotFound()) {
+    return NoGroupError(key, group);
+  } else if (!s.ok()) {
+    return s;
+  }
+
+  KeyStatisticsDurationGuard guard(this, DataType::kStreams, key.ToString());
+  std::unique_ptr<rocksdb::Iterator> iter(db_->NewIterator(default_read_options_, handles_[kStreamsDataCF]));
+  if (!new_entries) {
+    // the history of the consumer: its pending entries after start
+    std::string prefix_data = StreamPendingData(group);
+    BaseDataKey pending_prefix_key(key, version, prefix_data);
+    std::string prefix = pending_prefix_key.EncodeSeekKey().ToString();
+    StreamID from = start;
+    if (!from.Incr()) {
+      return Status::OK();
+    }
+    BaseDataKey from_key(key, version, StreamPendingData(group, &from));
+    std::string entry_value;
+    for (iter->Seek(from_key.Encode()); iter->Valid() && iter->key().starts_with(prefix); iter->Next()) {
+      ParsedBaseDataValue parsed_value(iter->value());
+      StreamPendingEntry pending;
+      if (!DecodeStreamPendingValue(parsed_value.UserValue(), &pending) || consumer.compare(pending.consumer) != 0) {
+        continue;
+      }
+      ParsedBaseDataKey parsed_data_key(iter->key());
+      StreamEntry entry{DecodeStreamID(parsed_data_key.Data()), {}};
+      BaseDataKey entry_key(key, version, StreamEntryData(entry.id));
+      s = db_->Get(default_read_options_, handles_[kStreamsDataCF], entry_key.Encode(), &entry_value);
+      if (s.ok()) {
+        ParsedBaseDataValue parsed_entry_value(&entry_value);
+        DecodeStreamFieldValues(parsed_entry_value.UserValue(), &entry.field_values);
+      } else if (!s.IsNotFound()) {
+        return s;
+      }
+      entries->push_back(std::move(entry));
+      if (count > 0 && static_cast<int64_t>(entries->size()) == count) {
+        break;
+      }
+    }
+    return iter->status();
+  }
+
+  // new entries: everything after the last delivered ID of the group
+  ParsedBaseDataValue parsed_group_value(&group_value);
+  StreamID last_delivered = DecodeStreamID(parsed_group_value.UserValue());
+  StreamID from = last_delivered;
+  if (!from.Incr()) {
+    return Status::OK();
+  }
+  BaseDataKey entry_prefix_key(key, version, Slice(&kStreamEntryTag, 1));
+  std::string prefix = entry_prefix_key.EncodeSeekKey().ToString();
+  BaseDataKey from_key(key, version, StreamEntryData(from));
+  for (iter->Seek(from_key.Encode()); iter->Valid() && iter->key().starts_with(prefix); iter->Next()) {
+    ParsedBaseDataKey parsed_data_key(iter->key());
+    ParsedBaseDataValue parsed_value(iter->value());
+    StreamEntry entry{DecodeStreamID(parsed_data_key.Data()), {}};
+    DecodeStreamFieldValues(parsed_value.UserValue(), &entry.field_values);
+    entries->push_back(std::move(entry));
+    if (count > 0 && static_cast<int64_t>(entries->size()) == count) {
+      break;
+    }
+  }
+  if (!iter->status().ok()) {
+    return iter->status();
+  }
+  if (entries->empty()) {
+    return Status::OK();
+  }
+
+  std::string delivered;
+  EncodeStreamID(entries->back().id, &delivered);
+  BaseDataValue group_internal_value(delivered);
+  batch->Put(kStreamsDataCF, group_key.Encode(), group_internal_value.Encode());
+  if (!noack) {
+    StreamPendingEntry pending;
+    pending.consumer = consumer.ToString();
+    pending.delivery_time = NowMillis();
+    pending.delivery_count = 1;
+    std::string pending_value = EncodeStreamPendingValue(pending);
+    for (const auto& entry : *entries) {
+      BaseDataKey pending_key(key, version, StreamPendingData(group, &entry.id));
+      BaseDataValue pending_internal_value(pending_value);
+      batch->Put(kStreamsDataCF, pending_key.Encode(), pending_internal_value.Encode());
+    }
+  }
+  return batch->Commit();
+}
+
+Status Redis::XAck(const Slice& key, const Slice& group, const std::vector<StreamID>& ids, int64_t* ret) {
+  *ret = 0;
+  auto batch = Batch::CreateBatch(this);
+  ScopeRecordLock l(lock_mgr_, key);
+
+  std::string meta_value;
+  Status s = GetStreamMeta(key, default_read_options_, &meta_value);
+  if (!s.ok()) {
+    return s;
+  }
+  ParsedStreamsMetaValue parsed_streams_meta_value(&meta_value);
+  uint64_t version = parsed_streams_meta_value.Version();
+
+  int64_t acked = 0;
+  std::string pending_value;
+  std::unordered_set<std::string> acked_keys;
+  for (const auto& id : ids) {
+    BaseDataKey pending_key(key, version, StreamPendingData(group, &id));
+    std::string encoded = pending_key.Encode().ToString();
+    if (acked_keys.count(encoded) != 0) {
+      continue;
+    }
+    s = db_->Get(default_read_options_, handles_[kStreamsDataCF], encoded, &pending_value);
+    if (s.ok()) {
+      batch->Delete(kStreamsDataCF, encoded);
+      acked_keys.insert(std::move(encoded));
+      acked++;
+    } else if (!s.IsNotFound()) {
+      return s;
+    }
+  }
+  if (acked == 0) {
+    return Status::OK();
+  }
+  s = batch->Commit();
+  if (s.ok()) {
+    *ret = acked;
+  }
+  return s;
+}
+
+Status Redis::XPending(const Slice& key, const Slice& group, const StreamID& start, const StreamID& end, int64_t count,
+                       const Slice& consumer, std::vector<StreamPendingEntry>* pendings) {
+  rocksdb::ReadOptions read_options;
+  const rocksdb::Snapshot* snapshot;
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
+  read_options.snapshot = snapshot;
+
+  std::string meta_value;
+  Status s = GetStreamMeta(key, read_options, &meta_value);
+  if (s.IsNotFound()) {
+    return NoGroupError(key, group);
+  } else if (!s.ok()) {
+    return s;
+  }
+  ParsedStreamsMetaValue parsed_streams_meta_value(&meta_value);
+  uint64_t version = parsed_streams_meta_value.Version();
+  BaseDataKey group_key(key, version, StreamGroupData(group));
+  std::string group_value;
+  s = db_->Get(read_options, handles_[kStreamsDataCF], group_key.Encode(), &group_value);
+  if (s.IsNotFound()) {
+    return NoGroupError(key, group);
+  } else if (!s.ok() || count == 0 || end < start) {
+    return s;
+  }
+
+  BaseDataKey pending_prefix_key(key, version, StreamPendingData(group));
+  std::string prefix = pending_prefix_key.EncodeSeekKey().ToString();
+  BaseDataKey start_key(key, version, StreamPendingData(group, &start));
+  std::unique_ptr<rocksdb::Iterator> iter(db_->NewIterator(read_options, handles_[kStreamsDataCF]));
+  for (iter->Seek(start_key.Encode()); iter->Valid() && iter->key().starts_with(prefix); iter->Next()) {
+    ParsedBaseDataKey parsed_data_key(iter->key());
+    StreamPendingEntry pending;
+    pending.id = DecodeStreamID(parsed_data_key.Data());
+    if (end < pending.id) {
+      break;
+    }
+    ParsedBaseDataValue parsed_value(iter->value());
+    if (!DecodeStreamPendingValue(parsed_value.UserValue(), &pending) ||
+        (!consumer.empty() && consumer.compare(pending.consumer) != 0)) {
+      continue;
+    }
+    pendings->push_back(std::move(pending));
+    if (count > 0 && static_cast<int64_t>(pendings->size()) == count) {
+      break;
+    }
+  }
+  return iter->status();
+}
+
+}  //  namespace storage
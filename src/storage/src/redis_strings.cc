@@ -25,7 +25,7 @@ Status Redis::ScanStringsKeyNum(KeyInfo* key_info) {
 
   rocksdb::ReadOptions iterator_options;
   const rocksdb::Snapshot* snapshot;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   iterator_options.snapshot = snapshot;
   iterator_options.fill_cache = false;
 
@@ -323,6 +323,42 @@ Status Redis::Get(const Slice& key, std::string* value) {
   return s;
 }
 
+Status Redis::MGet(const std::vector<std::string>& keys, std::vector<ValueStatus>* vss) {
+  vss->clear();
+  vss->reserve(keys.size());
+
+  std::vector<std::string> encoded_keys;
+  encoded_keys.reserve(keys.size());
+  for (const auto& key : keys) {
+    BaseKey base_key(key);
+    encoded_keys.emplace_back(base_key.Encode().ToString());
+  }
+  std::vector<Slice> key_slices(encoded_keys.begin(), encoded_keys.end());
+  std::vector<rocksdb::PinnableSlice> values(keys.size());
+  std::vector<Status> statuses(keys.size());
+  db_->MultiGet(default_read_options_, db_->DefaultColumnFamily(), keys.size(), key_slices.data(), values.data(),
+                statuses.data());
+
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (statuses[i].ok()) {
+      std::string value = values[i].ToString();
+      if (IsStale(value) || !ExpectedMetaValue(DataType::kStrings, value)) {
+        vss->push_back({std::string(), Status::NotFound()});
+      } else {
+        ParsedStringsValue parsed_strings_value(&value);
+        parsed_strings_value.StripSuffix();
+        vss->push_back({std::move(value), Status::OK()});
+      }
+    } else if (statuses[i].IsNotFound()) {
+      vss->push_back({std::string(), Status::NotFound()});
+    } else {
+      vss->clear();
+      return statuses[i];
+    }
+  }
+  return Status::OK();
+}
+
 Status Redis::GetWithTTL(const Slice& key, std::string* value, int64_t* ttl) {
   value->clear();
   BaseKey base_key(key);
@@ -1182,7 +1218,7 @@ Status Redis::StringsRenamenx(const Slice& key, Redis* new_inst, const Slice& ne
 void Redis::ScanStrings() {
   rocksdb::ReadOptions iterator_options;
   const rocksdb::Snapshot* snapshot;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   iterator_options.snapshot = snapshot;
   iterator_options.fill_cache = false;
   auto current_time = static_cast<int32_t>(time(nullptr));
@@ -1215,7 +1251,8 @@ Status Redis::Exists(const Slice& key) {
     switch (type) {
       case DataType::kHashes:
       case DataType::kSets:
-      case DataType::kZSets: {
+      case DataType::kZSets:
+      case DataType::kStreams: {
         ParsedHashesMetaValue parsed_base_meta_value(&meta_value);
         if (parsed_base_meta_value.IsStale() || parsed_base_meta_value.Count() <= 0) {
           s = Status::NotFound();
@@ -1260,7 +1297,8 @@ Status Redis::Del(const Slice& key) {
       }
       case DataType::kHashes:
       case DataType::kSets:
-      case DataType::kZSets: {
+      case DataType::kZSets:
+      case DataType::kStreams: {
         if (IsStale(meta_value)) {
           return Status ::NotFound();
         }
@@ -1311,7 +1349,8 @@ Status Redis::Expire(const Slice& key, int64_t timestamp) {
       }
       case DataType::kHashes:
       case DataType::kSets:
-      case DataType::kZSets: {
+      case DataType::kZSets:
+      case DataType::kStreams: {
         ParsedHashesMetaValue parsed_base_meta_value(&meta_value);
         if (parsed_base_meta_value.IsStale() || parsed_base_meta_value.Count() <= 0) {
           s = Status::NotFound();
@@ -1368,7 +1407,8 @@ Status Redis::Expireat(const Slice& key, int64_t timestamp) {
       }
       case DataType::kHashes:
       case DataType::kSets:
-      case DataType::kZSets: {
+      case DataType::kZSets:
+      case DataType::kStreams: {
         ParsedHashesMetaValue parsed_base_meta_value(&meta_value);
         if (parsed_base_meta_value.IsStale() || parsed_base_meta_value.Count() <= 0) {
           s = Status::NotFound();
@@ -1428,7 +1468,8 @@ Status Redis::Persist(const Slice& key) {
       }
       case DataType::kHashes:
       case DataType::kSets:
-      case DataType::kZSets: {
+      case DataType::kZSets:
+      case DataType::kStreams: {
         ParsedHashesMetaValue parsed_base_meta_value(&meta_value);
         if (parsed_base_meta_value.IsStale() || parsed_base_meta_value.Count() <= 0) {
           s = Status::NotFound();
@@ -1492,7 +1533,8 @@ Status Redis::TTL(const Slice& key, int64_t* timestamp) {
       }
       case DataType::kHashes:
       case DataType::kSets:
-      case DataType::kZSets: {
+      case DataType::kZSets:
+      case DataType::kStreams: {
         ParsedHashesMetaValue parsed_base_meta_value(&meta_value);
         if (parsed_base_meta_value.IsStale() || parsed_base_meta_value.Count() <= 0) {
           *timestamp = -2;
@@ -1538,7 +1580,7 @@ Status Redis::TTL(const Slice& key, int64_t* timestamp) {
 Status Redis::PKPatternMatchDel(const std::string& pattern, int32_t* ret) {
   rocksdb::ReadOptions iterator_options;
   const rocksdb::Snapshot* snapshot;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   iterator_options.snapshot = snapshot;
   iterator_options.fill_cache = false;
 
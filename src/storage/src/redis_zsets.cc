@@ -30,7 +30,7 @@ Status Redis::ScanZsetsKeyNum(KeyInfo* key_info) {
 
   rocksdb::ReadOptions iterator_options;
   const rocksdb::Snapshot* snapshot;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   iterator_options.snapshot = snapshot;
   iterator_options.fill_cache = false;
 
@@ -196,7 +196,7 @@ Status Redis::ZAdd(const Slice& key, const std::vector<ScoreMember>& score_membe
     ParsedZSetsMetaValue parsed_zsets_meta_value(&meta_value);
     if (parsed_zsets_meta_value.IsStale() || parsed_zsets_meta_value.Count() == 0) {
       valid = false;
-      version = parsed_zsets_meta_value.InitialMetaValue();
+      version = parsed_zsets_meta_value.InitialMetaValue(compact_format_);
     } else {
       valid = true;
       version = parsed_zsets_meta_value.Version();
@@ -252,7 +252,7 @@ Status Redis::ZAdd(const Slice& key, const std::vector<ScoreMember>& score_membe
     char buf[4];
     EncodeFixed32(buf, filtered_score_members.size());
     ZSetsMetaValue zsets_meta_value(DataType::kZSets, Slice(buf, sizeof(int32_t)));
-    version = zsets_meta_value.UpdateVersion();
+    version = zsets_meta_value.UpdateVersion(compact_format_);
     batch->Put(kMetaCF, base_meta_key.Encode(), zsets_meta_value.Encode());
     for (const auto& sm : filtered_score_members) {
       ZSetsMemberKey zsets_member_key(key, version, sm.member);
@@ -302,7 +302,7 @@ Status Redis::ZCount(const Slice& key, double min, double max, bool left_close,
   const rocksdb::Snapshot* snapshot = nullptr;
 
   std::string meta_value;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   read_options.snapshot = snapshot;
 
   BaseMetaKey base_meta_key(key);
@@ -323,7 +323,7 @@ Status Redis::ZCount(const Slice& key, double min, double max, bool left_close,
       ScoreMember score_member;
       ZSetsScoreKey zsets_score_key(key, version, min, Slice());
       KeyStatisticsDurationGuard guard(this, DataType::kZSets, key.ToString());
-      rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[kZsetsScoreCF]);
+      auto iter = NewPooledIterator(kZsetsScoreCF, read_options.snapshot);
       for (iter->Seek(zsets_score_key.Encode()); iter->Valid() && cur_index <= stop_index; iter->Next(), ++cur_index) {
         bool left_pass = false;
         bool right_pass = false;
@@ -348,7 +348,6 @@ Status Redis::ZCount(const Slice& key, double min, double max, bool left_close,
           break;
         }
       }
-      delete iter;
       *ret = cnt;
     }
   }
@@ -380,7 +379,7 @@ Status Redis::ZIncrby(const Slice& key, const Slice& member, double increment, d
   if (s.ok()) {
     ParsedZSetsMetaValue parsed_zsets_meta_value(&meta_value);
     if (parsed_zsets_meta_value.IsStale() || parsed_zsets_meta_value.Count() == 0) {
-      version = parsed_zsets_meta_value.InitialMetaValue();
+      version = parsed_zsets_meta_value.InitialMetaValue(compact_format_);
     } else {
       version = parsed_zsets_meta_value.Version();
     }
@@ -413,7 +412,7 @@ Status Redis::ZIncrby(const Slice& key, const Slice& member, double increment, d
     char buf[4];
     EncodeFixed32(buf, 1);
     ZSetsMetaValue zsets_meta_value(DataType::kZSets, Slice(buf, 4));
-    version = zsets_meta_value.UpdateVersion();
+    version = zsets_meta_value.UpdateVersion(compact_format_);
     batch.Put(handles_[kMetaCF], base_meta_key.Encode(), zsets_meta_value.Encode());
     score = increment;
   } else {
@@ -440,7 +439,7 @@ Status Redis::ZRange(const Slice& key, int32_t start, int32_t stop, std::vector<
   const rocksdb::Snapshot* snapshot = nullptr;
 
   std::string meta_value;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   read_options.snapshot = snapshot;
 
   BaseMetaKey base_meta_key(key);
@@ -469,7 +468,7 @@ Status Redis::ZRange(const Slice& key, int32_t start, int32_t stop, std::vector<
 
       ZSetsScoreKey zsets_score_key(key, version, std::numeric_limits<double>::lowest(), Slice());
       KeyStatisticsDurationGuard guard(this, DataType::kZSets, key.ToString());
-      rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[kZsetsScoreCF]);
+      auto iter = NewPooledIterator(kZsetsScoreCF, read_options.snapshot);
       for (iter->Seek(zsets_score_key.Encode()); iter->Valid() && cur_index <= stop_index; iter->Next(), ++cur_index) {
         if (cur_index >= start_index) {
           ParsedZSetsScoreKey parsed_zsets_score_key(iter->key());
@@ -478,7 +477,6 @@ Status Redis::ZRange(const Slice& key, int32_t start, int32_t stop, std::vector<
           score_members->push_back(score_member);
         }
       }
-      delete iter;
     }
   }
   return s;
@@ -491,7 +489,7 @@ Status Redis::ZRangeWithTTL(const Slice& key, int32_t start, int32_t stop, std::
   const rocksdb::Snapshot* snapshot = nullptr;
 
   std::string meta_value;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   read_options.snapshot = snapshot;
 
   BaseMetaKey base_meta_key(key);
@@ -528,7 +526,7 @@ Status Redis::ZRangeWithTTL(const Slice& key, int32_t start, int32_t stop, std::
       ScoreMember score_member;
       ZSetsScoreKey zsets_score_key(key, version, std::numeric_limits<double>::lowest(), Slice());
       KeyStatisticsDurationGuard guard(this, DataType::kZSets, key.ToString());
-      rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[kZsetsScoreCF]);
+      auto iter = NewPooledIterator(kZsetsScoreCF, read_options.snapshot);
       for (iter->Seek(zsets_score_key.Encode()); iter->Valid() && cur_index <= stop_index; iter->Next(), ++cur_index) {
         if (cur_index >= start_index) {
           ParsedZSetsScoreKey parsed_zsets_score_key(iter->key());
@@ -537,7 +535,6 @@ Status Redis::ZRangeWithTTL(const Slice& key, int32_t start, int32_t stop, std::
           score_members->push_back(score_member);
         }
       }
-      delete iter;
     }
   }
   return s;
@@ -550,7 +547,7 @@ Status Redis::ZRangebyscore(const Slice& key, double min, double max, bool left_
   const rocksdb::Snapshot* snapshot = nullptr;
 
   std::string meta_value;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   read_options.snapshot = snapshot;
 
   BaseMetaKey base_meta_key(key);
@@ -571,7 +568,7 @@ Status Redis::ZRangebyscore(const Slice& key, double min, double max, bool left_
       ScoreMember score_member;
       ZSetsScoreKey zsets_score_key(key, version, min, Slice());
       KeyStatisticsDurationGuard guard(this, DataType::kZSets, key.ToString());
-      rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[kZsetsScoreCF]);
+      auto iter = NewPooledIterator(kZsetsScoreCF, read_options.snapshot);
       for (iter->Seek(zsets_score_key.Encode()); iter->Valid() && index <= stop_index; iter->Next(), ++index) {
         bool left_pass = false;
         bool right_pass = false;
@@ -607,7 +604,6 @@ Status Redis::ZRangebyscore(const Slice& key, double min, double max, bool left_
           break;
         }
       }
-      delete iter;
     }
   }
   return s;
@@ -619,7 +615,7 @@ Status Redis::ZRank(const Slice& key, const Slice& member, int32_t* rank) {
   const rocksdb::Snapshot* snapshot = nullptr;
 
   std::string meta_value;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   read_options.snapshot = snapshot;
 
   BaseMetaKey base_meta_key(key);
@@ -640,7 +636,7 @@ Status Redis::ZRank(const Slice& key, const Slice& member, int32_t* rank) {
       ScoreMember score_member;
       ZSetsScoreKey zsets_score_key(key, version, std::numeric_limits<double>::lowest(), Slice());
       KeyStatisticsDurationGuard guard(this, DataType::kZSets, key.ToString());
-      rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[kZsetsScoreCF]);
+      auto iter = NewPooledIterator(kZsetsScoreCF, read_options.snapshot);
       for (iter->Seek(zsets_score_key.Encode()); iter->Valid() && index <= stop_index; iter->Next(), ++index) {
         ParsedZSetsScoreKey parsed_zsets_score_key(iter->key());
         if (parsed_zsets_score_key.member().compare(member) == 0) {
@@ -648,7 +644,6 @@ Status Redis::ZRank(const Slice& key, const Slice& member, int32_t* rank) {
           break;
         }
       }
-      delete iter;
       if (found) {
         *rank = index;
         return Status::OK();
@@ -861,7 +856,7 @@ Status Redis::ZRevrange(const Slice& key, int32_t start, int32_t stop, std::vect
   const rocksdb::Snapshot* snapshot = nullptr;
 
   std::string meta_value;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   read_options.snapshot = snapshot;
 
   BaseMetaKey base_meta_key(key);
@@ -888,7 +883,7 @@ Status Redis::ZRevrange(const Slice& key, int32_t start, int32_t stop, std::vect
       ScoreMember score_member;
       ZSetsScoreKey zsets_score_key(key, version, std::numeric_limits<double>::max(), Slice());
       KeyStatisticsDurationGuard guard(this, DataType::kZSets, key.ToString());
-      rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[kZsetsScoreCF]);
+      auto iter = NewPooledIterator(kZsetsScoreCF, read_options.snapshot);
       for (iter->SeekForPrev(zsets_score_key.Encode()); iter->Valid() && cur_index >= start_index;
            iter->Prev(), --cur_index) {
         if (cur_index <= stop_index) {
@@ -898,7 +893,6 @@ Status Redis::ZRevrange(const Slice& key, int32_t start, int32_t stop, std::vect
           score_members->push_back(score_member);
         }
       }
-      delete iter;
     }
   }
   return s;
@@ -911,7 +905,7 @@ Status Redis::ZRevrangebyscore(const Slice& key, double min, double max, bool le
   const rocksdb::Snapshot* snapshot = nullptr;
 
   std::string meta_value;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   read_options.snapshot = snapshot;
 
   BaseMetaKey base_meta_key(key);
@@ -931,7 +925,7 @@ Status Redis::ZRevrangebyscore(const Slice& key, double min, double max, bool le
       ScoreMember score_member;
       ZSetsScoreKey zsets_score_key(key, version, std::nextafter(max, std::numeric_limits<double>::max()), Slice());
       KeyStatisticsDurationGuard guard(this, DataType::kZSets, key.ToString());
-      rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[kZsetsScoreCF]);
+      auto iter = NewPooledIterator(kZsetsScoreCF, read_options.snapshot);
       for (iter->SeekForPrev(zsets_score_key.Encode()); iter->Valid() && left > 0; iter->Prev(), --left) {
         bool left_pass = false;
         bool right_pass = false;
@@ -967,7 +961,6 @@ Status Redis::ZRevrangebyscore(const Slice& key, double min, double max, bool le
           break;
         }
       }
-      delete iter;
     }
   }
   return s;
@@ -979,7 +972,7 @@ Status Redis::ZRevrank(const Slice& key, const Slice& member, int32_t* rank) {
   const rocksdb::Snapshot* snapshot = nullptr;
 
   std::string meta_value;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   read_options.snapshot = snapshot;
 
   BaseMetaKey base_meta_key(key);
@@ -999,7 +992,7 @@ Status Redis::ZRevrank(const Slice& key, const Slice& member, int32_t* rank) {
       uint64_t version = parsed_zsets_meta_value.Version();
       ZSetsScoreKey zsets_score_key(key, version, std::numeric_limits<double>::max(), Slice());
       KeyStatisticsDurationGuard guard(this, DataType::kZSets, key.ToString());
-      rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[kZsetsScoreCF]);
+      auto iter = NewPooledIterator(kZsetsScoreCF, read_options.snapshot);
       for (iter->SeekForPrev(zsets_score_key.Encode()); iter->Valid() && left >= 0; iter->Prev(), --left, ++rev_index) {
         ParsedZSetsScoreKey parsed_zsets_score_key(iter->key());
         if (parsed_zsets_score_key.member().compare(member) == 0) {
@@ -1007,7 +1000,6 @@ Status Redis::ZRevrank(const Slice& key, const Slice& member, int32_t* rank) {
           break;
         }
       }
-      delete iter;
       if (found) {
         *rank = rev_index;
       } else {
@@ -1020,12 +1012,10 @@ Status Redis::ZRevrank(const Slice& key, const Slice& member, int32_t* rank) {
 
 Status Redis::ZScore(const Slice& key, const Slice& member, double* score) {
   *score = 0;
+  // meta and one member, consistent without a snapshot like HGet
   rocksdb::ReadOptions read_options;
-  const rocksdb::Snapshot* snapshot = nullptr;
 
   std::string meta_value;
-  ScopeSnapshot ss(db_, &snapshot);
-  read_options.snapshot = snapshot;
 
   BaseMetaKey base_meta_key(key);
   Status s = db_->Get(read_options, handles_[kMetaCF], base_meta_key.Encode(), &meta_value);
@@ -1062,7 +1052,7 @@ Status Redis::ZGetAll(const Slice& key, double weight, std::map<std::string, dou
   Status s;
   rocksdb::ReadOptions read_options;
   const rocksdb::Snapshot* snapshot = nullptr;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   read_options.snapshot = snapshot;
   std::string meta_value;
 
@@ -1082,14 +1072,13 @@ Status Redis::ZGetAll(const Slice& key, double weight, std::map<std::string, dou
       uint64_t version = parsed_zsets_meta_value.Version();
       ZSetsScoreKey zsets_score_key(key.ToString(), version, std::numeric_limits<double>::lowest(), Slice());
       Slice seek_key = zsets_score_key.Encode();
-      rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[kZsetsScoreCF]);
+      auto iter = NewPooledIterator(kZsetsScoreCF, read_options.snapshot);
       for (iter->Seek(seek_key); iter->Valid() && cur_index <= stop_index; iter->Next(), ++cur_index) {
         ParsedZSetsScoreKey parsed_zsets_score_key(iter->key());
         double score = parsed_zsets_score_key.score() * weight;
         score = (score == -0.0) ? 0 : score;
         value_to_dest->insert(std::make_pair(parsed_zsets_score_key.member().ToString(), score));
       }
-      delete iter;
     }
   }
   return s;
@@ -1107,7 +1096,7 @@ Status Redis::ZUnionstore(const Slice& destination, const std::vector<std::strin
   uint64_t version;
   std::string meta_value;
   ScoreMember sm;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   read_options.snapshot = snapshot;
   ScopeRecordLock l(lock_mgr_, destination);
   std::map<std::string, double> member_score_map;
@@ -1169,7 +1158,7 @@ Status Redis::ZUnionstore(const Slice& destination, const std::vector<std::strin
   if (s.ok() && ExpectedMetaValue(DataType::kZSets, meta_value)) {
     ParsedZSetsMetaValue parsed_zsets_meta_value(&meta_value);
     statistic = parsed_zsets_meta_value.Count();
-    version = parsed_zsets_meta_value.InitialMetaValue();
+    version = parsed_zsets_meta_value.InitialMetaValue(compact_format_);
     if (!parsed_zsets_meta_value.check_set_count(static_cast<int32_t>(member_score_map.size()))) {
       return Status::InvalidArgument("zset size overflow");
     }
@@ -1179,7 +1168,7 @@ Status Redis::ZUnionstore(const Slice& destination, const std::vector<std::strin
     char buf[4];
     EncodeFixed32(buf, member_score_map.size());
     ZSetsMetaValue zsets_meta_value(DataType::kZSets, Slice(buf, sizeof(int32_t)));
-    version = zsets_meta_value.UpdateVersion();
+    version = zsets_meta_value.UpdateVersion(compact_format_);
     batch->Put(kMetaCF, base_destination.Encode(), zsets_meta_value.Encode());
   }
 
@@ -1215,7 +1204,7 @@ Status Redis::ZInterstore(const Slice& destination, const std::vector<std::strin
   auto batch = Batch::CreateBatch(this);
   rocksdb::ReadOptions read_options;
   const rocksdb::Snapshot* snapshot = nullptr;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   read_options.snapshot = snapshot;
   ScopeRecordLock l(lock_mgr_, destination);
 
@@ -1312,7 +1301,7 @@ Status Redis::ZInterstore(const Slice& destination, const std::vector<std::strin
   if (s.ok() && ExpectedMetaValue(DataType::kZSets, meta_value)) {
     ParsedZSetsMetaValue parsed_zsets_meta_value(&meta_value);
     statistic = parsed_zsets_meta_value.Count();
-    version = parsed_zsets_meta_value.InitialMetaValue();
+    version = parsed_zsets_meta_value.InitialMetaValue(compact_format_);
     if (!parsed_zsets_meta_value.check_set_count(static_cast<int32_t>(final_score_members.size()))) {
       return Status::InvalidArgument("zset size overflow");
     }
@@ -1322,7 +1311,7 @@ Status Redis::ZInterstore(const Slice& destination, const std::vector<std::strin
     char buf[4];
     EncodeFixed32(buf, final_score_members.size());
     ZSetsMetaValue zsets_meta_value(DataType::kZSets, Slice(buf, sizeof(int32_t)));
-    version = zsets_meta_value.UpdateVersion();
+    version = zsets_meta_value.UpdateVersion(compact_format_);
     batch->Put(kMetaCF, base_destination.Encode(), zsets_meta_value.Encode());
   }
   char score_buf[8];
@@ -1352,7 +1341,7 @@ Status Redis::ZRangebylex(const Slice& key, const Slice& min, const Slice& max,
   const rocksdb::Snapshot* snapshot = nullptr;
 
   std::string meta_value;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   read_options.snapshot = snapshot;
 
   bool left_no_limit = min.compare("-") == 0;
@@ -1374,7 +1363,7 @@ Status Redis::ZRangebylex(const Slice& key, const Slice& min, const Slice& max,
       int32_t stop_index = parsed_zsets_meta_value.Count() - 1;
       ZSetsMemberKey zsets_member_key(key, version, Slice());
       KeyStatisticsDurationGuard guard(this, DataType::kZSets, key.ToString());
-      rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[kZsetsDataCF]);
+      auto iter = NewPooledIterator(kZsetsDataCF, read_options.snapshot);
       for (iter->Seek(zsets_member_key.Encode()); iter->Valid() && cur_index <= stop_index; iter->Next(), ++cur_index) {
         bool left_pass = false;
         bool right_pass = false;
@@ -1393,7 +1382,6 @@ Status Redis::ZRangebylex(const Slice& key, const Slice& min, const Slice& max,
           break;
         }
       }
-      delete iter;
     }
   }
   return s;
@@ -1415,7 +1403,7 @@ Status Redis::ZRemrangebylex(const Slice& key, const Slice& min, const Slice& ma
   rocksdb::ReadOptions read_options;
   const rocksdb::Snapshot* snapshot = nullptr;
 
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   read_options.snapshot = snapshot;
   ScopeRecordLock l(lock_mgr_, key);
 
@@ -1502,7 +1490,7 @@ Status Redis::ZScan(const Slice& key, int64_t cursor, const std::string& pattern
   const rocksdb::Snapshot* snapshot;
 
   std::string meta_value;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   read_options.snapshot = snapshot;
 
   BaseMetaKey base_meta_key(key);
@@ -1535,7 +1523,7 @@ Status Redis::ZScan(const Slice& key, int64_t cursor, const std::string& pattern
       ZSetsMemberKey zsets_member_key(key, version, start_point);
       std::string prefix = zsets_member_prefix.EncodeSeekKey().ToString();
       KeyStatisticsDurationGuard guard(this, DataType::kZSets, key.ToString());
-      rocksdb::Iterator* iter = db_->NewIterator(read_options, handles_[kZsetsDataCF]);
+      auto iter = NewPooledIterator(kZsetsDataCF, read_options.snapshot);
       for (iter->Seek(zsets_member_key.Encode()); iter->Valid() && rest > 0 && iter->key().starts_with(prefix);
            iter->Next()) {
         ParsedZSetsMemberKey parsed_zsets_member_key(iter->key());
@@ -1558,7 +1546,6 @@ Status Redis::ZScan(const Slice& key, int64_t cursor, const std::string& pattern
       } else {
         *next_cursor = 0;
       }
-      delete iter;
     }
   } else {
     *next_cursor = 0;
@@ -1595,7 +1582,7 @@ Status Redis::ZsetsRename(const Slice& key, Redis* new_inst, const Slice& newkey
   new_inst->UpdateSpecificKeyStatistics(DataType::kZSets, newkey.ToString(), statistic);
 
   // ZsetsDel key
-  parsed_zsets_meta_value.InitialMetaValue();
+  parsed_zsets_meta_value.InitialMetaValue(compact_format_);
   s = db_->Put(default_write_options_, handles_[kMetaCF], base_meta_key.Encode(), meta_value);
   UpdateSpecificKeyStatistics(DataType::kZSets, key.ToString(), statistic);
 
@@ -1640,7 +1627,7 @@ Status Redis::ZsetsRenamenx(const Slice& key, Redis* new_inst, const Slice& newk
   new_inst->UpdateSpecificKeyStatistics(DataType::kZSets, newkey.ToString(), statistic);
 
   // ZsetsDel key
-  parsed_zsets_meta_value.InitialMetaValue();
+  parsed_zsets_meta_value.InitialMetaValue(compact_format_);
   s = db_->Put(default_write_options_, handles_[kMetaCF], base_meta_key.Encode(), meta_value);
   UpdateSpecificKeyStatistics(DataType::kZSets, key.ToString(), statistic);
 
@@ -1650,7 +1637,7 @@ Status Redis::ZsetsRenamenx(const Slice& key, Redis* new_inst, const Slice& newk
 void Redis::ScanZsets() {
   rocksdb::ReadOptions iterator_options;
   const rocksdb::Snapshot* snapshot;
-  ScopeSnapshot ss(db_, &snapshot);
+  ScopeSnapshot ss(db_, &snapshots_, &snapshot);
   iterator_options.snapshot = snapshot;
   iterator_options.fill_cache = false;
   auto current_time = static_cast<int32_t>(time(nullptr));
@@ -5,21 +5,62 @@
 
 #pragma once
 
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+
 #include "rocksdb/db.h"
 
 #include "pstd/noncopyable.h"
 
 namespace storage {
+
+// Hands one snapshot to all the readers of a DB until a write lands. Taking a
+// snapshot locks the DB mutex and links it into the snapshot list, which every
+// HGETALL or ZRANGE paid for; now the reads between two writes share one and
+// only bump a reference count. It is at the latest sequence when handed out,
+// so a read still sees every write acknowledged before it started.
+class SnapshotCache : public pstd::noncopyable {
+ public:
+  std::shared_ptr<const rocksdb::Snapshot> Get(rocksdb::DB* db) {
+    auto latest = db->GetLatestSequenceNumber();
+    {
+      std::shared_lock lock(mutex_);
+      if (snapshot_ && snapshot_->GetSequenceNumber() == latest) {
+        return snapshot_;
+      }
+    }
+    std::shared_ptr<const rocksdb::Snapshot> snapshot(db->GetSnapshot(),
+                                                      [db](const rocksdb::Snapshot* s) { db->ReleaseSnapshot(s); });
+    auto old = snapshot;  // released after the lock
+    std::lock_guard lock(mutex_);
+    snapshot_.swap(old);
+    return snapshot;
+  }
+
+  // The cached snapshot pins the data overwritten since, until the next read
+  // replaces it. Drop it before the DB closes or a compaction that should
+  // reclaim that data.
+  void Reset() {
+    std::shared_ptr<const rocksdb::Snapshot> snapshot;
+    std::lock_guard lock(mutex_);
+    snapshot_.swap(snapshot);
+  }
+
+ private:
+  std::shared_mutex mutex_;
+  std::shared_ptr<const rocksdb::Snapshot> snapshot_;
+};
+
 class ScopeSnapshot : public pstd::noncopyable {
  public:
-  ScopeSnapshot(rocksdb::DB* db, const rocksdb::Snapshot** snapshot) : db_(db), snapshot_(snapshot) {
-    *snapshot_ = db_->GetSnapshot();
+  ScopeSnapshot(rocksdb::DB* db, SnapshotCache* cache, const rocksdb::Snapshot** snapshot)
+      : snapshot_(cache->Get(db)) {
+    *snapshot = snapshot_.get();
   }
-  ~ScopeSnapshot() { db_->ReleaseSnapshot(*snapshot_); }
 
  private:
-  rocksdb::DB* const db_;
-  const rocksdb::Snapshot** snapshot_;
+  std::shared_ptr<const rocksdb::Snapshot> snapshot_;
 };
 
 }  // namespace storage
@@ -6,6 +6,7 @@
 #include <algorithm>
 #include <filesystem>
 #include <future>
+#include <limits>
 #include <string_view>
 #include <utility>
 #include <vector>
@@ -15,6 +16,7 @@
 #include "pstd/log.h"
 #include "pstd/pikiwidb_slot.h"
 #include "pstd/pstd_string.h"
+#include "rocksdb/utilities/backup_engine.h"
 #include "rocksdb/utilities/checkpoint.h"
 #include "scope_snapshot.h"
 #include "src/lru_cache.h"
@@ -142,19 +144,45 @@ static int RecursiveLinkAndCopy(const std::filesystem::path& source, const std::
 Status Storage::Open(const StorageOptions& storage_options, const std::string& db_path) {
   mkpath(db_path.c_str(), 0755);
   db_instance_num_ = storage_options.db_instance_num;
-  // Temporarily set to 100000
-  LogIndexAndSequenceCollector::max_gap_.store(storage_options.max_gap);
-  storage_options.options.write_buffer_manager =
-      std::make_shared<rocksdb::WriteBufferManager>(storage_options.mem_manager_size);
+  // the caller may share one write buffer manager across all storages
+  if (!storage_options.options.write_buffer_manager) {
+    storage_options.options.write_buffer_manager =
+        std::make_shared<rocksdb::WriteBufferManager>(storage_options.mem_manager_size);
+  }
   for (size_t index = 0; index < db_instance_num_; index++) {
     insts_.emplace_back(std::make_unique<Redis>(this, index));
-    Status s = insts_.back()->Open(storage_options, AppendSubDirectory(db_path, index));
+  }
+
+  // Opening an instance is dominated by IO (manifest replay, WAL recovery, table properties),
+  // so all of them are opened at the same time.
+  auto report = [&storage_options](size_t index, OpenStage stage) {
+    if (storage_options.open_progress_function) {
+      storage_options.open_progress_function(index, stage);
+    }
+  };
+  std::vector<std::future<Status>> results;
+  results.reserve(db_instance_num_);
+  for (size_t index = 0; index < db_instance_num_; index++) {
+    results.push_back(std::async(std::launch::async, [&, index] {
+      report(index, OpenStage::kOpening);
+      Status s = insts_[index]->Open(storage_options, AppendSubDirectory(db_path, index));
+      report(index, s.ok() ? OpenStage::kOpened : OpenStage::kFailed);
+      return s;
+    }));
+  }
+  bool failed = false;
+  for (size_t index = 0; index < db_instance_num_; index++) {
+    Status s = results[index].get();
     if (!s.ok()) {
       ERROR("open RocksDB{} failed {}", index, s.ToString());
-      return Status::IOError();
+      failed = true;
+      continue;
     }
     INFO("open RocksDB{} success!", index);
   }
+  if (failed) {
+    return Status::IOError();
+  }
 
   slot_indexer_ = std::make_unique<SlotIndexer>(db_instance_num_);
   db_id_ = storage_options.db_id;
@@ -275,6 +303,112 @@ Status Storage::LoadCheckpointInternal(const std::string& checkpoint_sub_path, c
   return Status::OK();
 }
 
+std::vector<std::future<Status>> Storage::CreateBackup(const std::string& backup_path, const BackupOptions& options) {
+  INFO("DB{} begin to back up to {}", db_id_, backup_path);
+  std::vector<std::future<Status>> result;
+  result.reserve(db_instance_num_);
+  for (int i = 0; i < db_instance_num_; ++i) {
+    auto res = std::async(std::launch::async, &Storage::CreateBackupInternal, this, backup_path, options, i);
+    result.push_back(std::move(res));
+  }
+  return result;
+}
+
+Status Storage::CreateBackupInternal(const std::string& backup_path, const BackupOptions& options, int index) {
+  auto backup_dir = AppendSubDirectory(backup_path, index);
+  rocksdb::BackupEngineOptions engine_options(backup_dir);
+  // the SSTs are named by size and checksum, those of an older backup are
+  // shared instead of copied, and every file is checked as it is copied
+  engine_options.share_table_files = true;
+  engine_options.share_files_with_checksum = true;
+  engine_options.max_background_operations = std::max(1, options.threads);
+  engine_options.backup_rate_limit = options.rate_limit;
+
+  rocksdb::BackupEngine* engine = nullptr;
+  rocksdb::Status s = rocksdb::BackupEngine::Open(engine_options, rocksdb::Env::Default(), &engine);
+  if (!s.ok()) {
+    WARN("DB{}'s RocksDB {} open backup engine on {} failed! Error: {}", db_id_, index, backup_dir, s.ToString());
+    return s;
+  }
+  std::unique_ptr<rocksdb::BackupEngine> engine_guard(engine);
+  {
+    std::lock_guard lock(backup_engines_mutex_);
+    if (backup_stopped_) {
+      return Status::Incomplete("the backup was stopped");
+    }
+    backup_engines_.push_back(engine);
+  }
+
+  rocksdb::CreateBackupOptions backup_options;
+  // the WAL files are backed up along, a flush is only needed without them
+  backup_options.flush_before_backup = insts_[index]->IsWalDisabled();
+  if (options.copied_bytes != nullptr) {
+    backup_options.progress_callback = [copied = options.copied_bytes,
+                                        step = engine_options.callback_trigger_interval_size] {
+      copied->fetch_add(step, std::memory_order_relaxed);
+    };
+  }
+  rocksdb::BackupID backup_id = 0;
+  s = engine->CreateNewBackup(backup_options, insts_[index]->GetDB(), &backup_id);
+  {
+    std::lock_guard lock(backup_engines_mutex_);
+    backup_engines_.erase(std::find(backup_engines_.begin(), backup_engines_.end(), engine));
+  }
+  if (!s.ok()) {
+    WARN("DB{}'s RocksDB {} create backup failed! Error: {}", db_id_, index, s.ToString());
+    return s;
+  }
+
+  s = engine->PurgeOldBackups(std::max<uint32_t>(1, options.keep));
+  if (!s.ok()) {
+    WARN("DB{}'s RocksDB {} purge old backups failed! Error: {}", db_id_, index, s.ToString());
+  }
+  INFO("DB{}'s RocksDB {} create backup {} in {} success!", db_id_, index, backup_id, backup_dir);
+  return Status::OK();
+}
+
+void Storage::StopBackup() {
+  std::lock_guard lock(backup_engines_mutex_);
+  backup_stopped_ = true;
+  for (auto engine : backup_engines_) {
+    engine->StopBackup();
+  }
+}
+
+std::vector<std::future<Status>> Storage::RestoreBackup(const std::string& backup_path, const std::string& db_path,
+                                                        size_t db_instance_num) {
+  INFO("Begin to restore the backup {} to {}", backup_path, db_path);
+  std::vector<std::future<Status>> result;
+  result.reserve(db_instance_num);
+  for (size_t i = 0; i < db_instance_num; ++i) {
+    auto res = std::async(std::launch::async, &Storage::RestoreBackupInternal, backup_path, db_path, i);
+    result.push_back(std::move(res));
+  }
+  return result;
+}
+
+Status Storage::RestoreBackupInternal(const std::string& backup_path, const std::string& db_path, int index) {
+  auto backup_dir = AppendSubDirectory(backup_path, index);
+  auto rocksdb_path = AppendSubDirectory(db_path, index);
+
+  rocksdb::BackupEngineReadOnly* engine = nullptr;
+  rocksdb::Status s =
+      rocksdb::BackupEngineReadOnly::Open(rocksdb::BackupEngineOptions(backup_dir), rocksdb::Env::Default(), &engine);
+  if (!s.ok()) {
+    WARN("RocksDB {} open backup engine on {} failed! Error: {}", index, backup_dir, s.ToString());
+    return s;
+  }
+  std::unique_ptr<rocksdb::BackupEngineReadOnly> engine_guard(engine);
+
+  s = engine->RestoreDBFromLatestBackup(rocksdb_path, rocksdb_path);
+  if (!s.ok()) {
+    WARN("RocksDB {} restore backup {} to {} failed! Error: {}", index, backup_dir, rocksdb_path, s.ToString());
+    return s;
+  }
+  INFO("RocksDB {} restore backup {} to {} success!", index, backup_dir, rocksdb_path);
+  return Status::OK();
+}
+
 Status Storage::LoadCursorStartKey(const DataType& dtype, int64_t cursor, char* type, std::string* start_key) {
   std::string index_key = DataTypeTag[static_cast<uint8_t>(dtype)] + std::to_string(cursor);
   std::string index_value;
@@ -302,6 +436,27 @@ std::unique_ptr<Redis>& Storage::GetDBInstance(const std::string& key) {
   return insts_[inst_index];
 }
 
+Status Storage::ForEachInstanceKeys(
+    const std::vector<std::string>& keys,
+    const std::function<Status(Redis*, const std::vector<std::string>&, const std::vector<size_t>&)>& fn) {
+  std::vector<std::vector<std::string>> inst_keys(insts_.size());
+  std::vector<std::vector<size_t>> inst_indexes(insts_.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    auto inst_index = slot_indexer_->GetInstanceID(GetSlotID(keys[i]));
+    inst_keys[inst_index].push_back(keys[i]);
+    inst_indexes[inst_index].push_back(i);
+  }
+  for (size_t i = 0; i < insts_.size(); ++i) {
+    if (inst_keys[i].empty()) {
+      continue;
+    }
+    if (Status s = fn(insts_[i].get(), inst_keys[i], inst_indexes[i]); !s.ok()) {
+      return s;
+    }
+  }
+  return Status::OK();
+}
+
 // Strings Commands
 Status Storage::Set(const Slice& key, const Slice& value) {
   auto& inst = GetDBInstance(key);
@@ -351,22 +506,20 @@ Status Storage::MSet(const std::vector<KeyValue>& kvs) {
 }
 
 Status Storage::MGet(const std::vector<std::string>& keys, std::vector<ValueStatus>* vss) {
-  vss->clear();
-  Status s;
-  for (const auto& key : keys) {
-    auto& inst = GetDBInstance(key);
-    std::string value;
-    s = inst->Get(key, &value);
-    if (s.ok()) {
-      vss->push_back({value, Status::OK()});
-    } else if (s.IsNotFound() || s.IsInvalidArgument()) {
-      vss->push_back({std::string(), Status::NotFound()});
-    } else {
+  vss->assign(keys.size(), {std::string(), Status::NotFound()});
+  return ForEachInstanceKeys(keys, [&](Redis* inst, const std::vector<std::string>& inst_keys,
+                                       const std::vector<size_t>& indexes) {
+    std::vector<ValueStatus> inst_vss;
+    Status s = inst->MGet(inst_keys, &inst_vss);
+    if (!s.ok()) {
       vss->clear();
       return s;
     }
-  }
-  return Status::OK();
+    for (size_t i = 0; i < indexes.size(); ++i) {
+      (*vss)[indexes[i]] = std::move(inst_vss[i]);
+    }
+    return Status::OK();
+  });
 }
 
 Status Storage::MGetWithTTL(const std::vector<std::string>& keys, std::vector<ValueStatus>* vss) {
@@ -556,6 +709,24 @@ Status Storage::HMGet(const Slice& key, const std::vector<std::string>& fields,
   return inst->HMGet(key, fields, vss);
 }
 
+Status Storage::HGetMultiKeys(const std::vector<std::string>& keys, const Slice& field,
+                              std::vector<ValueStatus>* vss) {
+  vss->assign(keys.size(), {std::string(), Status::NotFound()});
+  return ForEachInstanceKeys(keys, [&](Redis* inst, const std::vector<std::string>& inst_keys,
+                                       const std::vector<size_t>& indexes) {
+    std::vector<ValueStatus> inst_vss;
+    Status s = inst->HGetMultiKeys(inst_keys, field, &inst_vss);
+    if (!s.ok()) {
+      vss->clear();
+      return s;
+    }
+    for (size_t i = 0; i < indexes.size(); ++i) {
+      (*vss)[indexes[i]] = std::move(inst_vss[i]);
+    }
+    return Status::OK();
+  });
+}
+
 Status Storage::HGetall(const Slice& key, std::vector<FieldValue>* fvs) {
   auto& inst = GetDBInstance(key);
   return inst->HGetall(key, fvs);
@@ -1216,6 +1387,81 @@ Status Storage::ZScan(const Slice& key, int64_t cursor, const std::string& patte
   return inst->ZScan(key, cursor, pattern, count, score_members, next_cursor);
 }
 
+// Streams Commands
+Status Storage::XAdd(const Slice& key, const std::vector<std::string>& field_values, const StreamAddArgs& args,
+                     StreamID* id) {
+  auto& inst = GetDBInstance(key);
+  return inst->XAdd(key, field_values, args, id);
+}
+
+Status Storage::XLen(const Slice& key, uint64_t* len) {
+  auto& inst = GetDBInstance(key);
+  return inst->XLen(key, len);
+}
+
+Status Storage::XLastID(const Slice& key, StreamID* id) {
+  auto& inst = GetDBInstance(key);
+  return inst->XLastID(key, id);
+}
+
+Status Storage::XRange(const Slice& key, const StreamID& start, const StreamID& end, int64_t count,
+                       std::vector<StreamEntry>* entries) {
+  entries->clear();
+  auto& inst = GetDBInstance(key);
+  return inst->XRange(key, start, end, count, entries);
+}
+
+Status Storage::XRevRange(const Slice& key, const StreamID& end, const StreamID& start, int64_t count,
+                          std::vector<StreamEntry>* entries) {
+  entries->clear();
+  auto& inst = GetDBInstance(key);
+  return inst->XRevRange(key, end, start, count, entries);
+}
+
+Status Storage::XDel(const Slice& key, const std::vector<StreamID>& ids, int64_t* ret) {
+  auto& inst = GetDBInstance(key);
+  return inst->XDel(key, ids, ret);
+}
+
+Status Storage::XTrim(const Slice& key, const StreamTrimArgs& args, int64_t* ret) {
+  auto& inst = GetDBInstance(key);
+  return inst->XTrim(key, args, ret);
+}
+
+Status Storage::XGroupCreate(const Slice& key, const Slice& group, const StreamID& id, bool last_id, bool mkstream) {
+  auto& inst = GetDBInstance(key);
+  return inst->XGroupCreate(key, group, id, last_id, mkstream);
+}
+
+Status Storage::XGroupSetID(const Slice& key, const Slice& group, const StreamID& id, bool last_id) {
+  auto& inst = GetDBInstance(key);
+  return inst->XGroupSetID(key, group, id, last_id);
+}
+
+Status Storage::XGroupDestroy(const Slice& key, const Slice& group, int32_t* ret) {
+  auto& inst = GetDBInstance(key);
+  return inst->XGroupDestroy(key, group, ret);
+}
+
+Status Storage::XReadGroup(const Slice& key, const Slice& group, const Slice& consumer, const StreamID& start,
+                           bool new_entries, int64_t count, bool noack, std::vector<StreamEntry>* entries) {
+  entries->clear();
+  auto& inst = GetDBInstance(key);
+  return inst->XReadGroup(key, group, consumer, start, new_entries, count, noack, entries);
+}
+
+Status Storage::XAck(const Slice& key, const Slice& group, const std::vector<StreamID>& ids, int64_t* ret) {
+  auto& inst = GetDBInstance(key);
+  return inst->XAck(key, group, ids, ret);
+}
+
+Status Storage::XPending(const Slice& key, const Slice& group, const StreamID& start, const StreamID& end,
+                         int64_t count, const Slice& consumer, std::vector<StreamPendingEntry>* pendings) {
+  pendings->clear();
+  auto& inst = GetDBInstance(key);
+  return inst->XPending(key, group, start, end, count, consumer, pendings);
+}
+
 // Keys Commands
 int32_t Storage::Expire(const Slice& key, int64_t ttl) {
   auto& inst = GetDBInstance(key);
@@ -1818,6 +2064,47 @@ Status Storage::RunBGTask() {
   return Status::OK();
 }
 
+Status Storage::FlushDB() {
+  for (const auto& inst : insts_) {
+    if (auto s = inst->FlushDB(); !s.ok()) {
+      return s;
+    }
+  }
+  // the range tombstones go with a full compaction
+  return Compact(DataType::kAll, false);
+}
+
+Status Storage::ConvertToCompactFormat(int64_t* converted) {
+  ConvertCursor cursor;
+  Status s;
+  while (!cursor.done && s.ok()) {
+    s = ConvertToCompactFormat(&cursor, std::numeric_limits<size_t>::max());
+  }
+  *converted = cursor.converted;
+  return s;
+}
+
+Status Storage::ConvertToCompactFormat(ConvertCursor* cursor, size_t max_keys) {
+  while (!cursor->done && max_keys > 0) {
+    if (cursor->instance >= insts_.size()) {
+      cursor->done = true;
+      break;
+    }
+    int64_t scanned = 0;
+    auto s = insts_[cursor->instance]->ConvertToCompactFormat(&cursor->next_key, max_keys, &scanned,
+                                                              &cursor->converted);
+    cursor->scanned += scanned;
+    max_keys -= std::min(max_keys, static_cast<size_t>(scanned));
+    if (!s.ok()) {
+      return s;
+    }
+    if (cursor->next_key.empty()) {
+      ++cursor->instance;
+    }
+  }
+  return Status::OK();
+}
+
 Status Storage::Compact(const DataType& type, bool sync) {
   if (sync) {
     return DoCompactRange(type, "", "");
@@ -1988,6 +2275,69 @@ void Storage::GetRocksDBInfo(std::string& info) {
   }
 }
 
+void Storage::GetTierUsage(uint64_t* hot_bytes, uint64_t* cold_bytes) {
+  for (const auto& inst : insts_) {
+    inst->GetTierUsage(hot_bytes, cold_bytes);
+  }
+}
+
+void Storage::TrimIteratorPools() {
+  for (const auto& inst : insts_) {
+    inst->GetIteratorPool().Trim();
+  }
+}
+
+IteratorPoolStats Storage::GetIteratorPoolStats() {
+  IteratorPoolStats total;
+  for (const auto& inst : insts_) {
+    auto stats = inst->GetIteratorPool().Stats();
+    total.created += stats.created;
+    total.reused += stats.reused;
+    total.expired += stats.expired;
+    total.parked += stats.parked;
+  }
+  return total;
+}
+
+void Storage::RefreshWriteThrottle(const WriteThrottleOptions& options) {
+  for (const auto& inst : insts_) {
+    inst->GetWriteThrottle().Refresh(inst->GetDB(), inst->GetColumnFamilyHandles(), options);
+  }
+}
+
+bool Storage::WriteThrottled() const {
+  return std::any_of(insts_.begin(), insts_.end(),
+                     [](const auto& inst) { return inst->GetWriteThrottle().Throttled(); });
+}
+
+int64_t Storage::AdmitWrite(const std::vector<std::string>& keys) {
+  // an instance is asked once however many of the keys it owns
+  std::vector<bool> admitted(insts_.size(), false);
+  int64_t delay_us = 0;
+  for (const auto& key : keys) {
+    auto inst_index = slot_indexer_->GetInstanceID(GetSlotID(key));
+    if (admitted[inst_index]) {
+      continue;
+    }
+    admitted[inst_index] = true;
+    auto delay = insts_[inst_index]->GetWriteThrottle().Admit();
+    if (delay == WriteThrottle::kReject) {
+      return delay;
+    }
+    delay_us = std::max(delay_us, delay);
+  }
+  return delay_us;
+}
+
+std::vector<WriteThrottleStats> Storage::GetWriteThrottleStats() {
+  std::vector<WriteThrottleStats> stats;
+  stats.reserve(insts_.size());
+  for (const auto& inst : insts_) {
+    stats.push_back(inst->GetWriteThrottle().Stats());
+  }
+  return stats;
+}
+
 int64_t Storage::IsExist(const Slice& key, std::map<DataType, Status>* type_status) {
   int64_t type_count = 0;
   auto& inst = GetDBInstance(key);
@@ -2028,6 +2378,10 @@ Status Storage::OnBinlogWrite(const pikiwidb::Binlog& log, LogIndex log_idx) {
         assert(!entry.has_value());
         batch.Delete(inst->GetColumnFamilyHandles()[entry.cf_idx()], entry.key());
       } break;
+      case pikiwidb::OperateType::kDeleteRange: {
+        assert(entry.has_value());
+        batch.DeleteRange(inst->GetColumnFamilyHandles()[entry.cf_idx()], entry.key(), entry.value());
+      } break;
       default:
         static constexpr std::string_view msg = "Unknown operate type in binlog";
         ERROR(msg);
@@ -0,0 +1,123 @@
+//  Copyright (c) 2024-present, OpenAtom Foundation, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#ifndef SRC_STREAMS_DATA_KEY_FORMAT_H_
+#define SRC_STREAMS_DATA_KEY_FORMAT_H_
+
+#include <string>
+#include <vector>
+
+#include "pstd/pstd_coding.h"
+#include "src/coding.h"
+#include "storage/storage.h"
+#include "storage/storage_define.h"
+
+namespace storage {
+
+/*
+ * Stream records live in stream_data_cf and use the BaseDataKey layout
+ * | reserve1 | key | version | data | reserve2 |, the data part starts with a tag:
+ *
+ * entry:    | 'e' | ms 8B | seq 8B |                  value: field/value list
+ * group:    | 'g' | group name |                       value: last delivered ms 8B | seq 8B
+ * pending:  | 'p' | name len 4B | group name | ms 8B | seq 8B |
+ *                                       value: delivery time 8B | delivery count 8B | consumer
+ *
+ * IDs are big-endian so the bytewise comparator keeps entries in ID order,
+ * appends land at the tail of the key range and range reads are sequential.
+ */
+const char kStreamEntryTag = 'e';
+const char kStreamGroupTag = 'g';
+const char kStreamPendingTag = 'p';
+const size_t kStreamIDLength = 16;
+
+inline void EncodeStreamID(const StreamID& id, std::string* dst) {
+  char buf[kStreamIDLength];
+  for (int i = 0; i < 8; i++) {
+    buf[i] = static_cast<char>((id.ms >> (56 - 8 * i)) & 0xff);
+    buf[8 + i] = static_cast<char>((id.seq >> (56 - 8 * i)) & 0xff);
+  }
+  dst->append(buf, sizeof(buf));
+}
+
+// decodes the ID at the end of an entry or pending data part
+inline StreamID DecodeStreamID(const Slice& data) {
+  StreamID id;
+  const auto* ptr = reinterpret_cast<const uint8_t*>(data.data() + data.size() - kStreamIDLength);
+  for (int i = 0; i < 8; i++) {
+    id.ms = (id.ms << 8) | ptr[i];
+    id.seq = (id.seq << 8) | ptr[8 + i];
+  }
+  return id;
+}
+
+inline std::string StreamEntryData(const StreamID& id) {
+  std::string data(1, kStreamEntryTag);
+  EncodeStreamID(id, &data);
+  return data;
+}
+
+inline std::string StreamGroupData(const Slice& group) {
+  std::string data(1, kStreamGroupTag);
+  data.append(group.data(), group.size());
+  return data;
+}
+
+// without an ID this is the prefix shared by all pending records of the group
+inline std::string StreamPendingData(const Slice& group, const StreamID* id = nullptr) {
+  std::string data(1, kStreamPendingTag);
+  char buf[sizeof(uint32_t)];
+  EncodeFixed32(buf, static_cast<uint32_t>(group.size()));
+  data.append(buf, sizeof(buf));
+  data.append(group.data(), group.size());
+  if (id) {
+    EncodeStreamID(*id, &data);
+  }
+  return data;
+}
+
+inline std::string EncodeStreamFieldValues(const std::vector<std::string>& field_values) {
+  std::string value;
+  for (const auto& item : field_values) {
+    pstd::PutLengthPrefixedString(&value, item);
+  }
+  return value;
+}
+
+inline bool DecodeStreamFieldValues(const Slice& value, std::vector<std::string>* field_values) {
+  const char* ptr = value.data();
+  const char* limit = value.data() + value.size();
+  while (ptr < limit) {
+    uint32_t len = 0;
+    ptr = pstd::GetVarint32Ptr(ptr, limit, &len);
+    if (!ptr || ptr + len > limit) {
+      return false;
+    }
+    field_values->emplace_back(ptr, len);
+    ptr += len;
+  }
+  return true;
+}
+
+inline std::string EncodeStreamPendingValue(const StreamPendingEntry& pending) {
+  std::string value(2 * sizeof(uint64_t), '\0');
+  EncodeFixed64(value.data(), pending.delivery_time);
+  EncodeFixed64(value.data() + sizeof(uint64_t), pending.delivery_count);
+  value.append(pending.consumer);
+  return value;
+}
+
+inline bool DecodeStreamPendingValue(const Slice& value, StreamPendingEntry* pending) {
+  if (value.size() < 2 * sizeof(uint64_t)) {
+    return false;
+  }
+  pending->delivery_time = DecodeFixed64(value.data());
+  pending->delivery_count = DecodeFixed64(value.data() + sizeof(uint64_t));
+  pending->consumer.assign(value.data() + 2 * sizeof(uint64_t), value.size() - 2 * sizeof(uint64_t));
+  return true;
+}
+
+}  //  namespace storage
+#endif  // SRC_STREAMS_DATA_KEY_FORMAT_H_
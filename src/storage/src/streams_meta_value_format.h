@@ -0,0 +1,98 @@
+//  Copyright (c) 2024-present, OpenAtom Foundation, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#ifndef SRC_STREAMS_META_VALUE_FORMAT_H_
+#define SRC_STREAMS_META_VALUE_FORMAT_H_
+
+#include <string>
+
+#include "src/base_meta_value_format.h"
+#include "storage/storage.h"
+#include "storage/storage_define.h"
+
+namespace storage {
+
+/*
+ * | type | count | groups | last ms | last seq | version | reserve | cdate | timestamp |
+ * |  1B  |   4B  |   4B   |    8B   |    8B    |    8B   |   16B   |   8B  |     8B    |
+ *
+ * count is the number of records the stream owns in stream_data_cf, entries
+ * plus consumer groups, plus one for the stream itself. A stream left with
+ * neither entries nor groups keeps its last ID and stays until it is deleted
+ * like in Redis, while the generic meta handling that only looks at the count
+ * still sees a live key.
+ */
+const size_t kStreamMetaUserValueLength = 24;
+const int32_t kStreamSelfCount = 1;
+
+class StreamsMetaValue : public BaseMetaValue {
+ public:
+  StreamsMetaValue() : BaseMetaValue(DataType::kStreams, Slice(buf_, sizeof(buf_))) {}
+
+ private:
+  char buf_[kStreamMetaUserValueLength] = {0};
+};
+
+class ParsedStreamsMetaValue : public ParsedBaseMetaValue {
+ public:
+  // Use this constructor after rocksdb::DB::Get();
+  explicit ParsedStreamsMetaValue(std::string* internal_value_str) : ParsedBaseMetaValue(internal_value_str) {
+    DecodeStreamFields();
+  }
+
+  // Use this constructor in rocksdb::CompactionFilter::Filter();
+  explicit ParsedStreamsMetaValue(const Slice& internal_value_slice) : ParsedBaseMetaValue(internal_value_slice) {
+    DecodeStreamFields();
+  }
+
+  // Also forgets the groups and the last ID, which the base version leaves behind
+  uint64_t InitialMetaValue() {
+    SetGroups(0);
+    SetLastID(StreamID());
+    return ParsedBaseMetaValue::InitialMetaValue();
+  }
+
+  int32_t Groups() const { return groups_; }
+
+  void SetGroups(int32_t groups) {
+    groups_ = groups;
+    if (value_) {
+      EncodeFixed32(const_cast<char*>(value_->data()) + kGroupsOffset, groups_);
+    }
+  }
+
+  // number of entries, the count minus the group records and the stream itself
+  uint64_t Length() { return Count() > 0 ? static_cast<uint64_t>(Count() - groups_ - kStreamSelfCount) : 0; }
+
+  StreamID LastID() const { return last_id_; }
+
+  void SetLastID(const StreamID& id) {
+    last_id_ = id;
+    if (value_) {
+      char* dst = const_cast<char*>(value_->data()) + kLastIDOffset;
+      EncodeFixed64(dst, last_id_.ms);
+      EncodeFixed64(dst + sizeof(uint64_t), last_id_.seq);
+    }
+  }
+
+ private:
+  static const size_t kGroupsOffset = kTypeLength + sizeof(int32_t);
+  static const size_t kLastIDOffset = kGroupsOffset + sizeof(int32_t);
+
+  void DecodeStreamFields() {
+    if (user_value_.size() >= kStreamMetaUserValueLength) {
+      const char* ptr = user_value_.data() + sizeof(int32_t);
+      groups_ = static_cast<int32_t>(DecodeFixed32(ptr));
+      last_id_.ms = DecodeFixed64(ptr + sizeof(int32_t));
+      last_id_.seq = DecodeFixed64(ptr + sizeof(int32_t) + sizeof(uint64_t));
+    }
+  }
+
+  int32_t groups_ = 0;
+  StreamID last_id_;
+};
+
+}  //  namespace storage
+#endif  // SRC_STREAMS_META_VALUE_FORMAT_H_
@@ -17,12 +17,15 @@ namespace storage {
 
 class StringsFilter : public rocksdb::CompactionFilter {
  public:
-  StringsFilter() = default;
+  StringsFilter() {
+    int64_t unix_time = 0;
+    rocksdb::Env::Default()->GetCurrentTime(&unix_time);
+    cur_time_ = static_cast<int32_t>(unix_time);
+  }
+
   bool Filter(int level, const rocksdb::Slice& key, const rocksdb::Slice& value, std::string* new_value,
               bool* value_changed) const override {
-    int64_t unix_time;
-    rocksdb::Env::Default()->GetCurrentTime(&unix_time);
-    auto cur_time = static_cast<int32_t>(unix_time);
+    auto cur_time = cur_time_;
     ParsedStringsValue parsed_strings_value(value);
     TRACE("==========================START==========================");
     TRACE("[StringsFilter], key: %s, value = %s, timestamp: %llu, cur_time: %d", key.ToString().c_str(),
@@ -38,6 +41,9 @@ class StringsFilter : public rocksdb::CompactionFilter {
   }
 
   const char* Name() const override { return "StringsFilter"; }
+
+ private:
+  int32_t cur_time_ = 0;
 };
 
 class StringsFilterFactory : public rocksdb::CompactionFilterFactory {
@@ -19,8 +19,10 @@
 #include "src/base_key_format.h"
 #include "src/base_meta_value_format.h"
 #include "src/debug.h"
+#include "src/iterator_pool.h"
 #include "src/lists_meta_value_format.h"
 #include "src/mutex.h"
+#include "src/streams_meta_value_format.h"
 #include "src/strings_value_format.h"
 #include "storage/storage_define.h"
 #include "storage/util.h"
@@ -34,9 +36,7 @@ enum Direction { kForward, kReverse };
 
 class TypeIterator {
  public:
-  TypeIterator(const rocksdb::ReadOptions& options, rocksdb::DB* db, ColumnFamilyHandle* handle) {
-    raw_iter_.reset(db->NewIterator(options, handle));
-  }
+  explicit TypeIterator(PooledIterator raw_iter) : raw_iter_(std::move(raw_iter)) {}
 
   virtual ~TypeIterator() {}
 
@@ -93,7 +93,7 @@ class TypeIterator {
   virtual Status status() { return raw_iter_->status(); }
 
  protected:
-  std::unique_ptr<rocksdb::Iterator> raw_iter_;
+  PooledIterator raw_iter_;
   std::string user_key_;
   std::string user_value_;
   Direction direction_ = kForward;
@@ -108,9 +108,8 @@ class TypeIterator {
 
 class StringsIterator : public TypeIterator {
  public:
-  StringsIterator(const rocksdb::ReadOptions& options, rocksdb::DB* db, ColumnFamilyHandle* handle,
-                  const std::string& pattern)
-      : TypeIterator(options, db, handle), pattern_(pattern) {}
+  StringsIterator(PooledIterator raw_iter, const std::string& pattern)
+      : TypeIterator(std::move(raw_iter)), pattern_(pattern) {}
   ~StringsIterator() {}
 
   bool ShouldSkip() override {
@@ -139,9 +138,8 @@ class StringsIterator : public TypeIterator {
 
 class HashesIterator : public TypeIterator {
  public:
-  HashesIterator(const rocksdb::ReadOptions& options, rocksdb::DB* db, ColumnFamilyHandle* handle,
-                 const std::string& pattern)
-      : TypeIterator(options, db, handle), pattern_(pattern) {}
+  HashesIterator(PooledIterator raw_iter, const std::string& pattern)
+      : TypeIterator(std::move(raw_iter)), pattern_(pattern) {}
   ~HashesIterator() {}
 
   bool ShouldSkip() override {
@@ -169,9 +167,8 @@ class HashesIterator : public TypeIterator {
 
 class ListsIterator : public TypeIterator {
  public:
-  ListsIterator(const rocksdb::ReadOptions& options, rocksdb::DB* db, ColumnFamilyHandle* handle,
-                const std::string& pattern)
-      : TypeIterator(options, db, handle), pattern_(pattern) {}
+  ListsIterator(PooledIterator raw_iter, const std::string& pattern)
+      : TypeIterator(std::move(raw_iter)), pattern_(pattern) {}
   ~ListsIterator() {}
 
   bool ShouldSkip() override {
@@ -199,9 +196,8 @@ class ListsIterator : public TypeIterator {
 
 class SetsIterator : public TypeIterator {
  public:
-  SetsIterator(const rocksdb::ReadOptions& options, rocksdb::DB* db, ColumnFamilyHandle* handle,
-               const std::string& pattern)
-      : TypeIterator(options, db, handle), pattern_(pattern) {}
+  SetsIterator(PooledIterator raw_iter, const std::string& pattern)
+      : TypeIterator(std::move(raw_iter)), pattern_(pattern) {}
   ~SetsIterator() {}
 
   bool ShouldSkip() override {
@@ -229,9 +225,8 @@ class SetsIterator : public TypeIterator {
 
 class ZsetsIterator : public TypeIterator {
  public:
-  ZsetsIterator(const rocksdb::ReadOptions& options, rocksdb::DB* db, ColumnFamilyHandle* handle,
-                const std::string& pattern)
-      : TypeIterator(options, db, handle), pattern_(pattern) {}
+  ZsetsIterator(PooledIterator raw_iter, const std::string& pattern)
+      : TypeIterator(std::move(raw_iter)), pattern_(pattern) {}
   ~ZsetsIterator() {}
 
   bool ShouldSkip() override {
@@ -257,14 +252,42 @@ class ZsetsIterator : public TypeIterator {
   std::string pattern_;
 };
 
+class StreamsIterator : public TypeIterator {
+ public:
+  StreamsIterator(PooledIterator raw_iter, const std::string& pattern)
+      : TypeIterator(std::move(raw_iter)), pattern_(pattern) {}
+  ~StreamsIterator() {}
+
+  bool ShouldSkip() override {
+    auto type = static_cast<DataType>(static_cast<uint8_t>(raw_iter_->value()[0]));
+    if (type != DataType::kStreams) {
+      return true;
+    }
+    ParsedStreamsMetaValue parsed_meta_value(raw_iter_->value());
+    if (parsed_meta_value.IsStale() || parsed_meta_value.Count() == 0) {
+      return true;
+    }
+
+    ParsedBaseMetaKey parsed_key(raw_iter_->key().ToString());
+    if (StringMatch(pattern_.data(), pattern_.size(), parsed_key.Key().data(), parsed_key.Key().size(), 0) == 0) {
+      return true;
+    }
+    user_key_ = parsed_key.Key().ToString();
+    user_value_ = parsed_meta_value.UserValue().ToString();
+    return false;
+  }
+
+ private:
+  std::string pattern_;
+};
+
 /*
  * This iterator is used for all types of meta data needed for iteration
  */
 class AllIterator : public TypeIterator {
  public:
-  AllIterator(const rocksdb::ReadOptions& options, rocksdb::DB* db, ColumnFamilyHandle* handle,
-              const std::string& pattern)
-      : TypeIterator(options, db, handle), pattern_(pattern) {}
+  AllIterator(PooledIterator raw_iter, const std::string& pattern)
+      : TypeIterator(std::move(raw_iter)), pattern_(pattern) {}
   ~AllIterator() {}
 
   bool ShouldSkip() override {
@@ -273,7 +296,8 @@ class AllIterator : public TypeIterator {
     switch (type) {
       case DataType::kZSets:
       case DataType::kSets:
-      case DataType::kHashes: {
+      case DataType::kHashes:
+      case DataType::kStreams: {
         ParsedBaseMetaValue parsed_meta_value(raw_iter_->value());
         user_value = parsed_meta_value.UserValue().ToString();
         if (parsed_meta_value.IsStale() || parsed_meta_value.Count() == 0) {
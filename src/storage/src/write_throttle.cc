@@ -0,0 +1,125 @@
+//  Copyright (c) 2024-present, OpenAtom Foundation, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "src/write_throttle.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+
+namespace storage {
+
+// RocksDB delays at 16MB/s when DBOptions::delayed_write_rate is 0
+static constexpr uint64_t kDefaultDelayedWriteRate = 16 << 20;
+
+// how far value is from low to high, 0 below low
+static double Ratio(uint64_t value, uint64_t low, uint64_t high) {
+  if (high <= low || value <= low) {
+    return 0;
+  }
+  return std::min(1.0, static_cast<double>(value - low) / static_cast<double>(high - low));
+}
+
+uint32_t WriteThrottle::Pressure(const WriteStallMetrics& metrics) {
+  if (metrics.stopped) {
+    return 100;
+  }
+  // RocksDB slows the writes down from the slowdown trigger and stops them at the stop one
+  double pressure = Ratio(metrics.l0_files, metrics.l0_slowdown_trigger, metrics.l0_stop_trigger);
+  if (metrics.hard_pending_compaction_bytes > 0) {
+    auto soft = metrics.soft_pending_compaction_bytes < metrics.hard_pending_compaction_bytes
+                    ? metrics.soft_pending_compaction_bytes
+                    : 0;
+    pressure = std::max(
+        pressure, Ratio(metrics.pending_compaction_bytes, soft, metrics.hard_pending_compaction_bytes));
+  }
+  // it lowers the rate of a delayed DB as the backlog grows, e.g. for too many memtables
+  if (metrics.delayed_write_rate > 0 && metrics.delayed_write_rate < metrics.max_delayed_write_rate) {
+    pressure = std::max(pressure, 1.0 - static_cast<double>(metrics.delayed_write_rate) /
+                                            static_cast<double>(metrics.max_delayed_write_rate));
+  }
+  return static_cast<uint32_t>(pressure * 100);
+}
+
+void WriteThrottle::Refresh(rocksdb::DB* db, const std::vector<rocksdb::ColumnFamilyHandle*>& handles,
+                            const WriteThrottleOptions& options) {
+  uint64_t delayed_write_rate = 0;
+  uint64_t stopped = 0;
+  db->GetIntProperty(rocksdb::DB::Properties::kActualDelayedWriteRate, &delayed_write_rate);
+  db->GetIntProperty(rocksdb::DB::Properties::kIsWriteStopped, &stopped);
+  auto max_delayed_write_rate = db->GetDBOptions().delayed_write_rate;
+
+  WriteStallMetrics worst;
+  uint32_t worst_pressure = 0;
+  for (size_t i = 0; i < handles.size(); ++i) {
+    WriteStallMetrics metrics;
+    metrics.delayed_write_rate = delayed_write_rate;
+    metrics.max_delayed_write_rate = max_delayed_write_rate > 0 ? max_delayed_write_rate : kDefaultDelayedWriteRate;
+    metrics.stopped = stopped != 0;
+
+    std::string l0_files;
+    if (db->GetProperty(handles[i], rocksdb::DB::Properties::kNumFilesAtLevelPrefix + "0", &l0_files)) {
+      metrics.l0_files = std::strtoull(l0_files.c_str(), nullptr, 10);
+    }
+    db->GetIntProperty(handles[i], rocksdb::DB::Properties::kEstimatePendingCompactionBytes,
+                       &metrics.pending_compaction_bytes);
+    auto cf_options = db->GetOptions(handles[i]);
+    metrics.l0_slowdown_trigger = std::max(0, cf_options.level0_slowdown_writes_trigger);
+    metrics.l0_stop_trigger = std::max(0, cf_options.level0_stop_writes_trigger);
+    metrics.soft_pending_compaction_bytes = cf_options.soft_pending_compaction_bytes_limit;
+    metrics.hard_pending_compaction_bytes = cf_options.hard_pending_compaction_bytes_limit;
+
+    auto pressure = Pressure(metrics);
+    if (i == 0 || pressure > worst_pressure) {
+      worst = metrics;
+      worst_pressure = pressure;
+    }
+  }
+  Update(worst, options);
+}
+
+void WriteThrottle::Update(const WriteStallMetrics& metrics, const WriteThrottleOptions& options) {
+  auto pressure = options.forced_pressure >= 0 ? std::min<uint32_t>(options.forced_pressure, 100) : Pressure(metrics);
+  int64_t delay_us = 0;
+  if (!options.enabled || pressure == 0) {
+    delay_us = 0;
+  } else if (options.reject_percent > 0 && pressure >= options.reject_percent) {
+    delay_us = kReject;
+  } else {
+    // grows to max_delay_us by the rejection
+    auto full = options.reject_percent > 0 ? options.reject_percent : 100;
+    delay_us = static_cast<int64_t>(options.max_delay_us * pressure / full);
+  }
+  delay_us_.store(delay_us, std::memory_order_relaxed);
+
+  std::lock_guard lock(mutex_);
+  metrics_ = metrics;
+  pressure_ = pressure;
+}
+
+int64_t WriteThrottle::Admit() {
+  auto delay_us = delay_us_.load(std::memory_order_relaxed);
+  if (delay_us == kReject) {
+    rejected_.fetch_add(1, std::memory_order_relaxed);
+  } else if (delay_us > 0) {
+    delayed_.fetch_add(1, std::memory_order_relaxed);
+  }
+  return delay_us;
+}
+
+WriteThrottleStats WriteThrottle::Stats() const {
+  WriteThrottleStats stats;
+  {
+    std::lock_guard lock(mutex_);
+    stats.metrics = metrics_;
+    stats.pressure = pressure_;
+  }
+  stats.delay_us = delay_us_.load(std::memory_order_relaxed);
+  stats.delayed = delayed_.load(std::memory_order_relaxed);
+  stats.rejected = rejected_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+}  // namespace storage
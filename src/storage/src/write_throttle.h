@@ -0,0 +1,82 @@
+//  Copyright (c) 2024-present, OpenAtom Foundation, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "rocksdb/db.h"
+
+namespace storage {
+
+struct WriteThrottleOptions {
+  bool enabled = true;
+  uint64_t max_delay_us = 2000;  // the delay of a write just short of the rejection
+  uint32_t reject_percent = 90;  // the pressure the writes are turned away at, 0 for never
+  int32_t forced_pressure = -1;  // taken in place of the metrics when not negative, see DEBUG WRITE-PRESSURE
+};
+
+// The backlog RocksDB reports for a CF, and the limits it stalls the writes at
+struct WriteStallMetrics {
+  uint64_t l0_files = 0;
+  uint64_t l0_slowdown_trigger = 0;
+  uint64_t l0_stop_trigger = 0;
+  uint64_t pending_compaction_bytes = 0;
+  uint64_t soft_pending_compaction_bytes = 0;
+  uint64_t hard_pending_compaction_bytes = 0;
+  uint64_t delayed_write_rate = 0;      // rocksdb.actual-delayed-write-rate, 0 while RocksDB does not delay
+  uint64_t max_delayed_write_rate = 0;  // the rate RocksDB starts delaying at
+  bool stopped = false;
+};
+
+struct WriteThrottleStats {
+  WriteStallMetrics metrics;  // of the CF under the most pressure
+  uint32_t pressure = 0;      // percent
+  int64_t delay_us = 0;       // WriteThrottle::kReject while rejecting
+  uint64_t delayed = 0;
+  uint64_t rejected = 0;
+};
+
+// Turns the write backlog of a RocksDB instance into a delay per write that
+// grows with it, and into a rejection before RocksDB stops the writes. A
+// stopped write blocks its command thread until the compactions catch up, so
+// with a backlog on one instance every thread ends up waiting there; a
+// rejected one gets an error at once. Refresh() runs on a timer, Admit() on
+// every write.
+class WriteThrottle {
+ public:
+  static constexpr int64_t kReject = -1;
+
+  // 0 with no backlog, 100 once RocksDB stops the writes
+  static uint32_t Pressure(const WriteStallMetrics& metrics);
+
+  // Reads the stall metrics of every CF of db and updates with the worst one
+  void Refresh(rocksdb::DB* db, const std::vector<rocksdb::ColumnFamilyHandle*>& handles,
+               const WriteThrottleOptions& options);
+
+  void Update(const WriteStallMetrics& metrics, const WriteThrottleOptions& options);
+
+  // The microseconds a write should wait, kReject when it must be turned away
+  int64_t Admit();
+
+  // Whether the writes wait or are turned away at all, without counting one
+  bool Throttled() const { return delay_us_.load(std::memory_order_relaxed) != 0; }
+
+  WriteThrottleStats Stats() const;
+
+ private:
+  std::atomic<int64_t> delay_us_ = 0;
+  std::atomic<uint64_t> delayed_ = 0;
+  std::atomic<uint64_t> rejected_ = 0;
+
+  mutable std::mutex mutex_;
+  WriteStallMetrics metrics_;  // guarded by mutex_
+  uint32_t pressure_ = 0;      // guarded by mutex_
+};
+
+}  // namespace storage
@@ -21,7 +21,9 @@ namespace storage {
 class ZSetsScoreFilter : public rocksdb::CompactionFilter {
  public:
   ZSetsScoreFilter(rocksdb::DB* db, std::vector<rocksdb::ColumnFamilyHandle*>* handles_ptr, enum DataType type)
-      : db_(db), cf_handles_ptr_(handles_ptr), type_(type) {}
+      : db_(db), cf_handles_ptr_(handles_ptr), type_(type) {
+    rocksdb::Env::Default()->GetCurrentTime(&cur_time_);
+  }
 
   bool Filter(int level, const rocksdb::Slice& key, const rocksdb::Slice& value, std::string* new_value,
               bool* value_changed) const override {
@@ -75,13 +77,11 @@ class ZSetsScoreFilter : public rocksdb::CompactionFilter {
       return true;
     }
 
-    int64_t unix_time;
-    rocksdb::Env::Default()->GetCurrentTime(&unix_time);
-    if (cur_meta_etime_ != 0 && cur_meta_etime_ < static_cast<uint64_t>(unix_time)) {
+    if (cur_meta_etime_ != 0 && cur_meta_etime_ < static_cast<uint64_t>(cur_time_)) {
       TRACE("Drop[Timeout]");
       return true;
     }
-    if (cur_meta_version_ > parsed_zsets_score_key.Version()) {
+    if (VersionTime(cur_meta_version_) > VersionTime(parsed_zsets_score_key.Version())) {
       TRACE("Drop[score_key_version < cur_meta_version]");
       return true;
     } else {
@@ -100,6 +100,7 @@ class ZSetsScoreFilter : public rocksdb::CompactionFilter {
   mutable bool meta_not_found_ = false;
   mutable uint64_t cur_meta_version_ = 0;
   mutable uint64_t cur_meta_etime_ = 0;
+  int64_t cur_time_ = 0;
   enum DataType type_ = DataType::kNones;
 };
 
@@ -209,7 +209,8 @@ TEST_F(FlushOldestCFTest, SimpleTest) {
   {
     //  type    kv            kv         hash        hash                 hash
     // entry  [1:1] -> ... [10:10]  -> [11:11]  -> [12:13]  -> ...  -> [30:49]
-    auto cur_par = rocksdb->GetCollector().GetList().begin();
+    auto list = rocksdb->GetCollector().GetList();
+    auto cur_par = list.begin();
     auto logindex = 1;
     auto seq = 1;
     for (int i = 1; i <= 10; i++) {
@@ -55,8 +55,8 @@ TEST(HashesFilterTest, FilterTest) {
   std::string new_value = "";
 
   /*************** TEST META FILTER ***************/
-  HashesMetaFilter* hashes_meta_filter = new HashesMetaFilter();
-  ASSERT_TRUE(hashes_meta_filter != nullptr);
+  // the filter takes the time once, as a compaction started after each sleep
+  std::unique_ptr<HashesMetaFilter> hashes_meta_filter;
 
   // Timeout timestamp is not set, but it's an empty hash table.
   storage::EncodeFixed32(str, 0);
@@ -67,6 +67,7 @@ TEST(HashesFilterTest, FilterTest) {
   tmf_meta_value1.UpdateVersion();
 
   std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+  hashes_meta_filter = std::make_unique<HashesMetaFilter>();
   BaseMetaKey filter_test_key("FILTER_TEST_KEY");
   filter_result =
       hashes_meta_filter->Filter(0, filter_test_key.Encode(), tmf_meta_value1.Encode(), &new_value, &value_changed);
@@ -79,6 +80,7 @@ TEST(HashesFilterTest, FilterTest) {
   HashesMetaValue tmf_meta_value2(DataType::kHashes, std::string(str, sizeof(int32_t)));
   tmf_meta_value2.UpdateVersion();
   std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+  hashes_meta_filter = std::make_unique<HashesMetaFilter>();
   filter_result =
       hashes_meta_filter->Filter(0, filter_test_key.Encode(), tmf_meta_value2.Encode(), &new_value, &value_changed);
   ASSERT_EQ(filter_result, false);
@@ -89,6 +91,7 @@ TEST(HashesFilterTest, FilterTest) {
   tmf_meta_value3.UpdateVersion();
   tmf_meta_value3.SetRelativeTimestamp(3);
   std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+  hashes_meta_filter = std::make_unique<HashesMetaFilter>();
   filter_result =
       hashes_meta_filter->Filter(0, filter_test_key.Encode(), tmf_meta_value3.Encode(), &new_value, &value_changed);
   ASSERT_EQ(filter_result, false);
@@ -99,10 +102,10 @@ TEST(HashesFilterTest, FilterTest) {
   tmf_meta_value4.UpdateVersion();
   tmf_meta_value4.SetRelativeTimestamp(1);
   std::this_thread::sleep_for(std::chrono::milliseconds(2000));
+  hashes_meta_filter = std::make_unique<HashesMetaFilter>();
   filter_result =
       hashes_meta_filter->Filter(0, filter_test_key.Encode(), tmf_meta_value4.Encode(), &new_value, &value_changed);
   ASSERT_EQ(filter_result, true);
-  delete hashes_meta_filter;
 
   /*************** TEST DATA FILTER ***************/
 
@@ -140,8 +143,6 @@ TEST(HashesFilterTest, FilterTest) {
   delete hashes_data_filter2;
 
   // timeout timestamp is set, already timeout.
-  HashesDataFilter* hashes_data_filter3 = new HashesDataFilter(meta_db, &handles, DataType::kHashes);
-  ASSERT_TRUE(hashes_data_filter3 != nullptr);
   storage::EncodeFixed32(str, 1);
   HashesMetaValue tdf_meta_value3(DataType::kHashes, std::string(str, sizeof(int32_t)));
   version = tdf_meta_value3.UpdateVersion();
@@ -149,6 +150,8 @@ TEST(HashesFilterTest, FilterTest) {
   s = meta_db->Put(rocksdb::WriteOptions(), handles[0], filter_test_key.Encode(), tdf_meta_value3.Encode());
   ASSERT_TRUE(s.ok());
   std::this_thread::sleep_for(std::chrono::milliseconds(2000));
+  HashesDataFilter* hashes_data_filter3 = new HashesDataFilter(meta_db, &handles, DataType::kHashes);
+  ASSERT_TRUE(hashes_data_filter3 != nullptr);
   HashesDataKey tdf_data_key3("FILTER_TEST_KEY", version, "FILTER_TEST_FIELD");
   filter_result =
       hashes_data_filter3->Filter(0, tdf_data_key3.Encode(), "FILTER_TEST_VALUE", &new_value, &value_changed);
@@ -6,6 +6,7 @@
 #include <dirent.h>
 #include <gtest/gtest.h>
 #include <unistd.h>
+#include <chrono>
 #include <iostream>
 #include <iterator>
 #include <thread>
@@ -734,6 +735,40 @@ TEST_F(HashesTest, HMGetTest) {
   ASSERT_EQ(vss[2].value, "");
 }
 
+// HGetMultiKeys
+TEST_F(HashesTest, HGetMultiKeysTest) {
+  int32_t ret = 0;
+  std::vector<storage::ValueStatus> vss;
+
+  s = db.HSet("HGETMULTI_KEY1", "TEST_FIELD", "TEST_VALUE1", &ret);
+  ASSERT_TRUE(s.ok());
+  s = db.HSet("HGETMULTI_KEY2", "OTHER_FIELD", "TEST_VALUE2", &ret);
+  ASSERT_TRUE(s.ok());
+  s = db.HSet("HGETMULTI_KEY3", "TEST_FIELD", "TEST_VALUE3", &ret);
+  ASSERT_TRUE(s.ok());
+  s = db.HSet("HGETMULTI_KEY4", "TEST_FIELD", "TEST_VALUE4", &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(make_expired(&db, "HGETMULTI_KEY4"));
+  s = db.Set("HGETMULTI_STRING_KEY", "TEST_VALUE");
+  ASSERT_TRUE(s.ok());
+
+  std::vector<std::string> keys{"HGETMULTI_KEY1", "HGETMULTI_KEY2", "HGETMULTI_KEY3",
+                                "HGETMULTI_KEY4", "HGETMULTI_STRING_KEY", "HGETMULTI_NOT_EXIST_KEY"};
+  s = db.HGetMultiKeys(keys, "TEST_FIELD", &vss);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(vss.size(), 6);
+
+  ASSERT_TRUE(vss[0].status.ok());
+  ASSERT_EQ(vss[0].value, "TEST_VALUE1");
+  ASSERT_TRUE(vss[1].status.IsNotFound());
+  ASSERT_EQ(vss[1].value, "");
+  ASSERT_TRUE(vss[2].status.ok());
+  ASSERT_EQ(vss[2].value, "TEST_VALUE3");
+  ASSERT_TRUE(vss[3].status.IsNotFound());
+  ASSERT_TRUE(vss[4].status.IsNotFound());
+  ASSERT_TRUE(vss[5].status.IsNotFound());
+}
+
 // HMSet
 TEST_F(HashesTest, HMSetTest) {
   int32_t ret = 0;
@@ -2440,6 +2475,168 @@ TEST_F(HashesTest, PKHRScanRangeTest) {
   ASSERT_EQ(next_field, "i");
 }
 
+// The reads between two writes share one snapshot, a write must still be seen by the next read
+TEST_F(HashesTest, SharedSnapshotTest) {
+  int32_t ret = 0;
+  s = db.HSet("SHARED_SNAPSHOT_KEY", "f1", "v1", &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(field_value_match(&db, "SHARED_SNAPSHOT_KEY", {{"f1", "v1"}}));
+  ASSERT_TRUE(field_value_match(&db, "SHARED_SNAPSHOT_KEY", {{"f1", "v1"}}));
+
+  s = db.HSet("SHARED_SNAPSHOT_KEY", "f2", "v2", &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(field_value_match(&db, "SHARED_SNAPSHOT_KEY", {{"f1", "v1"}, {"f2", "v2"}}));
+
+  s = db.HDel("SHARED_SNAPSHOT_KEY", {"f1"}, &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(ret, 1);
+  ASSERT_TRUE(field_value_match(&db, "SHARED_SNAPSHOT_KEY", {{"f2", "v2"}}));
+  std::vector<ValueStatus> vss;
+  s = db.HMGet("SHARED_SNAPSHOT_KEY", {"f1", "f2"}, &vss);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(vss[0].status.IsNotFound());
+  ASSERT_EQ(vss[1].value, "v2");
+}
+
+TEST_F(HashesTest, ConvertFormatTest) {
+  int32_t ret = 0;
+  std::vector<FieldValue> fvs{{"f1", "v1"}, {"f2", std::string(64, 'x')}, {"f3", ""}};
+  s = db.HMSet("CONVERT_FORMAT_KEY", fvs);
+  ASSERT_TRUE(s.ok());
+
+  int64_t converted = 0;
+  s = db.ConvertToCompactFormat(&converted);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(converted, 1);
+  ASSERT_TRUE(field_value_match(&db, "CONVERT_FORMAT_KEY", fvs));
+
+  // the fields added later go in the compact format too
+  s = db.HSet("CONVERT_FORMAT_KEY", "f4", "v4", &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(ret, 1);
+  s = db.HDel("CONVERT_FORMAT_KEY", {"f1"}, &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(ret, 1);
+  ASSERT_TRUE(field_value_match(&db, "CONVERT_FORMAT_KEY", {{"f2", std::string(64, 'x')}, {"f3", ""}, {"f4", "v4"}}));
+  s = db.HLen("CONVERT_FORMAT_KEY", &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(ret, 3);
+
+  // nothing left to convert, and the old version is gone after a compaction
+  s = db.ConvertToCompactFormat(&converted);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(converted, 0);
+  s = db.Compact(DataType::kAll, true);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(field_value_match(&db, "CONVERT_FORMAT_KEY", {{"f2", std::string(64, 'x')}, {"f3", ""}, {"f4", "v4"}}));
+}
+
+TEST_F(HashesTest, ConvertFormatCursorTest) {
+  // more fields than one batch of the conversion holds
+  std::vector<FieldValue> fvs;
+  for (int i = 0; i < 3000; i++) {
+    fvs.push_back({"field" + std::to_string(i), "value" + std::to_string(i)});
+  }
+  s = db.HMSet("CONVERT_CURSOR_KEY1", fvs);
+  ASSERT_TRUE(s.ok());
+  s = db.HMSet("CONVERT_CURSOR_KEY2", {{"f1", "v1"}});
+  ASSERT_TRUE(s.ok());
+  s = db.HMSet("CONVERT_CURSOR_KEY3", {{"f1", "v1"}});
+  ASSERT_TRUE(s.ok());
+
+  // a key per step
+  ConvertCursor cursor;
+  int steps = 0;
+  while (!cursor.done) {
+    s = db.ConvertToCompactFormat(&cursor, 1);
+    ASSERT_TRUE(s.ok());
+    ASSERT_LE(cursor.scanned, ++steps);
+  }
+  ASSERT_EQ(cursor.scanned, 3);
+  ASSERT_EQ(cursor.converted, 3);
+  ASSERT_TRUE(field_value_match(&db, "CONVERT_CURSOR_KEY1", fvs));
+  ASSERT_TRUE(field_value_match(&db, "CONVERT_CURSOR_KEY3", {{"f1", "v1"}}));
+  int32_t ret = 0;
+  s = db.HLen("CONVERT_CURSOR_KEY1", &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(ret, 3000);
+
+  // a cursor done stays done
+  s = db.ConvertToCompactFormat(&cursor, 1);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(cursor.converted, 3);
+}
+
+TEST_F(HashesTest, IteratorPoolTest) {
+  int32_t ret = 0;
+  s = db.HSet("ITERATOR_POOL_KEY", "f1", "v1", &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(field_value_match(&db, "ITERATOR_POOL_KEY", {{"f1", "v1"}}));
+  auto before = db.GetIteratorPoolStats();
+
+  // the parked iterator is refreshed to the new write
+  s = db.HSet("ITERATOR_POOL_KEY", "f2", "v2", &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(field_value_match(&db, "ITERATOR_POOL_KEY", {{"f1", "v1"}, {"f2", "v2"}}));
+  auto after = db.GetIteratorPoolStats();
+  ASSERT_EQ(after.created, before.created);
+  ASSERT_EQ(after.reused, before.reused + 1);
+  ASSERT_GE(after.parked, 1);
+
+  // and dropped once trimmed past its idle time
+  std::this_thread::sleep_for(std::chrono::milliseconds(options.iterator_max_idle_ms + 10));
+  db.TrimIteratorPools();
+  ASSERT_EQ(db.GetIteratorPoolStats().parked, 0);
+  ASSERT_TRUE(field_value_match(&db, "ITERATOR_POOL_KEY", {{"f1", "v1"}, {"f2", "v2"}}));
+  ASSERT_EQ(db.GetIteratorPoolStats().created, after.created + 1);
+}
+
+// HGET throughput of 64 threads, run it with --gtest_also_run_disabled_tests
+TEST_F(HashesTest, DISABLED_HGetBenchmark) {
+  const int kThreads = 64;
+  const int kFields = 1000;
+  const int kOpsPerThread = 100000;
+  int32_t ret = 0;
+  for (int i = 0; i < kFields; i++) {
+    db.HSet("HGET_BENCH_KEY", "field" + std::to_string(i), "value" + std::to_string(i), &ret);
+  }
+
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([this, t] {
+      std::string value;
+      for (int i = 0; i < kOpsPerThread; i++) {
+        db.HGet("HGET_BENCH_KEY", "field" + std::to_string((t + i) % kFields), &value);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::cout << "HGET " << kThreads << " threads: " << static_cast<int64_t>(kThreads * kOpsPerThread / seconds)
+            << " ops/sec" << std::endl;
+
+  // HGETALL still takes a snapshot, shared while nothing is written
+  start = std::chrono::steady_clock::now();
+  threads.clear();
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([this] {
+      std::vector<FieldValue> fvs;
+      for (int i = 0; i < kOpsPerThread / 100; i++) {
+        db.HGetall("HGET_BENCH_KEY", &fvs);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::cout << "HGETALL " << kThreads << " threads: "
+            << static_cast<int64_t>(kThreads * (kOpsPerThread / 100) / seconds) << " ops/sec" << std::endl;
+}
+
 int main(int argc, char** argv) {
   if (!pstd::FileExists("./log")) {
     pstd::CreatePath("./log");
@@ -9,6 +9,7 @@
 
 #include "pstd/env.h"
 #include "pstd/log.h"
+#include "src/redis.h"
 #include "storage/storage.h"
 #include "storage/util.h"
 
@@ -5195,6 +5196,71 @@ TEST_F(KeysTest, TTLTest) {
   ttl_ret = db.TTL("TTL_KEY");
 }
 
+// FlushDB Test
+TEST_F(KeysTest, FlushDBTest) {
+  int32_t ret = 0;
+  uint64_t len = 0;
+  // the versions are in seconds, start at a new second so the keys are created
+  // again within the one they were flushed in
+  auto now = std::chrono::system_clock::now();
+  std::this_thread::sleep_until(std::chrono::ceil<std::chrono::seconds>(now));
+
+  s = db.Set("FLUSHDB_STRING", "VALUE");
+  ASSERT_TRUE(s.ok());
+  s = db.HSet("FLUSHDB_HASH", "FIELD", "VALUE", &ret);
+  ASSERT_TRUE(s.ok());
+  s = db.SAdd("FLUSHDB_SET", {"MEMBER"}, &ret);
+  ASSERT_TRUE(s.ok());
+  s = db.RPush("FLUSHDB_LIST", {"A", "B", "C"}, &len);
+  ASSERT_TRUE(s.ok());
+  s = db.ZAdd("FLUSHDB_ZSET", {{1, "MEMBER"}, {3, "THIRD"}}, &ret);
+  ASSERT_TRUE(s.ok());
+
+  s = db.FlushDB();
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(db.Exists({"FLUSHDB_STRING", "FLUSHDB_HASH", "FLUSHDB_SET", "FLUSHDB_LIST", "FLUSHDB_ZSET"}), 0);
+  // the score entries are gone too, a zset created again after a restart meets none of them
+  auto& redis = db.GetDBInstance(std::string("FLUSHDB_ZSET"));
+  std::unique_ptr<rocksdb::Iterator> score_iter(
+      redis->GetDB()->NewIterator(rocksdb::ReadOptions(), redis->GetColumnFamilyHandles()[storage::kZsetsScoreCF]));
+  score_iter->SeekToFirst();
+  ASSERT_FALSE(score_iter->Valid());
+  score_iter.reset();
+
+  // a key created again must not see the entries of the flushed one
+  s = db.RPush("FLUSHDB_LIST", {"D"}, &len);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(len, 1);
+  std::vector<std::string> elements;
+  s = db.LRange("FLUSHDB_LIST", 0, -1, &elements);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(elements, std::vector<std::string>{"D"});
+
+  s = db.ZAdd("FLUSHDB_ZSET", {{2, "OTHER"}}, &ret);
+  ASSERT_TRUE(s.ok());
+  std::vector<storage::ScoreMember> score_members;
+  s = db.ZRange("FLUSHDB_ZSET", 0, -1, &score_members);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(score_members.size(), 1);
+  ASSERT_EQ(score_members[0].member, "OTHER");
+  score_members.clear();
+  s = db.ZRangebyscore("FLUSHDB_ZSET", 0, 10, true, true, &score_members);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(score_members.size(), 1);
+  ASSERT_EQ(score_members[0].member, "OTHER");
+
+  std::string value;
+  s = db.HGet("FLUSHDB_HASH", "FIELD", &value);
+  ASSERT_TRUE(s.IsNotFound());
+  s = db.HSet("FLUSHDB_HASH", "OTHER", "VALUE", &ret);
+  ASSERT_TRUE(s.ok());
+  std::vector<storage::FieldValue> fvs;
+  s = db.HGetall("FLUSHDB_HASH", &fvs);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(fvs.size(), 1);
+  ASSERT_EQ(fvs[0].field, "OTHER");
+}
+
 int main(int argc, char** argv) {
   if (!pstd::FileExists("./log")) {
     pstd::CreatePath("./log");
@@ -9,6 +9,7 @@
 #include <gtest/gtest.h>
 
 #include "src/base_data_key_format.h"
+#include "src/base_data_value_format.h"
 #include "src/base_key_format.h"
 #include "src/coding.h"
 #include "src/debug.h"
@@ -57,6 +58,61 @@ TEST(KVFormatTest, BaseDataKeyFormat) {
   ASSERT_EQ(pbmk.Version(), version);
 }
 
+TEST(KVFormatTest, CompactDataKeyFormat) {
+  rocksdb::Slice slice_key("\u0000\u0001base_data_key\u0000", 16);
+  rocksdb::Slice slice_data("\u0000\u0001data\u0000", 7);
+  uint64_t time = 1701848429;
+  uint64_t version = time | kCompactVersionFlag;
+
+  BaseDataKey bdk(slice_key, version, slice_data);
+  rocksdb::Slice key_enc = bdk.Encode();
+  std::string expect_enc(1, kCompactFormatTag);
+  expect_enc.append("\u0000\u0001\u0001base_data_key\u0000\u0001\u0000\u0000", 20);
+  char dst[10];
+  char* end = pstd::EncodeVarint64(dst, version);
+  expect_enc.append(dst, end - dst);
+  expect_enc.append("\u0000\u0001data\u0000", 7);
+  ASSERT_EQ(key_enc, rocksdb::Slice(expect_enc));
+  // no reserve2, the seek key is the key
+  ASSERT_EQ(bdk.EncodeSeekKey(), rocksdb::Slice(expect_enc));
+
+  ParsedBaseDataKey pbmk(key_enc);
+  ASSERT_EQ(pbmk.Key(), slice_key);
+  ASSERT_EQ(pbmk.Data(), slice_data);
+  ASSERT_EQ(pbmk.Version(), version);
+  ASSERT_TRUE(IsCompactVersion(pbmk.Version()));
+  ASSERT_EQ(VersionTime(pbmk.Version()), time);
+}
+
+TEST(KVFormatTest, CompactDataValueFormat) {
+  uint64_t ctime = 1701848429;
+  BaseDataValue value("member_value");
+  value.setCtime(ctime);
+  std::string full = value.Encode().ToString();
+  std::string compact = value.EncodeCompact().ToString();
+  ASSERT_EQ(full.size(), 12 + kSuffixReserveLength + kTimestampLength);
+  ASSERT_EQ(compact.size(), 12 + kCompactTimestampLength + 1);
+
+  // both formats read back the same
+  for (auto* enc : {&full, &compact}) {
+    ParsedBaseDataValue parsed(*enc);
+    ASSERT_EQ(parsed.IsCompact(), enc == &compact);
+    ASSERT_EQ(parsed.UserValue(), "member_value");
+    ASSERT_EQ(parsed.Ctime(), ctime);
+  }
+
+  ParsedBaseDataValue parsed_compact(&compact);
+  parsed_compact.StripSuffix();
+  ASSERT_EQ(compact, "member_value");
+
+  // an empty value, like the zset score keys have
+  BaseDataValue empty_value("");
+  std::string empty_compact = empty_value.EncodeCompact().ToString();
+  ParsedBaseDataValue parsed_empty(empty_compact);
+  ASSERT_TRUE(parsed_empty.IsCompact());
+  ASSERT_EQ(parsed_empty.UserValue(), "");
+}
+
 TEST(KVFormatTest, ZsetsScoreKeyFormat) {
   rocksdb::Slice slice_key("\u0000\u0001base_data_key\u0000", 16);
   rocksdb::Slice slice_data("\u0000\u0001data\u0000", 7);
@@ -112,9 +112,6 @@ TEST_F(ListsFilterTest, DataFilterTest) {
   ASSERT_TRUE(s.ok());
 
   // Timeout timestamp is set, already expired.
-  auto lists_data_filter3 = std::make_unique<ListsDataFilter>(meta_db, &handles, DataType::kLists);
-  ASSERT_TRUE(lists_data_filter3 != nullptr);
-
   storage::EncodeFixed64(str, 1);
   ListsMetaValue lists_meta_value3(rocksdb::Slice(str, sizeof(uint64_t)));
   version = lists_meta_value3.UpdateVersion();
@@ -122,6 +119,8 @@ TEST_F(ListsFilterTest, DataFilterTest) {
   s = meta_db->Put(rocksdb::WriteOptions(), handles[0], bmk.Encode(), lists_meta_value3.Encode());
   ASSERT_TRUE(s.ok());
   std::this_thread::sleep_for(std::chrono::milliseconds(2000));
+  auto lists_data_filter3 = std::make_unique<ListsDataFilter>(meta_db, &handles, DataType::kLists);
+  ASSERT_TRUE(lists_data_filter3 != nullptr);
   ListsDataKey lists_data_key3("FILTER_TEST_KEY", version, 1);
   filter_result =
       lists_data_filter3->Filter(0, lists_data_key3.Encode(), "FILTER_TEST_VALUE", &new_value, &value_changed);
@@ -10,6 +10,8 @@
 #include <chrono>
 #include <cstddef>
 #include <string_view>
+#include <thread>
+#include <vector>
 
 #include "fmt/core.h"
 #include "gtest/gtest.h"
@@ -174,3 +176,88 @@ TEST(LogIndexAndSequenceCollectorTest, FindBenchmark) {
     }
   }
 }
+
+TEST(LogIndexAndSequenceCollectorTest, MaxGapPerInstance) {  // NOLINT
+  LogIndexAndSequenceCollector small;
+  LogIndexAndSequenceCollector large;
+  small.SetMaxGap(10);
+  large.SetMaxGap(100);
+  for (LogIndex i = 1; i <= 10; i++) {
+    small.Update(i, i);
+    large.Update(i, i);
+  }
+  EXPECT_TRUE(small.IsFlushPending());
+  EXPECT_FALSE(large.IsFlushPending());
+
+  small.Purge(5);
+  EXPECT_EQ(small.GetSize(), 6);
+  EXPECT_FALSE(small.IsFlushPending());
+}
+
+TEST(LogIndexAndSequenceCollectorTest, FullRingTest) {  // NOLINT
+  LogIndexAndSequenceCollector collector(0, 8);
+  for (LogIndex i = 1; i <= 20; i++) {
+    collector.Update(i, i * 2);
+  }
+  // the samples after the 8th are dropped, the seqnos after it map to an older log index
+  EXPECT_EQ(collector.GetSize(), 8);
+  EXPECT_TRUE(collector.IsFlushPending());
+  EXPECT_EQ(collector.FindAppliedLogIndex(40), 8);
+
+  collector.Purge(4);
+  EXPECT_EQ(collector.GetSize(), 5);
+  collector.Update(21, 42);
+  EXPECT_EQ(collector.FindAppliedLogIndex(40), 8);
+  EXPECT_EQ(collector.FindAppliedLogIndex(42), 21);
+
+  auto list = collector.GetList();
+  ASSERT_EQ(list.size(), 6);
+  EXPECT_EQ(list.front().GetAppliedLogIndex(), 4);
+  EXPECT_EQ(list.back().GetAppliedLogIndex(), 21);
+}
+
+// The apply thread updates while the flush callbacks of several column families purge and search.
+TEST(LogIndexAndSequenceCollectorTest, ConcurrentFlushTest) {  // NOLINT
+  constexpr LogIndex kLogs = 200000;
+  constexpr int kFlushThreads = 4;
+  LogIndexAndSequenceCollector collector(0, 64);
+  std::atomic<LogIndex> applied = 0;
+  std::atomic<bool> stop = false;
+
+  std::vector<std::thread> flushers;
+  std::atomic<int> wrong = 0;
+  for (int t = 0; t < kFlushThreads; t++) {
+    flushers.emplace_back([&] {
+      while (!stop.load()) {
+        auto cur = applied.load();
+        if (cur == 0) {
+          continue;
+        }
+        // log i is written at seqno 2i, the found log must not be newer than the seqno
+        auto found = collector.FindAppliedLogIndex(cur * 2 + 1);
+        if (found > cur) {
+          wrong++;
+        }
+        collector.Purge(cur / 2);
+      }
+    });
+  }
+
+  for (LogIndex i = 1; i <= kLogs; i++) {
+    collector.Update(i, i * 2);
+    applied.store(i);
+  }
+  stop.store(true);
+  for (auto& t : flushers) {
+    t.join();
+  }
+
+  EXPECT_EQ(wrong.load(), 0);
+  collector.Purge(kLogs);
+  EXPECT_GE(collector.GetSize(), 1);
+  auto list = collector.GetList();
+  for (size_t i = 1; i < list.size(); i++) {
+    EXPECT_LT(list[i - 1].GetAppliedLogIndex(), list[i].GetAppliedLogIndex());
+    EXPECT_LT(list[i - 1].GetSequenceNumber(), list[i].GetSequenceNumber());
+  }
+}
@@ -272,3 +272,76 @@ TEST_F(LogIndexTest, SimpleTest) {  // NOLINT
     }
   }
 }
+
+// With the Raft log as the only WAL, a crash loses the logs past the flushed
+// log index and they are replayed from the Raft log
+TEST(RaftLogAsWalTest, CrashRecoveryTest) {  // NOLINT
+  std::string db_path = "./test_db/raft_log_as_wal_test";
+  if (access(db_path.c_str(), F_OK) == 0) {
+    std::filesystem::remove_all(db_path);
+  }
+  mkdir(db_path.c_str(), 0755);
+
+  std::vector<pikiwidb::Binlog> logs;  // the Raft log, log index i at i - 1
+  std::unique_ptr<Storage> db;
+  StorageOptions options;
+  options.options.create_if_missing = true;
+  // a crash, the memtables are dropped on close
+  options.options.avoid_flush_during_shutdown = true;
+  options.db_instance_num = 1;
+  options.raft_timeout_s = 10000;
+  options.raft_log_as_wal = true;
+  options.append_log_function = [&](const pikiwidb::Binlog& log, std::promise<rocksdb::Status>&& promise) {
+    logs.push_back(log);
+    promise.set_value(db->OnBinlogWrite(log, static_cast<LogIndex>(logs.size())));
+  };
+  options.do_snapshot_function = [](int64_t log_index, bool sync) {};
+
+  auto open = [&] {
+    db = std::make_unique<Storage>();
+    auto s = db->Open(options, db_path);
+    ASSERT_TRUE(s.ok());
+  };
+  auto set_keys = [&](int start, int end) {
+    for (int i = start; i < end; i++) {
+      auto s = db->Set("key" + std::to_string(i), "value" + std::to_string(i));
+      ASSERT_TRUE(s.ok());
+    }
+  };
+  auto count_keys = [&](int start, int end) {
+    int found = 0;
+    std::string value;
+    for (int i = start; i < end; i++) {
+      if (db->Get("key" + std::to_string(i), &value).ok()) {
+        found++;
+      }
+    }
+    return found;
+  };
+
+  open();
+  set_keys(0, 100);
+  auto& redis = db->GetDBInstance(std::string("key0"));
+  auto s = redis->GetDB()->Flush(rocksdb::FlushOptions(), redis->GetColumnFamilyHandles());
+  ASSERT_TRUE(s.ok());
+  set_keys(100, 200);
+  db->Close();
+  db.reset();
+
+  open();
+  auto replay_point = db->GetSmallestFlushedLogIndex();
+  ASSERT_EQ(replay_point, 100);
+  ASSERT_EQ(count_keys(0, 100), 100);
+  ASSERT_EQ(count_keys(100, 200), 0);
+
+  // the log at the replay point is applied again, the binlogs are idempotent
+  for (auto idx = replay_point; idx <= static_cast<LogIndex>(logs.size()); idx++) {
+    s = db->OnBinlogWrite(logs[idx - 1], idx);
+    ASSERT_TRUE(s.ok());
+  }
+  ASSERT_EQ(count_keys(0, 200), 200);
+
+  db->Close();
+  db.reset();
+  DeleteFiles(db_path.c_str());
+}
@@ -0,0 +1,400 @@
+//  Copyright (c) 2024-present, OpenAtom Foundation, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include <gtest/gtest.h>
+#include <iostream>
+#include <thread>
+
+#include "pstd/env.h"
+#include "pstd/log.h"
+#include "storage/storage.h"
+#include "storage/util.h"
+
+using storage::Slice;
+using storage::Status;
+using storage::StreamAddArgs;
+using storage::StreamEntry;
+using storage::StreamID;
+using storage::StreamPendingEntry;
+using storage::StreamTrimArgs;
+
+class LogIniter {
+ public:
+  LogIniter() {
+    logger::Init("./streams_test.log");
+    spdlog::set_level(spdlog::level::info);
+  }
+};
+
+LogIniter log_initer;
+
+class StreamsTest : public ::testing::Test {
+ public:
+  StreamsTest() = default;
+  ~StreamsTest() override = default;
+
+  void SetUp() override {
+    pstd::DeleteDirIfExist(db_path);
+    mkdir(db_path.c_str(), 0755);
+    options.options.create_if_missing = true;
+    options.options.create_missing_column_families = true;
+    options.options.max_background_jobs = 10;
+    options.db_instance_num = 1;
+    auto s = db.Open(options, db_path);
+    ASSERT_TRUE(s.ok());
+  }
+
+  void TearDown() override { db.Close(); }
+
+  static void SetUpTestSuite() {}
+  static void TearDownTestSuite() {}
+
+  std::string db_path{"./test_db/streams_test"};
+  storage::StorageOptions options;
+  storage::Storage db;
+  storage::Status s;
+};
+
+static Status add_entry(storage::Storage* const db, const Slice& key, const StreamID& id, StreamID* out = nullptr) {
+  StreamAddArgs args;
+  args.id = id;
+  args.id_given = true;
+  args.seq_given = true;
+  StreamID added;
+  Status s = db->XAdd(key, {"field", id.ToString()}, args, &added);
+  if (out) {
+    *out = added;
+  }
+  return s;
+}
+
+static bool ids_match(const std::vector<StreamEntry>& entries, const std::vector<StreamID>& expect_ids) {
+  if (entries.size() != expect_ids.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < entries.size(); i++) {
+    if (entries[i].id != expect_ids[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// XAdd
+TEST_F(StreamsTest, XAddTest) {  // NOLINT
+  StreamID id;
+  uint64_t len = 0;
+
+  // ***************** Group 1 Test *****************
+  // generated IDs grow
+  StreamAddArgs args;
+  s = db.XAdd("GP1_XADD_KEY", {"a", "1"}, args, &id);
+  ASSERT_TRUE(s.ok());
+  StreamID first = id;
+  s = db.XAdd("GP1_XADD_KEY", {"b", "2"}, args, &id);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(first < id);
+  s = db.XLen("GP1_XADD_KEY", &len);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(len, 2);
+
+  // ***************** Group 2 Test *****************
+  // explicit IDs must be greater than the last one
+  s = add_entry(&db, "GP2_XADD_KEY", StreamID(5, 1));
+  ASSERT_TRUE(s.ok());
+  s = add_entry(&db, "GP2_XADD_KEY", StreamID(5, 1));
+  ASSERT_TRUE(s.IsCorruption());
+  s = add_entry(&db, "GP2_XADD_KEY", StreamID(4, 9));
+  ASSERT_TRUE(s.IsCorruption());
+  s = add_entry(&db, "GP2_XADD_KEY", StreamID(0, 0));
+  ASSERT_TRUE(s.IsCorruption());
+
+  // 'ms-*' continues the sequence of the same ms
+  args.id = StreamID(5, 0);
+  args.id_given = true;
+  args.seq_given = false;
+  s = db.XAdd("GP2_XADD_KEY", {"c", "3"}, args, &id);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(id == StreamID(5, 2));
+
+  // ***************** Group 3 Test *****************
+  // NOMKSTREAM does not create the key
+  StreamAddArgs no_mkstream_args;
+  no_mkstream_args.no_mkstream = true;
+  s = db.XAdd("GP3_XADD_KEY", {"a", "1"}, no_mkstream_args, &id);
+  ASSERT_TRUE(s.IsNotFound());
+  s = db.XLen("GP3_XADD_KEY", &len);
+  ASSERT_TRUE(s.IsNotFound());
+
+  // ***************** Group 4 Test *****************
+  // wrong type
+  s = db.Set("GP4_XADD_KEY", "VALUE");
+  ASSERT_TRUE(s.ok());
+  s = add_entry(&db, "GP4_XADD_KEY", StreamID(1, 1));
+  ASSERT_TRUE(s.IsInvalidArgument());
+}
+
+// XRange and XRevRange
+TEST_F(StreamsTest, XRangeTest) {  // NOLINT
+  std::vector<StreamEntry> entries;
+  for (uint64_t ms = 1; ms <= 5; ms++) {
+    s = add_entry(&db, "GP1_XRANGE_KEY", StreamID(ms, 0));
+    ASSERT_TRUE(s.ok());
+  }
+
+  s = db.XRange("GP1_XRANGE_KEY", StreamID::Min(), StreamID::Max(), -1, &entries);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(ids_match(entries, {{1, 0}, {2, 0}, {3, 0}, {4, 0}, {5, 0}}));
+  ASSERT_EQ(entries[2].field_values, std::vector<std::string>({"field", "3-0"}));
+
+  s = db.XRange("GP1_XRANGE_KEY", StreamID(2, 0), StreamID(4, 0), -1, &entries);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(ids_match(entries, {{2, 0}, {3, 0}, {4, 0}}));
+
+  s = db.XRange("GP1_XRANGE_KEY", StreamID(2, 0), StreamID::Max(), 2, &entries);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(ids_match(entries, {{2, 0}, {3, 0}}));
+
+  s = db.XRevRange("GP1_XRANGE_KEY", StreamID::Max(), StreamID(2, 0), 2, &entries);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(ids_match(entries, {{5, 0}, {4, 0}}));
+
+  s = db.XRevRange("GP1_XRANGE_KEY", StreamID(3, 5), StreamID::Min(), -1, &entries);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(ids_match(entries, {{3, 0}, {2, 0}, {1, 0}}));
+
+  s = db.XRange("GP1_XRANGE_KEY", StreamID(4, 0), StreamID(2, 0), -1, &entries);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(entries.empty());
+
+  s = db.XRange("GP1_XRANGE_NOT_EXIST_KEY", StreamID::Min(), StreamID::Max(), -1, &entries);
+  ASSERT_TRUE(s.IsNotFound());
+}
+
+// XDel and XTrim
+TEST_F(StreamsTest, XDelAndXTrimTest) {  // NOLINT
+  int64_t ret = 0;
+  uint64_t len = 0;
+  std::vector<StreamEntry> entries;
+  for (uint64_t ms = 1; ms <= 10; ms++) {
+    s = add_entry(&db, "GP1_XTRIM_KEY", StreamID(ms, 0));
+    ASSERT_TRUE(s.ok());
+  }
+
+  s = db.XDel("GP1_XTRIM_KEY", {{2, 0}, {2, 0}, {11, 0}}, &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(ret, 1);
+
+  // MAXLEN drops the head, the deleted entry is not counted twice
+  StreamTrimArgs maxlen_args;
+  maxlen_args.strategy = StreamTrimArgs::kMaxLen;
+  maxlen_args.maxlen = 6;
+  s = db.XTrim("GP1_XTRIM_KEY", maxlen_args, &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(ret, 3);
+  s = db.XRange("GP1_XTRIM_KEY", StreamID::Min(), StreamID::Max(), -1, &entries);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(ids_match(entries, {{5, 0}, {6, 0}, {7, 0}, {8, 0}, {9, 0}, {10, 0}}));
+
+  // MINID drops everything below the ID
+  StreamTrimArgs minid_args;
+  minid_args.strategy = StreamTrimArgs::kMinID;
+  minid_args.minid = StreamID(8, 0);
+  s = db.XTrim("GP1_XTRIM_KEY", minid_args, &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(ret, 3);
+  s = db.XLen("GP1_XTRIM_KEY", &len);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(len, 3);
+
+  // trimming on XADD, the trimmed entries still bound the next ID
+  StreamAddArgs args;
+  args.id = StreamID(20, 0);
+  args.id_given = true;
+  args.seq_given = true;
+  args.trim.strategy = StreamTrimArgs::kMaxLen;
+  args.trim.maxlen = 1;
+  StreamID id;
+  s = db.XAdd("GP1_XTRIM_KEY", {"a", "1"}, args, &id);
+  ASSERT_TRUE(s.ok());
+  s = db.XRange("GP1_XTRIM_KEY", StreamID::Min(), StreamID::Max(), -1, &entries);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(ids_match(entries, {{20, 0}}));
+  s = add_entry(&db, "GP1_XTRIM_KEY", StreamID(19, 0));
+  ASSERT_TRUE(s.IsCorruption());
+}
+
+// A stream emptied by XDEL or XTRIM stays with its last ID
+TEST_F(StreamsTest, EmptyStreamTest) {  // NOLINT
+  int64_t ret = 0;
+  uint64_t len = 0;
+  StreamID last_id;
+  for (uint64_t ms = 1; ms <= 3; ms++) {
+    s = add_entry(&db, "GP1_EMPTY_KEY", StreamID(ms, 0));
+    ASSERT_TRUE(s.ok());
+  }
+
+  StreamTrimArgs maxlen_args;
+  maxlen_args.strategy = StreamTrimArgs::kMaxLen;
+  maxlen_args.maxlen = 1;
+  s = db.XTrim("GP1_EMPTY_KEY", maxlen_args, &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(ret, 2);
+  s = db.XDel("GP1_EMPTY_KEY", {{3, 0}}, &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(ret, 1);
+
+  s = db.XLen("GP1_EMPTY_KEY", &len);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(len, 0);
+  s = db.XLastID("GP1_EMPTY_KEY", &last_id);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(last_id == StreamID(3, 0));
+  storage::DataType type;
+  s = db.GetType("GP1_EMPTY_KEY", type);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(type, storage::DataType::kStreams);
+
+  // the last ID still bounds the next one
+  s = add_entry(&db, "GP1_EMPTY_KEY", StreamID(2, 0));
+  ASSERT_TRUE(s.IsCorruption());
+  s = add_entry(&db, "GP1_EMPTY_KEY", StreamID(4, 0));
+  ASSERT_TRUE(s.ok());
+
+  // trimming every entry on XADD leaves an empty stream too
+  StreamAddArgs args;
+  args.id = StreamID(5, 0);
+  args.id_given = true;
+  args.seq_given = true;
+  args.trim.strategy = StreamTrimArgs::kMaxLen;
+  args.trim.maxlen = 0;
+  StreamID id;
+  s = db.XAdd("GP1_EMPTY_KEY", {"a", "1"}, args, &id);
+  ASSERT_TRUE(s.ok());
+  s = db.XLen("GP1_EMPTY_KEY", &len);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(len, 0);
+  s = db.XLastID("GP1_EMPTY_KEY", &last_id);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(last_id == StreamID(5, 0));
+
+  ASSERT_EQ(db.Del({"GP1_EMPTY_KEY"}), 1);
+  s = db.XLen("GP1_EMPTY_KEY", &len);
+  ASSERT_TRUE(s.IsNotFound());
+}
+
+// XGroupCreate, XReadGroup, XAck, XPending and XGroupDestroy
+TEST_F(StreamsTest, ConsumerGroupTest) {  // NOLINT
+  int32_t destroyed = 0;
+  int64_t ret = 0;
+  uint64_t len = 0;
+  std::vector<StreamEntry> entries;
+  std::vector<StreamPendingEntry> pendings;
+
+  s = db.XGroupCreate("GP1_GROUP_KEY", "g1", StreamID::Min(), false, false);
+  ASSERT_TRUE(s.IsCorruption());
+  s = db.XGroupCreate("GP1_GROUP_KEY", "g1", StreamID::Min(), false, true);
+  ASSERT_TRUE(s.ok());
+  s = db.XGroupCreate("GP1_GROUP_KEY", "g1", StreamID::Min(), false, true);
+  ASSERT_TRUE(s.IsCorruption());
+
+  // the group alone keeps the stream alive, it has no entries
+  s = db.XLen("GP1_GROUP_KEY", &len);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(len, 0);
+
+  for (uint64_t ms = 1; ms <= 4; ms++) {
+    s = add_entry(&db, "GP1_GROUP_KEY", StreamID(ms, 0));
+    ASSERT_TRUE(s.ok());
+  }
+
+  // new entries are delivered once
+  s = db.XReadGroup("GP1_GROUP_KEY", "g1", "alice", StreamID::Min(), true, 3, false, &entries);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(ids_match(entries, {{1, 0}, {2, 0}, {3, 0}}));
+  s = db.XReadGroup("GP1_GROUP_KEY", "g1", "bob", StreamID::Min(), true, -1, false, &entries);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(ids_match(entries, {{4, 0}}));
+  s = db.XReadGroup("GP1_GROUP_KEY", "g1", "bob", StreamID::Min(), true, -1, false, &entries);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(entries.empty());
+
+  // the history of a consumer is its pending entries
+  s = db.XReadGroup("GP1_GROUP_KEY", "g1", "alice", StreamID::Min(), false, -1, false, &entries);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(ids_match(entries, {{1, 0}, {2, 0}, {3, 0}}));
+
+  s = db.XPending("GP1_GROUP_KEY", "g1", StreamID::Min(), StreamID::Max(), -1, "", &pendings);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(pendings.size(), 4);
+  ASSERT_EQ(pendings[3].consumer, "bob");
+  ASSERT_EQ(pendings[3].delivery_count, 1);
+
+  s = db.XAck("GP1_GROUP_KEY", "g1", {{1, 0}, {4, 0}, {9, 0}}, &ret);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(ret, 2);
+  s = db.XPending("GP1_GROUP_KEY", "g1", StreamID::Min(), StreamID::Max(), -1, "alice", &pendings);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(pendings.size(), 2);
+
+  // a pending entry deleted from the stream comes back without fields
+  s = db.XDel("GP1_GROUP_KEY", {{2, 0}}, &ret);
+  ASSERT_TRUE(s.ok());
+  s = db.XReadGroup("GP1_GROUP_KEY", "g1", "alice", StreamID::Min(), false, -1, false, &entries);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(ids_match(entries, {{2, 0}, {3, 0}}));
+  ASSERT_TRUE(entries[0].field_values.empty());
+
+  // SETID replays the stream
+  s = db.XGroupSetID("GP1_GROUP_KEY", "g1", StreamID(2, 0), false);
+  ASSERT_TRUE(s.ok());
+  s = db.XReadGroup("GP1_GROUP_KEY", "g1", "carol", StreamID::Min(), true, -1, true, &entries);
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(ids_match(entries, {{3, 0}, {4, 0}}));
+
+  s = db.XReadGroup("GP1_GROUP_KEY", "g2", "alice", StreamID::Min(), true, -1, false, &entries);
+  ASSERT_TRUE(s.IsCorruption());
+
+  s = db.XGroupDestroy("GP1_GROUP_KEY", "g1", &destroyed);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(destroyed, 1);
+  s = db.XPending("GP1_GROUP_KEY", "g1", StreamID::Min(), StreamID::Max(), -1, "", &pendings);
+  ASSERT_TRUE(s.IsCorruption());
+  s = db.XLen("GP1_GROUP_KEY", &len);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(len, 3);
+}
+
+// Keys commands see streams like any other type
+TEST_F(StreamsTest, KeysTest) {  // NOLINT
+  std::vector<StreamEntry> entries;
+  s = add_entry(&db, "GP1_KEYS_KEY", StreamID(1, 0));
+  ASSERT_TRUE(s.ok());
+
+  storage::DataType type;
+  s = db.GetType("GP1_KEYS_KEY", type);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(type, storage::DataType::kStreams);
+
+  int64_t ret = db.Del({"GP1_KEYS_KEY"});
+  ASSERT_EQ(ret, 1);
+  s = db.XRange("GP1_KEYS_KEY", StreamID::Min(), StreamID::Max(), -1, &entries);
+  ASSERT_TRUE(s.IsNotFound());
+
+  // a new stream under the same key does not see the old entries
+  s = add_entry(&db, "GP1_KEYS_KEY", StreamID(1, 0));
+  ASSERT_TRUE(s.ok());
+  s = db.XRange("GP1_KEYS_KEY", StreamID::Min(), StreamID::Max(), -1, &entries);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(entries.size(), 1);
+}
+
+int main(int argc, char** argv) {
+  if (!pstd::FileExists("./log")) {
+    pstd::CreatePath("./log");
+  }
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
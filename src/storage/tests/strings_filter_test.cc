@@ -25,6 +25,10 @@ TEST(StringsFilterTest, FilterTest) {
   is_stale = filter->Filter(0, "FILTER_KEY", strings_value.Encode(), &new_value, &value_changed);
   ASSERT_FALSE(is_stale);
   std::this_thread::sleep_for(std::chrono::milliseconds(2000));
+  // the time is the one the filter was created at, that of its compaction
+  is_stale = filter->Filter(0, "FILTER_KEY", strings_value.Encode(), &new_value, &value_changed);
+  ASSERT_FALSE(is_stale);
+  filter = std::make_unique<StringsFilter>();
   is_stale = filter->Filter(0, "FILTER_KEY", strings_value.Encode(), &new_value, &value_changed);
   ASSERT_TRUE(is_stale);
 }
@@ -1013,6 +1013,63 @@ TEST_F(StringsTest, PKSetexAtTest) {
   ASSERT_EQ(ttl_ret, -2);
 }
 
+// CreateBackup & RestoreBackup
+TEST_F(StringsTest, BackupTest) {
+  std::string backup_path = "./test_db/string_backup";
+  std::string restore_path = "./test_db/string_restore";
+  pstd::DeleteDirIfExist(backup_path);
+  pstd::DeleteDirIfExist(restore_path);
+  BackupOptions backup_options;
+  backup_options.keep = 1;
+
+  s = db.Set("BACKUP_KEY1", "VALUE1");
+  ASSERT_TRUE(s.ok());
+  for (auto& r : db.CreateBackup(backup_path, backup_options)) {
+    ASSERT_TRUE(r.get().ok());
+  }
+
+  // the second backup only adds the new files, the first is purged
+  s = db.Set("BACKUP_KEY2", "VALUE2");
+  ASSERT_TRUE(s.ok());
+  for (auto& r : db.CreateBackup(backup_path, backup_options)) {
+    ASSERT_TRUE(r.get().ok());
+  }
+
+  for (auto& r : Storage::RestoreBackup(backup_path, restore_path, options.db_instance_num)) {
+    ASSERT_TRUE(r.get().ok());
+  }
+  storage::Storage restored;
+  s = restored.Open(options, restore_path);
+  ASSERT_TRUE(s.ok());
+  std::string value;
+  s = restored.Get("BACKUP_KEY1", &value);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(value, "VALUE1");
+  s = restored.Get("BACKUP_KEY2", &value);
+  ASSERT_TRUE(s.ok());
+  ASSERT_EQ(value, "VALUE2");
+  restored.Close();
+}
+
+// StopBackup fails the backups of a storage that is being reopened
+TEST_F(StringsTest, StopBackupTest) {
+  std::string db_path = "./test_db/string_stopped";
+  std::string backup_path = "./test_db/string_stopped_backup";
+  pstd::DeleteDirIfExist(db_path);
+  pstd::DeleteDirIfExist(backup_path);
+  storage::Storage stopped;
+  s = stopped.Open(options, db_path);
+  ASSERT_TRUE(s.ok());
+  s = stopped.Set("BACKUP_KEY", "VALUE");
+  ASSERT_TRUE(s.ok());
+
+  stopped.StopBackup();
+  for (auto& r : stopped.CreateBackup(backup_path, BackupOptions())) {
+    ASSERT_TRUE(r.get().IsIncomplete());
+  }
+  stopped.Close();
+}
+
 int main(int argc, char** argv) {
   if (!pstd::FileExists("./log")) {
     pstd::CreatePath("./log");
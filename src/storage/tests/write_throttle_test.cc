@@ -0,0 +1,88 @@
+//  Copyright (c) 2024-present, OpenAtom Foundation, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include <gtest/gtest.h>
+
+#include "src/write_throttle.h"
+
+using namespace storage;  // NOLINT
+
+static WriteStallMetrics Metrics(uint64_t l0_files, uint64_t pending_bytes = 0) {
+  WriteStallMetrics metrics;
+  metrics.l0_files = l0_files;
+  metrics.l0_slowdown_trigger = 20;
+  metrics.l0_stop_trigger = 36;
+  metrics.pending_compaction_bytes = pending_bytes;
+  metrics.soft_pending_compaction_bytes = 64ULL << 30;
+  metrics.hard_pending_compaction_bytes = 256ULL << 30;
+  metrics.max_delayed_write_rate = 16 << 20;
+  return metrics;
+}
+
+TEST(WriteThrottleTest, PressureTest) {  // NOLINT
+  EXPECT_EQ(WriteThrottle::Pressure(Metrics(4)), 0);
+  EXPECT_EQ(WriteThrottle::Pressure(Metrics(20)), 0);
+  EXPECT_EQ(WriteThrottle::Pressure(Metrics(28)), 50);
+  EXPECT_EQ(WriteThrottle::Pressure(Metrics(40)), 100);
+
+  // the worst of the L0 files and the pending compaction bytes
+  EXPECT_EQ(WriteThrottle::Pressure(Metrics(24, 160ULL << 30)), 50);
+
+  auto delayed = Metrics(4);
+  delayed.delayed_write_rate = 4 << 20;
+  EXPECT_EQ(WriteThrottle::Pressure(delayed), 75);
+
+  auto stopped = Metrics(4);
+  stopped.stopped = true;
+  EXPECT_EQ(WriteThrottle::Pressure(stopped), 100);
+}
+
+TEST(WriteThrottleTest, AdmitTest) {  // NOLINT
+  WriteThrottle throttle;
+  WriteThrottleOptions options;
+  options.max_delay_us = 1000;
+  options.reject_percent = 80;
+
+  EXPECT_EQ(throttle.Admit(), 0);
+
+  // half way to the rejection
+  throttle.Update(Metrics(28), options);
+  EXPECT_EQ(throttle.Admit(), 625);
+
+  throttle.Update(Metrics(33), options);
+  EXPECT_EQ(throttle.Admit(), WriteThrottle::kReject);
+
+  options.reject_percent = 0;
+  throttle.Update(Metrics(33), options);
+  EXPECT_GT(throttle.Admit(), 0);
+
+  options.enabled = false;
+  throttle.Update(Metrics(33), options);
+  EXPECT_EQ(throttle.Admit(), 0);
+
+  throttle.Update(Metrics(28), WriteThrottleOptions{});
+  auto stats = throttle.Stats();
+  EXPECT_EQ(stats.pressure, 50);
+  EXPECT_EQ(stats.metrics.l0_files, 28);
+  EXPECT_EQ(stats.delayed, 2);
+  EXPECT_EQ(stats.rejected, 1);
+}
+
+TEST(WriteThrottleTest, ForcedPressureTest) {  // NOLINT
+  WriteThrottle throttle;
+  WriteThrottleOptions options;
+  EXPECT_FALSE(throttle.Throttled());
+
+  options.forced_pressure = 100;
+  throttle.Update(Metrics(4), options);
+  EXPECT_TRUE(throttle.Throttled());
+  EXPECT_EQ(throttle.Stats().pressure, 100);
+  EXPECT_EQ(throttle.Admit(), WriteThrottle::kReject);
+
+  options.forced_pressure = -1;
+  throttle.Update(Metrics(4), options);
+  EXPECT_FALSE(throttle.Throttled());
+  EXPECT_EQ(throttle.Admit(), 0);
+}
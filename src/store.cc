@@ -10,17 +10,44 @@
 
 #include "store.h"
 
+#include <algorithm>
 #include <memory>
 #include <string>
 
 #include "config.h"
 #include "db.h"
 #include "pstd/log.h"
+#include "pstd/pstd_cpu.h"
 #include "pstd/pstd_string.h"
 
 namespace pikiwidb {
 
-PStore::~PStore() { INFO("STORE is closing..."); }
+// the L0 files of a busy DB grow by a flush every few seconds, a stop is seen coming well before
+static constexpr auto kWriteThrottleRefreshInterval = std::chrono::milliseconds(200);
+// an idle iterator pins the memtables and SSTs of its superversion
+static constexpr auto kIteratorTrimInterval = std::chrono::milliseconds(1000);
+
+PStore::~PStore() {
+  {
+    std::lock_guard lock(housekeeping_mutex_);
+    housekeeping_stopped_ = true;
+  }
+  housekeeping_cond_.notify_all();
+  if (housekeeping_thread_.joinable()) {
+    housekeeping_thread_.join();
+  }
+  if (loader_.joinable()) {
+    loader_.join();
+  }
+  if (backup_thread_.joinable()) {
+    backup_thread_.join();
+  }
+  convert_stopped_.store(true);
+  if (convert_thread_.joinable()) {
+    convert_thread_.join();
+  }
+  INFO("STORE is closing...");
+}
 
 PStore& PStore::Instance() {
   static PStore store;
@@ -28,15 +55,355 @@ PStore& PStore::Instance() {
 }
 
 void PStore::Init(int db_number) {
+  size_t cache_size = g_config.rocksdb_block_cache_size.load();
+  size_t secondary_cache_size = g_config.rocksdb_secondary_cache_size.load();
+  if (secondary_cache_size > 0) {
+    // the blocks evicted from the block cache are kept here LZ4 compressed,
+    // a hit costs a decompression instead of a read of the SST
+    rocksdb::CompressedSecondaryCacheOptions secondary_options;
+    secondary_options.capacity = secondary_cache_size;
+    secondary_cache_ = secondary_options.MakeSharedSecondaryCache();
+  }
+  if (pstd::StringEqualCaseInsensitive(g_config.rocksdb_block_cache_type.ToString(), "lru")) {
+    rocksdb::LRUCacheOptions cache_options;
+    cache_options.capacity = cache_size;
+    // reserved for the index and filter blocks
+    cache_options.high_pri_pool_ratio = 0.5;
+    cache_options.secondary_cache = secondary_cache_;
+    block_cache_ = cache_options.MakeSharedCache();
+  } else {
+    // 0 lets the cache size its table from the entries it actually holds
+    rocksdb::HyperClockCacheOptions cache_options(cache_size, 0);
+    cache_options.secondary_cache = secondary_cache_;
+    block_cache_ = cache_options.MakeSharedCache();
+  }
+  statistics_ = rocksdb::CreateDBStatistics();
+  // the tickers only, the histograms and timers cost too much on every read
+  statistics_->set_stats_level(rocksdb::StatsLevel::kExceptHistogramOrTimers);
+  size_t memtable_budget = g_config.rocksdb_write_buffer_manager_size.load();
+  if (memtable_budget > cache_size) {
+    WARN("rocksdb-write-buffer-manager-size {} exceeds rocksdb-block-cache-size {}", memtable_budget, cache_size);
+  }
+  write_buffer_manager_ = std::make_shared<rocksdb::WriteBufferManager>(
+      memtable_budget, block_cache_, g_config.rocksdb_write_buffer_manager_stall.load());
+
   db_number_ = db_number;
   backends_.reserve(db_number_);
+  open_progress_.resize(db_number_);
   for (int i = 0; i < db_number_; i++) {
-    auto db = std::make_unique<DB>(i, g_config.db_path);
-    db->Open();
-    backends_.push_back(std::move(db));
-    INFO("Open DB_{} success!", i);
+    backends_.push_back(std::make_unique<DB>(i, g_config.db_path));
+    open_progress_[i].resize(g_config.db_instance_num.load());
+  }
+
+  // clients are accepted right away and answered with -LOADING until every DB is open
+  loading_.store(true, std::memory_order_release);
+  loader_ = std::thread([this] { OpenAll(); });
+  housekeeping_thread_ = std::thread([this] { Housekeeping(); });
+}
+
+void PStore::OpenAll() {
+  auto start = std::chrono::steady_clock::now();
+
+  // every DB opens its instances concurrently as well, so the number of DBs opened at once is bounded
+  size_t instances = std::max<size_t>(1, g_config.db_instance_num.load());
+  size_t threads = std::max<size_t>(1, std::thread::hardware_concurrency() / instances);
+  threads = std::min<size_t>(threads, db_number_);
+  std::atomic<int> next = 0;
+  std::vector<std::thread> workers;
+  workers.reserve(threads);
+  for (size_t i = 0; i < threads; i++) {
+    workers.emplace_back([this, &next] {
+      auto restore_path = g_config.backup_restore_path.ToString();
+      for (int db = next++; db < db_number_; db = next++) {
+        // opening a DB whose restore failed would create an empty one in its place, which the
+        // next start then keeps instead of restoring the backup
+        if (!restore_path.empty()) {
+          if (auto s = backends_[db]->RestoreBackup(restore_path); !s.ok()) {
+            ERROR("DB_{} restore from {} failed: {}", db, restore_path, s.ToString());
+            abort();
+          }
+        }
+        backends_[db]->Open();
+        INFO("Open DB_{} success!", db);
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  // the background threads of RocksDB exist once the DBs are open
+  PinRocksDBThreads();
+
+  loading_.store(false, std::memory_order_release);
+  auto cost = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+  INFO("STORE Init success! {} DBs opened in {}ms", db_number_, cost.count());
+}
+
+void PStore::UpdateOpenProgress(int db, size_t instance, storage::OpenStage stage) {
+  std::lock_guard lock(progress_mutex_);
+  if (db < 0 || db >= static_cast<int>(open_progress_.size())) {
+    return;
+  }
+  auto& records = open_progress_[db];
+  if (instance >= records.size()) {
+    records.resize(instance + 1);
+  }
+  auto& record = records[instance];
+  record.stage = stage;
+  if (stage == storage::OpenStage::kOpening) {
+    record.start = std::chrono::steady_clock::now();
+  } else if (stage == storage::OpenStage::kOpened || stage == storage::OpenStage::kFailed) {
+    record.end = std::chrono::steady_clock::now();
+  }
+}
+
+std::vector<InstanceOpenProgress> PStore::GetOpenProgress() {
+  std::lock_guard lock(progress_mutex_);
+  auto now = std::chrono::steady_clock::now();
+  std::vector<InstanceOpenProgress> progress;
+  for (int db = 0; db < static_cast<int>(open_progress_.size()); db++) {
+    for (size_t i = 0; i < open_progress_[db].size(); i++) {
+      const auto& record = open_progress_[db][i];
+      InstanceOpenProgress item{db, i, record.stage, 0};
+      if (record.stage != storage::OpenStage::kPending) {
+        bool done = record.stage == storage::OpenStage::kOpened || record.stage == storage::OpenStage::kFailed;
+        auto end = done ? record.end : now;
+        item.elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - record.start).count();
+      }
+      progress.push_back(item);
+    }
+  }
+  return progress;
+}
+
+void PStore::Housekeeping() {
+  auto next_trim = std::chrono::steady_clock::now() + kIteratorTrimInterval;
+  std::unique_lock lock(housekeeping_mutex_);
+  while (!housekeeping_cond_.wait_for(lock, kWriteThrottleRefreshInterval, [this] { return housekeeping_stopped_; })) {
+    lock.unlock();
+    if (!IsLoading()) {
+      PinRocksDBThreads();
+    }
+    RefreshWriteThrottles();
+    auto now = std::chrono::steady_clock::now();
+    if (now >= next_trim) {
+      TrimIteratorPools();
+      next_trim = now + kIteratorTrimInterval;
+    }
+    lock.lock();
+  }
+}
+
+void PStore::PinRocksDBThreads() {
+  std::vector<int> cpus;
+  if (!pstd::ParseCpuList(g_config.rocksdb_threads_cpu_list.ToString(), &cpus) || cpus.empty()) {
+    return;
+  }
+  // RocksDB starts more background threads whenever a DB raises its limits,
+  // on a reopen or a SetDBOptions of max_background_jobs
+  int threads = pstd::CountThreads();
+  if (threads == pinned_thread_count_) {
+    return;
+  }
+  pinned_thread_count_ = threads;
+  INFO("{} RocksDB background threads pinned", pstd::BindThreadsByName("rocksdb:", cpus));
+}
+
+void PStore::TrimIteratorPools() {
+  if (IsLoading()) {
+    return;
+  }
+  for (auto& backend : backends_) {
+    backend->LockShared();
+    backend->GetStorage()->TrimIteratorPools();
+    backend->UnLockShared();
+  }
+}
+
+storage::IteratorPoolStats PStore::GetIteratorPoolStats() {
+  storage::IteratorPoolStats total;
+  if (IsLoading()) {
+    return total;
+  }
+  for (auto& backend : backends_) {
+    bool locked = backend->LockSharedUnlessHeld();
+    auto stats = backend->GetStorage()->GetIteratorPoolStats();
+    if (locked) {
+      backend->UnLockShared();
+    }
+    total.created += stats.created;
+    total.reused += stats.reused;
+    total.expired += stats.expired;
+    total.parked += stats.parked;
+  }
+  return total;
+}
+
+void PStore::RefreshWriteThrottles() {
+  if (IsLoading()) {
+    return;
+  }
+  storage::WriteThrottleOptions options;
+  options.enabled = g_config.write_throttle.load();
+  options.max_delay_us = g_config.write_throttle_max_delay_us.load();
+  options.reject_percent = g_config.write_throttle_reject_percent.load();
+  options.forced_pressure = forced_write_pressure_.load();
+  for (auto& backend : backends_) {
+    bool locked = backend->LockSharedUnlessHeld();
+    backend->GetStorage()->RefreshWriteThrottle(options);
+    if (locked) {
+      backend->UnLockShared();
+    }
+  }
+}
+
+void PStore::ForceWritePressure(int32_t pressure) {
+  forced_write_pressure_.store(pressure);
+  RefreshWriteThrottles();
+}
+
+std::vector<std::vector<storage::WriteThrottleStats>> PStore::GetWriteThrottleStats() {
+  std::vector<std::vector<storage::WriteThrottleStats>> stats;
+  if (IsLoading()) {
+    return stats;
+  }
+  for (auto& backend : backends_) {
+    bool locked = backend->LockSharedUnlessHeld();
+    stats.push_back(backend->GetStorage()->GetWriteThrottleStats());
+    if (locked) {
+      backend->UnLockShared();
+    }
+  }
+  return stats;
+}
+
+rocksdb::Status PStore::StartBackup() {
+  auto path = g_config.backup_path.ToString();
+  if (path.empty()) {
+    return rocksdb::Status::InvalidArgument("backup-path is not set");
+  }
+  if (IsLoading()) {
+    return rocksdb::Status::Busy("the DBs are loading");
+  }
+  std::lock_guard lock(backup_mutex_);
+  if (backup_running_.load()) {
+    return rocksdb::Status::Busy("a backup is in progress");
+  }
+  if (backup_thread_.joinable()) {
+    backup_thread_.join();
+  }
+
+  storage::BackupOptions options;
+  options.keep = g_config.backup_keep.load();
+  options.rate_limit = g_config.backup_rate_limit.load();
+  options.threads = static_cast<int>(g_config.backup_threads.load());
+  options.copied_bytes = &backup_copied_bytes_;
+  pstd::TrimSlash(path);
+  backup_copied_bytes_.store(0);
+  backup_running_.store(true);
+  backup_thread_ = std::thread([this, path, options] { RunBackup(path, options); });
+  return rocksdb::Status::OK();
+}
+
+void PStore::RunBackup(const std::string& path, const storage::BackupOptions& options) {
+  auto start = std::chrono::steady_clock::now();
+  INFO("Backup to {} started", path);
+  rocksdb::Status status;
+  for (auto& backend : backends_) {
+    auto s = backend->CreateBackup(path, options);
+    if (status.ok() && !s.ok()) {
+      status = s;
+    }
+  }
+  auto cost = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+  INFO("Backup to {} finished in {}ms: {}", path, cost.count(), status.ToString());
+
+  std::lock_guard lock(backup_mutex_);
+  last_backup_.copied_bytes = backup_copied_bytes_.load();
+  last_backup_.last_time = std::chrono::duration_cast<std::chrono::seconds>(
+                               std::chrono::system_clock::now().time_since_epoch())
+                               .count();
+  last_backup_.last_duration_ms = cost.count();
+  last_backup_.last_status = status.ok() ? "ok" : status.ToString();
+  backup_running_.store(false);
+}
+
+BackupProgress PStore::GetBackupProgress() {
+  std::lock_guard lock(backup_mutex_);
+  BackupProgress progress = last_backup_;
+  progress.in_progress = backup_running_.load();
+  if (progress.in_progress) {
+    progress.copied_bytes = backup_copied_bytes_.load();
+  }
+  return progress;
+}
+
+rocksdb::Status PStore::StartConvertFormat(int db) {
+  if (IsLoading()) {
+    return rocksdb::Status::Busy("the DBs are loading");
+  }
+  std::lock_guard lock(convert_mutex_);
+  if (convert_running_.load()) {
+    return rocksdb::Status::Busy("a conversion is in progress");
+  }
+  if (convert_thread_.joinable()) {
+    convert_thread_.join();
+  }
+  last_convert_.db = db;
+  convert_scanned_.store(0);
+  convert_converted_.store(0);
+  convert_running_.store(true);
+  convert_thread_ = std::thread([this, db] { RunConvertFormat(db); });
+  return rocksdb::Status::OK();
+}
+
+void PStore::RunConvertFormat(int db) {
+  // the keys scanned under one hold of the DB lock, FLUSHDB and the like wait at most for those
+  constexpr size_t kKeysPerStep = 1000;
+  auto start = std::chrono::steady_clock::now();
+  INFO("Conversion of DB {} to the compact format started", db);
+  auto& backend = backends_[db];
+  storage::ConvertCursor cursor;
+  rocksdb::Status status;
+  while (!cursor.done) {
+    if (convert_stopped_.load()) {
+      status = rocksdb::Status::Aborted("the server is closing");
+      break;
+    }
+    backend->LockShared();
+    status = backend->GetStorage()->ConvertToCompactFormat(&cursor, kKeysPerStep);
+    backend->UnLockShared();
+    convert_scanned_.store(cursor.scanned);
+    convert_converted_.store(cursor.converted);
+    if (!status.ok()) {
+      break;
+    }
+  }
+  auto cost = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+  INFO("Conversion of DB {} finished in {}ms, {} keys rewritten: {}", db, cost.count(), cursor.converted,
+       status.ToString());
+
+  std::lock_guard lock(convert_mutex_);
+  last_convert_.scanned_keys = cursor.scanned;
+  last_convert_.converted_keys = cursor.converted;
+  last_convert_.last_time = std::chrono::duration_cast<std::chrono::seconds>(
+                                std::chrono::system_clock::now().time_since_epoch())
+                                .count();
+  last_convert_.last_duration_ms = cost.count();
+  last_convert_.last_status = status.ok() ? "ok" : status.ToString();
+  convert_running_.store(false);
+}
+
+ConvertProgress PStore::GetConvertProgress() {
+  std::lock_guard lock(convert_mutex_);
+  ConvertProgress progress = last_convert_;
+  progress.in_progress = convert_running_.load();
+  if (progress.in_progress) {
+    progress.scanned_keys = convert_scanned_.load();
+    progress.converted_keys = convert_converted_.load();
   }
-  INFO("STORE Init success!");
+  return progress;
 }
 
 void PStore::HandleTaskSpecificDB(const TasksVector& tasks) {
@@ -12,12 +12,21 @@
 
 #define GLOG_NO_ABBREVIATED_SEVERITIES
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <map>
+#include <mutex>
 #include <shared_mutex>
+#include <thread>
 #include <vector>
 
 #include "common.h"
 #include "db.h"
+#include "rocksdb/cache.h"
+#include "rocksdb/secondary_cache.h"
+#include "rocksdb/statistics.h"
+#include "rocksdb/write_buffer_manager.h"
 #include "storage/storage.h"
 
 namespace pikiwidb {
@@ -44,6 +53,31 @@ struct TaskContext {
 
 using TasksVector = std::vector<TaskContext>;
 
+struct InstanceOpenProgress {
+  int db = 0;
+  size_t instance = 0;
+  storage::OpenStage stage = storage::OpenStage::kPending;
+  int64_t elapsed_ms = 0;
+};
+
+struct BackupProgress {
+  bool in_progress = false;
+  uint64_t copied_bytes = 0;  // of the running backup, or of the last one
+  int64_t last_time = 0;      // unix time the last backup finished at
+  int64_t last_duration_ms = 0;
+  std::string last_status = "none";
+};
+
+struct ConvertProgress {
+  bool in_progress = false;
+  int db = -1;  // of the running conversion, or of the last one
+  int64_t scanned_keys = 0;
+  int64_t converted_keys = 0;
+  int64_t last_time = 0;  // unix time the last conversion finished at
+  int64_t last_duration_ms = 0;
+  std::string last_status = "none";
+};
+
 class PStore {
  public:
   static PStore& Instance();
@@ -52,18 +86,102 @@ class PStore {
   void operator=(const PStore&) = delete;
   ~PStore();
 
+  // Creates the DBs and opens them in the background, until then IsLoading() is true
   void Init(int db_number);
 
+  bool IsLoading() const { return loading_.load(std::memory_order_acquire); }
+
+  void UpdateOpenProgress(int db, size_t instance, storage::OpenStage stage);
+
+  std::vector<InstanceOpenProgress> GetOpenProgress();
+
   std::unique_ptr<DB>& GetBackend(int32_t index) { return backends_[index]; };
 
+  // shared by every DB, see rocksdb_block_cache_size in config.h
+  const std::shared_ptr<rocksdb::Cache>& GetBlockCache() const { return block_cache_; }
+  const std::shared_ptr<rocksdb::WriteBufferManager>& GetWriteBufferManager() const { return write_buffer_manager_; }
+  // null unless rocksdb_secondary_cache_size is set
+  const std::shared_ptr<rocksdb::SecondaryCache>& GetSecondaryCache() const { return secondary_cache_; }
+  // the tickers of every DB, the cache hit rates of INFO come from them
+  const std::shared_ptr<rocksdb::Statistics>& GetStatistics() const { return statistics_; }
+
   void HandleTaskSpecificDB(const TasksVector& tasks);
 
+  // the parked iterators of every DB, see iterator_max_idle_ms in config.h. Trimmed by the housekeeping thread.
+  void TrimIteratorPools();
+  storage::IteratorPoolStats GetIteratorPoolStats();
+
+  // the write throttles of every instance from their stall metrics, see write_throttle in config.h.
+  // Refreshed by the housekeeping thread.
+  void RefreshWriteThrottles();
+  // Pins the pressure of every write throttle, -1 goes back to the stall metrics. See DEBUG WRITE-PRESSURE.
+  void ForceWritePressure(int32_t pressure);
+  // [db][instance]
+  std::vector<std::vector<storage::WriteThrottleStats>> GetWriteThrottleStats();
+
+  // Backs every DB up to backup_path in the background, Busy while one runs
+  rocksdb::Status StartBackup();
+  BackupProgress GetBackupProgress();
+
+  // Moves the hashes, sets and zsets of a DB to the compact format in the
+  // background, Busy while a conversion runs
+  rocksdb::Status StartConvertFormat(int db);
+  ConvertProgress GetConvertProgress();
+
   int GetDBNumber() const { return db_number_; }
 
  private:
   PStore() = default;
+  void OpenAll();
+  void RunBackup(const std::string& path, const storage::BackupOptions& options);
+  void RunConvertFormat(int db);
+  // The periodic work that takes the DB locks. It has a thread of its own, on
+  // a network thread it would stall every connection of that thread behind an
+  // exclusive command such as FLUSHALL.
+  void Housekeeping();
+  // Pins the RocksDB background threads to rocksdb_threads_cpu_list again when the process has gained or lost threads
+  void PinRocksDBThreads();
+
   int db_number_ = 0;
   std::vector<std::unique_ptr<DB>> backends_;
+
+  std::shared_ptr<rocksdb::Cache> block_cache_;
+  std::shared_ptr<rocksdb::SecondaryCache> secondary_cache_;
+  std::shared_ptr<rocksdb::WriteBufferManager> write_buffer_manager_;
+  std::shared_ptr<rocksdb::Statistics> statistics_;
+
+  std::atomic<bool> loading_ = false;
+  std::thread loader_;
+
+  struct OpenRecord {
+    storage::OpenStage stage = storage::OpenStage::kPending;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point end;
+  };
+  std::mutex progress_mutex_;
+  std::vector<std::vector<OpenRecord>> open_progress_;  // [db][instance]
+
+  std::mutex backup_mutex_;
+  std::thread backup_thread_;
+  std::atomic<bool> backup_running_ = false;
+  std::atomic<uint64_t> backup_copied_bytes_ = 0;
+  BackupProgress last_backup_;  // guarded by backup_mutex_
+
+  std::mutex convert_mutex_;
+  std::thread convert_thread_;
+  std::atomic<bool> convert_running_ = false;
+  std::atomic<bool> convert_stopped_ = false;
+  std::atomic<int64_t> convert_scanned_ = 0;
+  std::atomic<int64_t> convert_converted_ = 0;
+  ConvertProgress last_convert_;  // guarded by convert_mutex_
+
+  std::atomic<int32_t> forced_write_pressure_ = -1;
+
+  std::mutex housekeeping_mutex_;
+  std::condition_variable housekeeping_cond_;
+  bool housekeeping_stopped_ = false;  // guarded by housekeeping_mutex_
+  std::thread housekeeping_thread_;
+  int pinned_thread_count_ = -1;  // the threads of the process at the last pinning
 };
 
 #define PSTORE PStore::Instance()
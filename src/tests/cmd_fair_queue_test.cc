@@ -0,0 +1,188 @@
+//  Copyright (c) 2024-present, OpenAtom Foundation, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <thread>
+
+#include "cmd_fair_queue.h"
+
+using namespace pikiwidb;  // NOLINT
+
+struct FakeTask {
+  int db = 0;
+  size_t bytes = 1;
+
+  int Db() const { return db; }
+  size_t Bytes() const { return bytes; }
+};
+
+using FakeQueue = WeightedFairQueue<FakeTask>;
+
+static void PushTasks(FakeQueue* queue, int db, int count, size_t bytes = 1) {
+  for (int i = 0; i < count; ++i) {
+    ASSERT_TRUE(queue->Push(std::make_shared<FakeTask>(FakeTask{db, bytes})));
+  }
+}
+
+static std::map<int, int> PopByDb(FakeQueue* queue, size_t max) {
+  std::vector<std::shared_ptr<FakeTask>> out;
+  queue->Pop(max, &out);
+  std::map<int, int> popped;
+  for (const auto& task : out) {
+    popped[task->Db()]++;
+  }
+  return popped;
+}
+
+TEST(CmdFairQueueTest, WeightedShares) {  // NOLINT
+  FakeQueue queue;
+  std::vector<CmdQosLimits> limits(3);
+  limits[0].weight = 3;
+  limits[2].weight = 0;  // taken as 1
+  queue.SetLimits(limits);
+
+  PushTasks(&queue, 0, 100);
+  PushTasks(&queue, 1, 100);
+  PushTasks(&queue, 2, 100);
+  ASSERT_EQ(queue.Size(), 300);
+
+  // 3:1:1 over whole rounds
+  auto popped = PopByDb(&queue, 50);
+  EXPECT_EQ(popped[0], 30);
+  EXPECT_EQ(popped[1], 10);
+  EXPECT_EQ(popped[2], 10);
+
+  // a Pop cut short by max goes on with the share of the DB it stopped at
+  popped = PopByDb(&queue, 2);
+  EXPECT_EQ(popped[0], 2);
+  popped = PopByDb(&queue, 3);
+  EXPECT_EQ(popped[0], 1);
+  EXPECT_EQ(popped[1], 1);
+  EXPECT_EQ(popped[2], 1);
+  ASSERT_EQ(queue.Size(), 245);
+
+  auto stats = queue.Stats();
+  ASSERT_EQ(stats.size(), 3);
+  EXPECT_EQ(stats[0].weight, 3);
+  EXPECT_EQ(stats[0].dispatched, 33);
+  EXPECT_EQ(stats[2].weight, 1);
+  EXPECT_EQ(stats[2].queued, 89);
+}
+
+TEST(CmdFairQueueTest, MaxQueued) {  // NOLINT
+  FakeQueue queue;
+  std::vector<CmdQosLimits> limits(1);
+  limits[0].max_queued = 2;
+  queue.SetLimits(limits);
+
+  auto task = std::make_shared<FakeTask>();
+  EXPECT_TRUE(queue.Push(task));
+  EXPECT_TRUE(queue.Push(task));
+  EXPECT_FALSE(queue.Push(task));
+  // the other DBs are not limited
+  EXPECT_TRUE(queue.Push(std::make_shared<FakeTask>(FakeTask{1})));
+  // a command which must not be turned away, e.g. a blocked client run again, goes past the limit
+  EXPECT_TRUE(queue.Push(task, false));
+  EXPECT_EQ(queue.Size(), 4);
+
+  auto stats = queue.Stats();
+  ASSERT_EQ(stats.size(), 2);
+  EXPECT_EQ(stats[0].queued, 3);
+  EXPECT_EQ(stats[0].rejected, 1);
+
+  // room again once the queue drained
+  std::vector<std::shared_ptr<FakeTask>> out;
+  EXPECT_EQ(queue.Pop(10, &out), 4);
+  EXPECT_TRUE(queue.Push(task));
+}
+
+TEST(CmdFairQueueTest, Throttled) {  // NOLINT
+  FakeQueue queue;
+  std::vector<CmdQosLimits> limits(2);
+  limits[0].ops_limit = 100;
+  queue.SetLimits(limits);
+
+  // the bucket holds one second worth of commands
+  PushTasks(&queue, 0, 101);
+  std::vector<std::shared_ptr<FakeTask>> out;
+  EXPECT_EQ(queue.Pop(200, &out), 100);
+  EXPECT_EQ(queue.Size(), 1);
+
+  out.clear();
+  auto before = FakeQueue::Clock::now();
+  EXPECT_EQ(queue.Pop(200, &out), 0);
+  EXPECT_EQ(queue.Size(), 1);
+  EXPECT_FALSE(queue.Empty());
+
+  // a token comes every 10ms
+  auto ready = queue.NextReady();
+  EXPECT_GT(ready, before);
+  EXPECT_LE(ready, FakeQueue::Clock::now() + std::chrono::milliseconds(11));
+
+  // a DB without limits is not held up by the throttled one
+  PushTasks(&queue, 1, 1);
+  EXPECT_EQ(queue.Pop(200, &out), 1);
+  EXPECT_EQ(out.back()->Db(), 1);
+
+  std::this_thread::sleep_until(ready);
+  EXPECT_EQ(queue.Pop(200, &out), 1);
+  EXPECT_TRUE(queue.Empty());
+  EXPECT_EQ(queue.NextReady(), FakeQueue::Clock::time_point::max());
+  EXPECT_GE(queue.Stats()[0].throttled, 1);
+}
+
+TEST(CmdFairQueueTest, BytesLimit) {  // NOLINT
+  FakeQueue queue;
+  std::vector<CmdQosLimits> limits(1);
+  limits[0].bytes_limit = 1000;
+  queue.SetLimits(limits);
+
+  // a request larger than the bucket still goes, its debt holds the DB back
+  PushTasks(&queue, 0, 2, 1500);
+  std::vector<std::shared_ptr<FakeTask>> out;
+  EXPECT_EQ(queue.Pop(10, &out), 1);
+  EXPECT_EQ(queue.Pop(10, &out), 0);
+
+  // 500 bytes of debt at 1000 bytes per second
+  auto wait = queue.NextReady() - FakeQueue::Clock::now();
+  EXPECT_GT(wait, std::chrono::milliseconds(400));
+  EXPECT_LE(wait, std::chrono::milliseconds(501));
+}
+
+TEST(CmdFairQueueTest, LeaveAndRejoin) {  // NOLINT
+  FakeQueue queue;
+  std::vector<CmdQosLimits> limits(2);
+  limits[0].weight = 2;
+  queue.SetLimits(limits);
+
+  PushTasks(&queue, 0, 1);
+  PushTasks(&queue, 1, 3);
+  // DB 0 empties in its turn and leaves the round, DB 1 has the rest to itself
+  auto popped = PopByDb(&queue, 3);
+  EXPECT_EQ(popped[0], 1);
+  EXPECT_EQ(popped[1], 2);
+
+  // back with a fresh share, DB 1 gets its turn before DB 0 does again
+  PushTasks(&queue, 0, 4);
+  popped = PopByDb(&queue, 3);
+  EXPECT_EQ(popped[0], 2);
+  EXPECT_EQ(popped[1], 1);
+  popped = PopByDb(&queue, 10);
+  EXPECT_EQ(popped[0], 2);
+  EXPECT_EQ(popped[1], 0);
+  EXPECT_TRUE(queue.Empty());
+
+  // Clear drops everything, the DBs start over
+  PushTasks(&queue, 0, 2);
+  PushTasks(&queue, 1, 2);
+  queue.Clear();
+  EXPECT_TRUE(queue.Empty());
+  std::vector<std::shared_ptr<FakeTask>> out;
+  EXPECT_EQ(queue.Pop(10, &out), 0);
+  PushTasks(&queue, 1, 1);
+  EXPECT_EQ(queue.Pop(10, &out), 1);
+}
@@ -69,6 +69,13 @@ var _ = Describe("Admin", Ordered, func() {
 		Expect(client.Info(ctx).Val()).NotTo(Equal("FooBar"))
 	})
 
+	It("Cmd INFO loading", func() {
+		info, err := client.Info(ctx, "loading").Result()
+		Expect(err).NotTo(HaveOccurred())
+		Expect(info).To(ContainSubstring("loading:0"))
+		Expect(info).To(ContainSubstring("db0_instance0:stage=opened"))
+	})
+
 	It("Cmd Shutdown", func() {
 		Expect(client.Shutdown(ctx).Err()).NotTo(HaveOccurred())
 
@@ -161,6 +168,35 @@ var _ = Describe("Admin", Ordered, func() {
 		// Expect(res.Val()).To(Equal(map[string]string{"timeout": "0"}))
 	})
 
+	It("Cmd Debug write-pressure", func() {
+		defer func() {
+			Expect(client.Do(ctx, "debug", "write-pressure", "-1").Err()).NotTo(HaveOccurred())
+		}()
+		Expect(client.Do(ctx, "debug", "write-pressure", "101").Err()).To(HaveOccurred())
+
+		// turned away with BUSY, which tells a client to try again later
+		Expect(client.Do(ctx, "debug", "write-pressure", "100").Err()).NotTo(HaveOccurred())
+		// the housekeeping thread may have read the old pressure just before
+		Eventually(func() string {
+			err := client.Set(ctx, "write_pressure_key", "v1", 0).Err()
+			if err == nil {
+				return ""
+			}
+			return err.Error()
+		}, "2s", "50ms").Should(HavePrefix("BUSY "))
+		Expect(client.Del(ctx, "write_pressure_key").Err()).To(HaveOccurred())
+		// the reads go on
+		Expect(client.Exists(ctx, "write_pressure_key").Err()).NotTo(HaveOccurred())
+
+		// below the rejection a write only waits
+		Expect(client.Do(ctx, "debug", "write-pressure", "50").Err()).NotTo(HaveOccurred())
+		Eventually(func() error {
+			return client.Set(ctx, "write_pressure_key", "v2", 0).Err()
+		}, "2s", "50ms").Should(Succeed())
+		Expect(client.Get(ctx, "write_pressure_key").Val()).To(Equal("v2"))
+		Expect(client.Del(ctx, "write_pressure_key").Err()).NotTo(HaveOccurred())
+	})
+
 	It("Cmd Sort", func() {
 		size, err := client.LPush(ctx, "list", "1").Result()
 		Expect(err).NotTo(HaveOccurred())
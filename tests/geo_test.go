@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2024-present, OpenAtom Foundation, Inc.  All rights reserved.
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+package pikiwidb_test
+
+import (
+	"context"
+	"fmt"
+	"log"
+	"strconv"
+	"time"
+
+	. "github.com/onsi/ginkgo/v2"
+	. "github.com/onsi/gomega"
+	"github.com/redis/go-redis/v9"
+
+	"github.com/OpenAtomFoundation/pikiwidb/tests/util"
+)
+
+var _ = Describe("Geo", Ordered, func() {
+	var (
+		ctx    = context.TODO()
+		s      *util.Server
+		client *redis.Client
+	)
+
+	BeforeAll(func() {
+		config := util.GetConfPath(false, 0)
+
+		s = util.StartServer(config, map[string]string{"port": strconv.Itoa(7777)}, true)
+		Expect(s).NotTo(Equal(nil))
+	})
+
+	AfterAll(func() {
+		err := s.Close()
+		if err != nil {
+			log.Println("Close Server fail.", err.Error())
+			return
+		}
+	})
+
+	BeforeEach(func() {
+		client = s.NewClient()
+		if res := client.FlushDB(ctx); res.Err() != nil {
+			fmt.Println("[Geo]FlushDB error: ", res.Err())
+		}
+		time.Sleep(1 * time.Second)
+	})
+
+	AfterEach(func() {
+		err := client.Close()
+		if err != nil {
+			log.Println("Close client conn fail.", err.Error())
+			return
+		}
+	})
+
+	It("should GeoAdd, GeoPos and GeoDist", func() {
+		Expect(client.GeoAdd(ctx, "Sicily",
+			&redis.GeoLocation{Name: "Palermo", Longitude: 13.361389, Latitude: 38.115556},
+			&redis.GeoLocation{Name: "Catania", Longitude: 15.087269, Latitude: 37.502669},
+		).Val()).To(Equal(int64(2)))
+		Expect(client.ZScore(ctx, "Sicily", "Palermo").Val()).To(Equal(float64(3479099956230698)))
+		Expect(client.GeoAdd(ctx, "Sicily", &redis.GeoLocation{Name: "x", Longitude: 200, Latitude: 10}).Err()).To(HaveOccurred())
+
+		pos, err := client.GeoPos(ctx, "Sicily", "Palermo", "NonExisting").Result()
+		Expect(err).NotTo(HaveOccurred())
+		Expect(pos[0].Longitude).To(BeNumerically("~", 13.361389, 1e-5))
+		Expect(pos[0].Latitude).To(BeNumerically("~", 38.115556, 1e-5))
+		Expect(pos[1]).To(BeNil())
+
+		Expect(client.GeoDist(ctx, "Sicily", "Palermo", "Catania", "km").Val()).To(BeNumerically("~", 166.2742, 1e-3))
+		Expect(client.GeoDist(ctx, "Sicily", "Palermo", "NonExisting", "km").Err()).To(Equal(redis.Nil))
+	})
+
+	It("should GeoSearch", func() {
+		Expect(client.GeoAdd(ctx, "Sicily",
+			&redis.GeoLocation{Name: "Palermo", Longitude: 13.361389, Latitude: 38.115556},
+			&redis.GeoLocation{Name: "Catania", Longitude: 15.087269, Latitude: 37.502669},
+			&redis.GeoLocation{Name: "edge1", Longitude: 12.758489, Latitude: 38.788135},
+			&redis.GeoLocation{Name: "edge2", Longitude: 17.241510, Latitude: 38.788135},
+		).Err()).NotTo(HaveOccurred())
+
+		Expect(client.GeoSearch(ctx, "Sicily", &redis.GeoSearchQuery{
+			Longitude: 15, Latitude: 37, Radius: 200, RadiusUnit: "km", Sort: "ASC",
+		}).Val()).To(Equal([]string{"Catania", "Palermo"}))
+		Expect(client.GeoSearch(ctx, "Sicily", &redis.GeoSearchQuery{
+			Longitude: 15, Latitude: 37, BoxWidth: 400, BoxHeight: 400, BoxUnit: "km", Sort: "ASC",
+		}).Val()).To(Equal([]string{"Catania", "Palermo", "edge2", "edge1"}))
+		Expect(client.GeoSearch(ctx, "Sicily", &redis.GeoSearchQuery{
+			Member: "Palermo", Radius: 200, RadiusUnit: "km", Count: 1,
+		}).Val()).To(Equal([]string{"Palermo"}))
+		Expect(client.GeoSearch(ctx, "Sicily", &redis.GeoSearchQuery{
+			Longitude: 15, Latitude: 37, Radius: 400, RadiusUnit: "km", Count: 2, CountAny: true,
+		}).Val()).To(HaveLen(2))
+
+		locs, err := client.GeoSearchLocation(ctx, "Sicily", &redis.GeoSearchLocationQuery{
+			GeoSearchQuery: redis.GeoSearchQuery{Longitude: 15, Latitude: 37, Radius: 200, RadiusUnit: "km", Sort: "ASC"},
+			WithDist:       true,
+		}).Result()
+		Expect(err).NotTo(HaveOccurred())
+		Expect(locs[0].Name).To(Equal("Catania"))
+		Expect(locs[0].Dist).To(BeNumerically("~", 56.4413, 1e-3))
+	})
+
+	It("should GeoSearch many members", func() {
+		for i := 0; i < 600; i++ {
+			Expect(client.GeoAdd(ctx, "points", &redis.GeoLocation{
+				Name: "p" + strconv.Itoa(i), Longitude: 13 + float64(i%30)*0.001, Latitude: 38 + float64(i/30)*0.001,
+			}).Err()).NotTo(HaveOccurred())
+		}
+		Expect(client.GeoSearch(ctx, "points", &redis.GeoSearchQuery{
+			Longitude: 13.01, Latitude: 38.01, Radius: 100, RadiusUnit: "km",
+		}).Val()).To(HaveLen(600))
+	})
+})
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2024-present, OpenAtom Foundation, Inc.  All rights reserved.
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+package pikiwidb_test
+
+import (
+	"context"
+	"fmt"
+	"log"
+	"strconv"
+	"time"
+
+	. "github.com/onsi/ginkgo/v2"
+	. "github.com/onsi/gomega"
+	"github.com/redis/go-redis/v9"
+
+	"github.com/OpenAtomFoundation/pikiwidb/tests/util"
+)
+
+var _ = Describe("Stream", Ordered, func() {
+	var (
+		ctx    = context.TODO()
+		s      *util.Server
+		client *redis.Client
+	)
+
+	BeforeAll(func() {
+		config := util.GetConfPath(false, 0)
+
+		s = util.StartServer(config, map[string]string{"port": strconv.Itoa(7777)}, true)
+		Expect(s).NotTo(Equal(nil))
+	})
+
+	AfterAll(func() {
+		err := s.Close()
+		if err != nil {
+			log.Println("Close Server fail.", err.Error())
+			return
+		}
+	})
+
+	BeforeEach(func() {
+		client = s.NewClient()
+		if res := client.FlushDB(ctx); res.Err() != nil {
+			fmt.Println("[Stream]FlushDB error: ", res.Err())
+		}
+		time.Sleep(1 * time.Second)
+	})
+
+	AfterEach(func() {
+		err := client.Close()
+		if err != nil {
+			log.Println("Close client conn fail.", err.Error())
+			return
+		}
+	})
+
+	It("should XAdd and XRange", func() {
+		id, err := client.XAdd(ctx, &redis.XAddArgs{Stream: "stream", ID: "1-0", Values: []string{"a", "1"}}).Result()
+		Expect(err).NotTo(HaveOccurred())
+		Expect(id).To(Equal("1-0"))
+		Expect(client.XAdd(ctx, &redis.XAddArgs{Stream: "stream", ID: "2-*", Values: []string{"b", ""}}).Val()).To(Equal("2-0"))
+		Expect(client.XAdd(ctx, &redis.XAddArgs{Stream: "stream", ID: "2-0", Values: []string{"c", "3"}}).Err()).To(HaveOccurred())
+		Expect(client.XLen(ctx, "stream").Val()).To(Equal(int64(2)))
+
+		msgs, err := client.XRange(ctx, "stream", "-", "+").Result()
+		Expect(err).NotTo(HaveOccurred())
+		Expect(msgs).To(Equal([]redis.XMessage{
+			{ID: "1-0", Values: map[string]interface{}{"a": "1"}},
+			{ID: "2-0", Values: map[string]interface{}{"b": ""}},
+		}))
+		Expect(client.XRevRangeN(ctx, "stream", "+", "-", 1).Val()[0].ID).To(Equal("2-0"))
+		Expect(client.XRange(ctx, "stream", "(1-0", "+").Val()[0].ID).To(Equal("2-0"))
+		Expect(client.Type(ctx, "stream").Val()).To(Equal("stream"))
+	})
+
+	It("should XTrim and XDel", func() {
+		for i := 1; i <= 5; i++ {
+			Expect(client.XAdd(ctx, &redis.XAddArgs{Stream: "stream", ID: strconv.Itoa(i) + "-0", Values: []string{"k", "v"}}).Err()).NotTo(HaveOccurred())
+		}
+		Expect(client.XDel(ctx, "stream", "1-0", "9-0").Val()).To(Equal(int64(1)))
+		Expect(client.XTrimMaxLen(ctx, "stream", 2).Val()).To(Equal(int64(2)))
+		Expect(client.XTrimMinID(ctx, "stream", "5").Val()).To(Equal(int64(1)))
+		Expect(client.XLen(ctx, "stream").Val()).To(Equal(int64(1)))
+	})
+
+	It("should keep an emptied stream", func() {
+		Expect(client.XAdd(ctx, &redis.XAddArgs{Stream: "stream", ID: "3-0", Values: []string{"k", "v"}}).Err()).NotTo(HaveOccurred())
+		Expect(client.XDel(ctx, "stream", "3-0").Val()).To(Equal(int64(1)))
+		Expect(client.Exists(ctx, "stream").Val()).To(Equal(int64(1)))
+		Expect(client.XLen(ctx, "stream").Val()).To(Equal(int64(0)))
+		Expect(client.XAdd(ctx, &redis.XAddArgs{Stream: "stream", ID: "2-0", Values: []string{"k", "v"}}).Err()).To(MatchError(ContainSubstring("equal or smaller")))
+	})
+
+	It("should XReadGroup, XAck and XPending", func() {
+		Expect(client.XGroupCreateMkStream(ctx, "stream", "group", "$").Val()).To(Equal("OK"))
+		Expect(client.XGroupCreate(ctx, "stream", "group", "$").Err()).To(MatchError(ContainSubstring("BUSYGROUP")))
+		Expect(client.XAdd(ctx, &redis.XAddArgs{Stream: "stream", ID: "1-0", Values: []string{"a", "1"}}).Err()).NotTo(HaveOccurred())
+
+		res, err := client.XReadGroup(ctx, &redis.XReadGroupArgs{
+			Group: "group", Consumer: "alice", Streams: []string{"stream", ">"}, Block: -1,
+		}).Result()
+		Expect(err).NotTo(HaveOccurred())
+		Expect(res[0].Messages[0].ID).To(Equal("1-0"))
+
+		pending, err := client.XPending(ctx, "stream", "group").Result()
+		Expect(err).NotTo(HaveOccurred())
+		Expect(pending.Count).To(Equal(int64(1)))
+		Expect(pending.Consumers).To(Equal(map[string]int64{"alice": 1}))
+
+		Expect(client.XAck(ctx, "stream", "group", "1-0").Val()).To(Equal(int64(1)))
+		Expect(client.XPending(ctx, "stream", "group").Val().Count).To(Equal(int64(0)))
+		Expect(client.XGroupDestroy(ctx, "stream", "group").Val()).To(Equal(int64(1)))
+	})
+
+	It("should XReadGroup with COUNT 0", func() {
+		Expect(client.XGroupCreateMkStream(ctx, "stream", "group", "$").Val()).To(Equal("OK"))
+		for _, id := range []string{"1-0", "2-0", "3-0"} {
+			Expect(client.XAdd(ctx, &redis.XAddArgs{Stream: "stream", ID: id, Values: []string{"a", "1"}}).Err()).NotTo(HaveOccurred())
+		}
+
+		// COUNT 0 is no limit, for the new entries and for the history of the consumer
+		for _, id := range []string{">", "0"} {
+			cmd := redis.NewXStreamSliceCmd(ctx, "xreadgroup", "group", "group", "alice", "count", "0", "streams", "stream", id)
+			Expect(client.Process(ctx, cmd)).NotTo(HaveOccurred())
+			Expect(cmd.Val()[0].Messages).To(HaveLen(3))
+		}
+		Expect(client.XGroupDestroy(ctx, "stream", "group").Val()).To(Equal(int64(1)))
+	})
+
+	It("should XRead with BLOCK", func() {
+		Expect(client.XAdd(ctx, &redis.XAddArgs{Stream: "stream", ID: "1-0", Values: []string{"a", "1"}}).Err()).NotTo(HaveOccurred())
+
+		// times out without new entries
+		_, err := client.XRead(ctx, &redis.XReadArgs{Streams: []string{"stream", "$"}, Block: 200 * time.Millisecond}).Result()
+		Expect(err).To(Equal(redis.Nil))
+
+		// wakes up on XADD
+		writer := s.NewClient()
+		defer writer.Close()
+		go func() {
+			defer GinkgoRecover()
+			time.Sleep(200 * time.Millisecond)
+			Expect(writer.XAdd(ctx, &redis.XAddArgs{Stream: "stream", ID: "2-0", Values: []string{"b", "2"}}).Err()).NotTo(HaveOccurred())
+		}()
+		res, err := client.XRead(ctx, &redis.XReadArgs{Streams: []string{"stream", "$"}, Block: 5 * time.Second}).Result()
+		Expect(err).NotTo(HaveOccurred())
+		Expect(res[0].Messages[0].ID).To(Equal("2-0"))
+	})
+})
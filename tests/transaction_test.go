@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2024-present, OpenAtom Foundation, Inc.  All rights reserved.
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree. An additional grant
+ * of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+package pikiwidb_test
+
+import (
+	"context"
+	"log"
+	"strconv"
+
+	. "github.com/onsi/ginkgo/v2"
+	. "github.com/onsi/gomega"
+	"github.com/redis/go-redis/v9"
+
+	"github.com/OpenAtomFoundation/pikiwidb/tests/util"
+)
+
+var _ = Describe("Transaction", Ordered, func() {
+	var (
+		ctx    = context.TODO()
+		s      *util.Server
+		client *redis.Client
+	)
+
+	// BeforeAll closures will run exactly once before any of the specs
+	// within the Ordered container.
+	BeforeAll(func() {
+		config := util.GetConfPath(false, 0)
+
+		s = util.StartServer(config, map[string]string{"port": strconv.Itoa(7777)}, true)
+		Expect(s).NotTo(Equal(nil))
+	})
+
+	// AfterAll closures will run exactly once after the last spec has
+	// finished running.
+	AfterAll(func() {
+		err := s.Close()
+		if err != nil {
+			log.Println("Close Server fail.", err.Error())
+			return
+		}
+	})
+
+	BeforeEach(func() {
+		client = s.NewClient()
+	})
+
+	// nodes that run after the spec's subject(It).
+	AfterEach(func() {
+		err := client.Close()
+		if err != nil {
+			log.Println("Close client conn fail.", err.Error())
+			return
+		}
+	})
+
+	It("should Exec queued commands", func() {
+		cmds, err := client.TxPipelined(ctx, func(pipe redis.Pipeliner) error {
+			pipe.Set(ctx, "txKey", "1", 0)
+			pipe.Incr(ctx, "txKey")
+			pipe.Get(ctx, "txKey")
+			return nil
+		})
+		Expect(err).NotTo(HaveOccurred())
+		Expect(cmds).To(HaveLen(3))
+		Expect(cmds[1].(*redis.IntCmd).Val()).To(Equal(int64(2)))
+		Expect(cmds[2].(*redis.StringCmd).Val()).To(Equal("2"))
+
+		Expect(client.Del(ctx, "txKey").Err()).NotTo(HaveOccurred())
+	})
+
+	It("should Discard queued commands", func() {
+		Expect(client.Do(ctx, "multi").Val()).To(Equal("OK"))
+		Expect(client.Do(ctx, "set", "txDiscard", "v").Val()).To(Equal("QUEUED"))
+		Expect(client.Do(ctx, "discard").Val()).To(Equal("OK"))
+		Expect(client.Exists(ctx, "txDiscard").Val()).To(Equal(int64(0)))
+
+		Expect(client.Do(ctx, "exec").Err()).To(MatchError("ERR EXEC without MULTI"))
+	})
+
+	It("should abort Exec after a queueing error", func() {
+		Expect(client.Do(ctx, "multi").Val()).To(Equal("OK"))
+		Expect(client.Do(ctx, "set", "txAbort").Err()).To(HaveOccurred())
+		Expect(client.Do(ctx, "exec").Err()).To(MatchError(ContainSubstring("EXECABORT")))
+		Expect(client.Exists(ctx, "txAbort").Val()).To(Equal(int64(0)))
+	})
+
+	It("should abort Exec when a watched key changes", func() {
+		other := s.NewClient()
+		defer other.Close()
+
+		Expect(client.Set(ctx, "txWatch", "1", 0).Err()).NotTo(HaveOccurred())
+		err := client.Watch(ctx, func(tx *redis.Tx) error {
+			// modified by another client between WATCH and EXEC
+			Expect(other.Set(ctx, "txWatch", "2", 0).Err()).NotTo(HaveOccurred())
+			_, err := tx.TxPipelined(ctx, func(pipe redis.Pipeliner) error {
+				pipe.Set(ctx, "txWatch", "3", 0)
+				return nil
+			})
+			return err
+		}, "txWatch")
+		Expect(err).To(Equal(redis.TxFailedErr))
+		Expect(client.Get(ctx, "txWatch").Val()).To(Equal("2"))
+
+		err = client.Watch(ctx, func(tx *redis.Tx) error {
+			_, err := tx.TxPipelined(ctx, func(pipe redis.Pipeliner) error {
+				pipe.Set(ctx, "txWatch", "3", 0)
+				return nil
+			})
+			return err
+		}, "txWatch")
+		Expect(err).NotTo(HaveOccurred())
+		Expect(client.Get(ctx, "txWatch").Val()).To(Equal("3"))
+
+		Expect(client.Del(ctx, "txWatch").Err()).NotTo(HaveOccurred())
+	})
+
+	It("should not abort Exec when a write only names the watched key as a value", func() {
+		other := s.NewClient()
+		defer other.Close()
+
+		err := client.Watch(ctx, func(tx *redis.Tx) error {
+			Expect(other.Set(ctx, "txValue", "txWatched", 0).Err()).NotTo(HaveOccurred())
+			_, err := tx.TxPipelined(ctx, func(pipe redis.Pipeliner) error {
+				pipe.Set(ctx, "txWatched", "1", 0)
+				return nil
+			})
+			return err
+		}, "txWatched")
+		Expect(err).NotTo(HaveOccurred())
+		Expect(client.Get(ctx, "txWatched").Val()).To(Equal("1"))
+
+		Expect(client.Del(ctx, "txWatched", "txValue").Err()).NotTo(HaveOccurred())
+	})
+})